@@ -49,6 +49,7 @@ namespace Falcor
 
     void CopyContext::flush(bool wait)
     {
+        mFlushCount++;
         if (mCommandsPending)
         {
             mpLowLevelData->flush();
@@ -64,13 +65,14 @@ namespace Falcor
 
         if (wait)
         {
+            mSyncCount++;
             mpLowLevelData->getFence()->syncCpu();
         }
     }
 
-    CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const ReadTextureTask::SharedPtr& pRecycled)
     {
-        return CopyContext::ReadTextureTask::create(this, pTexture, subresourceIndex);
+        return CopyContext::ReadTextureTask::create(this, pTexture, subresourceIndex, pRecycled);
     }
 
     std::vector<uint8_t> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
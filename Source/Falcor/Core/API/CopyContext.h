@@ -43,7 +43,19 @@ namespace Falcor
         {
         public:
             using SharedPtr = std::shared_ptr<ReadTextureTask>;
-            static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex);
+
+            /** Record a copy of a texture subresource into a staging buffer and signal a fence, without waiting for the GPU.
+                \param[in] pCtx Context to record the copy on. The context is flushed.
+                \param[in] pTexture Texture to read.
+                \param[in] subresourceIndex Subresource to read.
+                \param[in] pRecycled Optional task whose data has already been read. Its staging buffer and fence are reused if the buffer is large enough.
+                \return A new task.
+            */
+            static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, const SharedPtr& pRecycled = nullptr);
+
+            /** Wait for the copy to finish and return the texture data.
+                This can be called from any thread.
+            */
             std::vector<uint8_t> getData();
         private:
             ReadTextureTask() = default;
@@ -52,6 +64,7 @@ namespace Falcor
             CopyContext* mpContext;
 #ifdef FALCOR_D3D12
             uint32_t mRowCount;
+            uint64_t mFenceValue;
             ResourceFormat mTextureFormat;
             D3D12_PLACED_SUBRESOURCE_FOOTPRINT mFootprint;
 #elif defined(FALCOR_VK)
@@ -80,6 +93,14 @@ namespace Falcor
         */
         void setPendingCommands(bool commandsPending) { mCommandsPending = commandsPending; }
 
+        /** Get the number of calls to flush() since the context was created. Useful for detecting redundant flushes.
+        */
+        uint64_t getFlushCount() const { return mFlushCount; }
+
+        /** Get the number of calls to flush() that blocked the CPU until the GPU finished executing.
+        */
+        uint64_t getSyncCount() const { return mSyncCount; }
+
         /** Insert a resource barrier
             if pViewInfo is nullptr, will transition the entire resource. Otherwise, it will only transition the subresource in the view
             \return true if a barrier commands were recorded for the entire resource-view, otherwise false (for example, when the current resource state is the same as the new state or when only some subresources were transitioned)
@@ -126,8 +147,11 @@ namespace Falcor
         std::vector<uint8_t> readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
 
         /** Read texture data Asynchronously
+            \param[in] pTexture Texture to read.
+            \param[in] subresourceIndex Subresource to read.
+            \param[in] pRecycled Optional finished task whose staging buffer is reused to avoid allocating a new one.
         */
-        ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
+        ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const ReadTextureTask::SharedPtr& pRecycled = nullptr);
 
         /** Get the low-level context data
         */
@@ -151,6 +175,8 @@ namespace Falcor
         void updateTextureSubresources(const Texture* pTexture, uint32_t firstSubresource, uint32_t subresourceCount, const void* pData, const uint3& offset = uint3(0), const uint3& size = uint3(-1));
 
         bool mCommandsPending = false;
+        uint64_t mFlushCount = 0;
+        uint64_t mSyncCount = 0;
         LowLevelContextData::SharedPtr mpLowLevelData;
     };
 }
@@ -50,6 +50,7 @@ namespace Falcor
         {ResourceFormat::RGB10A2Unorm,                  DXGI_FORMAT_R10G10B10A2_UNORM},
         {ResourceFormat::RGB10A2Uint,                   DXGI_FORMAT_R10G10B10A2_UINT},
         {ResourceFormat::RGBA16Unorm,                   DXGI_FORMAT_R16G16B16A16_UNORM},
+        {ResourceFormat::RGBA16Snorm,                   DXGI_FORMAT_R16G16B16A16_SNORM},
         {ResourceFormat::RGBA8UnormSrgb,                DXGI_FORMAT_R8G8B8A8_UNORM_SRGB},
         {ResourceFormat::R16Float,                      DXGI_FORMAT_R16_FLOAT},
         {ResourceFormat::RG16Float,                     DXGI_FORMAT_R16G16_FLOAT},
@@ -30,6 +30,7 @@
 #include "Device.h"
 #include "RenderContext.h"
 #include "Utils/Threading.h"
+#include "Utils/Image/TextureReadback.h"
 
 #include <mutex>
 
@@ -260,7 +261,7 @@ namespace Falcor
         return findViewCommon<ShaderResourceView>(this, mostDetailedMip, mipCount, firstArraySlice, arraySize, mSrvs, createFunc);
     }
 
-    void Texture::captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags)
+    void Texture::captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags, TextureReadback* pReadback)
     {
         if (format == Bitmap::FileFormat::DdsFile)
         {
@@ -272,30 +273,37 @@ namespace Falcor
         // Handle the special case where we have an HDR texture with less then 3 channels
         FormatType type = getFormatType(mFormat);
         uint32_t channels = getFormatChannelCount(mFormat);
-        std::vector<uint8_t> textureData;
+        const Texture* pSrcTex = this;
+        Texture::SharedPtr pOther;
+        uint32_t subresource = getSubresourceIndex(arraySlice, mipLevel);
         ResourceFormat resourceFormat = mFormat;
 
         if (type == FormatType::Float && channels < 3)
         {
-            Texture::SharedPtr pOther = Texture::create2D(getWidth(mipLevel), getHeight(mipLevel), ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
+            pOther = Texture::create2D(getWidth(mipLevel), getHeight(mipLevel), ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
             pContext->blit(getSRV(mipLevel, 1, arraySlice, 1), pOther->getRTV(0, 0, 1));
-            textureData = pContext->readTextureSubresource(pOther.get(), 0);
+            pSrcTex = pOther.get();
+            subresource = 0;
             resourceFormat = ResourceFormat::RGBA32Float;
         }
-        else
-        {
-            uint32_t subresource = getSubresourceIndex(arraySlice, mipLevel);
-            textureData = pContext->readTextureSubresource(this, subresource);
-        }
 
         uint32_t width = getWidth(mipLevel);
         uint32_t height = getHeight(mipLevel);
-        auto func = [=]()
+        auto saveImage = [=](const std::vector<uint8_t>& textureData)
         {
             Bitmap::saveImage(filename, width, height, format, exportFlags, resourceFormat, true, (void*)textureData.data());
         };
 
-        Threading::dispatchTask(func);
+        if (pReadback)
+        {
+            pReadback->readTexture(pContext, pSrcTex, subresource, saveImage);
+            return;
+        }
+
+        // Without a readback owned by the caller, wait for the file to be written, so the staging buffer doesn't outlive the call.
+        auto pLocalReadback = TextureReadback::create(1);
+        pLocalReadback->readTexture(pContext, pSrcTex, subresource, saveImage);
+        pLocalReadback->flush();
     }
 
     void Texture::uploadInitData(const void* pData, bool autoGenMips)
@@ -35,6 +35,7 @@ namespace Falcor
     class Sampler;
     class Device;
     class RenderContext;
+    class TextureReadback;
 
     /** Abstracts the API texture objects
     */
@@ -228,8 +229,11 @@ namespace Falcor
             \param[in] filename Name of the file to save.
             \param[in] fileFormat Destination image file format (e.g., PNG, PFM, etc.)
             \param[in] exportFlags Save flags, see Bitmap::ExportFlags
+            \param[in] pReadback Optional readback to queue the capture on. The call then doesn't wait for the GPU, the file is written
+            on the readback's worker thread. The caller owns the readback and must keep it alive until the file is written.
+            Without a readback, the call waits until the file is written.
         */
-        void captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format = Bitmap::FileFormat::PngFile, Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None);
+        void captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format = Bitmap::FileFormat::PngFile, Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None, TextureReadback* pReadback = nullptr);
 
         /** Generates mipmaps for a specified texture object.
         */
@@ -32,11 +32,43 @@
 #include "Core/API/Device.h"
 
 #include <slang/slang.h>
+#include <atomic>
 
 namespace Falcor
 {
     namespace
     {
+        struct
+        {
+            std::atomic<uint64_t> unchanged = 0;
+            std::atomic<uint64_t> cacheHits = 0;
+            std::atomic<uint64_t> cacheMisses = 0;
+        } sSpecializationStats;
+
+        bool isSameSpecialization(const ParameterBlock::SpecializationArgs& a, const ParameterBlock::SpecializationArgs& b)
+        {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                if (a[i].kind != b[i].kind || a[i].type != b[i].type) return false;
+            }
+            return true;
+        }
+
+        std::string getSpecializedLayoutKey(slang::TypeReflection* pType, const ParameterBlock::SpecializationArgs& specializationArgs)
+        {
+            // Types are identified by name, the same way specialized kernels are looked up in `ProgramVersion::getKernels()`.
+            std::string key = pType->getName();
+            key += "<";
+            for (size_t i = 0; i < specializationArgs.size(); i++)
+            {
+                if (i > 0) key += ",";
+                key += specializationArgs[i].type->getName();
+            }
+            key += ">";
+            return key;
+        }
+
         std::string getErrorPrefix(const char* funcName, const std::string& varName)
         {
             return std::string(funcName) + " is trying to access the shader variable '" + varName + "'";
@@ -1480,11 +1512,38 @@ namespace Falcor
             return false;
         }
 
-        // TODO: we should have some kind of caching step here, where we
-        // collect the existential type arguments and see if they've changed
-        // since the last time.
+        // Collect the existential type arguments and skip the update if
+        // they haven't changed since the last time.
+        //
+        SpecializationArgs specializationArgs;
+        collectSpecializationArgs(specializationArgs);
+
+        if( mSpecializationValid && isSameSpecialization(specializationArgs, mLastSpecializationArgs) )
+        {
+            sSpecializationStats.unchanged++;
+            return false;
+        }
+
+        bool result = updateSpecializationImpl(specializationArgs);
+        mLastSpecializationArgs = std::move(specializationArgs);
+        mSpecializationValid = mpSpecializedReflector != nullptr;
+        return result;
+    }
+
+    ParameterBlock::SpecializationStats ParameterBlock::getSpecializationStats()
+    {
+        SpecializationStats stats;
+        stats.unchanged = sSpecializationStats.unchanged;
+        stats.cacheHits = sSpecializationStats.cacheHits;
+        stats.cacheMisses = sSpecializationStats.cacheMisses;
+        return stats;
+    }
 
-        return updateSpecializationImpl();
+    void ParameterBlock::resetSpecializationStats()
+    {
+        sSpecializationStats.unchanged = 0;
+        sSpecializationStats.cacheHits = 0;
+        sSpecializationStats.cacheMisses = 0;
     }
 
     void ParameterBlock::collectSpecializationArgs(ParameterBlock::SpecializationArgs& ioArgs) const
@@ -1541,7 +1600,7 @@ namespace Falcor
         }
     }
 
-    bool ParameterBlock::updateSpecializationImpl() const
+    bool ParameterBlock::updateSpecializationImpl(const SpecializationArgs& specializationArgs) const
     {
         // We want to compute the specialized layout that this object
         // should use...
@@ -1549,17 +1608,25 @@ namespace Falcor
         auto pSlangTypeLayout = getElementType()->getSlangTypeLayout();
         auto pSlangType = pSlangTypeLayout->getType();
 
-        SpecializationArgs specializationArgs;
-        collectSpecializationArgs(specializationArgs);
+        // Specialized layouts are cached per program version, so that if we
+        // go back to a previous configuration we can re-use its layout.
+        //
+        auto& specializedLayouts = mpProgramVersion->mSpecializedLayouts;
+        std::string key = getSpecializedLayoutKey(pSlangType, specializationArgs);
+        auto it = specializedLayouts.find(key);
+        if( it != specializedLayouts.end() )
+        {
+            sSpecializationStats.cacheHits++;
+            bool changed = mpSpecializedReflector != it->second;
+            mpSpecializedReflector = it->second;
+            return changed;
+        }
+        sSpecializationStats.cacheMisses++;
 
         // We call back into Slang to generate a specialization of
         // the element type and compute its layout.
         //
-        // TODO: We should probably have a cache of specialized layouts
-        // here, so that if we go back to a previous configuration we
-        // can re-use its layout.
-        //
-
+        auto lock = mpProgramVersion->lockSlangSession();
         auto pSlangSession = mpProgramVersion->getSlangSession();
 
         ComPtr<ISlangBlob> pDiagnostics;
@@ -1583,6 +1650,7 @@ namespace Falcor
         auto pSpecializedSlangTypeLayout = pSlangSession->getTypeLayout(pSpecializedSlangType);
 
         mpSpecializedReflector = ParameterBlockReflection::create(mpProgramVersion.get(), pSpecializedSlangTypeLayout);
+        specializedLayouts[key] = mpSpecializedReflector;
 
         return true;
     }
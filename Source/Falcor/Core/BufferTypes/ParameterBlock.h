@@ -93,6 +93,14 @@ namespace Falcor
         {
             return getRootVar()[offset];
         }
+
+        /** Get a shader variable that points at the field/element with the given pre-resolved `handle`.
+            This is an alias for `getRootVar()[handle]`.
+        */
+        ShaderVar operator[](const ShaderVarHandle& handle) const
+        {
+            return getRootVar()[handle];
+        }
     };
 
     /** A parameter block. This block stores all the parameter data associated with a specific type in shader code
@@ -308,9 +316,31 @@ namespace Falcor
         */
         size_t getSize() const { return mData.size(); }
 
+        /** Update the specialized layout of the block based on the concrete types bound to its interface-type parameters.
+            The update is skipped if the bound types are unchanged since the last call. Specialized layouts are cached
+            per program version, so switching back to a previously used set of types doesn't call into Slang.
+            \return True if the block switched to a new specialized layout.
+        */
         bool updateSpecialization() const;
         ParameterBlockReflection::SharedConstPtr getSpecializedReflector() const { return mpSpecializedReflector; }
 
+        /** Statistics of the specialized layout cache, accumulated over all parameter blocks.
+        */
+        struct SpecializationStats
+        {
+            uint64_t unchanged = 0;     ///< Updates skipped because the specialization arguments didn't change.
+            uint64_t cacheHits = 0;     ///< Specialized layouts found in the layout cache.
+            uint64_t cacheMisses = 0;   ///< Specialized layouts computed by Slang.
+        };
+
+        /** Get the specialized layout cache statistics.
+        */
+        static SpecializationStats getSpecializationStats();
+
+        /** Reset the specialized layout cache statistics.
+        */
+        static void resetSpecializationStats();
+
         bool prepareDescriptorSets(CopyContext* pCopyContext);
 
         uint32_t getDescriptorSetCount() const { return mpReflector->getDescriptorSetCount(); }
@@ -390,9 +420,11 @@ namespace Falcor
         std::shared_ptr<const ProgramVersion> mpProgramVersion;
         ParameterBlockReflection::SharedConstPtr mpReflector;
         mutable ParameterBlockReflection::SharedConstPtr mpSpecializedReflector;
+        mutable SpecializationArgs mLastSpecializationArgs;     ///< Arguments used for the current specialized reflector.
+        mutable bool mSpecializationValid = false;              ///< True if mpSpecializedReflector matches mLastSpecializationArgs.
         std::vector<uint8_t> mData;
 
-        virtual bool updateSpecializationImpl() const;
+        virtual bool updateSpecializationImpl(const SpecializationArgs& specializationArgs) const;
         void createConstantBuffers(const ShaderVar& var);
 
         /** Get a constant buffer view for the underlying constant buffer for ordinary/uniform data.
@@ -26,6 +26,11 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "stdafx.h"
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
 // #include "Utils/StringUtils.h"
 // #include "Utils/Platform/OS.h"
 // #include "Utils/Logger.h"
@@ -166,6 +171,11 @@ namespace Falcor
         return forkVal;
     }
 
+    uint32_t getProcessId()
+    {
+        return (uint32_t)getpid();
+    }
+
     bool isProcessRunning(size_t processID)
     {
         // TODO
@@ -194,16 +204,206 @@ namespace Falcor
         return (stat(pathname, &sb) == 0) && S_ISDIR(sb.st_mode);
     }
 
+    namespace
+    {
+        /** Watches files for changes using a single inotify instance and thread.
+            Directories are watched instead of files, so that files replaced by editors (write to temp file + rename) are still tracked.
+            Bursts of write events are coalesced, the callback is called once the file has been quiet for a short time.
+        */
+        class FileWatcher
+        {
+        public:
+            static FileWatcher& get()
+            {
+                static FileWatcher sInstance;
+                return sInstance;
+            }
+
+            void addFile(const std::string& filePath, const std::function<void()>& callback)
+            {
+                std::string dir = getDirectoryFromFile(filePath);
+                if (dir.empty()) dir = ".";
+
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mInotifyFd < 0) return;
+
+                // Replace the callback if the file is already watched.
+                if (auto it = mFiles.find(filePath); it != mFiles.end())
+                {
+                    it->second.callback = callback;
+                    return;
+                }
+
+                int wd = inotify_add_watch(mInotifyFd, dir.c_str(), kWatchMask);
+                if (wd < 0)
+                {
+                    logError("monitorFileUpdates() - inotify_add_watch() failed for '" + dir + "' with error " + std::string(strerror(errno)));
+                    return;
+                }
+
+                // inotify returns the same descriptor when a directory is watched more than once.
+                mDirectories[wd].refCount++;
+                mFiles[filePath] = { wd, getFilenameFromPath(filePath), callback };
+            }
+
+            void removeFile(const std::string& filePath)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    auto it = mFiles.find(filePath);
+                    if (it == mFiles.end()) return;
+
+                    int wd = it->second.wd;
+                    mFiles.erase(it);
+                    if (--mDirectories[wd].refCount == 0)
+                    {
+                        inotify_rm_watch(mInotifyFd, wd);
+                        mDirectories.erase(wd);
+                    }
+                }
+
+                // Wait for a callback that is currently being dispatched, unless called from within a callback.
+                if (std::this_thread::get_id() != mThread.get_id())
+                {
+                    std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+                }
+            }
+
+        private:
+            static constexpr uint32_t kWatchMask = IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+            static constexpr auto kDebounceTime = std::chrono::milliseconds(50);
+            using Clock = std::chrono::steady_clock;
+
+            struct WatchedFile
+            {
+                int wd = -1;
+                std::string filename;
+                std::function<void()> callback;
+                bool pending = false;
+                Clock::time_point dispatchTime;
+            };
+
+            struct WatchedDirectory
+            {
+                uint32_t refCount = 0;
+            };
+
+            FileWatcher()
+            {
+                mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (mInotifyFd < 0 || mWakeFd < 0)
+                {
+                    logError("monitorFileUpdates() - Failed to initialize inotify with error " + std::string(strerror(errno)));
+                    if (mInotifyFd >= 0) close(mInotifyFd);
+                    if (mWakeFd >= 0) close(mWakeFd);
+                    mInotifyFd = mWakeFd = -1;
+                    return;
+                }
+                mThread = std::thread(&FileWatcher::run, this);
+            }
+
+            ~FileWatcher()
+            {
+                if (mThread.joinable())
+                {
+                    mTerminate = true;
+                    uint64_t value = 1;
+                    if (write(mWakeFd, &value, sizeof(value))) {}
+                    mThread.join();
+                }
+                if (mInotifyFd >= 0) close(mInotifyFd);
+                if (mWakeFd >= 0) close(mWakeFd);
+            }
+
+            void run()
+            {
+                alignas(inotify_event) char buffer[4096];
+                std::vector<std::function<void()>> callbacks;
+
+                while (!mTerminate)
+                {
+                    // Sleep until there are events or the next debounced callback is due.
+                    int timeout = -1;
+                    {
+                        std::lock_guard<std::mutex> lock(mMutex);
+                        auto now = Clock::now();
+                        for (const auto& [path, file] : mFiles)
+                        {
+                            if (!file.pending) continue;
+                            int ms = (int)std::chrono::ceil<std::chrono::milliseconds>(std::max(file.dispatchTime - now, Clock::duration::zero())).count();
+                            timeout = timeout < 0 ? ms : std::min(timeout, ms);
+                        }
+                    }
+
+                    pollfd fds[2] = { { mInotifyFd, POLLIN, 0 }, { mWakeFd, POLLIN, 0 } };
+                    if (poll(fds, 2, timeout) < 0 && errno != EINTR)
+                    {
+                        logError("monitorFileUpdates() - poll() failed with error " + std::string(strerror(errno)));
+                        return;
+                    }
+                    if (mTerminate) return;
+
+                    std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+                    {
+                        std::lock_guard<std::mutex> lock(mMutex);
+
+                        // Drain all pending events and (re)start the quiet period of the affected files.
+                        ssize_t length;
+                        while ((length = read(mInotifyFd, buffer, sizeof(buffer))) > 0)
+                        {
+                            for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len)
+                            {
+                                const inotify_event* pEvent = reinterpret_cast<inotify_event*>(p);
+                                if (pEvent->len == 0) continue;
+                                for (auto& [path, file] : mFiles)
+                                {
+                                    if (file.wd == pEvent->wd && file.filename == pEvent->name)
+                                    {
+                                        file.pending = true;
+                                        file.dispatchTime = Clock::now() + kDebounceTime;
+                                    }
+                                }
+                            }
+                        }
+
+                        // Collect the callbacks of the files that have been quiet long enough.
+                        auto now = Clock::now();
+                        for (auto& [path, file] : mFiles)
+                        {
+                            if (file.pending && file.dispatchTime <= now)
+                            {
+                                file.pending = false;
+                                if (file.callback) callbacks.push_back(file.callback);
+                            }
+                        }
+                    }
+
+                    // Call the callbacks without holding the lock, so they can add or remove watched files.
+                    for (const auto& callback : callbacks) callback();
+                    callbacks.clear();
+                }
+            }
+
+            int mInotifyFd = -1;
+            int mWakeFd = -1;
+            std::atomic<bool> mTerminate = false;
+            std::thread mThread;
+            std::mutex mMutex;              ///< Protects the watched files and directories.
+            std::mutex mDispatchMutex;      ///< Held while processing events and calling callbacks.
+            std::unordered_map<std::string, WatchedFile> mFiles;
+            std::unordered_map<int, WatchedDirectory> mDirectories;
+        };
+    }
+
     void monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback)
     {
-        (void)filePath; (void)callback;
-        should_not_get_here();
+        FileWatcher::get().addFile(filePath, callback);
     }
 
     void closeSharedFile(const std::string& filePath)
     {
-        (void)filePath;
-        should_not_get_here();
+        FileWatcher::get().removeFile(filePath);
     }
 
     std::string getTempFilename()
@@ -530,4 +730,34 @@ namespace Falcor
     {
         return dlsym(dll, funcName.c_str());
     }
+
+    bool mapFile(const std::string& filename, MappedFile& file)
+    {
+        file = {};
+
+        int32_t handle = open(filename.c_str(), O_RDONLY);
+        if (handle < 0) return false;
+
+        struct stat fileStat;
+        if (fstat(handle, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(handle);
+            return false;
+        }
+
+        // The mapping stays valid after the file descriptor is closed.
+        void* pData = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+        close(handle);
+        if (pData == MAP_FAILED) return false;
+
+        file.pData = pData;
+        file.size = (size_t)fileStat.st_size;
+        return true;
+    }
+
+    void unmapFile(MappedFile& file)
+    {
+        if (file.pData) munmap(const_cast<void*>(file.pData), file.size);
+        file = {};
+    }
 }
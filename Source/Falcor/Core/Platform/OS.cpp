@@ -29,6 +29,8 @@
 #include "Utils/StringUtils.h"
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <random>
 
 namespace fs = std::filesystem;
 
@@ -41,6 +43,19 @@ namespace Falcor
         gMsgBoxTitle = title;
     }
 
+    std::string getUniqueTempFilename(const std::string& filename)
+    {
+        static std::mutex mutex;
+        static std::mt19937_64 rng(std::random_device{}());
+
+        uint64_t random;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            random = rng();
+        }
+        return filename + "." + std::to_string(getProcessId()) + "." + toHexString(random) + ".tmp";
+    }
+
     uint32_t getLowerPowerOf2(uint32_t a)
     {
         assert(a != 0);
@@ -220,6 +220,13 @@ namespace Falcor
     */
     dlldecl std::string getTempFilename();
 
+    /** Get a temporary filename to write a file to before renaming it into place.
+        The name is unique across threads and processes, it is the given filename with the process ID, a random number and the ".tmp" extension appended.
+        \param[in] filename The final filename.
+        \return The temporary filename.
+    */
+    dlldecl std::string getUniqueTempFilename(const std::string& filename);
+
     /** Create a directory from path.
     */
     dlldecl bool createDirectory(const std::string& path);
@@ -236,6 +243,10 @@ namespace Falcor
      */
     dlldecl void terminateProcess(size_t processID);
 
+    /** Get the ID of the current process
+     */
+    dlldecl uint32_t getProcessId();
+
     /** Get the current executable directory
         \return The full path of the application directory
     */
@@ -402,6 +413,26 @@ namespace Falcor
     */
     dlldecl std::string readFile(const std::string& filename);
 
+    /** Read-only memory mapping of a file.
+    */
+    struct MappedFile
+    {
+        const void* pData = nullptr;    ///< Pointer to the mapped file contents, or nullptr if not mapped.
+        size_t size = 0;                ///< Size of the mapped file in bytes.
+        void* pHandle = nullptr;        ///< Platform specific handle of the mapping.
+    };
+
+    /** Map a file into memory for reading.
+        \param[in] filename Full path of the file to map.
+        \param[out] file The mapping. Must be released with unmapFile().
+        \return True if the file was mapped, otherwise false.
+    */
+    dlldecl bool mapFile(const std::string& filename, MappedFile& file);
+
+    /** Release a memory mapping created with mapFile().
+    */
+    dlldecl void unmapFile(MappedFile& file);
+
     /** Load a shared-library
     */
     dlldecl DllHandle loadDll(const std::string& libPath);
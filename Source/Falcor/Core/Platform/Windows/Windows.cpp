@@ -467,6 +467,11 @@ namespace Falcor
         return reinterpret_cast<size_t>(processInformation.hProcess);
     }
 
+    uint32_t getProcessId()
+    {
+        return (uint32_t)GetCurrentProcessId();
+    }
+
     bool isProcessRunning(size_t processID)
     {
         uint32_t exitCode = 0;
@@ -583,6 +588,45 @@ namespace Falcor
         }
     }
 
+    bool mapFile(const std::string& filename, MappedFile& file)
+    {
+        file = {};
+
+        HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(hFile);
+            return false;
+        }
+
+        // The mapping object keeps a reference to the file, so the file handle can be closed right away.
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (hMapping == NULL) return false;
+
+        const void* pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        if (pData == nullptr)
+        {
+            CloseHandle(hMapping);
+            return false;
+        }
+
+        file.pData = pData;
+        file.size = (size_t)fileSize.QuadPart;
+        file.pHandle = hMapping;
+        return true;
+    }
+
+    void unmapFile(MappedFile& file)
+    {
+        if (file.pData) UnmapViewOfFile(file.pData);
+        if (file.pHandle) CloseHandle((HANDLE)file.pHandle);
+        file = {};
+    }
+
     void enumerateFiles(std::string searchString, std::vector<std::string>& filenames)
     {
         WIN32_FIND_DATAA ffd;
@@ -29,6 +29,14 @@
 #include "Program.h"
 #include "Slang/slang.h"
 #include "Utils/StringUtils.h"
+#include "rapidjson/document.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <set>
 
 namespace Falcor
 {
@@ -40,6 +48,254 @@ namespace Falcor
 
     static Program::DefineList sGlobalDefineList;
 
+    SlangContext::SharedPtr createSlangContext()
+    {
+        auto pContext = std::make_shared<SlangContext>();
+        slang::createGlobalSession(pContext->pGlobalSession.writeRef());
+        return pContext;
+    }
+
+    namespace
+    {
+        const uint32_t kMaxCompileThreads = 4;
+        const uint32_t kPermutationFileVersion = 1;
+
+        std::mutex sShaderCacheMutex;
+        ShaderCache::SharedPtr sShaderCache;
+        bool sShaderCacheInitialized = false;
+
+        bool sAsyncCompilation = false;
+
+        std::mutex sCompileStatsMutex;
+        Program::CompileStats sCompileStats;
+
+        // Permutations are identified by Program::getPermutationKey() and the program defines.
+        using PermutationMap = std::map<std::string, std::set<Program::DefineList>>;
+        bool sRecordPermutations = false;
+        PermutationMap sRecordedPermutations;
+        PermutationMap sPrewarmPermutations;
+
+        template<typename F>
+        void updateCompileStats(F func)
+        {
+            std::lock_guard<std::mutex> lock(sCompileStatsMutex);
+            func(sCompileStats);
+        }
+
+        // Slang context of a compile thread. Other threads share the main context.
+        thread_local SlangContext::SharedPtr tpSlangContext;
+
+        /** Get the Slang context of the calling thread.
+            The main context is intentionally leaked, so it outlives versions that are destroyed during static destruction.
+        */
+        const SlangContext::SharedPtr& getSlangContext()
+        {
+            if (tpSlangContext) return tpSlangContext;
+            static SlangContext::SharedPtr* pMainContext = new SlangContext::SharedPtr(createSlangContext());
+            return *pMainContext;
+        }
+
+        /** Threads compiling program versions in the background.
+            Compiling blocks for a long time, so dedicated threads are used rather than the job system (see Threading).
+            Each thread compiles with its own Slang global session, which allows compiling in parallel. A compiled version keeps
+            the global session it was compiled with, and the thread starts a new session for its next job. That way the session of a
+            published version is only used by the threads using the version, and they never wait for background compilation.
+            This costs the creation of a global session per version compiled in the background, and the memory of the session.
+            The threads are started on first use and stopped by shutdown().
+        */
+        class CompileQueue
+        {
+        public:
+            static CompileQueue& get()
+            {
+                static CompileQueue queue;
+                return queue;
+            }
+
+            /** Queue a job. The job is called with cancel set to true if the queue is shut down before the job runs.
+            */
+            void enqueue(std::function<void(bool cancel)> job)
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                if (mTerminate)
+                {
+                    lock.unlock();
+                    job(true);
+                    return;
+                }
+                if (mThreads.empty()) start();
+                mJobs.push_back(std::move(job));
+                lock.unlock();
+                mCondition.notify_one();
+            }
+
+            /** Cancel the queued jobs, wait for the running ones and stop the threads.
+            */
+            void shutdown()
+            {
+                std::deque<std::function<void(bool)>> jobs;
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mTerminate = true;
+                    jobs.swap(mJobs);
+                }
+                mCondition.notify_all();
+                for (auto& job : jobs) job(true);
+                for (auto& thread : mThreads) thread.join();
+                mThreads.clear();
+            }
+
+            ~CompileQueue() { shutdown(); }
+
+        private:
+            void start()
+            {
+                uint32_t threadCount = std::clamp(std::thread::hardware_concurrency() / 2, 1u, kMaxCompileThreads);
+                for (uint32_t i = 0; i < threadCount; i++) mThreads.emplace_back([this]() { run(); });
+            }
+
+            void run()
+            {
+                while (true)
+                {
+                    std::function<void(bool)> job;
+                    {
+                        std::unique_lock<std::mutex> lock(mMutex);
+                        mCondition.wait(lock, [this]() { return mTerminate || !mJobs.empty(); });
+                        if (mTerminate) break;
+                        job = std::move(mJobs.front());
+                        mJobs.pop_front();
+                    }
+
+                    // Start a new global session if the previous one was handed over to a compiled version.
+                    if (!tpSlangContext || tpSlangContext.use_count() > 1) tpSlangContext = createSlangContext();
+                    job(false);
+                }
+                tpSlangContext.reset();
+            }
+
+            std::mutex mMutex;
+            std::condition_variable mCondition;
+            std::deque<std::function<void(bool)>> mJobs;
+            std::vector<std::thread> mThreads;
+            bool mTerminate = false;
+        };
+
+        /** Measures the time the calling thread is blocked by shader compilation.
+            The time is added to the compile statistics and reported as a profiler event.
+        */
+        class CompileStall
+        {
+        public:
+            CompileStall() : mStart(CpuTimer::getCurrentTimePoint()) {}
+
+            ~CompileStall()
+            {
+                double stallTime = CpuTimer::calcDuration(mStart, CpuTimer::getCurrentTimePoint()) * 1.0e-3;
+                updateCompileStats([stallTime](Program::CompileStats& stats)
+                {
+                    stats.stalls++;
+                    stats.stallTime += stallTime;
+                    stats.maxStallTime = std::max(stats.maxStallTime, stallTime);
+                });
+            }
+
+        private:
+#if _PROFILING_ENABLED
+            ProfilerEvent mEvent{ "shaderCompileStall", Profiler::Flags::Internal };
+#endif
+            CpuTimer::TimePoint mStart;
+        };
+
+        /** Blob holding kernel code loaded from the shader cache.
+            Implements ISlangBlob, whose interface ID matches ID3DBlob, so it can be used wherever Slang's own blobs are.
+        */
+        class CachedBlob : public ISlangBlob
+        {
+        public:
+            CachedBlob(std::vector<uint8_t>&& data) : mData(std::move(data)) {}
+
+            SLANG_NO_THROW SlangResult SLANG_MCALL queryInterface(SlangUUID const& uuid, void** outObject) override
+            {
+                static const SlangUUID kUnknownUUID = { 0x00000000, 0x0000, 0x0000, { 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46 } };
+                static const SlangUUID kBlobUUID = { 0x8BA5FB08, 0x5195, 0x40e2, { 0xAC, 0x58, 0x0D, 0x98, 0x9C, 0x3A, 0x01, 0x02 } };
+                if (std::memcmp(&uuid, &kUnknownUUID, sizeof(SlangUUID)) == 0 || std::memcmp(&uuid, &kBlobUUID, sizeof(SlangUUID)) == 0)
+                {
+                    addRef();
+                    *outObject = static_cast<ISlangBlob*>(this);
+                    return SLANG_OK;
+                }
+                *outObject = nullptr;
+                return SLANG_E_NO_INTERFACE;
+            }
+
+            SLANG_NO_THROW uint32_t SLANG_MCALL addRef() override { return ++mRefCount; }
+
+            SLANG_NO_THROW uint32_t SLANG_MCALL release() override
+            {
+                uint32_t refCount = --mRefCount;
+                if (refCount == 0) delete this;
+                return refCount;
+            }
+
+            SLANG_NO_THROW void const* SLANG_MCALL getBufferPointer() override { return mData.data(); }
+            SLANG_NO_THROW size_t SLANG_MCALL getBufferSize() override { return mData.size(); }
+
+        private:
+            std::atomic<uint32_t> mRefCount = 0;
+            std::vector<uint8_t> mData;
+        };
+
+        /** Hash the contents of a shader file. Hashes are memoized by file path, size and modification time,
+            since the same include files are shared by most programs. The full resolution of the file system
+            timestamp is used, the one second resolution of time_t would miss edits in quick succession.
+        */
+        ShaderCache::Key hashShaderFile(const std::string& path)
+        {
+            struct FileState
+            {
+                uintmax_t size;
+                std::filesystem::file_time_type writeTime;
+
+                bool operator==(const FileState& other) const { return size == other.size && writeTime == other.writeTime; }
+            };
+
+            static std::mutex mutex;
+            static std::unordered_map<std::string, std::pair<FileState, ShaderCache::Key>> hashes;
+
+            std::error_code sizeError, timeError;
+            FileState state = { std::filesystem::file_size(path, sizeError), std::filesystem::last_write_time(path, timeError) };
+            const bool memoize = !sizeError && !timeError;
+
+            if (memoize)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = hashes.find(path);
+                if (it != hashes.end() && it->second.first == state) return it->second.second;
+            }
+
+            ShaderCache::KeyBuilder builder;
+            MappedFile file;
+            if (mapFile(path, file))
+            {
+                builder.addBytes(file.pData, file.size);
+                unmapFile(file);
+            }
+            else
+            {
+                // Make sure that unreadable dependencies never produce the key of an existing file.
+                builder.add(std::string("<unreadable>") + path);
+            }
+
+            if (memoize)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                hashes[path] = { state, builder.getKey() };
+            }
+            return builder.getKey();
+        }
+    }
+
     static Shader::SharedPtr createShaderFromBlob(const Shader::Blob& shaderBlob, ShaderType shaderType, const std::string& entryPointName, Shader::CompilerFlags flags, std::string& log)
     {
         std::string errorMsg;
@@ -320,23 +576,76 @@ namespace Falcor
         return false;
     }
 
+    /** State of a program version compiled on a compile thread.
+        The result fields are written by the compile thread before `done` is set.
+    */
+    struct Program::PendingVersion
+    {
+        ProgramVersion::SharedPtr pVersion;
+        string_time_map dependencies;
+        std::string log;
+
+        std::atomic<bool> done = false;
+        std::mutex mutex;
+        std::condition_variable condition;
+
+        void finish()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+            }
+            condition.notify_all();
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return done.load(); });
+        }
+    };
+
     const ProgramVersion::SharedConstPtr& Program::getActiveVersion() const
     {
+        if (!mPrewarmed) prewarm();
+
         if (mLinkRequired)
         {
             const auto& it = mProgramVersions.find(mDefineList);
             if (it == mProgramVersions.end())
             {
+                auto pendingIt = mPendingVersions.find(mDefineList);
+                if (pendingIt == mPendingVersions.end() && sAsyncCompilation && mpActiveVersion)
+                {
+                    compileAsync(mDefineList);
+                    pendingIt = mPendingVersions.find(mDefineList);
+                }
+
+                if (pendingIt != mPendingVersions.end())
+                {
+                    // Keep using the last good version while the new one is compiling.
+                    // mLinkRequired stays set, so we check again on the next call.
+                    if (sAsyncCompilation && mpActiveVersion && !pendingIt->second->done)
+                    {
+                        updateCompileStats([](CompileStats& stats) { stats.staleVersionsUsed++; });
+                        return mpActiveVersion;
+                    }
+
+                    auto pPending = pendingIt->second;
+                    mPendingVersions.erase(pendingIt);
+                    if (adoptPendingVersion(pPending))
+                    {
+                        mLinkRequired = false;
+                        return mpActiveVersion;
+                    }
+                }
+
                 // Note that link() updates mActiveProgram only if the operation was successful.
                 // On error we get false, and mActiveProgram points to the last successfully compiled version.
                 if (link() == false)
                 {
                     throw std::exception("Program linkage failed");
                 }
-                else
-                {
-                    mProgramVersions[mDefineList] = mpActiveVersion;
-                }
             }
             else
             {
@@ -348,17 +657,117 @@ namespace Falcor
         return mpActiveVersion;
     }
 
-    slang::IGlobalSession* createSlangGlobalSession()
+    void Program::compileAsync(const DefineList& defineList) const
     {
-        slang::IGlobalSession* result = nullptr;
-        slang::createGlobalSession(&result);
-        return result;
+        if (mProgramVersions.find(defineList) != mProgramVersions.end()) return;
+        if (mPendingVersions.find(defineList) != mPendingVersions.end()) return;
+
+        auto pPending = std::make_shared<PendingVersion>();
+        mPendingVersions[defineList] = pPending;
+
+        // The job holds a reference to the program, so it stays alive until the compilation is done.
+        // The global defines are captured here, as they may change on the render thread during compilation.
+        auto pProgram = shared_from_this();
+        CompileQueue::get().enqueue([pProgram, pPending, defineList, globalDefineList = sGlobalDefineList](bool cancel)
+        {
+            // Cancelled versions are compiled synchronously if they are used after all (see adoptPendingVersion()).
+            if (cancel)
+            {
+                pPending->finish();
+                return;
+            }
+
+            pPending->pVersion = pProgram->preprocessAndCreateProgramVersion(defineList, globalDefineList, pPending->dependencies, pPending->log);
+            if (pPending->pVersion)
+            {
+                updateCompileStats([](CompileStats& stats) { stats.versionsCompiledAsync++; });
+
+                // Versions without specialization parameters always use the same kernels, so we can generate their code right away.
+                // Versions with specialization parameters need the arguments from the vars, they are specialized on first use.
+                const ProgramVersion* pVersion = pPending->pVersion.get();
+                if (pVersion->getSlangGlobalScope()->getSpecializationParamCount() == 0)
+                {
+                    auto pKernelCode = std::make_unique<ProgramVersion::KernelCode>();
+                    if (pProgram->compileKernelCode(pVersion, {}, *pKernelCode, pPending->log))
+                    {
+                        pVersion->mpPrecompiledKernelCode = std::move(pKernelCode);
+                        updateCompileStats([](CompileStats& stats) { stats.kernelsCompiledAsync++; });
+                    }
+                }
+            }
+            pPending->finish();
+        });
+    }
+
+    bool Program::isCompiling() const
+    {
+        for (const auto& it : mPendingVersions)
+        {
+            if (!it.second->done) return true;
+        }
+        return false;
+    }
+
+    bool Program::isActiveVersionPending() const
+    {
+        if (!mLinkRequired) return false;
+        auto it = mPendingVersions.find(mDefineList);
+        return it != mPendingVersions.end() && !it->second->done;
+    }
+
+    bool Program::adoptPendingVersion(const std::shared_ptr<PendingVersion>& pPending) const
+    {
+        if (!pPending->done)
+        {
+            CompileStall stall;
+            pPending->wait();
+        }
+
+        mFileTimeMap.insert(pPending->dependencies.begin(), pPending->dependencies.end());
+
+        // On failure, the caller recompiles synchronously to report the errors.
+        if (!pPending->pVersion) return false;
+
+        if (!pPending->log.empty())
+        {
+            std::string warn = "Warnings in program:\n" + getProgramDescString() + "\n" + pPending->log;
+            logWarning(warn);
+        }
+
+        addVersion(pPending->pVersion);
+        return true;
+    }
+
+    void Program::addVersion(const ProgramVersion::SharedPtr& pVersion) const
+    {
+        const auto& defineList = pVersion->getDefines();
+        mProgramVersions[defineList] = pVersion;
+        mpActiveVersion = pVersion;
+
+        if (sRecordPermutations)
+        {
+            // Programs created from strings can't be identified reliably across runs.
+            bool hasStringSource = std::any_of(mDesc.mSources.begin(), mDesc.mSources.end(), [](const Desc::Source& src) { return src.type == Desc::Source::Type::String; });
+            if (!hasStringSource) sRecordedPermutations[getPermutationKey()].insert(defineList);
+        }
+    }
+
+    void Program::prewarm() const
+    {
+        mPrewarmed = true;
+        auto it = sPrewarmPermutations.find(getPermutationKey());
+        if (it == sPrewarmPermutations.end()) return;
+        for (const auto& defineList : it->second) compileAsync(defineList);
+    }
+
+    std::string Program::getPermutationKey() const
+    {
+        return getProgramDescString() + " sm_" + mDesc.mShaderModel + " flags " + std::to_string((uint32_t)mDesc.getCompilerFlags());
     }
 
     slang::IGlobalSession* getSlangGlobalSession()
     {
-        static slang::IGlobalSession* pSlangGlobalSession = createSlangGlobalSession();
-        return pSlangGlobalSession;
+        return getSlangContext()->pGlobalSession;
     }
 
     // Translation a Falcor `ShaderType` to the corresponding `SlangStage`
@@ -416,7 +825,8 @@ namespace Falcor
     }
 
     SlangCompileRequest* Program::createSlangCompileRequest(
-        const DefineList& defineList) const
+        const DefineList& defineList,
+        const DefineList& globalDefineList) const
     {
         slang::IGlobalSession* pSlangGlobalSession = getSlangGlobalSession();
         assert(pSlangGlobalSession);
@@ -477,13 +887,13 @@ namespace Falcor
         };
 
         // Add global defines.
-        for (const auto& shaderDefine : sGlobalDefineList)
+        for (const auto& shaderDefine : globalDefineList)
         {
             addSlangDefine(shaderDefine.first.c_str(), shaderDefine.second.c_str());
         }
 
         // Add program specific defines.
-        for (const auto& shaderDefine : getDefineList())
+        for (const auto& shaderDefine : defineList)
         {
             addSlangDefine(shaderDefine.first.c_str(), shaderDefine.second.c_str());
         }
@@ -512,8 +922,6 @@ namespace Falcor
             pSlangSession.writeRef());
         assert(pSlangSession);
 
-        mFileTimeMap.clear();
-
         SlangCompileRequest* pSlangRequest = nullptr;
         pSlangSession->createCompileRequest(
             &pSlangRequest);
@@ -643,22 +1051,19 @@ namespace Falcor
         return failed ? nullptr : pSpecializedSlangProgram;
     }
 
-    ProgramKernels::SharedPtr Program::preprocessAndCreateProgramKernels(
-        ProgramVersion const* pVersion,
-        ProgramVars    const* pVars,
-        std::string         & log) const
+    bool Program::compileKernelCode(
+        ProgramVersion const*                       pVersion,
+        ParameterBlock::SpecializationArgs const&   specializationArgs,
+        ProgramVersion::KernelCode                & kernelCode,
+        std::string                               & log) const
     {
+        // The Slang objects of the version belong to the global session it was compiled with.
+        auto lock = pVersion->lockSlangSession();
+
         auto pSlangGlobalScope = pVersion->getSlangGlobalScope();
         auto pSlangSession = pSlangGlobalScope->getSession();
 
-        // Global-scope specialization parameters apply to all the entry points
-        // in a `Program`. We will collect the arguments for global specialization
-        // parameters here, using the global `ProgramVars`.
-        //
-        ParameterBlock::SpecializationArgs specializationArgs;
-        pVars->collectSpecializationArgs(specializationArgs);
-
-        // Next we instruct Slang to specialize the global scope based on
+        // We instruct Slang to specialize the global scope based on
         // the global specialization arguments.
         //
         ComPtr<slang::IComponentType> pSpecializedSlangGlobalScope = doSlangSpecialization(
@@ -667,7 +1072,7 @@ namespace Falcor
             log);
         if (!pSpecializedSlangGlobalScope)
         {
-            return nullptr;
+            return false;
         }
 
         uint32_t allEntryPointCount = uint32_t(mDesc.mEntryPoints.size());
@@ -749,32 +1154,95 @@ namespace Falcor
                 pSpecializedSlangProgram.writeRef());
         }
 
-        ProgramReflection::SharedPtr pReflector;
-        doSlangReflection(pVersion, pSpecializedSlangProgram, pLinkedEntryPoints, pReflector, log);
+        doSlangReflection(pVersion, pSpecializedSlangProgram, pLinkedEntryPoints, kernelCode.pReflector, log);
 
-        // Create Shader objects for each entry point and cache them here
-        std::vector<Shader::SharedPtr> allShaders;
+        // Reflection always comes from the Slang front-end, since `ProgramReflection` refers to Slang's layout objects.
+        // Only the back-end code generation is skipped for kernels found in the shader cache.
+        // Programs compiled with DumpIntermediates always run the back-end, as the intermediates are a side effect of it.
+        ShaderCache::SharedPtr pShaderCache = is_set(mDesc.getCompilerFlags(), Shader::CompilerFlags::DumpIntermediates) ? nullptr : getShaderCache();
+
+        std::string specializationKey;
+        for (const auto& specializationArg : specializationArgs)
+        {
+            specializationKey += std::string(specializationArg.type->getName()) + ",";
+        }
+
+        // Generate the code for each entry point
+        kernelCode.blobs.clear();
         for (uint32_t i = 0; i < allEntryPointCount; i++)
         {
             auto pLinkedEntryPoint = pLinkedEntryPoints[i];
-            auto entryPointDesc = mDesc.mEntryPoints[i];
 
+            // Look up the kernel code in the shader cache before invoking the compiler back-end.
+            // The key extends the version key with the specialization arguments and the entry point.
             Shader::Blob blob;
-            ComPtr<slang::IBlob> pSlangDiagnostics;
-            bool failed = SLANG_FAILED(pLinkedEntryPoint->getEntryPointCode(
-                /* entryPointIndex: */ 0,
-                /* targetIndex: */ 0,
-                blob.writeRef(),
-                pSlangDiagnostics.writeRef()));
-
-            if (pSlangDiagnostics && pSlangDiagnostics->getBufferSize() > 0)
+            ShaderCache::Key kernelKey = ShaderCache::KeyBuilder().add(pVersion->mCacheKey).add(specializationKey).add(i).getKey();
+            std::vector<uint8_t> cachedCode;
+            if (pShaderCache && pShaderCache->load(kernelKey, cachedCode))
             {
-                log += (char const*)pSlangDiagnostics->getBufferPointer();
+                blob = new CachedBlob(std::move(cachedCode));
             }
+            else
+            {
+                ComPtr<slang::IBlob> pSlangDiagnostics;
+                bool failed = SLANG_FAILED(pLinkedEntryPoint->getEntryPointCode(
+                    /* entryPointIndex: */ 0,
+                    /* targetIndex: */ 0,
+                    blob.writeRef(),
+                    pSlangDiagnostics.writeRef()));
+
+                if (pSlangDiagnostics && pSlangDiagnostics->getBufferSize() > 0)
+                {
+                    log += (char const*)pSlangDiagnostics->getBufferPointer();
+                }
+
+                if (failed) return false;
 
-            if (failed) return nullptr;
+                if (pShaderCache) pShaderCache->store(kernelKey, blob->getBufferPointer(), blob->getBufferSize());
+            }
+
+            kernelCode.blobs.push_back(blob);
+        }
 
-            Shader::SharedPtr shader = createShaderFromBlob(blob, entryPointDesc.stage, entryPointDesc.name, mDesc.getCompilerFlags(), log);
+        return true;
+    }
+
+    ProgramKernels::SharedPtr Program::preprocessAndCreateProgramKernels(
+        ProgramVersion const* pVersion,
+        ProgramVars    const* pVars,
+        std::string         & log) const
+    {
+        // Global-scope specialization parameters apply to all the entry points
+        // in a `Program`. We will collect the arguments for global specialization
+        // parameters here, using the global `ProgramVars`.
+        //
+        ParameterBlock::SpecializationArgs specializationArgs;
+        pVars->collectSpecializationArgs(specializationArgs);
+
+        // Use the kernel code generated on a compile thread if there is any,
+        // otherwise we have to generate it now.
+        ProgramVersion::KernelCode kernelCode;
+        if (specializationArgs.empty() && pVersion->mpPrecompiledKernelCode)
+        {
+            kernelCode = std::move(*pVersion->mpPrecompiledKernelCode);
+            pVersion->mpPrecompiledKernelCode.reset();
+        }
+        else
+        {
+            CompileStall stall;
+            if (!compileKernelCode(pVersion, specializationArgs, kernelCode, log)) return nullptr;
+            updateCompileStats([](CompileStats& stats) { stats.kernelsCompiled++; });
+        }
+
+        const auto& pReflector = kernelCode.pReflector;
+
+        // Create Shader objects for each entry point and cache them here
+        std::vector<Shader::SharedPtr> allShaders;
+        for (uint32_t i = 0; i < uint32_t(mDesc.mEntryPoints.size()); i++)
+        {
+            auto entryPointDesc = mDesc.mEntryPoints[i];
+
+            Shader::SharedPtr shader = createShaderFromBlob(kernelCode.blobs[i], entryPointDesc.stage, entryPointDesc.name, mDesc.getCompilerFlags(), log);
             if (!shader) return nullptr;
 
             allShaders.push_back(std::move(shader));
@@ -834,9 +1302,16 @@ namespace Falcor
     }
 
     ProgramVersion::SharedPtr Program::preprocessAndCreateProgramVersion(
-        std::string& log) const
+        DefineList  const& defineList,
+        DefineList  const& globalDefineList,
+        string_time_map  & dependencies,
+        std::string      & log) const
     {
-        auto pSlangRequest = createSlangCompileRequest(mDefineList);
+        // Everything we create from here on belongs to the global session of the calling thread.
+        SlangContext::SharedPtr pSlangContext = getSlangContext();
+        std::lock_guard<std::mutex> lock(pSlangContext->mutex);
+
+        auto pSlangRequest = createSlangCompileRequest(defineList, globalDefineList);
         if (pSlangRequest == nullptr) return nullptr;
 
         SlangResult slangResult = spCompile(pSlangRequest);
@@ -874,9 +1349,11 @@ namespace Falcor
         for (int ii = 0; ii < depFileCount; ++ii)
         {
             std::string depFilePath = spGetDependencyFilePath(pSlangRequest, ii);
-            mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            dependencies[depFilePath] = getFileModifiedTime(depFilePath);
         }
 
+        ShaderCache::Key cacheKey = computeVersionCacheKey(defineList, globalDefineList, dependencies);
+
         // Note: the `ProgramReflection` needs to be able to refer back to the
         // `ProgramVersion`, but the `ProgramVersion` can't be initialized
         // until we have its reflection. We cut that dependency knot by
@@ -911,14 +1388,59 @@ namespace Falcor
         }
 
         pVersion->init(
-            mDefineList,
+            defineList,
             pReflector,
             getProgramDescString(),
             pSlangEntryPoints);
+        pVersion->mCacheKey = cacheKey;
+        pVersion->mpSlangContext = pSlangContext;
 
         return pVersion;
     }
 
+    ShaderCache::Key Program::computeVersionCacheKey(const DefineList& defineList, const DefineList& globalDefineList, const string_time_map& dependencies) const
+    {
+        ShaderCache::KeyBuilder builder;
+
+        // Compiler versions and target.
+        builder.add(ShaderCache::kVersion);
+        builder.add(spGetBuildTagString());
+
+        slang::TargetDesc targetDesc;
+        const char* targetMacroName = nullptr;
+        setUpSlangCompilationTarget(targetDesc, targetMacroName);
+        builder.add((uint32_t)targetDesc.format);
+        builder.add(targetMacroName);
+        builder.add(mDesc.mShaderModel);
+        builder.add((uint32_t)mDesc.getCompilerFlags());
+
+        // Defines.
+        for (const auto& define : globalDefineList) builder.add(define.first).add(define.second);
+        builder.add(std::string("<program defines>"));
+        for (const auto& define : defineList) builder.add(define.first).add(define.second);
+
+        // Sources and entry points. The contents of source files are covered by the dependencies below.
+        for (const auto& src : mDesc.mSources)
+        {
+            builder.add((uint32_t)src.type);
+            builder.add(src.type == Desc::Source::Type::File ? src.pLibrary->getFilename() : src.str);
+        }
+        for (const auto& entryPoint : mDesc.mEntryPoints)
+        {
+            builder.add(entryPoint.name).add((uint32_t)entryPoint.stage).add(entryPoint.sourceIndex);
+        }
+
+        // Contents of all files referenced by the program, including includes and imported modules.
+        std::vector<std::pair<std::string, time_t>> sortedDependencies(dependencies.begin(), dependencies.end());
+        std::sort(sortedDependencies.begin(), sortedDependencies.end());
+        for (const auto& dependency : sortedDependencies)
+        {
+            builder.add(dependency.first).add(hashShaderFile(dependency.first));
+        }
+
+        return builder.getKey();
+    }
+
     EntryPointGroupKernels::SharedPtr Program::createEntryPointGroupKernels(
         const std::vector<Shader::SharedPtr>& shaders,
         EntryPointBaseReflection::SharedPtr const& pReflector) const
@@ -932,7 +1454,11 @@ namespace Falcor
         {
             // Create the program
             std::string log;
-            auto pVersion = preprocessAndCreateProgramVersion(log);
+            ProgramVersion::SharedPtr pVersion;
+            {
+                CompileStall stall;
+                pVersion = preprocessAndCreateProgramVersion(mDefineList, sGlobalDefineList, mFileTimeMap, log);
+            }
 
             if (pVersion == nullptr)
             {
@@ -949,7 +1475,8 @@ namespace Falcor
                     logWarning(warn);
                 }
 
-                mpActiveVersion = pVersion;
+                updateCompileStats([](CompileStats& stats) { stats.versionsCompiled++; });
+                addVersion(pVersion);
                 return true;
             }
         }
@@ -957,8 +1484,10 @@ namespace Falcor
 
     void Program::reset()
     {
+        // Versions still compiling are discarded when they finish.
         mpActiveVersion = nullptr;
         mProgramVersions.clear();
+        mPendingVersions.clear();
         mFileTimeMap.clear();
         mLinkRequired = true;
     }
@@ -1037,8 +1566,175 @@ namespace Falcor
         reloadAllPrograms(true);
     }
 
+    void Program::setShaderCache(const ShaderCache::SharedPtr& pCache)
+    {
+        std::lock_guard<std::mutex> lock(sShaderCacheMutex);
+        sShaderCache = pCache;
+        sShaderCacheInitialized = true;
+    }
+
+    ShaderCache::SharedPtr Program::getShaderCache()
+    {
+        std::lock_guard<std::mutex> lock(sShaderCacheMutex);
+        if (!sShaderCacheInitialized)
+        {
+            sShaderCache = ShaderCache::create(getAppDataDirectory() + "/Falcor/ShaderCache");
+            sShaderCacheInitialized = true;
+        }
+        return sShaderCache;
+    }
+
+    void Program::setAsyncCompilation(bool enabled)
+    {
+        sAsyncCompilation = enabled;
+    }
+
+    bool Program::isAsyncCompilationEnabled()
+    {
+        return sAsyncCompilation;
+    }
+
+    void Program::shutdownCompileThreads()
+    {
+        CompileQueue::get().shutdown();
+    }
+
+    Program::CompileStats Program::getCompileStats()
+    {
+        std::lock_guard<std::mutex> lock(sCompileStatsMutex);
+        return sCompileStats;
+    }
+
+    void Program::resetCompileStats()
+    {
+        std::lock_guard<std::mutex> lock(sCompileStatsMutex);
+        sCompileStats = CompileStats();
+    }
+
+    void Program::setPermutationRecording(bool enabled)
+    {
+        sRecordPermutations = enabled;
+    }
+
+    bool Program::savePermutations(const std::string& filename)
+    {
+        using namespace rapidjson;
+
+        Document document(kObjectType);
+        auto& allocator = document.GetAllocator();
+        auto makeString = [&allocator](const std::string& str) { return Value(str.c_str(), (SizeType)str.size(), allocator); };
+
+        Value programs(kArrayType);
+        for (const auto& [key, defineLists] : sRecordedPermutations)
+        {
+            Value permutations(kArrayType);
+            for (const auto& defineList : defineLists)
+            {
+                Value defines(kObjectType);
+                for (const auto& [name, value] : defineList) defines.AddMember(makeString(name), makeString(value), allocator);
+                permutations.PushBack(defines, allocator);
+            }
+
+            Value program(kObjectType);
+            program.AddMember("program", makeString(key), allocator);
+            program.AddMember("permutations", permutations, allocator);
+            programs.PushBack(program, allocator);
+        }
+
+        document.AddMember("version", kPermutationFileVersion, allocator);
+        document.AddMember("programs", programs, allocator);
+
+        StringBuffer buffer;
+        PrettyWriter<StringBuffer> writer(buffer);
+        document.Accept(writer);
+
+        std::ofstream file(filename);
+        file << buffer.GetString();
+        if (file.fail())
+        {
+            logWarning("Failed to write program permutations to '" + filename + "'.");
+            return false;
+        }
+        return true;
+    }
+
+    bool Program::loadPermutations(const std::string& filename)
+    {
+        using namespace rapidjson;
+
+        std::string fullpath;
+        if (!findFileInDataDirectories(filename, fullpath))
+        {
+            logWarning("Can't find program permutations file '" + filename + "'.");
+            return false;
+        }
+
+        Document document;
+        document.Parse(readFile(fullpath).c_str());
+        if (document.HasParseError() || !document.IsObject() || !document.HasMember("version") || !document["version"].IsUint() ||
+            document["version"].GetUint() != kPermutationFileVersion || !document.HasMember("programs") || !document["programs"].IsArray())
+        {
+            logWarning("Invalid program permutations file '" + filename + "'.");
+            return false;
+        }
+
+        size_t permutationCount = 0;
+        const auto& programs = document["programs"];
+        for (SizeType i = 0; i < programs.Size(); i++)
+        {
+            const auto& program = programs[i];
+            if (!program.IsObject() || !program.HasMember("program") || !program["program"].IsString() || !program.HasMember("permutations") || !program["permutations"].IsArray()) continue;
+
+            auto& permutations = sPrewarmPermutations[program["program"].GetString()];
+            const auto& permutationList = program["permutations"];
+            for (SizeType j = 0; j < permutationList.Size(); j++)
+            {
+                const auto& defines = permutationList[j];
+                if (!defines.IsObject()) continue;
+                DefineList defineList;
+                for (auto it = defines.MemberBegin(); it != defines.MemberEnd(); it++)
+                {
+                    if (it->value.IsString()) defineList.add(it->name.GetString(), it->value.GetString());
+                }
+                permutations.insert(defineList);
+                permutationCount++;
+            }
+        }
+
+        // Programs that already exist start prewarming right away, others on first use.
+        for (const auto& pWeakProgram : sPrograms)
+        {
+            if (auto pProgram = pWeakProgram.lock()) pProgram->prewarm();
+        }
+
+        logInfo("Loaded " + std::to_string(permutationCount) + " program permutations from '" + filename + "'.");
+        return true;
+    }
+
     SCRIPT_BINDING(Program)
     {
         pybind11::class_<Program, Program::SharedPtr>(m, "Program");
+
+        auto getCompileStats = []()
+        {
+            auto stats = Program::getCompileStats();
+            pybind11::dict d;
+            d["versionsCompiled"] = stats.versionsCompiled;
+            d["versionsCompiledAsync"] = stats.versionsCompiledAsync;
+            d["kernelsCompiled"] = stats.kernelsCompiled;
+            d["kernelsCompiledAsync"] = stats.kernelsCompiledAsync;
+            d["staleVersionsUsed"] = stats.staleVersionsUsed;
+            d["stalls"] = stats.stalls;
+            d["stallTime"] = stats.stallTime;
+            d["maxStallTime"] = stats.maxStallTime;
+            return d;
+        };
+
+        m.def("setAsyncShaderCompilation", &Program::setAsyncCompilation, "enabled"_a);
+        m.def("getShaderCompileStats", getCompileStats);
+        m.def("resetShaderCompileStats", &Program::resetCompileStats);
+        m.def("recordShaderPermutations", &Program::setPermutationRecording, "enabled"_a = true);
+        m.def("saveShaderPermutations", &Program::savePermutations, "filename"_a);
+        m.def("loadShaderPermutations", &Program::loadPermutations, "filename"_a);
     }
 }
@@ -157,13 +157,45 @@ namespace Falcor
 #endif
         };
 
+        /** Shader compilation statistics, accumulated over all programs.
+        */
+        struct CompileStats
+        {
+            uint64_t versionsCompiled = 0;          ///< Number of program versions compiled synchronously on the calling thread.
+            uint64_t versionsCompiledAsync = 0;     ///< Number of program versions compiled on the compile threads.
+            uint64_t kernelsCompiled = 0;           ///< Number of program kernels compiled synchronously on the calling thread.
+            uint64_t kernelsCompiledAsync = 0;      ///< Number of program kernels compiled on the compile threads.
+            uint64_t staleVersionsUsed = 0;         ///< Number of times the previous version was used because the requested one was still compiling.
+            uint64_t stalls = 0;                    ///< Number of times the calling thread had to wait for compilation.
+            double stallTime = 0.0;                 ///< Total time in seconds spent waiting for compilation.
+            double maxStallTime = 0.0;              ///< Longest single wait for compilation in seconds.
+        };
+
         virtual ~Program() = 0;
 
         /** Get the API handle of the active program.
+            If the active defines changed and the matching version is not compiled yet, it is compiled synchronously,
+            unless asynchronous compilation is enabled (see setAsyncCompilation()) and a previous version exists.
+            In that case the version is compiled on a compile thread and the previously active version is returned until it is ready.
             \return The active program version, or an exception is thrown on failure.
         */
         const ProgramVersion::SharedConstPtr& getActiveVersion() const;
 
+        /** Start compiling the program version for a set of defines on a compile thread.
+            Does nothing if the version is already compiled or compiling.
+            \param[in] defineList The program defines of the version.
+        */
+        void compileAsync(const DefineList& defineList) const;
+
+        /** Check if any program version is being compiled on the compile threads.
+        */
+        bool isCompiling() const;
+
+        /** Check if the active defines changed and the matching version is still being compiled.
+            In that case getActiveVersion() returns a previous version.
+        */
+        bool isActiveVersionPending() const;
+
         /** Adds a macro definition to the program. If the macro already exists, it will be replaced.
             \param[in] name The name of define.
             \param[in] value Optional. The value of the define string.
@@ -223,6 +255,60 @@ namespace Falcor
         */
         static void removeGlobalDefines(const DefineList& defineList);
 
+        /** Set the persistent shader cache used by all programs.
+            By default, a cache is created in the application data directory on first use.
+            \param[in] pCache The shader cache, or nullptr to disable caching of compiled kernels.
+        */
+        static void setShaderCache(const ShaderCache::SharedPtr& pCache);
+
+        /** Get the persistent shader cache used by all programs.
+            \return The shader cache, or nullptr if caching is disabled.
+        */
+        static ShaderCache::SharedPtr getShaderCache();
+
+        /** Enable or disable asynchronous compilation of program versions. Disabled by default.
+            When enabled, changing the defines of a program that already has an active version does not stall, see getActiveVersion().
+            Note that the reflection of the active version changes when the new version becomes active, so passes that create
+            their vars from the reflection need to recreate them when the version changes.
+        */
+        static void setAsyncCompilation(bool enabled);
+
+        /** Check if asynchronous compilation of program versions is enabled.
+        */
+        static bool isAsyncCompilationEnabled();
+
+        /** Stop the compile threads. Versions that are still queued are not compiled, running compilations are waited for.
+            Versions requested afterwards are compiled synchronously. Must be called before the device is destroyed.
+        */
+        static void shutdownCompileThreads();
+
+        /** Get the shader compilation statistics.
+        */
+        static CompileStats getCompileStats();
+
+        /** Reset the shader compilation statistics.
+        */
+        static void resetCompileStats();
+
+        /** Start or stop recording the program permutations that are compiled.
+            The recorded permutations can be saved with savePermutations() and used to prewarm later runs with loadPermutations().
+        */
+        static void setPermutationRecording(bool enabled);
+
+        /** Save the recorded program permutations to a file.
+            \param[in] filename Output filename.
+            \return True if the file was written.
+        */
+        static bool savePermutations(const std::string& filename);
+
+        /** Load a list of program permutations to prewarm.
+            Whenever a program listed in the file is used, all its listed permutations are compiled on the compile threads.
+            Programs that already exist start compiling their permutations right away.
+            \param[in] filename Filename of a file written by savePermutations().
+            \return True if the file was loaded.
+        */
+        static bool loadPermutations(const std::string& filename);
+
         /** Get the program reflection for the active program.
             \return Program reflection object, or an exception is thrown on failure.
         */
@@ -242,10 +328,19 @@ namespace Falcor
 
         void init(Desc const& desc, DefineList const& programDefines);
 
+        struct PendingVersion;
+        using string_time_map = std::unordered_map<std::string, time_t>;
+
         bool link() const;
 
+        bool adoptPendingVersion(const std::shared_ptr<PendingVersion>& pPending) const;
+        void addVersion(const ProgramVersion::SharedPtr& pVersion) const;
+        void prewarm() const;
+        std::string getPermutationKey() const;
+
         SlangCompileRequest* createSlangCompileRequest(
-            DefineList  const& defineList) const;
+            DefineList  const& defineList,
+            DefineList  const& globalDefineList) const;
 
         virtual void setUpSlangCompilationTarget(
             slang::TargetDesc&  ioTargetDesc,
@@ -258,13 +353,23 @@ namespace Falcor
             ProgramReflection::SharedPtr&               pReflector,
             std::string&                                log) const;
 
-        ProgramVersion::SharedPtr preprocessAndCreateProgramVersion(std::string& log) const;
+        ProgramVersion::SharedPtr preprocessAndCreateProgramVersion(
+            DefineList  const& defineList,
+            DefineList  const& globalDefineList,
+            string_time_map  & dependencies,
+            std::string      & log) const;
 
         ProgramKernels::SharedPtr preprocessAndCreateProgramKernels(
             ProgramVersion const* pVersion,
             ProgramVars    const* pVars,
             std::string         & log) const;
 
+        bool compileKernelCode(
+            ProgramVersion const*                        pVersion,
+            std::vector<slang::SpecializationArg> const& specializationArgs,
+            ProgramVersion::KernelCode                 & kernelCode,
+            std::string                                & log) const;
+
         virtual EntryPointGroupKernels::SharedPtr createEntryPointGroupKernels(
             const std::vector<Shader::SharedPtr>& shaders,
             EntryPointGroupReflection::SharedPtr const& pReflector) const;
@@ -284,15 +389,18 @@ namespace Falcor
         // We are doing lazy compilation, so these are mutable
         mutable bool mLinkRequired = true;
         mutable std::map<DefineList, ProgramVersion::SharedConstPtr> mProgramVersions;
+        mutable std::map<DefineList, std::shared_ptr<PendingVersion>> mPendingVersions;
         mutable ProgramVersion::SharedConstPtr mpActiveVersion;
+        mutable bool mPrewarmed = false;
         void markDirty() { mLinkRequired = true; }
 
         std::string getProgramDescString() const;
         static std::vector<std::weak_ptr<Program>> sPrograms;
 
-        using string_time_map = std::unordered_map<std::string, time_t>;
         mutable string_time_map mFileTimeMap;
 
+        ShaderCache::Key computeVersionCacheKey(const DefineList& defineList, const DefineList& globalDefineList, const string_time_map& dependencies) const;
+
         bool checkIfFilesChanged();
         void reset();
     };
@@ -73,7 +73,31 @@ namespace Falcor
 
     TypedShaderVarOffset TypedShaderVarOffset::operator[](size_t index) const
     {
-        throw 99;
+        if (!isValid()) return *this;
+
+        auto pType = getType();
+
+        if (auto pArrayType = pType->asArrayType())
+        {
+            auto elementCount = pArrayType->getElementCount();
+            if (!elementCount || index < elementCount)
+            {
+                UniformShaderVarOffset elementUniformLocation = getUniform() + index * pArrayType->getElementByteStride();
+                ResourceShaderVarOffset elementResourceLocation(getResource().getRangeIndex(), getResource().getArrayIndex() * elementCount + ResourceShaderVarOffset::ArrayIndex(index));
+                return TypedShaderVarOffset(pArrayType->getElementType().get(), ShaderVarOffset(elementUniformLocation, elementResourceLocation));
+            }
+        }
+        else if (auto pStructType = pType->asStructType())
+        {
+            if (index < pStructType->getMemberCount())
+            {
+                auto pMember = pStructType->getMember(index);
+                return TypedShaderVarOffset(pMember->getType().get(), (*this) + pMember->getBindLocation());
+            }
+        }
+
+        logError("No element or member found at index " + std::to_string(index));
+        return TypedShaderVarOffset();
     }
 
     TypedShaderVarOffset ReflectionType::getZeroOffset() const
@@ -2252,6 +2276,7 @@ namespace Falcor
         if( iter != mMapNameToType.end() )
             return iter->second;
 
+        auto lock = mpProgramVersion->lockSlangSession();
         auto pSlangType = mpSlangReflector->findTypeByName(name.c_str());
         if (!pSlangType) return nullptr;
         auto pSlangTypeLayout = mpSlangReflector->getTypeLayout(pSlangType);
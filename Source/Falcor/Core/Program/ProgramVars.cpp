@@ -302,17 +302,16 @@ namespace Falcor
         return bindRootSetsCommon<forGraphics>(pVars, pContext, bindRootSig, pRootSignature);
     }
 
-    bool ProgramVars::updateSpecializationImpl() const
+    bool ProgramVars::updateSpecializationImpl(const SpecializationArgs& specializationArgs) const
     {
-        ParameterBlock::SpecializationArgs specializationArgs;
-        collectSpecializationArgs(specializationArgs);
         if( specializationArgs.size() == 0 )
         {
             mpSpecializedReflector = ParameterBlock::mpReflector;
             return false;
         }
 
-        // TODO: Want a caching step here, if possible...
+        // The specialized kernels are cached by the program version, and
+        // `updateSpecialization()` skips this call if the arguments are unchanged.
 
         auto pProgramKernels = mpProgramVersion->getKernels(this);
         mpSpecializedReflector = pProgramKernels->getReflector()->getDefaultParameterBlock();
@@ -79,7 +79,7 @@ namespace Falcor
         */
         const ProgramReflection::SharedConstPtr& getReflection() const { return mpReflector; }
 
-        virtual bool updateSpecializationImpl() const override;
+        virtual bool updateSpecializationImpl(const SpecializationArgs& specializationArgs) const override;
 
         uint32_t getEntryPointGroupCount() const { return uint32_t(mpEntryPointGroupVars.size()); }
         EntryPointGroupVars* getEntryPointGroupVars(uint32_t index) const
@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "Core/Program/ProgramReflection.h"
+#include "Core/Program/ShaderCache.h"
 #include "Core/API/Shader.h"
 #include "Core/API/RootSignature.h"
 
@@ -203,6 +204,18 @@ namespace Falcor
         RootSignature::SharedPtr mpRootSignature;
     };
 
+    /** Slang global session together with the lock that serializes its use.
+        Slang sessions are not thread-safe. The program versions compiled with a global session keep it alive,
+        and all calls into the Slang objects of a version must hold its lock (see ProgramVersion::lockSlangSession()).
+    */
+    struct SlangContext
+    {
+        using SharedPtr = std::shared_ptr<SlangContext>;
+
+        ComPtr<slang::IGlobalSession> pGlobalSession;
+        std::mutex mutex;
+    };
+
     class ProgramVersion : public std::enable_shared_from_this<ProgramVersion>
     {
     public:
@@ -210,6 +223,14 @@ namespace Falcor
         using SharedConstPtr = std::shared_ptr<const ProgramVersion>;
         using DefineList = Shader::DefineList;
 
+        /** Compiled code and specialized reflection of the kernels of a version for one set of specialization arguments.
+        */
+        struct KernelCode
+        {
+            ProgramReflection::SharedPtr pReflector;
+            std::vector<Shader::Blob> blobs;    ///< Code of each entry point.
+        };
+
         /** Get the program that this version was created from
         */
         std::shared_ptr<Program> getProgram() const { return mpProgram; }
@@ -235,9 +256,15 @@ namespace Falcor
         slang::IComponentType* getSlangGlobalScope() const;
         slang::IComponentType* getSlangEntryPoint(uint32_t index) const;
 
+        /** Lock the Slang session of this version. The lock must be held while calling into the Slang session or reflection of the version.
+            The session is never used by a compile thread once the version is published, so this doesn't wait for background compilation.
+        */
+        std::unique_lock<std::mutex> lockSlangSession() const { return std::unique_lock<std::mutex>(mpSlangContext->mutex); }
+
     protected:
         friend class Program;
         friend class RtProgram;
+        friend class ParameterBlock;
 
         static SharedPtr createEmpty(Program* pProgram, slang::IComponentType* pSlangGlobalScope);
 
@@ -250,13 +277,26 @@ namespace Falcor
             std::vector<ComPtr<slang::IComponentType>> const&   pSlangEntryPoints);
 
         std::shared_ptr<Program>        mpProgram;
+
+        // The Slang global session this version was compiled with. Declared before the Slang objects, so it is released after them.
+        SlangContext::SharedPtr         mpSlangContext;
+
         DefineList                      mDefines;
         ProgramReflection::SharedPtr    mpReflector;
         std::string                     mName;
         ComPtr<slang::IComponentType>   mpSlangGlobalScope;
         std::vector<ComPtr<slang::IComponentType>> mpSlangEntryPoints;
 
+        // Key identifying the inputs of this version in the persistent shader cache.
+        ShaderCache::Key                mCacheKey;
+
+        // Kernel code for the unspecialized version, compiled ahead of time on a compile thread.
+        mutable std::unique_ptr<KernelCode> mpPrecompiledKernelCode;
+
         // Cached version of compiled kernels for this program version
         mutable std::unordered_map<std::string, ProgramKernels::SharedPtr> mpKernels;
+
+        // Cached specialized parameter block layouts, keyed by element type and specialization arguments
+        mutable std::unordered_map<std::string, ParameterBlockReflection::SharedConstPtr> mSpecializedLayouts;
     };
 }
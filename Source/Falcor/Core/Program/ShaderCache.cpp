@@ -0,0 +1,315 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "ShaderCache.h"
+#include <filesystem>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace fs = std::filesystem;
+
+    namespace
+    {
+        const uint32_t kMagic = 0x43485346; // 'FSHC'
+        const std::string kEntryExtension = ".shadercache";
+        const std::string kTempExtension = ".tmp"; // Extension of files created with getUniqueTempFilename().
+
+        // Temporary files older than this are left over from crashed processes and removed during eviction.
+        const auto kStaleTempFileAge = std::chrono::minutes(10);
+
+        struct EntryHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            ShaderCache::Key key;
+            uint64_t payloadSize;
+            uint64_t payloadHash;
+        };
+    }
+
+    std::string ShaderCache::Key::toString() const
+    {
+        return toHexString(hash[0]) + toHexString(hash[1]);
+    }
+
+    ShaderCache::KeyBuilder::KeyBuilder()
+    {
+        // Independent seeds for the two halves of the key.
+        mState[0] = 0x243f6a8885a308d3ull;
+        mState[1] = 0x13198a2e03707344ull;
+    }
+
+    ShaderCache::KeyBuilder& ShaderCache::KeyBuilder::addBytes(const void* pData, size_t size)
+    {
+        // The two halves of the key hash the same data starting from different states.
+        // The second half additionally hashes the running state of the first, so the halves don't collide together.
+        mState[0] = hashBytes(pData, size, mState[0]);
+        mState[1] = hashBytes(pData, size, mState[1] ^ mState[0]);
+        mLength += size;
+        return *this;
+    }
+
+    ShaderCache::KeyBuilder& ShaderCache::KeyBuilder::add(const std::string& str)
+    {
+        uint64_t size = str.size();
+        addBytes(&size, sizeof(size));
+        return addBytes(str.data(), str.size());
+    }
+
+    ShaderCache::Key ShaderCache::KeyBuilder::getKey() const
+    {
+        Key key;
+        key.hash[0] = hashMix64(mState[0] ^ mLength);
+        key.hash[1] = hashMix64(mState[1] + mLength);
+        return key;
+    }
+
+    ShaderCache::SharedPtr ShaderCache::create(const std::string& directory, uint64_t maxSize)
+    {
+        return SharedPtr(new ShaderCache(directory, maxSize));
+    }
+
+    ShaderCache::ShaderCache(const std::string& directory, uint64_t maxSize)
+        : mDirectory(directory)
+        , mMaxSize(maxSize)
+    {
+        mEstimatedSize = getSize();
+    }
+
+    void ShaderCache::setMaxSize(uint64_t maxSize)
+    {
+        mMaxSize = maxSize;
+        if (mEstimatedSize > mMaxSize) evict();
+    }
+
+    std::string ShaderCache::getEntryFilename(const Key& key) const
+    {
+        return mDirectory + "/" + key.toString() + kEntryExtension;
+    }
+
+    bool ShaderCache::contains(const Key& key) const
+    {
+        std::error_code ec;
+        return fs::is_regular_file(getEntryFilename(key), ec);
+    }
+
+    bool ShaderCache::load(const Key& key, std::vector<uint8_t>& data)
+    {
+        std::string filename = getEntryFilename(key);
+
+        std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+        if (!stream.is_open())
+        {
+            mMisses++;
+            return false;
+        }
+
+        // Read the entire entry at once and close the file, so other processes can evict or replace it.
+        std::vector<uint8_t> entry((size_t)stream.tellg());
+        stream.seekg(0);
+        stream.read(reinterpret_cast<char*>(entry.data()), entry.size());
+        bool readFailed = stream.fail();
+        stream.close();
+
+        EntryHeader header;
+        bool valid = !readFailed && entry.size() >= sizeof(EntryHeader);
+        if (valid)
+        {
+            std::memcpy(&header, entry.data(), sizeof(EntryHeader));
+            const uint8_t* pPayload = entry.data() + sizeof(EntryHeader);
+            valid = header.magic == kMagic && header.version == kVersion && header.key == key &&
+                header.payloadSize == entry.size() - sizeof(EntryHeader) &&
+                header.payloadHash == hashBytes(pPayload, (size_t)header.payloadSize);
+        }
+
+        if (!valid)
+        {
+            logWarning("Removing invalid shader cache entry '" + filename + "'.");
+            removeEntry(filename);
+            mCorruptEntries++;
+            mMisses++;
+            return false;
+        }
+
+        data.assign(entry.begin() + sizeof(EntryHeader), entry.end());
+
+        // Mark the entry as recently used. This fails harmlessly if another process replaced or evicted it meanwhile.
+        std::error_code ec;
+        fs::last_write_time(filename, fs::file_time_type::clock::now(), ec);
+
+        mHits++;
+        return true;
+    }
+
+    bool ShaderCache::store(const Key& key, const void* pData, size_t size)
+    {
+        std::error_code ec;
+        if (!fs::is_directory(mDirectory, ec) && !fs::create_directories(mDirectory, ec) && !fs::is_directory(mDirectory, ec))
+        {
+            logWarning("Failed to create shader cache directory '" + mDirectory + "'.");
+            return false;
+        }
+
+        EntryHeader header;
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.key = key;
+        header.payloadSize = size;
+        header.payloadHash = hashBytes(pData, size);
+
+        // Write to a temporary file and rename it, so that other processes never see a partially written entry.
+        // If several processes store the same key concurrently, the entries are identical and the last rename wins.
+        std::string filename = getEntryFilename(key);
+        std::string tempFilename = getUniqueTempFilename(filename);
+        {
+            std::ofstream stream(tempFilename, std::ios::binary | std::ios::trunc);
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(reinterpret_cast<const char*>(pData), size);
+            stream.close();
+            if (stream.fail())
+            {
+                fs::remove(tempFilename, ec);
+                logWarning("Failed to write shader cache entry '" + tempFilename + "'.");
+                return false;
+            }
+        }
+
+        fs::rename(tempFilename, filename, ec);
+        if (ec)
+        {
+            fs::remove(tempFilename, ec);
+            logWarning("Failed to write shader cache entry '" + filename + "'.");
+            return false;
+        }
+
+        mStores++;
+
+        // Evict down to a bit below the limit, so that we don't scan the directory on every store once the cache is full.
+        uint64_t estimatedSize = mEstimatedSize.fetch_add(sizeof(header) + size) + sizeof(header) + size;
+        if (estimatedSize > mMaxSize) evict(mMaxSize - mMaxSize / 8);
+
+        return true;
+    }
+
+    uint64_t ShaderCache::getSize() const
+    {
+        uint64_t size = 0;
+        std::error_code ec;
+        for (fs::directory_iterator it(mDirectory, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->path().extension() != kEntryExtension) continue;
+            std::error_code sizeEc;
+            uint64_t fileSize = it->file_size(sizeEc);
+            if (!sizeEc) size += fileSize;
+        }
+        return size;
+    }
+
+    void ShaderCache::evict(uint64_t targetSize)
+    {
+        std::lock_guard<std::mutex> lock(mEvictMutex);
+
+        struct Entry
+        {
+            fs::path path;
+            uint64_t size;
+            fs::file_time_type lastUse;
+        };
+
+        std::vector<Entry> entries;
+        uint64_t totalSize = 0;
+        auto now = fs::file_time_type::clock::now();
+
+        std::error_code ec;
+        for (fs::directory_iterator it(mDirectory, ec), end; !ec && it != end; it.increment(ec))
+        {
+            // Entries may be removed by other processes while we iterate, so errors for individual files are ignored.
+            std::error_code fileEc;
+            auto extension = it->path().extension();
+            auto lastUse = it->last_write_time(fileEc);
+            if (fileEc) continue;
+
+            if (extension == kTempExtension)
+            {
+                if (now - lastUse > kStaleTempFileAge) fs::remove(it->path(), fileEc);
+                continue;
+            }
+            if (extension != kEntryExtension) continue;
+
+            uint64_t size = it->file_size(fileEc);
+            if (fileEc) continue;
+
+            entries.push_back({ it->path(), size, lastUse });
+            totalSize += size;
+        }
+
+        if (totalSize > targetSize)
+        {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+            for (const auto& entry : entries)
+            {
+                if (totalSize <= targetSize) break;
+                std::error_code removeEc;
+                if (fs::remove(entry.path, removeEc))
+                {
+                    totalSize -= entry.size;
+                    mEvictions++;
+                }
+            }
+        }
+
+        mEstimatedSize = totalSize;
+    }
+
+    void ShaderCache::removeEntry(const std::string& filename)
+    {
+        std::error_code ec;
+        fs::remove(filename, ec);
+    }
+
+    ShaderCache::Stats ShaderCache::getStats() const
+    {
+        Stats stats;
+        stats.hits = mHits;
+        stats.misses = mMisses;
+        stats.corruptEntries = mCorruptEntries;
+        stats.stores = mStores;
+        stats.evictions = mEvictions;
+        return stats;
+    }
+
+    void ShaderCache::resetStats()
+    {
+        mHits = 0;
+        mMisses = 0;
+        mCorruptEntries = 0;
+        mStores = 0;
+        mEvictions = 0;
+    }
+}
@@ -0,0 +1,198 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <atomic>
+#include <mutex>
+
+namespace Falcor
+{
+    /** Persistent on-disk cache of compiled shader kernels.
+
+        The cache is content-addressed: each entry is stored in its own file, named after a 128-bit key
+        computed by the caller from everything that affects the compiled code (source and include file
+        contents, defines, shader model, compiler flags etc., see KeyBuilder). The cache does not know
+        anything about the payload, it stores and returns opaque byte blobs (DXIL, DXBC or SPIR-V).
+
+        The cache can be shared by several processes:
+        - Entries are written to a uniquely named temporary file and renamed into place, so readers never see partially written entries.
+        - Every entry carries a header with the key and a checksum of the payload. Corrupt or mismatching entries are treated as misses and removed.
+        - Failures to access the file system are never fatal, they are treated as misses.
+
+        The total size of the cache is bounded. When a store takes the cache over its size limit, the least
+        recently used entries are evicted. Entries are marked as used by updating their modification time
+        on every hit, so the LRU order is shared between processes.
+    */
+    class dlldecl ShaderCache
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ShaderCache>;
+
+        /** Version of the entry file format. Must be incremented whenever the layout of the entries changes.
+        */
+        static const uint32_t kVersion = 2;
+
+        /** Default maximum size of the cache in bytes.
+        */
+        static const uint64_t kDefaultMaxSize = 1024ull * 1024 * 1024;
+
+        /** Cache key (128-bit hash).
+        */
+        struct Key
+        {
+            uint64_t hash[2] = { 0, 0 };
+
+            bool operator==(const Key& other) const { return hash[0] == other.hash[0] && hash[1] == other.hash[1]; }
+            bool operator!=(const Key& other) const { return !(*this == other); }
+
+            /** Get the key as a 32 character hex string.
+            */
+            std::string toString() const;
+        };
+
+        /** Incrementally computes a cache key from a sequence of values.
+            The order of the values matters. Strings are hashed together with their length, so that
+            a sequence of strings can't produce the same key as their concatenation.
+        */
+        class dlldecl KeyBuilder
+        {
+        public:
+            KeyBuilder();
+
+            KeyBuilder& addBytes(const void* pData, size_t size);
+            KeyBuilder& add(const std::string& str);
+            KeyBuilder& add(const char* str) { return add(std::string(str ? str : "")); }
+            KeyBuilder& add(const Key& key) { return addBytes(key.hash, sizeof(key.hash)); }
+
+            template<typename T>
+            KeyBuilder& add(const T& value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+                return addBytes(&value, sizeof(T));
+            }
+
+            Key getKey() const;
+
+        private:
+            uint64_t mState[2];
+            uint64_t mLength = 0;
+        };
+
+        /** Cache statistics. Counters are accumulated since the cache was created or resetStats() was called.
+        */
+        struct Stats
+        {
+            uint64_t hits = 0;              ///< Number of successful lookups.
+            uint64_t misses = 0;            ///< Number of failed lookups, including corrupt entries.
+            uint64_t corruptEntries = 0;    ///< Number of entries that failed validation.
+            uint64_t stores = 0;            ///< Number of entries written.
+            uint64_t evictions = 0;         ///< Number of entries evicted to honor the size limit.
+        };
+
+        /** Create a cache.
+            \param[in] directory Directory to store the cache entries in. Created on the first store if it doesn't exist.
+            \param[in] maxSize Maximum total size of the cache entries in bytes.
+            \return A new object.
+        */
+        static SharedPtr create(const std::string& directory, uint64_t maxSize = kDefaultMaxSize);
+
+        /** Get the directory where the entries are stored.
+        */
+        const std::string& getDirectory() const { return mDirectory; }
+
+        /** Get the maximum total size of the cache entries in bytes.
+        */
+        uint64_t getMaxSize() const { return mMaxSize; }
+
+        /** Set the maximum total size of the cache entries in bytes. Evicts entries if the cache is currently larger.
+        */
+        void setMaxSize(uint64_t maxSize);
+
+        /** Look up an entry.
+            \param[in] key Cache key.
+            \param[out] data The cached payload, if found.
+            \return True if a valid entry was found.
+        */
+        bool load(const Key& key, std::vector<uint8_t>& data);
+
+        /** Store an entry. Existing entries with the same key are replaced.
+            \param[in] key Cache key.
+            \param[in] pData Payload.
+            \param[in] size Payload size in bytes.
+            \return True if the entry was written.
+        */
+        bool store(const Key& key, const void* pData, size_t size);
+
+        /** Check if an entry file exists for a key. The entry is not validated.
+        */
+        bool contains(const Key& key) const;
+
+        /** Get the full path of the entry file for a key.
+        */
+        std::string getEntryFilename(const Key& key) const;
+
+        /** Get the current total size of the cache entries in bytes. This scans the cache directory.
+        */
+        uint64_t getSize() const;
+
+        /** Evict least recently used entries until the total size is within the size limit.
+        */
+        void evict() { evict(mMaxSize); }
+
+        /** Remove all entries.
+        */
+        void clear() { evict(0); }
+
+        /** Get the cache statistics.
+        */
+        Stats getStats() const;
+
+        /** Reset the cache statistics.
+        */
+        void resetStats();
+
+    private:
+        ShaderCache(const std::string& directory, uint64_t maxSize);
+
+        void evict(uint64_t targetSize);
+        void removeEntry(const std::string& filename);
+
+        std::string mDirectory;
+        uint64_t mMaxSize;
+
+        // Estimated total size of the entries, used to decide when to scan the directory for eviction.
+        // Other processes may write to the same directory, so this is only an estimate.
+        std::atomic<uint64_t> mEstimatedSize = 0;
+        std::mutex mEvictMutex;
+
+        std::atomic<uint64_t> mHits = 0;
+        std::atomic<uint64_t> mMisses = 0;
+        std::atomic<uint64_t> mCorruptEntries = 0;
+        std::atomic<uint64_t> mStores = 0;
+        std::atomic<uint64_t> mEvictions = 0;
+    };
+}
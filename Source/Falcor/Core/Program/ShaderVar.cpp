@@ -30,6 +30,63 @@
 
 namespace Falcor
 {
+    namespace
+    {
+#ifdef _DEBUG
+        bool sValidateHandles = true;
+#else
+        bool sValidateHandles = false;
+#endif
+
+        /** One member access in a shader variable path, followed by zero or more array indices.
+        */
+        struct PathElement
+        {
+            std::string name;
+            std::vector<size_t> indices;
+        };
+
+        bool parsePath(const std::string& path, std::vector<PathElement>& elements)
+        {
+            size_t pos = 0;
+            while (pos <= path.size())
+            {
+                PathElement element;
+                size_t end = path.find_first_of(".[", pos);
+                element.name = path.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+                if (element.name.empty()) return false;
+                pos = end;
+
+                while (pos != std::string::npos && path[pos] == '[')
+                {
+                    size_t close = path.find(']', pos);
+                    if (close == std::string::npos || close == pos + 1) return false;
+                    const std::string index = path.substr(pos + 1, close - pos - 1);
+                    if (index.find_first_not_of("0123456789") != std::string::npos) return false;
+                    element.indices.push_back(std::stoull(index));
+                    pos = close + 1;
+                    if (pos == path.size()) pos = std::string::npos;
+                }
+
+                elements.push_back(std::move(element));
+                if (pos == std::string::npos) return true;
+                if (path[pos] != '.') return false;
+                pos++;
+            }
+            return false;
+        }
+
+        /** If the offset points at a constant buffer or parameter block, get the zero offset into its contents.
+        */
+        bool dereferenceBlock(TypedShaderVarOffset& offset)
+        {
+            auto pResourceType = offset.getType()->asResourceType();
+            if (!pResourceType || pResourceType->getType() != ReflectionResourceType::Type::ConstantBuffer) return false;
+            offset = pResourceType->getParameterBlockReflector()->getElementType()->getZeroOffset();
+            return true;
+        }
+    }
+
     ShaderVar::ShaderVar() : mpBlock(nullptr) {}
     ShaderVar::ShaderVar(const ShaderVar& other) : mpBlock(other.mpBlock), mOffset(other.mOffset) {}
     ShaderVar::ShaderVar(ParameterBlock* pObject, const TypedShaderVarOffset& offset) : mpBlock(pObject), mOffset(offset) {}
@@ -278,6 +335,43 @@ namespace Falcor
         return ShaderVar();
     }
 
+    ShaderVar ShaderVar::operator[](ShaderVarHandle const& handle) const
+    {
+        if (!isValid()) return *this;
+        if (!handle.isValid())
+        {
+            logError("Trying to access a shader variable with an invalid handle.");
+            return ShaderVar();
+        }
+
+        // Each step is relative to the previous one. Constant buffers and parameter
+        // blocks between the steps are dereferenced by `operator[](TypedShaderVarOffset)`.
+        ShaderVar result = *this;
+        for (const auto& step : handle.mSteps) result = result[step];
+
+#if _LOG_ENABLED
+        if (sValidateHandles)
+        {
+            std::vector<PathElement> elements;
+            parsePath(handle.mPath, elements);
+            ShaderVar expected = *this;
+            for (const auto& element : elements)
+            {
+                expected = expected.findMember(element.name);
+                for (size_t index : element.indices) expected = expected.isValid() ? expected[index] : expected;
+            }
+
+            if (!expected.isValid() || expected.mpBlock != result.mpBlock || expected.mOffset != result.mOffset || *expected.getType() != *result.getType())
+            {
+                logError("Shader variable handle '" + handle.mPath + "' doesn't match the layout of the variable it is used with. Handles need to be re-resolved when the program version changes.");
+                return expected;
+            }
+        }
+#endif
+
+        return result;
+    }
+
     bool ShaderVar::isValid() const
     {
         return mOffset.isValid();
@@ -418,4 +512,68 @@ namespace Falcor
         return (uint8_t*)(mpBlock->getRawData()) + mOffset.getUniform().getByteOffset();
     }
 
+
+    ShaderVarHandle::ShaderVarHandle(const ReflectionType::SharedConstPtr& pType, const std::string& path)
+        : mPath(path)
+    {
+        std::vector<PathElement> elements;
+        if (!pType || !parsePath(path, elements))
+        {
+            logError("Invalid shader variable path '" + path + "'.");
+            return;
+        }
+
+        // Walk the path on the reflection types. A new step starts each time the path enters
+        // a constant buffer or parameter block, as the offsets after that are relative to the block's contents.
+        std::vector<TypedShaderVarOffset> steps;
+        TypedShaderVarOffset offset = pType->getZeroOffset();
+        bool atStart = true;
+        auto enterBlock = [&]()
+        {
+            TypedShaderVarOffset blockOffset = offset;
+            if (dereferenceBlock(offset) && !atStart) steps.push_back(blockOffset);
+            atStart = false;
+        };
+
+        for (const auto& element : elements)
+        {
+            enterBlock();
+            auto pStructType = offset.getType()->asStructType();
+            auto pMember = pStructType ? pStructType->findMember(element.name) : nullptr;
+            if (!pMember)
+            {
+                logError("Can't resolve shader variable path '" + path + "'. No member named '" + element.name + "' found.");
+                return;
+            }
+            offset = TypedShaderVarOffset(pMember->getType().get(), offset + pMember->getBindLocation());
+
+            for (size_t index : element.indices)
+            {
+                enterBlock();
+                offset = offset[index];
+                if (!offset.isValid())
+                {
+                    logError("Can't resolve shader variable path '" + path + "'. Index " + std::to_string(index) + " is out of range.");
+                    return;
+                }
+            }
+        }
+
+        steps.push_back(offset);
+        mSteps = std::move(steps);
+    }
+
+    ShaderVarHandle::ShaderVarHandle(const ShaderVar& var, const std::string& path)
+        : ShaderVarHandle(var.getType(), path)
+    {}
+
+    void ShaderVarHandle::setValidationEnabled(bool enabled)
+    {
+        sValidateHandles = enabled;
+    }
+
+    bool ShaderVarHandle::isValidationEnabled()
+    {
+        return sValidateHandles;
+    }
 }
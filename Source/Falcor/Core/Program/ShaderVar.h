@@ -36,6 +36,7 @@ namespace Falcor
     class ParameterBlock;
     template<typename T>
     class ParameterBlockSharedPtr;
+    class ShaderVarHandle;
 
     /** A "pointer" to a shader variable stored in some parameter block.
 
@@ -318,6 +319,11 @@ namespace Falcor
         */
         ShaderVar operator[](UniformShaderVarOffset const& offset) const;
 
+        /** Get a shader variable pointer using a pre-resolved member path.
+            This performs no string lookups. See `ShaderVarHandle` for details.
+        */
+        ShaderVar operator[](ShaderVarHandle const& handle) const;
+
         /** Implicit conversion from a shader variable to a texture.
             This operation allows a bound texture to be queried using the `[]` syntax:
                 pTexture = pVars["someTexture"];
@@ -388,6 +394,69 @@ namespace Falcor
 
         template<typename T> bool setImpl(const T& val) const;
     };
+
+    /** A member path into a shader variable that is resolved once and then reused to access variables without string lookups.
+
+    Looking up variables by name (e.g. `pVars["PerFrameCB"]["gFrameDim"]`) constructs strings and searches
+    the reflection of each struct on every access. For parameters that are set every frame, the path can instead
+    be resolved once when the vars are created, and the handle used to access the variable afterwards:
+
+        mFrameDimHandle = ShaderVarHandle(pVars->getRootVar(), "PerFrameCB.gFrameDim");
+        ...
+        pVars[mFrameDimHandle] = frameDim;
+
+    A path consists of member names separated by '.', where each member can be followed by array indices (e.g. "gLights[2].intensity").
+    Constant buffers and parameter blocks along the path are dereferenced implicitly, the same way as with `operator[]`.
+
+    A handle is only valid for variables with the same layout as the one it was resolved against, i.e. it must be re-resolved
+    when the program version changes. When validation is enabled (the default in debug builds), every access through a handle is
+    checked against a regular string lookup and an error is logged on mismatch.
+    */
+    class dlldecl ShaderVarHandle
+    {
+    public:
+        /** Create an invalid handle.
+        */
+        ShaderVarHandle() = default;
+
+        /** Resolve a member path relative to a variable of the given type.
+            Logs an error and creates an invalid handle if the path doesn't exist.
+            \param[in] pType Type of the variables the handle will be used with.
+            \param[in] path Member path.
+        */
+        ShaderVarHandle(const ReflectionType::SharedConstPtr& pType, const std::string& path);
+
+        /** Resolve a member path relative to a shader variable.
+            Logs an error and creates an invalid handle if the path doesn't exist.
+            \param[in] var Shader variable, typically the root variable of a parameter block.
+            \param[in] path Member path.
+        */
+        ShaderVarHandle(const ShaderVar& var, const std::string& path);
+
+        /** Check if the handle was successfully resolved.
+        */
+        bool isValid() const { return !mSteps.empty(); }
+
+        /** Get the member path of the handle.
+        */
+        const std::string& getPath() const { return mPath; }
+
+        /** Enable/disable validation of handle accesses against string lookups.
+        */
+        static void setValidationEnabled(bool enabled);
+
+        /** Check if validation of handle accesses is enabled.
+        */
+        static bool isValidationEnabled();
+
+    private:
+        friend struct ShaderVar;
+
+        /** Offsets to apply in sequence, one per constant buffer or parameter block along the path.
+        */
+        std::vector<TypedShaderVarOffset> mSteps;
+        std::string mPath;
+    };
 }
 
 #include "Core/BufferTypes/ParameterBlock.h"
@@ -175,8 +175,10 @@ namespace Falcor
     {
         mpRenderer.reset();
         if (mVideoCapture.pVideoCapture) endVideoCapture();
+        mpScreenCaptureReadback.reset();
 
         Clock::shutdown();
+        Program::shutdownCompileThreads();
         Threading::shutdown();
         Scripting::shutdown();
         RenderPassLibrary::instance().shutdown();
@@ -516,7 +518,8 @@ namespace Falcor
         {
             Texture::SharedPtr pTexture;
             pTexture = gpDevice->getSwapChainFbo()->getColorTexture(0);
-            pTexture->captureToFile(0, 0, pngFile);
+            if (!mpScreenCaptureReadback) mpScreenCaptureReadback = TextureReadback::create();
+            pTexture->captureToFile(0, 0, pngFile, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, mpScreenCaptureReadback.get());
         }
         else
         {
@@ -122,6 +122,7 @@ namespace Falcor
         bool mVsyncOn = false;
         bool mShowUI = true;
         bool mCaptureScreen = false;
+        TextureReadback::SharedPtr mpScreenCaptureReadback;   ///< Readback for captureScreen(), so screen captures don't wait for the GPU.
         FrameRate mFrameRate;
         Clock mClock;
 
@@ -62,10 +62,18 @@ namespace Falcor
             std::vector<float> weights(numTris);
             for (size_t i = 0; i < numTris; i++) weights[i] = triangles[i].flux;
 
-            mTriangleTable = generateAliasTable(std::move(weights));
+            // Rebuild the existing table in place if the number of triangles is unchanged.
+            if (mTriangleTable.fullTable && mTriangleTable.N == numTris)
+            {
+                samplerChanged = updateAliasTable(weights);
+            }
+            else
+            {
+                mTriangleTable = generateAliasTable(std::move(weights));
+                samplerChanged = true;
+            }
 
             mNeedsRebuild = false;
-            samplerChanged = true;
         }
 
         return samplerChanged;        
@@ -91,92 +99,62 @@ namespace Falcor
     EmissivePowerSampler::AliasTable EmissivePowerSampler::generateAliasTable(std::vector<float> weights)
     {
         uint32_t N = uint32_t(weights.size());
-        std::uniform_int_distribution<uint32_t> rngDist;
 
-        double sum = 0.0f;
-        for (float f : weights)
-        {
-            sum += f;
-        }
-        for (float& f : weights)
-        {
-            f *= N / float(sum);
-        }
+        mAliasTableBuilder.build(std::move(weights));
+        mAliasTableBuilder.shuffle(mAliasTableRng);
 
-        std::vector<uint32_t> permutation(N);
-        for (uint32_t i = 0; i < N; ++i)
+        AliasTable result
         {
-            permutation[i] = i;
-        }
-        std::sort(permutation.begin(), permutation.end(), [&](uint32_t a, uint32_t b) { return weights[a] < weights[b]; });
-
-        std::vector<float> thresholds(N);
-        std::vector<uint32_t> redirect(N);
-        std::vector<uint2> merged(N);
-        std::vector<uint2> fullTable(N);
+            float(mAliasTableBuilder.getWeightSum()),
+            N,
+            Buffer::createTyped<uint2>(N),
+        };
 
-        uint32_t head = 0;
-        uint32_t tail = N - 1;
+        uploadAliasTable(result.fullTable);
 
-        while (head != tail)
-        {
-            int i = permutation[head];
-            int j = permutation[tail];
+        return result;
+    }
 
-            thresholds[i] = weights[i];
-            redirect[i] = j;
-            weights[j] -= 1.0f - weights[i];
+    bool EmissivePowerSampler::updateAliasTable(const std::vector<float>& weights)
+    {
+        assert(weights.size() == mAliasTableBuilder.getCount());
 
-            if (head == tail - 1)
-            {
-                thresholds[j] = 1.0f;
-                redirect[j] = j;
-                break;
-            }
-            else if (weights[j] < 1.0f)
-            {
-                std::swap(permutation[head], permutation[tail]);
-                tail--;
-            }
-            else
+        // Find the weights that changed.
+        const auto& currentWeights = mAliasTableBuilder.getWeights();
+        std::vector<uint32_t> changedIndices;
+        std::vector<float> changedWeights;
+        for (uint32_t i = 0; i < (uint32_t)weights.size(); i++)
+        {
+            if (weights[i] != currentWeights[i])
             {
-                head++;
+                changedIndices.push_back(i);
+                changedWeights.push_back(weights[i]);
             }
         }
 
-        for (uint32_t i = 0; i < N; ++i)
-        {
-            permutation[i] = i;
-        }
+        if (!mAliasTableBuilder.updateWeights(changedIndices, changedWeights)) return false;
 
-        for (uint32_t i = 0; i < N; ++i)
-        {
-            uint32_t dst = i + (rngDist(mAliasTableRng) % (N - i));
-            std::swap(thresholds[i], thresholds[dst]);
-            std::swap(redirect[i], redirect[dst]);
-            std::swap(permutation[i], permutation[dst]);
-        }
+        mAliasTableBuilder.shuffle(mAliasTableRng);
+        mTriangleTable.weightSum = float(mAliasTableBuilder.getWeightSum());
+        uploadAliasTable(mTriangleTable.fullTable);
 
-        for (uint32_t i = 0; i < N; ++i)
-        {
-            merged[i] = uint2(redirect[i], permutation[i]);
+        return true;
+    }
 
+    void EmissivePowerSampler::uploadAliasTable(const Buffer::SharedPtr& pBuffer)
+    {
+        const auto& entries = mAliasTableBuilder.getEntries();
+        std::vector<uint2> fullTable(entries.size());
+
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
             // Pack 16-bit threshold (i.e., a half float) plus 2x 24-bit table entries
-            uint32_t prob = (uint32_t(f32tof16(thresholds[i])) << 16u);
-            uint2 lowPrec = uint2(redirect[i] & 0xFFFFFFu, permutation[i] & 0xFFFFFFu);
+            uint32_t prob = (uint32_t(f32tof16(entries[i].threshold)) << 16u);
+            uint2 lowPrec = uint2(entries[i].indexA & 0xFFFFFFu, entries[i].indexB & 0xFFFFFFu);
             uint2 mergedEntry = uint2(prob | ((lowPrec.x >> 8u) & 0xFFFFu), ((lowPrec.x & 0xFFu) << 24u) | lowPrec.y);
             fullTable[i] = mergedEntry;
         }
 
-        AliasTable result
-        {
-            float(sum),
-            N,
-            Buffer::createTyped<uint2>(N),
-        };
-
-        result.fullTable->setBlob(&fullTable[0], 0, N * sizeof(uint2));
-
-        return result;
+        pBuffer->setBlob(fullTable.data(), 0, fullTable.size() * sizeof(uint2));
     }
 }
@@ -28,6 +28,7 @@
 #pragma once
 #include "EmissiveLightSampler.h"
 #include "LightCollection.h"
+#include "Utils/Sampling/AliasTableBuilder.h"
 
 namespace Falcor
 {
@@ -76,12 +77,23 @@ namespace Falcor
         */
         AliasTable generateAliasTable(std::vector<float> weights);
 
+        /** Update the weights of the existing alias table and rebuild it in place.
+            \param[in] weights  The weights we'd like to sample each entry proportional to. Must have the same size as the existing table.
+            \returns True if any weight changed and the table was rebuilt.
+        */
+        bool updateAliasTable(const std::vector<float>& weights);
+
+        /** Pack the builder's table entries and upload them to the given buffer.
+        */
+        void uploadAliasTable(const Buffer::SharedPtr& pBuffer);
+
         // Internal state
         bool                            mNeedsRebuild = true;   ///< Trigger rebuild on the next call to update(). We should always build on the first call, so the initial value is true.
 
         LightCollection::SharedConstPtr mpLightCollection;
 
         std::mt19937                    mAliasTableRng;
-        AliasTable                      mTriangleTable;
+        AliasTableBuilder               mAliasTableBuilder = AliasTableBuilder(true);
+        AliasTable                      mTriangleTable = {};
     };
 }
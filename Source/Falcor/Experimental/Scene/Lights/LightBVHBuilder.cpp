@@ -41,6 +41,61 @@ namespace
     const uint32_t kMaxLeafTriangleCount = 1 << PackedNode::kTriangleCountBits;
     const uint32_t kMaxLeafTriangleOffset = 1 << PackedNode::kTriangleOffsetBits;
 
+    // Parameters for the parallel build.
+    // Subtrees with at least kMinParallelSubtreeSize triangles are built in separate tasks.
+    // Per-node reductions over triangles (bounds, flux, bins) are computed in chunks of kReductionChunkSize
+    // triangles, which are processed in parallel for nodes with at least kMinParallelReductionSize triangles.
+    // The chunk results are always combined in order, so the BVH is identical for serial and parallel builds.
+    const uint32_t kMinParallelSubtreeSize = 1 << 14;
+    const uint32_t kReductionChunkSize = 1 << 13;
+    const uint32_t kMinParallelReductionSize = 1 << 16;
+
+    /** Reduces a range of elements in fixed-size chunks.
+        \param[in] begin First element.
+        \param[in] end One past the last element.
+        \param[in] parallel Process the chunks in parallel.
+        \param[in] reduceChunk Function computing the result for a chunk with signature T(uint32_t begin, uint32_t end).
+        \param[in] combine Function accumulating a chunk result with signature void(T& result, const T& chunkResult).
+        \return The combined result.
+    */
+    template<typename T, typename ReduceFunc, typename CombineFunc>
+    T reduceChunks(uint32_t begin, uint32_t end, bool parallel, const ReduceFunc& reduceChunk, const CombineFunc& combine)
+    {
+        const uint32_t chunkCount = div_round_up(end - begin, kReductionChunkSize);
+        if (chunkCount <= 1) return reduceChunk(begin, end);
+
+        std::vector<T> chunkResults(chunkCount);
+        auto reduce = [&](uint32_t chunk)
+        {
+            uint32_t chunkBegin = begin + chunk * kReductionChunkSize;
+            chunkResults[chunk] = reduceChunk(chunkBegin, std::min(chunkBegin + kReductionChunkSize, end));
+        };
+
+        if (parallel) Threading::parallelFor(0, chunkCount, reduce, 1);
+        else for (uint32_t chunk = 0; chunk < chunkCount; chunk++) reduce(chunk);
+
+        T result = std::move(chunkResults[0]);
+        for (uint32_t chunk = 1; chunk < chunkCount; chunk++) combine(result, chunkResults[chunk]);
+        return result;
+    }
+
+    /** Offsets the child node index or triangle offset of a packed node.
+        This is used when appending the nodes of a subtree that was built separately.
+        The packed data is modified directly to avoid a lossy unpack/pack round trip of the node attributes.
+    */
+    void offsetNodeReferences(PackedNode& node, uint32_t nodeOffset, uint32_t triangleOffset)
+    {
+        if (node.isLeaf())
+        {
+            assert(node.getLeafNode().triangleOffset + triangleOffset < kMaxLeafTriangleOffset);
+            node.data[0].x += triangleOffset;
+        }
+        else
+        {
+            node.data[0].x += nodeOffset;
+        }
+    }
+
     inline float safeACos(float v)
     {
         return std::acos(glm::clamp(v, -1.0f, 1.0f));
@@ -242,11 +297,34 @@ namespace Falcor
         // Get global list of emissive triangles.
         assert(bvh.mpLightCollection);
         const auto& triangles = bvh.mpLightCollection->getMeshLightTriangles();
+
+        // Build the tree.
+        std::vector<uint32_t> triangleIndices;
+        std::vector<uint64_t> triangleBitmasks;
+        buildNodes(triangles, bvh.mNodes, triangleIndices, triangleBitmasks);
+
+        // If there are no non-culled triangles, we're done.
+        if (bvh.mNodes.empty()) return;
+
+        // The BVH is ready, mark it as valid and upload the data.
+        bvh.mIsValid = true;
+        bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
+        bvh.uploadCPUBuffers(triangleIndices, triangleBitmasks);
+
+        // Computate metadata.
+        bvh.finalize();
+    }
+
+    void LightBVHBuilder::buildNodes(const std::vector<LightCollection::MeshLightTriangle>& triangles, std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks) const
+    {
+        nodes.clear();
+        triangleIndices.clear();
+        triangleBitmasks.clear();
         if (triangles.empty()) return;
 
         // Create list of triangles that should be included in BVH.
         // For each triangle, precompute data we need for the build.
-        BuildingData data(bvh.mNodes);
+        BuildingData data(nodes, triangleIndices, triangleBitmasks);
         data.trianglesData.reserve(triangles.size());
 
         for (size_t i = 0; i < triangles.size(); i++)
@@ -285,16 +363,20 @@ namespace Falcor
         // To be grossly conservative, assume each triangle requires two nodes.
         // This is only system RAM and shouldn't be that much, so it's not worth being more careful about it.
         // TODO: Better estimate of how many nodes we will need.
-        data.nodes.clear();
         data.nodes.reserve(2 * data.trianglesData.size());
         data.triangleIndices.reserve(data.trianglesData.size());
 
         const uint64_t invalidBitmask = std::numeric_limits<uint64_t>::max();
         data.triangleBitmasks.resize(triangles.size(), invalidBitmask); // This is sized based on input triangle count, as it's indexed by global triangle index.
 
+        // Limit the number of subtree tasks to a few per worker thread.
+        data.maxParallelDepth = 2;
+        while ((1u << data.maxParallelDepth) < 4 * std::max(1u, Threading::getThreadCount())) data.maxParallelDepth++;
+
         // Build the tree.
         SplitHeuristicFunction splitFunc = getSplitFunction(mOptions.splitHeuristicSelection);
-        buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data);
+        BuildOutput output = { data.nodes, data.triangleIndices };
+        buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data, output);
         assert(!data.nodes.empty());
 
         size_t numValid = 0;
@@ -305,14 +387,6 @@ namespace Falcor
         // Compute per-node light bounding cones.
         float cosConeAngle;
         computeLightingConesInternal(0, data, cosConeAngle);
-
-        // The BVH is ready, mark it as valid and upload the data.
-        bvh.mIsValid = true;
-        bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
-        bvh.uploadCPUBuffers(data.triangleIndices, data.triangleBitmasks);
-
-        // Computate metadata.
-        bvh.finalize();
     }
 
     bool LightBVHBuilder::renderUI(Gui::Widgets& widget)
@@ -328,6 +402,7 @@ namespace Falcor
         optionsChanged |= widget.checkbox("Allow refitting", options.allowRefitting);
         optionsChanged |= widget.var("Max triangle count per leaf", options.maxTriangleCountPerLeaf, 1u, kMaxLeafTriangleCount);
         optionsChanged |= widget.dropdown("Split heuristic", kSplitHeuristicList, (uint32_t&)options.splitHeuristicSelection);
+        optionsChanged |= widget.checkbox("Parallel build", options.useParallelBuild);
 
         if (auto splitGroup = widget.group("Split Options", true))
         {
@@ -360,24 +435,41 @@ namespace Falcor
     {
     }
 
-    uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data)
+    uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, BuildOutput& output)
     {
         assert(triangleRange.begin < triangleRange.end);
 
         // Compute the AABB and total flux of the node.
-        float nodeFlux = 0.f;
-        AABB nodeBounds;
-        for (uint32_t dataIndex = triangleRange.begin; dataIndex < triangleRange.end; ++dataIndex)
+        struct NodeBoundsAndFlux
         {
-            nodeBounds |= data.trianglesData[dataIndex].bounds;
-            nodeFlux += data.trianglesData[dataIndex].flux;
-        }
-        assert(nodeBounds.valid());
+            AABB bounds;
+            float flux = 0.f;
+        };
+
+        const bool parallelReduction = options.useParallelBuild && triangleRange.length() >= kMinParallelReductionSize;
+        const NodeBoundsAndFlux nodeData = reduceChunks<NodeBoundsAndFlux>(triangleRange.begin, triangleRange.end, parallelReduction,
+            [&data](uint32_t begin, uint32_t end)
+            {
+                NodeBoundsAndFlux result;
+                for (uint32_t dataIndex = begin; dataIndex < end; ++dataIndex)
+                {
+                    result.bounds |= data.trianglesData[dataIndex].bounds;
+                    result.flux += data.trianglesData[dataIndex].flux;
+                }
+                return result;
+            },
+            [](NodeBoundsAndFlux& result, const NodeBoundsAndFlux& chunk)
+            {
+                result.bounds |= chunk.bounds;
+                result.flux += chunk.flux;
+            });
 
-        data.currentNodeFlux = nodeFlux;
+        const AABB& nodeBounds = nodeData.bounds;
+        const float nodeFlux = nodeData.flux;
+        assert(nodeBounds.valid());
 
         bool trySplitting = triangleRange.length() > (options.createLeavesASAP ? options.maxTriangleCountPerLeaf : 1);
-        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options) : SplitResult();
+        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, nodeFlux, options) : SplitResult();
 
         // If we should split, then create an internal node and split.
         if (splitResult.isValid())
@@ -389,9 +481,9 @@ namespace Falcor
             std::nth_element(std::begin(data.trianglesData) + triangleRange.begin, std::begin(data.trianglesData) + splitResult.triangleIndex, std::begin(data.trianglesData) + triangleRange.end, comp);
 
             // Allocate internal node.
-            assert(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
+            assert(output.nodes.size() < std::numeric_limits<uint32_t>::max());
+            const uint32_t nodeIndex = (uint32_t)output.nodes.size();
+            output.nodes.push_back({});
 
             InternalNode node = {};
             node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
@@ -405,13 +497,55 @@ namespace Falcor
                 throw std::exception(("BVH depth of " + std::to_string(depth + 1) + " reached; maximum of " + std::to_string(kMaxBVHDepth) + " allowed.").c_str());
             }
 
-            uint32_t leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data);
-            uint32_t rightIndex = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data);
+            const Range leftRange(triangleRange.begin, splitResult.triangleIndex);
+            const Range rightRange(splitResult.triangleIndex, triangleRange.end);
+            uint32_t leftIndex = 0;
+            uint32_t rightIndex = 0;
+
+            if (options.useParallelBuild && depth < data.maxParallelDepth && std::min(leftRange.length(), rightRange.length()) >= kMinParallelSubtreeSize)
+            {
+                // Build the right subtree in a job system task while building the left subtree directly into the output.
+                // The subtrees work on disjoint triangle ranges, so they don't share any mutable data.
+                // The right subtree is then appended to the output, which gives the same node order as the serial build.
+                std::vector<PackedNode> rightNodes;
+                std::vector<uint32_t> rightTriangleIndices;
+                Threading::Task rightTask = Threading::dispatchTask([&]()
+                {
+                    BuildOutput rightOutput = { rightNodes, rightTriangleIndices };
+                    buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, rightRange, data, rightOutput);
+                });
+
+                try
+                {
+                    leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, leftRange, data, output);
+                }
+                catch (...)
+                {
+                    // The right subtree task references this stack frame, so wait for it before propagating the error.
+                    try { rightTask.finish(); } catch (...) {}
+                    throw;
+                }
+                rightTask.finish();
+
+                assert(output.nodes.size() + rightNodes.size() < std::numeric_limits<uint32_t>::max());
+                const uint32_t nodeOffset = (uint32_t)output.nodes.size();
+                const uint32_t triangleOffset = (uint32_t)output.triangleIndices.size();
+                for (auto& rightNode : rightNodes) offsetNodeReferences(rightNode, nodeOffset, triangleOffset);
+
+                output.nodes.insert(output.nodes.end(), rightNodes.begin(), rightNodes.end());
+                output.triangleIndices.insert(output.triangleIndices.end(), rightTriangleIndices.begin(), rightTriangleIndices.end());
+                rightIndex = nodeOffset;
+            }
+            else
+            {
+                leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, leftRange, data, output);
+                rightIndex = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, rightRange, data, output);
+            }
 
             assert(leftIndex == nodeIndex + 1); // The left node should always be placed immediately after the current node.
             node.rightChildIdx = rightIndex;
 
-            data.nodes[nodeIndex].setInternalNode(node);
+            output.nodes[nodeIndex].setInternalNode(node);
             return nodeIndex;
         }
         else // No split => create leaf node
@@ -419,9 +553,9 @@ namespace Falcor
             assert(triangleRange.length() <= options.maxTriangleCountPerLeaf);
 
             // Allocate leaf node.
-            assert(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
+            assert(output.nodes.size() < std::numeric_limits<uint32_t>::max());
+            const uint32_t nodeIndex = (uint32_t)output.nodes.size();
+            output.nodes.push_back({});
 
             LeafNode node = {};
             node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
@@ -431,19 +565,19 @@ namespace Falcor
             node.attribs.cosConeAngle = cosTheta;
 
             node.triangleCount = triangleRange.length();
-            node.triangleOffset = (uint32_t)data.triangleIndices.size();
+            node.triangleOffset = (uint32_t)output.triangleIndices.size();
             assert(node.triangleCount < kMaxLeafTriangleCount);
             assert(node.triangleOffset < kMaxLeafTriangleOffset);
 
             for (uint32_t triangleIdx = triangleRange.begin, index = 0; triangleIdx < triangleRange.end; ++triangleIdx, ++index)
             {
                 uint32_t globalTriangleIndex = data.trianglesData[triangleIdx].triangleIndex;
-                data.triangleIndices.push_back(globalTriangleIndex);
+                output.triangleIndices.push_back(globalTriangleIndex);
                 data.triangleBitmasks[globalTriangleIndex] = bitmask;
             }
-            assert(data.triangleIndices.size() == node.triangleOffset + node.triangleCount);
+            assert(output.triangleIndices.size() == node.triangleOffset + node.triangleCount);
 
-            data.nodes[nodeIndex].setLeafNode(node);
+            output.nodes[nodeIndex].setLeafNode(node);
             return nodeIndex;
         }
     }
@@ -508,7 +642,7 @@ namespace Falcor
         return coneDirection;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, float /*nodeFlux*/, const Options& /*parameters*/)
     {
         // Find the largest dimension.
         float3 dimensions = nodeBounds.extent();
@@ -535,7 +669,7 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         assert(!overallBestSplit.second.isValid());
@@ -555,37 +689,64 @@ namespace Falcor
             }
         };
 
+        // Select the dimensions to compute splits along.
+        std::vector<uint32_t> dimensions;
+        if (parameters.splitAlongLargest)
+        {
+            // Find the largest dimension.
+            float3 extent = nodeBounds.extent();
+            uint32_t largestDimension = extent[2] >= extent[0] && extent[2] >= extent[1] ?
+                2 : (extent[1] >= extent[0] && extent[1] >= extent[2] ? 1 : 0);
+            dimensions.push_back(largestDimension);
+        }
+        else
+        {
+            dimensions = { 0, 1, 2 };
+        }
+
         assert(parameters.binCount > 1);
-        std::vector<Bin> bins(parameters.binCount);
-        std::vector<float> costs(parameters.binCount - 1);
+        const uint32_t binCount = parameters.binCount;
+        std::vector<float> costs(binCount - 1);
 
-        /** Helper function that computes the best split along the given dimension using the SAH metric.
-            The triangles are binned to n bins, storing only the aggregate parameters (triangle count and bounds).
-            Then the cost metric is evaluated for each of the n-1 potential splits.
-        */
-        const auto binAlongDimension = [&bins, &costs, &triangleRange, &data, &parameters, &overallBestSplit, &nodeBounds](uint32_t dimension)
+        // Helper to compute the bin id for a given triangle.
+        auto getBinId = [&](const TriangleSortData& td, uint32_t dimension)
         {
-            // Helper to compute the bin id for a given triangle.
-            auto getBinId = [&](const TriangleSortData& td)
+            float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
+            assert(bmin < bmax);
+            float scale = (float)binCount / (bmax - bmin);
+            float p = td.bounds.center()[dimension];
+            assert(bmin <= p && p <= bmax);
+            return std::min((uint32_t)((p - bmin) * scale), binCount - 1);
+        };
+
+        // Fill the bins for all dimensions with all triangles, storing only the aggregate parameters (triangle count and bounds).
+        // The bins for dimension i are stored at offset i * binCount.
+        using BinList = std::vector<Bin>;
+        const bool parallel = parameters.useParallelBuild && triangleRange.length() >= kMinParallelReductionSize;
+        const BinList bins = reduceChunks<BinList>(triangleRange.begin, triangleRange.end, parallel,
+            [&](uint32_t begin, uint32_t end)
             {
-                float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
-                assert(bmin < bmax);
-                float scale = (float)parameters.binCount / (bmax - bmin);
-                float p = td.bounds.center()[dimension];
-                assert(bmin <= p && p <= bmax);
-                return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
-            };
-
-            // Reset the bins.
-            for (Bin& bin : bins) bin = Bin();
-
-            // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
+                BinList chunkBins(dimensions.size() * binCount);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    for (size_t d = 0; d < dimensions.size(); ++d)
+                    {
+                        chunkBins[d * binCount + getBinId(td, dimensions[d])] |= td;
+                    }
+                }
+                return chunkBins;
+            },
+            [](BinList& result, const BinList& chunkBins)
             {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
-            }
+                for (size_t i = 0; i < result.size(); ++i) result[i] |= chunkBins[i];
+            });
 
+        /** Helper function that computes the best split along the given dimension using the SAH metric.
+            The cost metric is evaluated for each of the n-1 potential splits between the n bins.
+        */
+        const auto splitAlongDimension = [&costs, &triangleRange, &parameters, &overallBestSplit](uint32_t dimension, const Bin* bins)
+        {
             // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
             // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
             Bin total = Bin();
@@ -626,21 +787,9 @@ namespace Falcor
             }
         };
 
-        if (parameters.splitAlongLargest)
-        {
-            // Find the largest dimension.
-            float3 dimensions = nodeBounds.extent();
-            uint32_t largestDimension = dimensions[2] >= dimensions[0] && dimensions[2] >= dimensions[1] ?
-                2 : (dimensions[1] >= dimensions[0] && dimensions[1] >= dimensions[2] ? 1 : 0);
-
-            binAlongDimension(largestDimension);
-        }
-        else
+        for (size_t d = 0; d < dimensions.size(); ++d)
         {
-            for (uint32_t dimension = 0; dimension < 3; ++dimension)
-            {
-                binAlongDimension(dimension);
-            }
+            splitAlongDimension(dimensions[d], &bins[d * binCount]);
         }
 
         // If we couldn't find a valid split, create leaf node immediately if possible or revert to equal splitting.
@@ -648,7 +797,7 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
@@ -690,15 +839,15 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, float nodeFlux, const Options& parameters)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         assert(!overallBestSplit.second.isValid());
 
         // Find the largest dimension.
-        float3 dimensions = nodeBounds.extent();
-        uint32_t largestDimension = dimensions[2] >= dimensions[0] && dimensions[2] >= dimensions[1] ?
-            2 : (dimensions[1] >= dimensions[0] && dimensions[1] >= dimensions[2] ? 1 : 0);
+        float3 extent = nodeBounds.extent();
+        uint32_t largestDimension = extent[2] >= extent[0] && extent[2] >= extent[1] ?
+            2 : (extent[1] >= extent[0] && extent[1] >= extent[2] ? 1 : 0);
 
         struct Bin
         {
@@ -721,57 +870,97 @@ namespace Falcor
             }
         };
 
+        // Select the dimensions to compute splits along.
+        std::vector<uint32_t> dimensions;
+        if (parameters.splitAlongLargest) dimensions.push_back(largestDimension);
+        else dimensions = { 0, 1, 2 };
+
         assert(parameters.binCount > 1);
-        std::vector<Bin> bins(parameters.binCount);
-        std::vector<float> costs(parameters.binCount - 1);
+        const uint32_t binCount = parameters.binCount;
+        std::vector<float> costs(binCount - 1);
 
-        /** Helper function that computes the best split along the given dimension using the SAOH metric.
-            The triangles are binned to n bins, storing only the aggregate parameters (triangle count, bounds, flux, and cone direction).
-            Then the cost metric is evaluated for each of the n-1 potential splits.
-            Note that while the bounds and flux are accurately represented by the aggregated parameters,
-            the bounding cones are approximates based on the bins' bounding cones. This is less expensive,
-            but also less precise than computing them directly from the triangles.
-        */
-        const auto binAlongDimension = [&bins, &costs, &triangleRange, &data, &parameters, &overallBestSplit, &nodeBounds, largestDimension, dimensions](uint32_t dimension)
+        // Helper to compute the bin id for a given triangle.
+        auto getBinId = [&](const TriangleSortData& td, uint32_t dimension)
         {
-            // Helper to compute the bin id for a given triangle.
-            auto getBinId = [&](const TriangleSortData& td)
+            float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
+            float w = bmax - bmin;
+            assert(w >= 0.f); // The node bounds can be zero if all primitives are axis-aligned and coplanar
+            float scale = w > FLT_MIN ? (float)binCount / w : 0.f;
+            float p = td.bounds.center()[dimension];
+            assert(bmin <= p && p <= bmax);
+            return std::min((uint32_t)((p - bmin) * scale), binCount - 1);
+        };
+
+        // Fill the bins for all dimensions with all triangles, storing only the aggregate parameters (triangle count, bounds, flux, and cone direction).
+        // The bins for dimension i are stored at offset i * binCount.
+        using BinList = std::vector<Bin>;
+        const bool parallel = parameters.useParallelBuild && triangleRange.length() >= kMinParallelReductionSize;
+        BinList bins = reduceChunks<BinList>(triangleRange.begin, triangleRange.end, parallel,
+            [&](uint32_t begin, uint32_t end)
             {
-                float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
-                float w = bmax - bmin;
-                assert(w >= 0.f); // The node bounds can be zero if all primitives are axis-aligned and coplanar
-                float scale = w > FLT_MIN ? (float)parameters.binCount / w : 0.f;
-                float p = td.bounds.center()[dimension];
-                assert(bmin <= p && p <= bmax);
-                return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
-            };
-
-            // Reset the bins.
-            for (Bin& bin : bins) bin = Bin();
-
-            // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
+                BinList chunkBins(dimensions.size() * binCount);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    for (size_t d = 0; d < dimensions.size(); ++d)
+                    {
+                        chunkBins[d * binCount + getBinId(td, dimensions[d])] |= td;
+                    }
+                }
+                return chunkBins;
+            },
+            [](BinList& result, const BinList& chunkBins)
             {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
-            }
+                for (size_t i = 0; i < result.size(); ++i) result[i] |= chunkBins[i];
+            });
+
+        // Compute the lighting cones for each bin.
+        // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
+        // If the vector is zero length (no lights or if all directions cancelled out), the cone is marked as invalid.
+        // TODO: Switch to a more sophisticated algorithm to get narrower cones.
+        for (Bin& bin : bins)
+        {
+            bin.cosConeAngle = glm::length(bin.coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
+            bin.coneDirection = glm::normalize(bin.coneDirection);
+        }
 
-            // Compute the lighting cones for each bin.
-            // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
-            // If the vector is zero length (no lights or if all directions cancelled out), the cone is marked as invalid.
-            // TODO: Switch to a more sophisticated algorithm to get narrower cones.
-            for (Bin& bin : bins)
+        // Growing the cone angle takes the minimum over all lights, where an invalid cone angle is absorbing.
+        // The result is independent of the order, so this is also reduced in chunks.
+        using ConeAngleList = std::vector<float>;
+        const ConeAngleList cosConeAngles = reduceChunks<ConeAngleList>(triangleRange.begin, triangleRange.end, parallel,
+            [&](uint32_t begin, uint32_t end)
             {
-                bin.cosConeAngle = glm::length(bin.coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
-                bin.coneDirection = glm::normalize(bin.coneDirection);
-            }
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
+                ConeAngleList chunkCosConeAngles(bins.size());
+                for (size_t i = 0; i < bins.size(); ++i) chunkCosConeAngles[i] = bins[i].cosConeAngle;
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    for (size_t d = 0; d < dimensions.size(); ++d)
+                    {
+                        size_t binIndex = d * binCount + getBinId(td, dimensions[d]);
+                        chunkCosConeAngles[binIndex] = computeCosConeAngle(bins[binIndex].coneDirection, chunkCosConeAngles[binIndex], td.coneDirection, td.cosConeAngle);
+                    }
+                }
+                return chunkCosConeAngles;
+            },
+            [](ConeAngleList& result, const ConeAngleList& chunkCosConeAngles)
             {
-                const auto& td = data.trianglesData[i];
-                Bin& bin = bins[getBinId(td)];
-                bin.cosConeAngle = computeCosConeAngle(bin.coneDirection, bin.cosConeAngle, td.coneDirection, td.cosConeAngle);
-            }
+                for (size_t i = 0; i < result.size(); ++i)
+                {
+                    bool invalid = result[i] == kInvalidCosConeAngle || chunkCosConeAngles[i] == kInvalidCosConeAngle;
+                    result[i] = invalid ? kInvalidCosConeAngle : std::min(result[i], chunkCosConeAngles[i]);
+                }
+            });
+        for (size_t i = 0; i < bins.size(); ++i) bins[i].cosConeAngle = cosConeAngles[i];
 
+        /** Helper function that computes the best split along the given dimension using the SAOH metric.
+            The cost metric is evaluated for each of the n-1 potential splits between the n bins.
+            Note that while the bounds and flux are accurately represented by the aggregated parameters,
+            the bounding cones are approximates based on the bins' bounding cones. This is less expensive,
+            but also less precise than computing them directly from the triangles.
+        */
+        const auto splitAlongDimension = [&costs, &triangleRange, &parameters, &overallBestSplit, largestDimension, extent](uint32_t dimension, const Bin* bins)
+        {
             // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
             // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
             Bin total = Bin();
@@ -828,7 +1017,7 @@ namespace Falcor
             assert(triangleRange.begin <= axisBestSplit.second.triangleIndex && axisBestSplit.second.triangleIndex <= triangleRange.end);
 
             // Scale the cost by the ratio of the node's extent to discourage long skinny nodes.
-            axisBestSplit.first *= static_cast<float>(dimensions[largestDimension]) / static_cast<float>(dimensions[dimension]);
+            axisBestSplit.first *= static_cast<float>(extent[largestDimension]) / static_cast<float>(extent[dimension]);
 
             // Early out if all lights fall on either side of the split.
             if (axisBestSplit.second.triangleIndex == triangleRange.begin ||
@@ -842,16 +1031,9 @@ namespace Falcor
         };
 
         // Compute the best split.
-        if (parameters.splitAlongLargest)
-        {
-            binAlongDimension(largestDimension);
-        }
-        else
+        for (size_t d = 0; d < dimensions.size(); ++d)
         {
-            for (uint32_t dimension = 0; dimension < 3; ++dimension)
-            {
-                binAlongDimension(dimension);
-            }
+            splitAlongDimension(dimensions[d], &bins[d * binCount]);
         }
 
         // If we couldn't find a valid split, create leaf node immediately if possible or revert to equal splitting.
@@ -859,7 +1041,7 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAOH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, nodeFlux, parameters);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
@@ -869,7 +1051,7 @@ namespace Falcor
             // Evaluate the cost metric for the node. This requires us to first compute the cone angle.
             float cosTheta = kInvalidCosConeAngle;
             computeLightingCone(triangleRange, data, cosTheta);
-            float leafCost = evalSAOH(nodeBounds, data.currentNodeFlux, cosTheta, parameters);
+            float leafCost = evalSAOH(nodeBounds, nodeFlux, cosTheta, parameters);
             if (leafCost <= overallBestSplit.first) return SplitResult();
         }
 
@@ -913,6 +1095,7 @@ namespace Falcor
         options.field(allowRefitting);
         options.field(usePreintegration);
         options.field(useLightingCones);
+        options.field(useParallelBuild);
 #undef field
     }
 }
@@ -84,6 +84,7 @@
 #include "Core/Program/ProgramReflection.h"
 #include "Core/Program/ProgramVars.h"
 #include "Core/Program/ProgramVersion.h"
+#include "Core/Program/ShaderCache.h"
 #include "Core/Program/ShaderLibrary.h"
 
 // Core/State
@@ -119,16 +120,19 @@
 // Utils
 #include "Utils/Math/AABB.h"
 #include "Utils/BinaryFileStream.h"
+#include "Utils/Hash.h"
 #include "Utils/Logger.h"
 #include "Utils/NumericRange.h"
 #include "Utils/StringUtils.h"
 #include "Utils/TermColor.h"
 #include "Utils/Threading.h"
+#include "Utils/WorkQueue.h"
 #include "Utils/Algorithm/DirectedGraph.h"
 #include "Utils/Algorithm/DirectedGraphTraversal.h"
 #include "Utils/Algorithm/ParallelReduction.h"
 #include "Utils/Image/Bitmap.h"
 #include "Utils/Image/ImageIO.h"
+#include "Utils/Image/TextureReadback.h"
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Scripting/Dictionary.h"
@@ -102,7 +102,8 @@ namespace Falcor
             assert(mNameToIndex.count(name) == 0);
             mNameToIndex[name] = (uint32_t)mResourceData.size();
             bool resolveBindFlags = (field.getBindFlags() == ResourceBindFlags::None);
-            mResourceData.push_back({ field, {timePoint, timePoint}, nullptr, resolveBindFlags, name });
+            bool persistent = is_set(field.getFlags(), RenderPassReflection::Field::Flags::Persistent);
+            mResourceData.push_back({ field, {timePoint, timePoint}, nullptr, resolveBindFlags, name, persistent });
         }
         else // Add alias
         {
@@ -112,81 +113,213 @@ namespace Falcor
             mergeTimePoint(mResourceData[index].lifetime, timePoint);
             mResourceData[index].pResource = nullptr;
             mResourceData[index].resolveBindFlags = mResourceData[index].resolveBindFlags || (field.getBindFlags() == ResourceBindFlags::None);
+            mResourceData[index].persistent = mResourceData[index].persistent || is_set(field.getFlags(), RenderPassReflection::Field::Flags::Persistent);
         }
     }
 
-    Resource::SharedPtr createResourceForPass(const ResourceCache::DefaultProperties& params, const RenderPassReflection::Field& field, bool resolveBindFlags, const std::string& resourceName)
+    namespace
     {
-        uint32_t width = field.getWidth() ? field.getWidth() : params.dims.x;
-        uint32_t height = field.getHeight() ? field.getHeight() : params.dims.y;
-        uint32_t depth = field.getDepth() ? field.getDepth() : 1;
-        uint32_t sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
-        auto bindFlags = field.getBindFlags();
-        auto arraySize = field.getArraySize();
-        auto mipLevels = field.getMipCount();
+        ResourceCache::ResourceDesc resolveResourceDesc(const ResourceCache::DefaultProperties& params, const RenderPassReflection::Field& field, bool resolveBindFlags)
+        {
+            ResourceCache::ResourceDesc desc;
+            desc.type = field.getType();
+            desc.width = field.getWidth() ? field.getWidth() : params.dims.x;
+            desc.height = field.getHeight() ? field.getHeight() : params.dims.y;
+            desc.depth = field.getDepth() ? field.getDepth() : 1;
+            desc.sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
+            desc.bindFlags = field.getBindFlags();
+            desc.arraySize = field.getArraySize();
+            desc.mipLevels = field.getMipCount();
 
-        ResourceFormat format = ResourceFormat::Unknown;
+            if (field.getType() != RenderPassReflection::Field::Type::RawBuffer)
+            {
+                desc.format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
+                if (resolveBindFlags)
+                {
+                    ResourceBindFlags mask = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
+                    bool isOutput = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Output);
+                    bool isInternal = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Internal);
+                    if (isOutput || isInternal) mask |= Resource::BindFlags::DepthStencil | Resource::BindFlags::RenderTarget;
+                    auto supported = getFormatBindFlags(desc.format);
+                    mask &= supported;
+                    desc.bindFlags |= mask;
+                }
+            }
+            else // RawBuffer
+            {
+                if (resolveBindFlags) desc.bindFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
+            }
+            return desc;
+        }
 
-        if (field.getType() != RenderPassReflection::Field::Type::RawBuffer)
+        Resource::SharedPtr createResource(const ResourceCache::ResourceDesc& desc, const std::string& resourceName)
         {
-            format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
-            if (resolveBindFlags)
+            Resource::SharedPtr pResource;
+
+            switch (desc.type)
             {
-                ResourceBindFlags mask = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
-                bool isOutput = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Output);
-                bool isInternal = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Internal);
-                if (isOutput || isInternal) mask |= Resource::BindFlags::DepthStencil | Resource::BindFlags::RenderTarget;
-                auto supported = getFormatBindFlags(format);
-                mask &= supported;
-                bindFlags |= mask;
+            case RenderPassReflection::Field::Type::RawBuffer:
+                pResource = Buffer::create(desc.width, desc.bindFlags, Buffer::CpuAccess::None);
+                break;
+            case RenderPassReflection::Field::Type::Texture1D:
+                pResource = Texture::create1D(desc.width, desc.format, desc.arraySize, desc.mipLevels, nullptr, desc.bindFlags);
+                break;
+            case RenderPassReflection::Field::Type::Texture2D:
+                if (desc.sampleCount > 1)
+                {
+                    pResource = Texture::create2DMS(desc.width, desc.height, desc.format, desc.sampleCount, desc.arraySize, desc.bindFlags);
+                }
+                else
+                {
+                    pResource = Texture::create2D(desc.width, desc.height, desc.format, desc.arraySize, desc.mipLevels, nullptr, desc.bindFlags);
+                }
+                break;
+            case RenderPassReflection::Field::Type::Texture3D:
+                pResource = Texture::create3D(desc.width, desc.height, desc.depth, desc.format, desc.mipLevels, nullptr, desc.bindFlags);
+                break;
+            case RenderPassReflection::Field::Type::TextureCube:
+                pResource = Texture::createCube(desc.width, desc.height, desc.format, desc.arraySize, desc.mipLevels, nullptr, desc.bindFlags);
+                break;
+            default:
+                should_not_get_here();
+                return nullptr;
             }
+            pResource->setName(resourceName);
+            return pResource;
         }
-        else // RawBuffer
+    }
+
+    uint64_t ResourceCache::ResourceDesc::getSizeInBytes() const
+    {
+        if (type == RenderPassReflection::Field::Type::RawBuffer) return width;
+        if (format == ResourceFormat::Unknown) return 0;
+
+        const uint32_t d = type == RenderPassReflection::Field::Type::Texture3D ? depth : 1;
+        const uint32_t h = type == RenderPassReflection::Field::Type::Texture1D ? 1 : height;
+        const uint32_t faces = type == RenderPassReflection::Field::Type::TextureCube ? 6 : 1;
+        const uint32_t layers = (type == RenderPassReflection::Field::Type::Texture3D ? 1 : std::max(arraySize, 1u)) * faces;
+        const uint32_t mips = mipLevels == Texture::kMaxPossible ? bitScanReverse(width | h | d) + 1 : std::max(mipLevels, 1u);
+
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+
+        uint64_t size = 0;
+        for (uint32_t mip = 0; mip < mips; mip++)
         {
-            if (resolveBindFlags) bindFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
+            uint64_t blocksX = div_round_up(std::max(width >> mip, 1u), blockWidth);
+            uint64_t blocksY = div_round_up(std::max(h >> mip, 1u), blockHeight);
+            uint64_t slices = std::max(d >> mip, 1u);
+            size += blocksX * blocksY * slices * getFormatBytesPerBlock(format);
         }
-        Resource::SharedPtr pResource;
+        return size * layers * std::max(sampleCount, 1u);
+    }
+
+    bool ResourceCache::ResourceDesc::operator==(const ResourceDesc& other) const
+    {
+        return type == other.type && width == other.width && height == other.height && depth == other.depth &&
+            sampleCount == other.sampleCount && arraySize == other.arraySize && mipLevels == other.mipLevels &&
+            format == other.format && bindFlags == other.bindFlags;
+    }
+
+    ResourceCache::MemoryPlan ResourceCache::planMemory(const std::vector<ResourceUsage>& resources)
+    {
+        MemoryPlan plan;
+        plan.allocationIndices.resize(resources.size());
 
-        switch (field.getType())
+        // Process the resources in order of their first use. Greedily assigning each resource to any compatible allocation
+        // that is free at that time is optimal for interval graphs, i.e., it uses as many allocations per class of compatible
+        // resources as there are overlapping lifetimes at the busiest time point.
+        std::vector<uint32_t> order(resources.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return resources[a].lifetime.first < resources[b].lifetime.first; });
+
+        struct Allocation
+        {
+            uint32_t resourceIndex;     // First resource assigned to the allocation, which defines the creation parameters
+            uint32_t lastUse;           // Last time point at which the allocation is in use
+            bool transient;
+        };
+        std::vector<Allocation> allocations;
+
+        for (uint32_t i : order)
         {
-        case RenderPassReflection::Field::Type::RawBuffer:
-            pResource = Buffer::create(width, bindFlags, Buffer::CpuAccess::None);
-            break;
-        case RenderPassReflection::Field::Type::Texture1D:
-            pResource = Texture::create1D(width, format, arraySize, mipLevels, nullptr, bindFlags);
-            break;
-        case RenderPassReflection::Field::Type::Texture2D:
-            if (sampleCount > 1)
+            const auto& resource = resources[i];
+            plan.unaliasedMemory += resource.desc.getSizeInBytes();
+
+            uint32_t allocationIndex = uint32_t(-1);
+            if (resource.transient)
+            {
+                for (uint32_t a = 0; a < (uint32_t)allocations.size(); a++)
+                {
+                    const auto& allocation = allocations[a];
+                    if (allocation.transient && allocation.lastUse < resource.lifetime.first && resources[allocation.resourceIndex].desc == resource.desc)
+                    {
+                        allocationIndex = a;
+                        break;
+                    }
+                }
+            }
+
+            if (allocationIndex == uint32_t(-1))
             {
-                pResource = Texture::create2DMS(width, height, format, sampleCount, arraySize, bindFlags);
+                allocationIndex = (uint32_t)allocations.size();
+                allocations.push_back({ i, resource.lifetime.second, resource.transient });
+                plan.allocationSizes.push_back(resource.desc.getSizeInBytes());
+                plan.aliasedMemory += plan.allocationSizes.back();
             }
             else
             {
-                pResource = Texture::create2D(width, height, format, arraySize, mipLevels, nullptr, bindFlags);
+                allocations[allocationIndex].lastUse = resource.lifetime.second;
             }
-            break;
-        case RenderPassReflection::Field::Type::Texture3D:
-            pResource = Texture::create3D(width, height, depth, format, mipLevels, nullptr, bindFlags);
-            break;
-        case RenderPassReflection::Field::Type::TextureCube:
-            pResource = Texture::createCube(width, height, format, arraySize, mipLevels, nullptr, bindFlags);
-            break;
-        default:
-            should_not_get_here();
-            return nullptr;
+
+            plan.allocationIndices[i] = allocationIndex;
         }
-        pResource->setName(resourceName);
-        return pResource;
+
+        return plan;
     }
 
     void ResourceCache::allocateResources(const DefaultProperties& params)
     {
-        for (auto& data : mResourceData)
+        // Gather the resources that need to be created.
+        std::vector<uint32_t> resourceIndices;
+        std::vector<ResourceUsage> usages;
+        for (uint32_t i = 0; i < (uint32_t)mResourceData.size(); i++)
         {
+            const auto& data = mResourceData[i];
             if ((data.pResource == nullptr) && (data.field.isValid()))
             {
-                data.pResource = createResourceForPass(params, data.field, data.resolveBindFlags, data.name);
+                // Graph outputs (lifetime ends at -1), internal and persistent resources must keep their data between executions.
+                bool transient = params.aliasTransientResources && data.lifetime.second != uint32_t(-1) && !data.persistent &&
+                    !is_set(data.field.getVisibility(), RenderPassReflection::Field::Visibility::Internal);
+
+                resourceIndices.push_back(i);
+                usages.push_back({ resolveResourceDesc(params, data.field, data.resolveBindFlags), data.lifetime, transient });
             }
         }
+
+        if (resourceIndices.empty()) return;
+
+        // Plan the allocations and create one resource per allocation.
+        mMemoryPlan = planMemory(usages);
+
+        std::vector<Resource::SharedPtr> allocations(mMemoryPlan.allocationSizes.size());
+        std::vector<std::string> allocationNames(allocations.size());
+        for (size_t i = 0; i < resourceIndices.size(); i++)
+        {
+            uint32_t a = mMemoryPlan.allocationIndices[i];
+            const auto& name = mResourceData[resourceIndices[i]].name;
+            allocationNames[a] += (allocationNames[a].empty() ? "" : " | ") + name;
+        }
+
+        for (size_t i = 0; i < resourceIndices.size(); i++)
+        {
+            uint32_t a = mMemoryPlan.allocationIndices[i];
+            if (allocations[a] == nullptr) allocations[a] = createResource(usages[i].desc, allocationNames[a]);
+            mResourceData[resourceIndices[i]].pResource = allocations[a];
+        }
+
+        auto toMB = [](uint64_t bytes) { return std::to_string(bytes / (1024.0 * 1024.0)); };
+        logInfo("ResourceCache: Allocated " + std::to_string(resourceIndices.size()) + " resources in " + std::to_string(allocations.size()) + " allocations. " +
+            "Memory usage " + toMB(mMemoryPlan.unaliasedMemory) + " MB without aliasing, " + toMB(mMemoryPlan.aliasedMemory) + " MB with aliasing.");
     }
 }
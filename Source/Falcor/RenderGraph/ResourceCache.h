@@ -47,8 +47,59 @@ namespace Falcor
         {
             uint2 dims;                                         ///< Width, height of the swap chain
             ResourceFormat format = ResourceFormat::Unknown;    ///< Format to use for texture creation
+            bool aliasTransientResources = true;                ///< Share resources between graph fields whose lifetimes don't overlap
         };
 
+        /** Fully resolved creation parameters of a graph resource.
+        */
+        struct ResourceDesc
+        {
+            RenderPassReflection::Field::Type type = RenderPassReflection::Field::Type::Texture2D;
+            uint32_t width = 0;                                 ///< Width in texels, or size in bytes for buffers
+            uint32_t height = 0;
+            uint32_t depth = 0;
+            uint32_t sampleCount = 0;
+            uint32_t arraySize = 0;
+            uint32_t mipLevels = 0;
+            ResourceFormat format = ResourceFormat::Unknown;
+            ResourceBindFlags bindFlags = ResourceBindFlags::None;
+
+            /** Estimate the memory size of the resource. Doesn't account for alignment or padding added by the driver.
+            */
+            uint64_t getSizeInBytes() const;
+
+            bool operator==(const ResourceDesc& other) const;
+            bool operator!=(const ResourceDesc& other) const { return !(*this == other); }
+        };
+
+        /** Describes how a graph resource is used, as input to the memory planning.
+        */
+        struct ResourceUsage
+        {
+            ResourceDesc desc;                          ///< Creation parameters
+            std::pair<uint32_t, uint32_t> lifetime;     ///< First and last time point the resource is used at (inclusive)
+            bool transient = true;                      ///< Whether the resource may share its allocation with other resources
+        };
+
+        /** Result of the memory planning.
+        */
+        struct MemoryPlan
+        {
+            std::vector<uint32_t> allocationIndices;    ///< Index of the allocation used by each resource
+            std::vector<uint64_t> allocationSizes;      ///< Size in bytes of each allocation
+            uint64_t unaliasedMemory = 0;               ///< Memory in bytes used if every resource has its own allocation
+            uint64_t aliasedMemory = 0;                 ///< Memory in bytes used by the planned allocations
+        };
+
+        /** Plan the allocations for a set of resources.
+            Transient resources with identical creation parameters and non-overlapping lifetimes are assigned to the same allocation.
+            Each class of compatible resources is colored as an interval graph, which gives the minimum number of allocations per class.
+            This only runs on the CPU and doesn't create any resources.
+            \param[in] resources The resources to plan.
+            \return The memory plan.
+        */
+        static MemoryPlan planMemory(const std::vector<ResourceUsage>& resources);
+
         /** Add/Remove reference to a graph input resource not owned by the cache
             \param[in] name The resource's name
             \param[in] pResource The resource to register. If this is null, will unregister the resource
@@ -77,6 +128,10 @@ namespace Falcor
         */
         void allocateResources(const DefaultProperties& params);
 
+        /** Get the memory plan of the last allocateResources() call.
+        */
+        const MemoryPlan& getMemoryPlan() const { return mMemoryPlan; }
+
         /** Clears all registered field/resource properties and allocated resources.
         */
         void reset();
@@ -91,6 +146,7 @@ namespace Falcor
             Resource::SharedPtr pResource;          // The resource
             bool resolveBindFlags;                  // Whether or not we should resolve the field's bind-flags before creating the resource
             std::string name;                       // Full name of the resource, including the pass name
+            bool persistent;                        // Whether any of the aliased fields requires the resource data to persist between executions
         };
 
         // Resources and properties for fields within (and therefore owned by) a render graph
@@ -99,6 +155,8 @@ namespace Falcor
 
         // References to output resources not to be allocated by the render graph
         ResourcesMap mExternalResources;
+
+        MemoryPlan mMemoryPlan;
     };
 
 }
@@ -37,6 +37,9 @@ namespace Falcor
     {
         const double kEpsilonTime = 1e-5f;
 
+        // Minimum number of animations for evaluating a batch in parallel.
+        const size_t kMinParallelBatchSize = 256;
+
         const Gui::DropdownList kChannelLoopModeDropdown =
         {
             { (uint32_t)Animation::Behavior::Constant, "Constant" },
@@ -81,6 +84,13 @@ namespace Falcor
             return slerp(qq0, qq1, t);
         }
 
+        // Returns the first keyframe at or after the given time in a range of keyframes sorted by time.
+        template<typename Iterator>
+        Iterator findKeyframe(Iterator begin, Iterator end, double time)
+        {
+            return std::lower_bound(begin, end, time, [](const Animation::Keyframe& k, double t) { return k.time < t; });
+        }
+
         // This function performs linear extrapolation when either t < 0 or t > 1
         Animation::Keyframe interpolateLinear(const Animation::Keyframe& k0, const Animation::Keyframe& k1, float t)
         {
@@ -116,6 +126,60 @@ namespace Falcor
     {}
 
     glm::mat4 Animation::animate(double currentTime)
+    {
+        Keyframe interpolated = evaluate(currentTime);
+
+        glm::mat4 T = translate(interpolated.translation);
+        glm::mat4 R = mat4_cast(interpolated.rotation);
+        glm::mat4 S = scale(interpolated.scaling);
+        glm::mat4 transform = T * R * S;
+
+        return transform;
+    }
+
+    void Animation::animate(const std::vector<SharedPtr>& animations, double currentTime, BatchResult& result)
+    {
+        result.resize(animations.size());
+
+        auto evaluateAnimation = [&](uint32_t i)
+        {
+            Keyframe interpolated = animations[i]->evaluate(currentTime);
+            result.translations[i] = interpolated.translation;
+            result.rotations[i] = interpolated.rotation;
+            result.scalings[i] = interpolated.scaling;
+        };
+
+        const uint32_t count = (uint32_t)animations.size();
+        if (count >= kMinParallelBatchSize) Threading::parallelFor(0, count, evaluateAnimation);
+        else for (uint32_t i = 0; i < count; ++i) evaluateAnimation(i);
+    }
+
+    void Animation::BatchResult::resize(size_t count)
+    {
+        translations.resize(count);
+        rotations.resize(count);
+        scalings.resize(count);
+    }
+
+    glm::mat4 Animation::BatchResult::getMatrix(size_t index) const
+    {
+        // Equivalent to T * R * S, with the scaling applied to the columns of the rotation matrix.
+        glm::mat3 R = glm::mat3_cast(rotations[index]);
+        const float3& s = scalings[index];
+        return glm::mat4(
+            float4(R[0] * s.x, 0.f),
+            float4(R[1] * s.y, 0.f),
+            float4(R[2] * s.z, 0.f),
+            float4(translations[index], 1.f));
+    }
+
+    void Animation::BatchResult::getMatrices(std::vector<glm::mat4>& matrices) const
+    {
+        matrices.resize(size());
+        for (size_t i = 0; i < matrices.size(); i++) matrices[i] = getMatrix(i);
+    }
+
+    Animation::Keyframe Animation::evaluate(double currentTime) const
     {
         // Calculate the sample time.
         double time = currentTime;
@@ -128,15 +192,13 @@ namespace Falcor
         bool isLinearPostInfinity = time > mKeyframes.back().time && this->getPostInfinityBehavior() == Behavior::Linear;
         bool isLinearPreInfinity = time < mKeyframes.front().time && this->getPreInfinityBehavior() == Behavior::Linear;
 
-        Keyframe interpolated;
-
         if (isLinearPreInfinity && mKeyframes.size() > 1)
         {
             const auto& k0 = mKeyframes.front();
             auto k1 = interpolate(mInterpolationMode, k0.time + kEpsilonTime);
             double segmentDuration = k1.time - k0.time;
             float t = (float)((time - k0.time) / segmentDuration);
-            interpolated = interpolateLinear(k0, k1, t);
+            return interpolateLinear(k0, k1, t);
         }
         else if (isLinearPostInfinity && mKeyframes.size() > 1)
         {
@@ -144,38 +206,19 @@ namespace Falcor
             auto k0 = interpolate(mInterpolationMode, k1.time - kEpsilonTime);
             double segmentDuration = k1.time - k0.time;
             float t = (float)((time - k0.time) / segmentDuration);
-            interpolated = interpolateLinear(k0, k1, t);
+            return interpolateLinear(k0, k1, t);
         }
         else
         {
-            interpolated = interpolate(mInterpolationMode, time);
+            return interpolate(mInterpolationMode, time);
         }
-
-        glm::mat4 T = translate(interpolated.translation);
-        glm::mat4 R = mat4_cast(interpolated.rotation);
-        glm::mat4 S = scale(interpolated.scaling);
-        glm::mat4 transform = T * R * S;
-
-        return transform;
     }
 
     Animation::Keyframe Animation::interpolate(InterpolationMode mode, double time) const
     {
         assert(!mKeyframes.empty());
 
-        // Validate cached frame index.
-        size_t frameIndex = clamp(mCachedFrameIndex, (size_t)0, mKeyframes.size() - 1);
-        if (time < mKeyframes[frameIndex].time) frameIndex = 0;
-
-        // Find frame index.
-        while (frameIndex < mKeyframes.size() - 1)
-        {
-            if (mKeyframes[frameIndex + 1].time > time) break;
-            frameIndex++;
-        }
-
-        // Cache frame index;
-        mCachedFrameIndex = frameIndex;
+        size_t frameIndex = findFrameIndex(time);
 
         // Compute index of adjacent frame including optional warping.
         auto adjacentFrame = [this] (size_t frame, int32_t offset = 1)
@@ -222,11 +265,38 @@ namespace Falcor
         }
     }
 
+    // Finds the last keyframe at or before the given time, or the first keyframe if the time lies before it.
+    size_t Animation::findFrameIndex(double time) const
+    {
+        assert(!mKeyframes.empty());
+        const size_t lastIndex = mKeyframes.size() - 1;
+
+        // Fast path for continuous playback: check the cached segment and the one after it.
+        size_t frameIndex = std::min(mCachedFrameIndex, lastIndex);
+        for (size_t i = frameIndex; i <= std::min(frameIndex + 1, lastIndex); i++)
+        {
+            bool afterStart = i == 0 || mKeyframes[i].time <= time;
+            bool beforeEnd = i == lastIndex || mKeyframes[i + 1].time > time;
+            if (afterStart && beforeEnd)
+            {
+                mCachedFrameIndex = i;
+                return i;
+            }
+        }
+
+        // Binary search for seeking, scrubbing and oscillating playback.
+        auto it = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), time, [](double t, const Keyframe& k) { return t < k.time; });
+        frameIndex = it == mKeyframes.begin() ? 0 : (size_t)(it - mKeyframes.begin()) - 1;
+
+        mCachedFrameIndex = frameIndex;
+        return frameIndex;
+    }
+
     // Calculates the sample time within the keyframe range if the current time lies outside and
     // the animation does not behave linearly. If the animation behaves linearly, then the
     // current time is returned. This function should not be used if the current time lies
     // within the range of defined keyframe times.
-    double Animation::calcSampleTime(double currentTime)
+    double Animation::calcSampleTime(double currentTime) const
     {
         double modifiedTime = currentTime;
         double firstKeyframeTime = mKeyframes.front().time;
@@ -261,56 +331,26 @@ namespace Falcor
     {
         assert(keyframe.time <= mDuration);
 
-        if (mKeyframes.size() == 0 || mKeyframes[0].time > keyframe.time)
-        {
-            mKeyframes.insert(mKeyframes.begin(), keyframe);
-            return;
-        }
-        else
-        {
-            for (size_t i = 0; i < mKeyframes.size(); i++)
-            {
-                auto& current = mKeyframes[i];
-                // If we already have a key-frame at the same time, replace it
-                if (current.time == keyframe.time)
-                {
-                    current = keyframe;
-                    return;
-                }
-
-                // If this is not the last frame, Check if we are in between frames
-                if (i < mKeyframes.size() - 1)
-                {
-                    auto& Next = mKeyframes[i + 1];
-                    if (current.time < keyframe.time && Next.time > keyframe.time)
-                    {
-                        mKeyframes.insert(mKeyframes.begin() + i + 1, keyframe);
-                        return;
-                    }
-                }
-            }
-
-            // If we got here, need to push it to the end of the list
-            mKeyframes.push_back(keyframe);
-        }
+        // Keyframes are sorted by time. If we already have a keyframe at the same time, replace it.
+        auto it = findKeyframe(mKeyframes.begin(), mKeyframes.end(), keyframe.time);
+        if (it != mKeyframes.end() && it->time == keyframe.time) *it = keyframe;
+        else mKeyframes.insert(it, keyframe);
     }
 
     const Animation::Keyframe& Animation::getKeyframe(double time) const
     {
-        for (const auto& k : mKeyframes)
+        auto it = findKeyframe(mKeyframes.begin(), mKeyframes.end(), time);
+        if (it == mKeyframes.end() || it->time != time)
         {
-            if (k.time == time) return k;
+            throw std::runtime_error(("Animation::getKeyframe() - can't find a keyframe at time " + std::to_string(time)).c_str());
         }
-        throw std::runtime_error(("Animation::getKeyframe() - can't find a keyframe at time " + std::to_string(time)).c_str());
+        return *it;
     }
 
     bool Animation::doesKeyframeExists(double time) const
     {
-        for (const auto& k : mKeyframes)
-        {
-            if (k.time == time) return true;
-        }
-        return false;
+        auto it = findKeyframe(mKeyframes.begin(), mKeyframes.end(), time);
+        return it != mKeyframes.end() && it->time == time;
     }
 
     void Animation::renderUI(Gui::Widgets& widget)
@@ -59,6 +59,36 @@ namespace Falcor
             glm::quat rotation = glm::quat(1, 0, 0, 0);
         };
 
+        /** Result of evaluating a batch of animations at one time.
+            The transforms are stored in structure-of-arrays layout, indexed by the animation's position in the batch.
+        */
+        struct BatchResult
+        {
+            std::vector<float3> translations;
+            std::vector<glm::quat> rotations;
+            std::vector<float3> scalings;
+
+            /** Resize the arrays.
+                \param[in] count Number of animations.
+            */
+            void resize(size_t count);
+
+            /** Get the number of animations.
+            */
+            size_t size() const { return translations.size(); }
+
+            /** Compute the transform matrix T * R * S for an animation in the batch.
+                \param[in] index Index of the animation in the batch.
+                \return Returns the transform matrix.
+            */
+            glm::mat4 getMatrix(size_t index) const;
+
+            /** Compute the transform matrices for all animations in the batch.
+                \param[out] matrices Transform matrices, resized to the batch size.
+            */
+            void getMatrices(std::vector<glm::mat4>& matrices) const;
+        };
+
         /** Create a new animation.
             \param[in] name Animation name.
             \param[in] nodeID ID of the animated node.
@@ -136,6 +166,14 @@ namespace Falcor
         */
         glm::mat4 animate(double currentTime);
 
+        /** Compute a batch of animations at the same time.
+            Large batches are evaluated in parallel, each animation is evaluated by a single thread.
+            \param[in] animations Animations to evaluate.
+            \param[in] currentTime The current time in seconds.
+            \param[out] result Interpolated translation, rotation and scaling of each animation.
+        */
+        static void animate(const std::vector<SharedPtr>& animations, double currentTime, BatchResult& result);
+
         /* Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
@@ -143,8 +181,10 @@ namespace Falcor
     private:
         Animation(const std::string& name, uint32_t nodeID, double duration);
 
+        Keyframe evaluate(double currentTime) const;
         Keyframe interpolate(InterpolationMode mode, double time) const;
-        double calcSampleTime(double currentTime);
+        size_t findFrameIndex(double time) const;
+        double calcSampleTime(double currentTime) const;
 
         const std::string mName;
         uint32_t mNodeID;
@@ -157,6 +197,8 @@ namespace Falcor
         bool mEnableWarping = false;
 
         std::vector<Keyframe> mKeyframes;
-        mutable size_t mCachedFrameIndex = 0;
+        mutable size_t mCachedFrameIndex = 0; // Index of the last keyframe found. Speeds up lookups for continuous playback.
+
+        friend class SceneCache;
     };
 }
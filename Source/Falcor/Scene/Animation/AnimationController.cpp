@@ -36,21 +36,47 @@ namespace Falcor
         const std::string kWorldMatrices = "worldMatrices";
         const std::string kInverseTransposeWorldMatrices = "inverseTransposeWorldMatrices";
         const std::string kPreviousFrameWorldMatrices = "previousFrameWorldMatrices";
+
+        // Changed matrix ranges separated by at most this many unchanged matrices are uploaded together.
+        const uint32_t kMaxUploadRangeGap = 16;
+
+        TransformHierarchy createTransformHierarchy(const Scene* pScene, const std::vector<Animation::SharedPtr>& animations, bool skinning)
+        {
+            const auto& sceneGraph = pScene->mSceneGraph;
+            std::vector<uint32_t> parents(sceneGraph.size());
+            std::vector<glm::mat4> localMatrices(sceneGraph.size());
+            std::vector<glm::mat4> localToBindSpace(skinning ? sceneGraph.size() : 0);
+            for (size_t i = 0; i < sceneGraph.size(); i++)
+            {
+                parents[i] = sceneGraph[i].parent;
+                localMatrices[i] = sceneGraph[i].transform;
+                if (skinning) localToBindSpace[i] = sceneGraph[i].localToBindSpace;
+            }
+
+            // Tag all matrices affected by an animation. The flags are propagated to the descendants by the hierarchy.
+            std::vector<bool> animated(sceneGraph.size(), false);
+            for (const auto& pAnimation : animations) animated[pAnimation->getNodeID()] = true;
+
+            return TransformHierarchy(std::move(parents), std::move(localMatrices), animated, std::move(localToBindSpace));
+        }
+
+        void uploadRanges(Buffer* pBuffer, const std::vector<glm::mat4>& matrices, const std::vector<TransformHierarchy::Range>& ranges)
+        {
+            for (const auto& range : ranges)
+            {
+                pBuffer->setBlob(matrices.data() + range.offset, range.offset * sizeof(glm::mat4), range.count * sizeof(glm::mat4));
+            }
+        }
     }
 
     AnimationController::AnimationController(Scene* pScene, const StaticVertexVector& staticVertexData, const DynamicVertexVector& dynamicVertexData, const std::vector<Animation::SharedPtr>& animations)
         : mpScene(pScene)
-        , mLocalMatrices(pScene->mSceneGraph.size())
-        , mInvTransposeGlobalMatrices(pScene->mSceneGraph.size())
-        , mMatricesAnimated(pScene->mSceneGraph.size())
-        , mMatricesChanged(pScene->mSceneGraph.size())
         , mAnimations(animations)
+        , mTransforms(createTransformHierarchy(pScene, animations, !dynamicVertexData.empty()))
     {
-        initFlags();
-
         // Create GPU resources.
-        assert(mLocalMatrices.size() * 4 <= std::numeric_limits<uint32_t>::max());
-        uint32_t float4Count = (uint32_t)mLocalMatrices.size() * 4;
+        assert((size_t)mTransforms.getNodeCount() * 4 <= std::numeric_limits<uint32_t>::max());
+        uint32_t float4Count = mTransforms.getNodeCount() * 4;
 
         mpWorldMatricesBuffer = Buffer::createStructured(sizeof(float4), float4Count, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
         mpWorldMatricesBuffer->setName("AnimationController::mpWorldMatricesBuffer");
@@ -81,41 +107,11 @@ namespace Falcor
         mAnimationChanged = true;
     }
 
-    void AnimationController::initFlags()
-    {
-        std::fill(mMatricesAnimated.begin(), mMatricesAnimated.end(), false);
-
-        // Tag all matrices affected by an animation.
-        for (const auto& pAnimation : mAnimations)
-        {
-            mMatricesAnimated[pAnimation->getNodeID()] = true;
-        }
-
-        // Traverse the scene graph hierarchy to propagate the flags.
-        assert(mpScene->mSceneGraph.size() == mMatricesAnimated.size());
-        for (size_t i = 0; i < mMatricesAnimated.size(); i++)
-        {
-            if (uint32_t parent = mpScene->mSceneGraph[i].parent; parent != SceneBuilder::kInvalidNode)
-            {
-                assert(parent < i);
-                mMatricesAnimated[i] = mMatricesAnimated[i] || mMatricesAnimated[parent];
-            }
-        }
-    }
-
-    void AnimationController::initLocalMatrices()
-    {
-        for (size_t i = 0; i < mLocalMatrices.size(); i++)
-        {
-            mLocalMatrices[i] = mpScene->mSceneGraph[i].transform;
-        }
-    }
-
     bool AnimationController::animate(RenderContext* pContext, double currentTime)
     {
         PROFILE("animate");
 
-        mMatricesChanged.assign(mMatricesChanged.size(), false);
+        mTransforms.clearChanges();
 
         if (mAnimationChanged == false)
         {
@@ -127,7 +123,7 @@ namespace Falcor
                 return false;
             }
         }
-        else initLocalMatrices();
+        else mTransforms.resetLocalMatrices();
 
         mAnimationChanged = false;
         mLastAnimationTime = currentTime;
@@ -135,11 +131,10 @@ namespace Falcor
         if (mEnabled)
         {
             double time = (mLoopAnimations == true) ? std::fmod(currentTime, mGlobalAnimationLength) : currentTime;
-            for (auto& pAnimation : mAnimations)
+            Animation::animate(mAnimations, time, mAnimationBatch);
+            for (size_t i = 0; i < mAnimations.size(); i++)
             {
-                uint32_t nodeID = pAnimation->getNodeID();
-                mLocalMatrices[nodeID] = pAnimation->animate(time);
-                mMatricesChanged[nodeID] = true;
+                mTransforms.setLocalMatrix(mAnimations[i]->getNodeID(), mAnimationBatch.getMatrix(i));
             }
         }
 
@@ -153,28 +148,17 @@ namespace Falcor
 
     void AnimationController::updateMatrices()
     {
-        // We can optimize this
-        mGlobalMatrices = mLocalMatrices;
+        mTransforms.update();
 
-        for (size_t i = 0; i < mGlobalMatrices.size(); i++)
-        {
-            if (mpScene->mSceneGraph[i].parent != SceneBuilder::kInvalidNode)
-            {
-                mGlobalMatrices[i] = mGlobalMatrices[mpScene->mSceneGraph[i].parent] * mGlobalMatrices[i];
-                mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[mpScene->mSceneGraph[i].parent];
-                assert(!mMatricesChanged[i] || mMatricesAnimated[i]);
-            }
+        mPrevChangedRanges = std::move(mChangedRanges);
+        mChangedRanges = mTransforms.getChangedRanges(kMaxUploadRangeGap);
 
-            mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
-
-            if (mpSkinningPass)
-            {
-                mSkinningMatrices[i] = mGlobalMatrices[i] * mpScene->mSceneGraph[i].localToBindSpace;
-                mInvTransposeSkinningMatrices[i] = transpose(inverse(mSkinningMatrices[i]));
-            }
-        }
-        mpWorldMatricesBuffer->setBlob(mGlobalMatrices.data(), 0, mpWorldMatricesBuffer->getSize());
-        mpInvTransposeWorldMatricesBuffer->setBlob(mInvTransposeGlobalMatrices.data(), 0, mpInvTransposeWorldMatricesBuffer->getSize());
+        // The world matrices are double buffered. The buffer we write to was last updated two frames ago,
+        // so the matrices that changed in the previous frame need to be uploaded as well.
+        const auto& globalMatrices = mTransforms.getGlobalMatrices();
+        uploadRanges(mpWorldMatricesBuffer.get(), globalMatrices, mPrevChangedRanges);
+        uploadRanges(mpWorldMatricesBuffer.get(), globalMatrices, mChangedRanges);
+        uploadRanges(mpInvTransposeWorldMatricesBuffer.get(), mTransforms.getInvTransposeGlobalMatrices(), mChangedRanges);
     }
 
     void AnimationController::bindBuffers()
@@ -203,15 +187,16 @@ namespace Falcor
     void AnimationController::createSkinningPass(const std::vector<PackedStaticVertexData>& staticVertexData, const std::vector<DynamicVertexData>& dynamicVertexData)
     {
         // We always copy the static data, to initialize the non-skinned vertices.
+        // Scenes using the compact vertex format have no standard vertex data. Their vertex buffer is initialized by the scene builder.
         const Buffer::SharedPtr& pVB = mpScene->mpVao->getVertexBuffer(Scene::kStaticDataBufferIndex);
-        assert(pVB->getSize() == staticVertexData.size() * sizeof(staticVertexData[0]));
-        pVB->setBlob(staticVertexData.data(), 0, pVB->getSize());
+        if (!staticVertexData.empty())
+        {
+            assert(pVB->getSize() == staticVertexData.size() * sizeof(staticVertexData[0]));
+            pVB->setBlob(staticVertexData.data(), 0, pVB->getSize());
+        }
 
         if (!dynamicVertexData.empty())
         {
-            mSkinningMatrices.resize(mpScene->mSceneGraph.size());
-            mInvTransposeSkinningMatrices.resize(mSkinningMatrices.size());
-
             mpSkinningPass = ComputePass::create("Scene/Animation/Skinning.slang");
             auto block = mpSkinningPass->getVars()["gData"];
 
@@ -240,8 +225,8 @@ namespace Falcor
             block["prevSkinnedVertices"] = mpPrevVertexData;
 
             // Bind transforms.
-            assert(mSkinningMatrices.size() * 4 < std::numeric_limits<uint32_t>::max());
-            uint32_t float4Count = (uint32_t)mSkinningMatrices.size() * 4;
+            assert((size_t)mTransforms.getNodeCount() * 4 < std::numeric_limits<uint32_t>::max());
+            uint32_t float4Count = mTransforms.getNodeCount() * 4;
             mpSkinningMatricesBuffer = Buffer::createStructured(sizeof(float4), float4Count, ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
             mpSkinningMatricesBuffer->setName("AnimationController::mpSkinningMatricesBuffer");
             mpInvTransposeSkinningMatricesBuffer = Buffer::createStructured(sizeof(float4), float4Count, ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
@@ -259,8 +244,8 @@ namespace Falcor
     void AnimationController::executeSkinningPass(RenderContext* pContext)
     {
         if (!mpSkinningPass) return;
-        mpSkinningMatricesBuffer->setBlob(mSkinningMatrices.data(), 0, mpSkinningMatricesBuffer->getSize());
-        mpInvTransposeSkinningMatricesBuffer->setBlob(mInvTransposeSkinningMatrices.data(), 0, mpInvTransposeSkinningMatricesBuffer->getSize());
+        uploadRanges(mpSkinningMatricesBuffer.get(), mTransforms.getSkinningMatrices(), mChangedRanges);
+        uploadRanges(mpInvTransposeSkinningMatricesBuffer.get(), mTransforms.getInvTransposeSkinningMatrices(), mChangedRanges);
         mpSkinningPass->execute(pContext, mSkinningDispatchSize, 1, 1);
     }
 
@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "Animation.h"
+#include "TransformHierarchy.h"
 #include "RenderGraph/BasePasses/ComputePass.h"
 #include "Scene/SceneTypes.slang"
 
@@ -95,15 +96,15 @@ namespace Falcor
 
         /** Check if a matrix is animated.
         */
-        bool isMatrixAnimated(size_t matrixID) const { return mMatricesAnimated[matrixID]; }
+        bool isMatrixAnimated(size_t matrixID) const { return mTransforms.isAnimated(matrixID); }
 
         /** Check if a matrix changed since last frame.
         */
-        bool isMatrixChanged(size_t matrixID) const { return mMatricesChanged[matrixID]; }
+        bool isMatrixChanged(size_t matrixID) const { return mTransforms.isChanged(matrixID); }
 
         /** Get the global matrices.
         */
-        const std::vector<glm::mat4>& getGlobalMatrices() const { return mGlobalMatrices; }
+        const std::vector<glm::mat4>& getGlobalMatrices() const { return mTransforms.getGlobalMatrices(); }
 
         /** Render the UI.
         */
@@ -123,21 +124,18 @@ namespace Falcor
         friend class SceneBuilder;
         AnimationController(Scene* pScene, const StaticVertexVector& staticVertexData, const DynamicVertexVector& dynamicVertexData, const std::vector<Animation::SharedPtr>& animations);
 
-        void initFlags();
         void bindBuffers();
         void updateMatrices();
 
         void createSkinningPass(const std::vector<PackedStaticVertexData>& staticVertexData, const std::vector<DynamicVertexData>& dynamicVertexData);
         void executeSkinningPass(RenderContext* pContext);
-        void initLocalMatrices();
 
         // Animation
         std::vector<Animation::SharedPtr> mAnimations;
-        std::vector<glm::mat4> mLocalMatrices;
-        std::vector<glm::mat4> mGlobalMatrices;
-        std::vector<glm::mat4> mInvTransposeGlobalMatrices;
-        std::vector<bool> mMatricesAnimated;        ///< Flag per matrix, true if matrix is affected by animations.
-        std::vector<bool> mMatricesChanged;         ///< Flag per matrix, true if matrix changed since last frame.
+        Animation::BatchResult mAnimationBatch;                 ///< Interpolated transforms of all animations.
+        TransformHierarchy mTransforms;                         ///< Local/global matrices of the scene graph.
+        std::vector<TransformHierarchy::Range> mChangedRanges;  ///< Matrices changed in the current frame.
+        std::vector<TransformHierarchy::Range> mPrevChangedRanges; ///< Matrices changed in the previous frame.
 
         bool mEnabled = true;
         bool mAnimationChanged = true;
@@ -152,8 +150,6 @@ namespace Falcor
 
         // Skinning
         ComputePass::SharedPtr mpSkinningPass;
-        std::vector<glm::mat4> mSkinningMatrices;
-        std::vector<glm::mat4> mInvTransposeSkinningMatrices;
         uint32_t mSkinningDispatchSize = 0;
 
         Buffer::SharedPtr mpSkinningMatricesBuffer;
@@ -0,0 +1,164 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "TransformHierarchy.h"
+#include <glm/gtc/matrix_inverse.hpp>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Computes transpose(inverse(m)).
+            Scene graph transforms are almost always affine, for which the inverse only requires inverting the upper 3x3 part.
+        */
+        glm::mat4 inverseTranspose(const glm::mat4& m)
+        {
+            bool isAffine = m[0][3] == 0.f && m[1][3] == 0.f && m[2][3] == 0.f && m[3][3] == 1.f;
+            return glm::transpose(isAffine ? glm::affineInverse(m) : glm::inverse(m));
+        }
+    }
+
+    TransformHierarchy::TransformHierarchy(std::vector<uint32_t> parents, std::vector<glm::mat4> localMatrices, const std::vector<bool>& animated, std::vector<glm::mat4> localToBindSpace)
+        : mParents(std::move(parents))
+        , mInitialLocalMatrices(std::move(localMatrices))
+        , mLocalToBindSpace(std::move(localToBindSpace))
+        , mAnimated(animated)
+    {
+        const size_t nodeCount = mParents.size();
+        assert(nodeCount <= std::numeric_limits<uint32_t>::max());
+        assert(mInitialLocalMatrices.size() == nodeCount && mAnimated.size() == nodeCount);
+        assert(mLocalToBindSpace.empty() || mLocalToBindSpace.size() == nodeCount);
+
+        // Propagate the animated flags to the descendants and collect the animated nodes.
+        for (uint32_t i = 0; i < (uint32_t)nodeCount; i++)
+        {
+            if (uint32_t parent = mParents[i]; parent != kInvalidNode)
+            {
+                assert(parent < i);
+                mAnimated[i] = mAnimated[i] || mAnimated[parent];
+            }
+            if (mAnimated[i]) mAnimatedNodes.push_back(i);
+        }
+
+        mChanged.resize(nodeCount, false);
+        mLocalMatrices = mInitialLocalMatrices;
+        mGlobalMatrices.resize(nodeCount);
+        mInvTransposeGlobalMatrices.resize(nodeCount);
+        if (!mLocalToBindSpace.empty())
+        {
+            mSkinningMatrices.resize(nodeCount);
+            mInvTransposeSkinningMatrices.resize(nodeCount);
+        }
+    }
+
+    void TransformHierarchy::setLocalMatrix(uint32_t nodeID, const glm::mat4& matrix)
+    {
+        assert(mAnimated[nodeID]);
+        mLocalMatrices[nodeID] = matrix;
+        mChanged[nodeID] = true;
+    }
+
+    void TransformHierarchy::resetLocalMatrices()
+    {
+        mLocalMatrices = mInitialLocalMatrices;
+        mFullUpdate = true;
+    }
+
+    void TransformHierarchy::clearChanges()
+    {
+        // Only animated nodes can be flagged as changed.
+        for (uint32_t nodeID : mAnimatedNodes) mChanged[nodeID] = false;
+        mChangedNodes.clear();
+        mLastUpdateWasFull = false;
+    }
+
+    void TransformHierarchy::update()
+    {
+        mChangedNodes.clear();
+
+        if (mFullUpdate)
+        {
+            for (uint32_t i = 0; i < getNodeCount(); i++) updateNode(i);
+
+            // All animated nodes may have changed, for example when animations are disabled and the initial matrices are restored.
+            for (uint32_t nodeID : mAnimatedNodes) mChanged[nodeID] = true;
+            mChangedNodes = mAnimatedNodes;
+            mFullUpdate = false;
+            mLastUpdateWasFull = true;
+            return;
+        }
+
+        // Propagate the changed flags down the dirty subtrees. Only animated nodes can change,
+        // and as parents are stored before their children, a single pass over the animated nodes is sufficient.
+        for (uint32_t nodeID : mAnimatedNodes)
+        {
+            if (uint32_t parent = mParents[nodeID]; parent != kInvalidNode && mChanged[parent]) mChanged[nodeID] = true;
+            if (mChanged[nodeID])
+            {
+                updateNode(nodeID);
+                mChangedNodes.push_back(nodeID);
+            }
+        }
+    }
+
+    std::vector<TransformHierarchy::Range> TransformHierarchy::getChangedRanges(uint32_t maxGap) const
+    {
+        std::vector<Range> ranges;
+        if (mLastUpdateWasFull)
+        {
+            if (getNodeCount() > 0) ranges.push_back({ 0, getNodeCount() });
+            return ranges;
+        }
+
+        for (uint32_t nodeID : mChangedNodes)
+        {
+            if (!ranges.empty() && nodeID - (ranges.back().offset + ranges.back().count) <= maxGap)
+            {
+                ranges.back().count = nodeID - ranges.back().offset + 1;
+            }
+            else
+            {
+                ranges.push_back({ nodeID, 1 });
+            }
+        }
+        return ranges;
+    }
+
+    void TransformHierarchy::updateNode(uint32_t nodeID)
+    {
+        uint32_t parent = mParents[nodeID];
+        mGlobalMatrices[nodeID] = parent != kInvalidNode ? mGlobalMatrices[parent] * mLocalMatrices[nodeID] : mLocalMatrices[nodeID];
+        mInvTransposeGlobalMatrices[nodeID] = inverseTranspose(mGlobalMatrices[nodeID]);
+
+        if (!mLocalToBindSpace.empty())
+        {
+            mSkinningMatrices[nodeID] = mGlobalMatrices[nodeID] * mLocalToBindSpace[nodeID];
+            mInvTransposeSkinningMatrices[nodeID] = inverseTranspose(mSkinningMatrices[nodeID]);
+        }
+    }
+}
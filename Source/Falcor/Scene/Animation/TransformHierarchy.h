@@ -0,0 +1,119 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** CPU-side transform propagation for the scene graph.
+
+        Holds the local and global matrices of all scene graph nodes, together with the derived
+        inverse transpose and skinning matrices. Updates are incremental: only the subtrees below
+        nodes whose local matrix changed are recomputed. The changed nodes are reported as ranges,
+        so that GPU uploads can be limited to the parts of the buffers that changed.
+    */
+    class dlldecl TransformHierarchy
+    {
+    public:
+        static const uint32_t kInvalidNode = uint32_t(-1);
+
+        /** Range of consecutive nodes.
+        */
+        struct Range
+        {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        /** Create a transform hierarchy.
+            \param[in] parents Parent node index per node, or kInvalidNode for root nodes. Parents must be stored before their children.
+            \param[in] localMatrices Initial local matrix per node.
+            \param[in] animated Flag per node, true if the local matrix of the node may change. Flags are propagated to the descendants.
+            \param[in] localToBindSpace Local to bind space matrix per node. If empty, no skinning matrices are computed.
+        */
+        TransformHierarchy(std::vector<uint32_t> parents, std::vector<glm::mat4> localMatrices, const std::vector<bool>& animated, std::vector<glm::mat4> localToBindSpace = {});
+
+        /** Set the local matrix of an animated node. The node's subtree is recomputed on the next call to update().
+        */
+        void setLocalMatrix(uint32_t nodeID, const glm::mat4& matrix);
+
+        /** Restore the initial local matrices. All matrices are recomputed on the next call to update().
+        */
+        void resetLocalMatrices();
+
+        /** Clear the changed flags of all nodes. Call this at the start of a frame, before setting new local matrices.
+        */
+        void clearChanges();
+
+        /** Update the global (and derived) matrices of all nodes below changed nodes.
+        */
+        void update();
+
+        /** Get the nodes changed by the last update as ranges of consecutive nodes.
+            \param[in] maxGap Ranges separated by at most this many unchanged nodes are merged.
+            \return List of ranges in ascending order.
+        */
+        std::vector<Range> getChangedRanges(uint32_t maxGap = 0) const;
+
+        /** Get the number of nodes.
+        */
+        uint32_t getNodeCount() const { return (uint32_t)mParents.size(); }
+
+        /** Check if a node is affected by animations.
+        */
+        bool isAnimated(size_t nodeID) const { return mAnimated[nodeID]; }
+
+        /** Check if a node changed in the last update.
+        */
+        bool isChanged(size_t nodeID) const { return mChanged[nodeID]; }
+
+        const std::vector<glm::mat4>& getLocalMatrices() const { return mLocalMatrices; }
+        const std::vector<glm::mat4>& getGlobalMatrices() const { return mGlobalMatrices; }
+        const std::vector<glm::mat4>& getInvTransposeGlobalMatrices() const { return mInvTransposeGlobalMatrices; }
+        const std::vector<glm::mat4>& getSkinningMatrices() const { return mSkinningMatrices; }
+        const std::vector<glm::mat4>& getInvTransposeSkinningMatrices() const { return mInvTransposeSkinningMatrices; }
+
+    private:
+        void updateNode(uint32_t nodeID);
+
+        std::vector<uint32_t> mParents;
+        std::vector<glm::mat4> mInitialLocalMatrices;
+        std::vector<glm::mat4> mLocalToBindSpace;
+        std::vector<uint32_t> mAnimatedNodes;       ///< Indices of all nodes affected by animations, in ascending order.
+        std::vector<bool> mAnimated;                ///< Flag per node, true if the node is affected by animations.
+        std::vector<bool> mChanged;                 ///< Flag per node, true if the node changed in the last update.
+        std::vector<uint32_t> mChangedNodes;        ///< Indices of the nodes changed in the last update, in ascending order.
+        bool mFullUpdate = true;                    ///< True if all nodes need to be recomputed.
+        bool mLastUpdateWasFull = false;            ///< True if all nodes were recomputed in the last update.
+
+        std::vector<glm::mat4> mLocalMatrices;
+        std::vector<glm::mat4> mGlobalMatrices;
+        std::vector<glm::mat4> mInvTransposeGlobalMatrices;
+        std::vector<glm::mat4> mSkinningMatrices;
+        std::vector<glm::mat4> mInvTransposeSkinningMatrices;
+    };
+}
@@ -302,6 +302,7 @@ namespace Falcor
         void setJitterInternal(float jitterX, float jitterY);
 
         friend class SceneBuilder;
+        friend class SceneCache;
     };
 
     enum_class_operators(Camera::Changes);
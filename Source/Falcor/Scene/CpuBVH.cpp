@@ -0,0 +1,351 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CpuBVH.h"
+#include <immintrin.h>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kBinCount = 16;
+
+        // Below this depth the splits use SAH. Deeper subtrees (only produced by very unbalanced SAH splits) use median splits,
+        // which bounds the tree depth so that traversal can use a fixed size stack.
+        const uint32_t kMaxSahDepth = 48;
+        const uint32_t kMaxStackSize = 256;
+
+        float safeInverse(float d)
+        {
+            // Clamp tiny components so that the slab distances stay finite.
+            const float kMinComponent = 1e-20f;
+            return 1.f / (std::abs(d) > kMinComponent ? d : std::copysign(kMinComponent, d));
+        }
+    }
+
+    void CpuBVH::build(const std::vector<float3>& positions)
+    {
+        assert(positions.size() % 3 == 0);
+        const uint32_t triangleCount = (uint32_t)(positions.size() / 3);
+
+        mNodes.clear();
+        mTriangles.clear();
+        mBounds = AABB();
+        if (triangleCount == 0) return;
+
+        std::vector<BuildPrim> prims(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            auto& prim = prims[i];
+            prim.bounds = AABB(positions[3 * i]).include(positions[3 * i + 1]).include(positions[3 * i + 2]);
+            prim.center = prim.bounds.center();
+            prim.triangleIndex = i;
+            mBounds.include(prim.bounds);
+        }
+
+        // A 4-wide tree with up to four triangles per leaf has about n/6 nodes.
+        mNodes.reserve(triangleCount / 6 + 1);
+        buildRecursive(prims, 0, prims.size(), 0);
+
+        // Store the triangles in leaf order.
+        mTriangles.resize(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            const uint32_t triangleIndex = prims[i].triangleIndex;
+            const float3& v0 = positions[3 * triangleIndex];
+            mTriangles[i] = { v0, positions[3 * triangleIndex + 1] - v0, positions[3 * triangleIndex + 2] - v0, triangleIndex };
+        }
+    }
+
+    uint32_t CpuBVH::buildRecursive(std::vector<BuildPrim>& prims, size_t begin, size_t end, uint32_t depth)
+    {
+        assert(end > begin);
+        const uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.push_back({});
+
+        // Split the triangles into up to four groups by two levels of binary splits. Groups that are small enough become leaves.
+        const bool useSah = depth < kMaxSahDepth;
+        std::pair<size_t, size_t> ranges[4];
+        uint32_t childCount = 0;
+        if (end - begin <= kMaxLeafSize)
+        {
+            ranges[childCount++] = { begin, end };
+        }
+        else
+        {
+            const size_t mid = split(prims, begin, end, useSah);
+            for (auto [first, last] : { std::make_pair(begin, mid), std::make_pair(mid, end) })
+            {
+                if (last - first > kMaxLeafSize)
+                {
+                    const size_t childMid = split(prims, first, last, useSah);
+                    ranges[childCount++] = { first, childMid };
+                    ranges[childCount++] = { childMid, last };
+                }
+                else
+                {
+                    ranges[childCount++] = { first, last };
+                }
+            }
+        }
+
+        for (uint32_t slot = 0; slot < 4; slot++)
+        {
+            // Empty slots get inverted bounds, which the slab test never hits.
+            AABB box(float3(std::numeric_limits<float>::infinity()), float3(-std::numeric_limits<float>::infinity()));
+            uint32_t child = 0;
+            uint32_t triangleCount = 0;
+
+            if (slot < childCount)
+            {
+                const auto [first, last] = ranges[slot];
+                box = prims[first].bounds;
+                for (size_t i = first + 1; i < last; i++) box.include(prims[i].bounds);
+
+                if (last - first <= kMaxLeafSize)
+                {
+                    child = (uint32_t)first | kLeafFlag;
+                    triangleCount = (uint32_t)(last - first);
+                }
+                else
+                {
+                    child = buildRecursive(prims, first, last, depth + 1);
+                }
+            }
+
+            // Note that buildRecursive() may reallocate the node array.
+            Node& node = mNodes[nodeIndex];
+            node.minX[slot] = box.minPoint.x;
+            node.minY[slot] = box.minPoint.y;
+            node.minZ[slot] = box.minPoint.z;
+            node.maxX[slot] = box.maxPoint.x;
+            node.maxY[slot] = box.maxPoint.y;
+            node.maxZ[slot] = box.maxPoint.z;
+            node.children[slot] = child;
+            node.triangleCounts[slot] = triangleCount;
+        }
+
+        return nodeIndex;
+    }
+
+    size_t CpuBVH::split(std::vector<BuildPrim>& prims, size_t begin, size_t end, bool useSah) const
+    {
+        assert(end - begin > 1);
+        AABB centerBounds;
+        for (size_t i = begin; i < end; i++) centerBounds.include(prims[i].center);
+        const float3 extent = centerBounds.extent();
+
+        auto getBin = [&](const BuildPrim& prim, int axis)
+        {
+            const float t = (prim.center[axis] - centerBounds.minPoint[axis]) / extent[axis];
+            return std::min((uint32_t)(t * kBinCount), kBinCount - 1);
+        };
+
+        // Evaluate the SAH cost of splitting between each pair of bins along all axes.
+        // The cost is the sum over both sides of the surface area times the number of triangles.
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+        float bestCost = std::numeric_limits<float>::infinity();
+
+        for (int axis = 0; useSah && axis < 3; axis++)
+        {
+            if (!(extent[axis] > 0.f)) continue;
+
+            AABB binBounds[kBinCount];
+            uint32_t binCounts[kBinCount] = {};
+            for (size_t i = begin; i < end; i++)
+            {
+                const uint32_t bin = getBin(prims[i], axis);
+                binBounds[bin].include(prims[i].bounds);
+                binCounts[bin]++;
+            }
+
+            // Sweep from the right to get the cost of the right side of each split.
+            float rightCosts[kBinCount] = {};
+            AABB rightBounds;
+            uint32_t rightCount = 0;
+            for (uint32_t bin = kBinCount - 1; bin > 0; bin--)
+            {
+                rightBounds.include(binBounds[bin]);
+                rightCount += binCounts[bin];
+                rightCosts[bin - 1] = rightCount > 0 ? rightBounds.area() * rightCount : 0.f;
+            }
+
+            AABB leftBounds;
+            uint32_t leftCount = 0;
+            for (uint32_t bin = 0; bin < kBinCount - 1; bin++)
+            {
+                leftBounds.include(binBounds[bin]);
+                leftCount += binCounts[bin];
+                if (leftCount == 0 || leftCount == end - begin) continue;
+
+                const float cost = leftBounds.area() * leftCount + rightCosts[bin];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                }
+            }
+        }
+
+        if (bestAxis >= 0)
+        {
+            auto it = std::partition(prims.begin() + begin, prims.begin() + end, [&](const BuildPrim& prim) { return getBin(prim, bestAxis) <= bestBin; });
+            const size_t mid = (size_t)(it - prims.begin());
+            if (mid > begin && mid < end) return mid;
+        }
+
+        // Fall back to a median split along the largest axis if SAH is disabled or all centers fall in the same bin.
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const size_t mid = begin + (end - begin) / 2;
+        std::nth_element(prims.begin() + begin, prims.begin() + mid, prims.begin() + end, [axis](const BuildPrim& a, const BuildPrim& b)
+        {
+            // Break ties by index so the result is deterministic.
+            return a.center[axis] < b.center[axis] || (a.center[axis] == b.center[axis] && a.triangleIndex < b.triangleIndex);
+        });
+        return mid;
+    }
+
+    bool CpuBVH::intersect(const Ray& ray, Hit& hit) const
+    {
+        return traverse<false>(ray, hit);
+    }
+
+    bool CpuBVH::occluded(const Ray& ray) const
+    {
+        Hit hit;
+        return traverse<true>(ray, hit);
+    }
+
+    template<bool AnyHit>
+    bool CpuBVH::traverse(const Ray& ray, Hit& hit) const
+    {
+        if (mNodes.empty()) return false;
+
+        const float3 invDir(safeInverse(ray.dir.x), safeInverse(ray.dir.y), safeInverse(ray.dir.z));
+        const __m128 originX = _mm_set1_ps(ray.origin.x), originY = _mm_set1_ps(ray.origin.y), originZ = _mm_set1_ps(ray.origin.z);
+        const __m128 invDirX = _mm_set1_ps(invDir.x), invDirY = _mm_set1_ps(invDir.y), invDirZ = _mm_set1_ps(invDir.z);
+        const __m128 rayTMin = _mm_set1_ps(ray.tMin);
+
+        // The near and far slabs are selected by the direction sign, so that inverted bounds of empty slots never intersect.
+        const bool negX = invDir.x < 0.f, negY = invDir.y < 0.f, negZ = invDir.z < 0.f;
+
+        float tMax = ray.tMax;
+        bool found = false;
+
+        struct StackEntry
+        {
+            uint32_t node;
+            float tNear;
+        };
+        StackEntry stack[kMaxStackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = { 0, ray.tMin };
+
+        while (stackSize > 0)
+        {
+            const StackEntry entry = stack[--stackSize];
+            if (entry.tNear > tMax) continue;
+            const Node& node = mNodes[entry.node];
+
+            // Intersect the ray with the bounds of all four children.
+            const __m128 minX = _mm_load_ps(node.minX), minY = _mm_load_ps(node.minY), minZ = _mm_load_ps(node.minZ);
+            const __m128 maxX = _mm_load_ps(node.maxX), maxY = _mm_load_ps(node.maxY), maxZ = _mm_load_ps(node.maxZ);
+
+            const __m128 nearX = _mm_mul_ps(_mm_sub_ps(negX ? maxX : minX, originX), invDirX);
+            const __m128 nearY = _mm_mul_ps(_mm_sub_ps(negY ? maxY : minY, originY), invDirY);
+            const __m128 nearZ = _mm_mul_ps(_mm_sub_ps(negZ ? maxZ : minZ, originZ), invDirZ);
+            const __m128 farX = _mm_mul_ps(_mm_sub_ps(negX ? minX : maxX, originX), invDirX);
+            const __m128 farY = _mm_mul_ps(_mm_sub_ps(negY ? minY : maxY, originY), invDirY);
+            const __m128 farZ = _mm_mul_ps(_mm_sub_ps(negZ ? minZ : maxZ, originZ), invDirZ);
+
+            const __m128 tNear = _mm_max_ps(_mm_max_ps(nearX, nearY), _mm_max_ps(nearZ, rayTMin));
+            const __m128 tFar = _mm_min_ps(_mm_min_ps(farX, farY), _mm_min_ps(farZ, _mm_set1_ps(tMax)));
+            const uint32_t hitMask = (uint32_t)_mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+            if (hitMask == 0) continue;
+
+            alignas(16) float childTNear[4];
+            _mm_store_ps(childTNear, tNear);
+
+            // Intersect the leaves directly and collect the inner nodes to visit.
+            StackEntry innerNodes[4];
+            uint32_t innerCount = 0;
+
+            for (uint32_t mask = hitMask; mask != 0; mask &= mask - 1)
+            {
+                const uint32_t slot = bitScanForward(mask);
+                const uint32_t child = node.children[slot];
+                if ((child & kLeafFlag) == 0)
+                {
+                    innerNodes[innerCount++] = { child, childTNear[slot] };
+                    continue;
+                }
+
+                // Moller-Trumbore ray/triangle intersection.
+                const uint32_t first = child & ~kLeafFlag;
+                for (uint32_t i = first; i < first + node.triangleCounts[slot]; i++)
+                {
+                    const Triangle& tri = mTriangles[i];
+                    const float3 p = glm::cross(ray.dir, tri.e2);
+                    const float det = glm::dot(tri.e1, p);
+                    if (det == 0.f) continue;
+
+                    const float invDet = 1.f / det;
+                    const float3 s = ray.origin - tri.v0;
+                    const float u = glm::dot(s, p) * invDet;
+                    if (u < 0.f || u > 1.f) continue;
+
+                    const float3 q = glm::cross(s, tri.e1);
+                    const float v = glm::dot(ray.dir, q) * invDet;
+                    if (v < 0.f || u + v > 1.f) continue;
+
+                    const float t = glm::dot(tri.e2, q) * invDet;
+                    if (t < ray.tMin || t > tMax) continue;
+
+                    if (AnyHit) return true;
+                    tMax = t;
+                    hit.triangleIndex = tri.triangleIndex;
+                    hit.t = t;
+                    hit.barycentrics = float2(u, v);
+                    found = true;
+                }
+            }
+
+            // Push the inner nodes so that the nearest one is visited first.
+            std::sort(innerNodes, innerNodes + innerCount, [](const StackEntry& a, const StackEntry& b) { return a.tNear > b.tNear; });
+            for (uint32_t i = 0; i < innerCount; i++)
+            {
+                assert(stackSize < kMaxStackSize);
+                stack[stackSize++] = innerNodes[i];
+            }
+        }
+
+        return found;
+    }
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Math/AABB.h"
+#include <limits>
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU bounding volume hierarchy over triangles, used for software ray tracing.
+
+        The hierarchy is a 4-wide BVH built with binned SAH splits. Each node stores the bounds of its
+        four children in SoA layout, so that a ray is tested against all children at once using SSE.
+        Leaves hold up to kMaxLeafSize triangles, which are stored in leaf order with precomputed edges.
+
+        The queries follow the DXR conventions: triangles are hit from both sides, the barycentrics (u,v)
+        weight the second and third vertex, and only hits with t in [tMin, tMax] are reported.
+    */
+    class dlldecl CpuBVH
+    {
+    public:
+        static const uint32_t kInvalidIndex = 0xffffffff;
+        static const uint32_t kMaxLeafSize = 4;
+
+        struct Ray
+        {
+            float3 origin = float3(0.f);
+            float tMin = 0.f;
+            float3 dir = float3(0.f, 0.f, 1.f);
+            float tMax = std::numeric_limits<float>::infinity();
+        };
+
+        struct Hit
+        {
+            uint32_t triangleIndex = kInvalidIndex; ///< Index of the triangle in the array passed to build().
+            float t = std::numeric_limits<float>::infinity();
+            float2 barycentrics = float2(0.f);
+
+            bool isValid() const { return triangleIndex != kInvalidIndex; }
+        };
+
+        /** Build the hierarchy.
+            \param[in] positions World-space positions of the triangles, three consecutive vertices per triangle.
+        */
+        void build(const std::vector<float3>& positions);
+
+        /** Find the closest hit along a ray.
+            \param[in] ray Ray. The direction doesn't have to be normalized.
+            \param[out] hit Closest hit. Unchanged if there is no hit.
+            \return True if a triangle was hit.
+        */
+        bool intersect(const Ray& ray, Hit& hit) const;
+
+        /** Check if any triangle is hit along a ray. This is cheaper than intersect() as traversal stops at the first hit.
+            \param[in] ray Ray. The direction doesn't have to be normalized.
+            \return True if a triangle was hit.
+        */
+        bool occluded(const Ray& ray) const;
+
+        /** Get the number of triangles in the hierarchy.
+        */
+        uint32_t getTriangleCount() const { return (uint32_t)mTriangles.size(); }
+
+        /** Get the number of nodes in the hierarchy.
+        */
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+        /** Get the bounds of all triangles.
+        */
+        const AABB& getBounds() const { return mBounds; }
+
+    private:
+        static const uint32_t kLeafFlag = 0x80000000;
+
+        /** Node with four children. Children are either nodes or ranges of triangles (tagged with kLeafFlag).
+            Empty child slots have inverted bounds, which are never hit.
+        */
+        struct alignas(16) Node
+        {
+            float minX[4], minY[4], minZ[4];
+            float maxX[4], maxY[4], maxZ[4];
+            uint32_t children[4];           ///< Child node index, or first triangle index tagged with kLeafFlag.
+            uint32_t triangleCounts[4];     ///< Number of triangles in leaf children. Zero for inner nodes and empty slots.
+        };
+
+        /** Triangle in the form used by the Moller-Trumbore intersection test.
+        */
+        struct Triangle
+        {
+            float3 v0;
+            float3 e1;                      ///< v1 - v0.
+            float3 e2;                      ///< v2 - v0.
+            uint32_t triangleIndex;         ///< Index of the triangle in the array passed to build().
+        };
+
+        struct BuildPrim
+        {
+            AABB bounds;
+            float3 center;
+            uint32_t triangleIndex;
+        };
+
+        template<bool AnyHit>
+        bool traverse(const Ray& ray, Hit& hit) const;
+
+        uint32_t buildRecursive(std::vector<BuildPrim>& prims, size_t begin, size_t end, uint32_t depth);
+        size_t split(std::vector<BuildPrim>& prims, size_t begin, size_t end, bool useSah) const;
+
+        std::vector<Node> mNodes;
+        std::vector<Triangle> mTriangles;
+        AABB mBounds;
+    };
+}
@@ -0,0 +1,276 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CpuPathTracer.h"
+#include "Utils/Threading.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** PCG32 random number generator, seeded with SplitMix64 so that consecutive seeds give uncorrelated sequences.
+        */
+        class Rng
+        {
+        public:
+            Rng(uint64_t seed)
+            {
+                uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                mState = z ^ (z >> 31);
+                next();
+            }
+
+            uint32_t next()
+            {
+                const uint64_t state = mState;
+                mState = state * 6364136223846793005ull + 1442695040888963407ull;
+                const uint32_t xorShifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+                const uint32_t rot = (uint32_t)(state >> 59);
+                return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+            }
+
+            /** Returns a uniform random number in [0,1).
+            */
+            float nextFloat() { return (next() >> 8) * (1.f / 16777216.f); }
+
+        private:
+            uint64_t mState;
+        };
+
+        /** Offset a ray origin along the normal to avoid self-intersection. Same as computeRayOrigin() in Helpers.slang.
+        */
+        float3 computeRayOrigin(const float3& pos, const float3& normal)
+        {
+            const float origin = 1.f / 32.f;
+            const float fScale = 1.f / 65536.f;
+            const float iScale = 256.f;
+
+            float3 result;
+            for (int i = 0; i < 3; i++)
+            {
+                const int32_t iOff = (int32_t)(normal[i] * iScale);
+                const float iPos = asfloat(asint(pos[i]) + (pos[i] < 0.f ? -iOff : iOff));
+                result[i] = std::abs(pos[i]) < origin ? pos[i] + normal[i] * fScale : iPos;
+            }
+            return result;
+        }
+
+        /** Sample a direction from the cosine-weighted hemisphere around a normal.
+        */
+        float3 sampleCosineHemisphere(const float3& N, Rng& rng)
+        {
+            const float u = rng.nextFloat();
+            const float phi = 2.f * (float)M_PI * rng.nextFloat();
+            const float r = std::sqrt(u);
+            const float3 local(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(0.f, 1.f - u)));
+
+            // Build an orthonormal basis around the normal (Duff et al. 2017).
+            const float sign = std::copysign(1.f, N.z);
+            const float a = -1.f / (sign + N.z);
+            const float b = N.x * N.y * a;
+            const float3 T(1.f + sign * N.x * N.x * a, sign * b, -sign * N.x);
+            const float3 B(b, sign + N.y * N.y * a, -N.y);
+            return glm::normalize(local.x * T + local.y * B + local.z * N);
+        }
+
+        float3 getDiffuseAlbedo(const Material& material)
+        {
+            const float3 baseColor = float3(material.getBaseColor());
+            return material.getShadingModel() == ShadingModelMetalRough ? baseColor * (1.f - material.getMetallic()) : baseColor;
+        }
+    }
+
+    CpuPathTracer::SharedPtr CpuPathTracer::create(const CpuScene::SharedPtr& pScene, const Options& options)
+    {
+        if (!pScene) throw std::exception("CpuPathTracer requires a scene");
+        return SharedPtr(new CpuPathTracer(pScene, options));
+    }
+
+    CpuPathTracer::CpuPathTracer(const CpuScene::SharedPtr& pScene, const Options& options)
+        : mpScene(pScene)
+        , mOptions(options)
+    {
+        for (const auto& pLight : mpScene->getLights())
+        {
+            const LightType type = pLight->getType();
+            if (type == LightType::Rect || type == LightType::Disc || type == LightType::Sphere)
+            {
+                logWarning("CpuPathTracer doesn't support analytic area lights. Light '" + pLight->getName() + "' is ignored.");
+            }
+        }
+    }
+
+    std::vector<float4> CpuPathTracer::render(const uint2& frameDim) const
+    {
+        const auto& pCamera = mpScene->getCamera();
+        if (!pCamera) throw std::exception("CpuPathTracer::render() requires a scene with a camera");
+        if (frameDim.x == 0 || frameDim.y == 0) return {};
+
+        // Match the aspect ratio to the image on a copy, so that the scene camera is left unchanged.
+        Camera localCamera = *pCamera;
+        localCamera.setAspectRatio((float)frameDim.x / (float)frameDim.y);
+        const CameraData& camera = localCamera.getData();
+        const float3 cameraDirW = glm::normalize(camera.cameraW);
+
+        std::vector<float4> image((size_t)frameDim.x * frameDim.y);
+
+        // Rows are distributed over the threads. Each pixel and sample has its own random sequence.
+        Threading::parallelFor(0, frameDim.y, [&](uint32_t y)
+        {
+            for (uint32_t x = 0; x < frameDim.x; x++)
+            {
+                const uint64_t pixelIndex = (uint64_t)y * frameDim.x + x;
+                float3 radiance(0.f);
+
+                for (uint32_t s = 0; s < mOptions.samplesPerPixel; s++)
+                {
+                    const uint64_t seed = ((uint64_t)mOptions.seed << 40) ^ (pixelIndex * mOptions.samplesPerPixel + s);
+                    Rng rng(~seed);
+
+                    // Compute a pinhole camera ray through a random position in the pixel, as computeRayPinhole() in Camera.slang.
+                    const float2 p = (float2(x, y) + float2(rng.nextFloat(), rng.nextFloat())) / float2(frameDim);
+                    const float2 ndc = float2(2.f, -2.f) * p + float2(-1.f, 1.f);
+
+                    CpuBVH::Ray ray;
+                    ray.origin = camera.posW;
+                    ray.dir = glm::normalize(ndc.x * camera.cameraU + ndc.y * camera.cameraV + camera.cameraW);
+                    const float invCos = 1.f / glm::dot(cameraDirW, ray.dir);
+                    ray.tMin = camera.nearZ * invCos;
+                    ray.tMax = camera.farZ * invCos;
+
+                    radiance += tracePath(ray, seed);
+                }
+
+                if (mOptions.samplesPerPixel > 0) radiance /= (float)mOptions.samplesPerPixel;
+                image[pixelIndex] = float4(radiance, 1.f);
+            }
+        }, 1);
+
+        return image;
+    }
+
+    float3 CpuPathTracer::tracePath(const CpuBVH::Ray& primaryRay, uint64_t seed) const
+    {
+        Rng rng(seed);
+        CpuBVH::Ray ray = primaryRay;
+        float3 radiance(0.f);
+        float3 throughput(1.f);
+
+        for (uint32_t depth = 0;; depth++)
+        {
+            CpuScene::Hit hit;
+            if (!mpScene->traceClosest(ray, hit))
+            {
+                radiance += throughput * mOptions.backgroundColor;
+                break;
+            }
+
+            const CpuScene::SurfaceData sd = mpScene->getSurfaceData(hit, ray.dir);
+            const Material& material = *mpScene->getMaterial(sd.materialID);
+
+            if (mOptions.useEmissiveLights && (sd.frontFacing || material.isDoubleSided()))
+            {
+                radiance += throughput * material.getEmissiveColor() * material.getEmissiveFactor();
+            }
+
+            // Shade the side that was hit. The shading normal is flipped along with the face normal.
+            const float3 faceN = sd.frontFacing ? sd.faceN : -sd.faceN;
+            float3 N = sd.frontFacing ? sd.N : -sd.N;
+            if (glm::dot(N, faceN) <= 0.f) N = faceN;
+
+            const float3 albedo = getDiffuseAlbedo(material);
+            const float3 origin = computeRayOrigin(sd.posW, faceN);
+
+            // Sample the analytic lights with shadow rays.
+            if (mOptions.useAnalyticLights)
+            {
+                for (const auto& pLight : mpScene->getLights())
+                {
+                    if (!pLight->isActive()) continue;
+                    const LightData& light = pLight->getData();
+
+                    float3 L;
+                    float3 Li;
+                    float distance = std::numeric_limits<float>::infinity();
+
+                    if (pLight->getType() == LightType::Point)
+                    {
+                        L = light.posW - sd.posW;
+                        const float distSquared = glm::dot(L, L);
+                        if (distSquared <= 1e-5f) continue;
+                        distance = std::sqrt(distSquared);
+                        L /= distance;
+
+                        float falloff = 1.f / ((0.01f * 0.01f) + distSquared);
+                        const float cosTheta = -glm::dot(L, light.dirW);
+                        if (cosTheta < light.cosOpeningAngle) continue;
+                        if (light.penumbraAngle > 0.f)
+                        {
+                            const float deltaAngle = light.openingAngle - std::acos(cosTheta);
+                            falloff *= glm::clamp((deltaAngle - light.penumbraAngle) / light.penumbraAngle, 0.f, 1.f);
+                        }
+                        Li = light.intensity * falloff;
+                    }
+                    else if (pLight->getType() == LightType::Directional || pLight->getType() == LightType::Distant)
+                    {
+                        L = -glm::normalize(light.dirW);
+                        Li = light.intensity;
+                    }
+                    else continue;
+
+                    const float cosN = glm::dot(N, L);
+                    if (cosN <= 0.f || glm::dot(faceN, L) <= 0.f) continue;
+
+                    CpuBVH::Ray shadowRay;
+                    shadowRay.origin = origin;
+                    shadowRay.dir = L;
+                    shadowRay.tMax = distance * (1.f - 1e-4f);
+                    if (mpScene->traceAny(shadowRay)) continue;
+
+                    radiance += throughput * albedo / (float)M_PI * Li * cosN;
+                }
+            }
+
+            if (depth >= mOptions.maxBounces) break;
+
+            // Continue the path in a cosine-weighted direction. The diffuse BRDF times cosine over the pdf is the albedo.
+            const float3 dir = sampleCosineHemisphere(N, rng);
+            if (glm::dot(dir, faceN) <= 0.f) break;
+            throughput *= albedo;
+            if (throughput == float3(0.f)) break;
+
+            ray = CpuBVH::Ray();
+            ray.origin = origin;
+            ray.dir = dir;
+        }
+
+        return radiance;
+    }
+}
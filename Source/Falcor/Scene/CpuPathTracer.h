@@ -0,0 +1,91 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "CpuScene.h"
+
+namespace Falcor
+{
+    /** Reference path tracer running on the CPU, for image tests and benchmarks on machines without a GPU.
+
+        The path tracer uses the materials, lights and camera of a CpuScene, with a simplified shading model:
+        - Surfaces are diffuse, with the base color as albedo (scaled by 1 - metallic for metal-rough materials).
+          Material textures are not sampled.
+        - Emissive materials emit from the front side, or both sides if double-sided. They are only hit by chance.
+        - Point, spot and directional lights are sampled with shadow rays, with the same falloff as Lights.slang.
+          Distant lights are treated as directional lights. Analytic area lights are ignored.
+        - Rays that miss the scene return a constant background color.
+
+        Each pixel uses its own random number sequence, so the result is deterministic and doesn't depend on the thread count.
+    */
+    class dlldecl CpuPathTracer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuPathTracer>;
+
+        struct Options
+        {
+            uint32_t samplesPerPixel = 16;          ///< Number of paths per pixel.
+            uint32_t maxBounces = 3;                ///< Maximum number of indirect bounces. Zero gives direct illumination only.
+            uint32_t seed = 0;                      ///< Seed of the random number sequences.
+            bool useAnalyticLights = true;          ///< Sample the analytic lights at each path vertex.
+            bool useEmissiveLights = true;          ///< Add the emission of hit emissive surfaces.
+            float3 backgroundColor = float3(0.f);   ///< Radiance of rays that miss the scene.
+        };
+
+        /** Create a path tracer.
+            \param[in] pScene CPU scene.
+            \param[in] options Rendering options.
+            \return A new object, or throws an exception if creation failed.
+        */
+        static SharedPtr create(const CpuScene::SharedPtr& pScene, const Options& options = Options());
+
+        /** Render an image from the scene camera. The pixels are processed in parallel.
+            The camera is used with its aspect ratio set to match the image, as done by Scene::setCameraAspectRatio().
+            The scene camera itself is not modified.
+            \param[in] frameDim Image dimensions in pixels.
+            \return Radiance per pixel in RGBA32Float layout with alpha = 1, stored row by row starting at the top-left corner.
+        */
+        std::vector<float4> render(const uint2& frameDim) const;
+
+        /** Estimate the radiance along a ray using a single path.
+            \param[in] ray Ray in world space.
+            \param[in] seed Seed of the random number sequence of the path.
+            \return Radiance estimate.
+        */
+        float3 tracePath(const CpuBVH::Ray& ray, uint64_t seed) const;
+
+        void setOptions(const Options& options) { mOptions = options; }
+        const Options& getOptions() const { return mOptions; }
+
+    private:
+        CpuPathTracer(const CpuScene::SharedPtr& pScene, const Options& options);
+
+        CpuScene::SharedPtr mpScene;
+        Options mOptions;
+    };
+}
@@ -0,0 +1,169 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "CpuScene.h"
+#include "SceneBuilder.h"
+
+namespace Falcor
+{
+    CpuScene::SharedPtr CpuScene::create(SceneBuilder& builder)
+    {
+        builder.prepareSceneData();
+
+        SharedPtr pScene = SharedPtr(new CpuScene());
+        const auto& buffers = builder.mBuffersData;
+        const bool useCompactVertices = !buffers.compactData.empty();
+
+        // Unpack the vertices and indices of all triangle meshes from the global buffers.
+        pScene->mMeshes.resize(builder.mMeshes.size());
+        for (uint32_t meshID = 0; meshID < (uint32_t)builder.mMeshes.size(); meshID++)
+        {
+            const auto& spec = builder.mMeshes[meshID];
+            auto& mesh = pScene->mMeshes[meshID];
+            mesh.materialID = spec.materialId;
+            mesh.isFrontFaceCW = spec.isFrontFaceCW;
+            if (spec.topology != Vao::Topology::TriangleList) continue;
+
+            // Compact vertices are encoded relative to the mesh bounds, see SceneBuilder::createCompactVertexData().
+            const float3 positionOffset = spec.boundingBox.valid() ? spec.boundingBox.center() : float3(0.f);
+            const float3 positionScale = spec.boundingBox.valid() ? 0.5f * spec.boundingBox.extent() : float3(0.f);
+
+            mesh.vertices.resize(spec.vertexCount);
+            for (uint32_t i = 0; i < spec.vertexCount; i++)
+            {
+                const uint32_t index = spec.staticVertexOffset + i;
+                mesh.vertices[i] = useCompactVertices ? buffers.compactData[index].unpack(positionOffset, positionScale) : buffers.staticData[index].unpack();
+            }
+
+            mesh.indices.resize(spec.getTriangleCount() * 3);
+            for (uint32_t i = 0; i < (uint32_t)mesh.indices.size(); i++)
+            {
+                if (spec.indexCount == 0) mesh.indices[i] = i;
+                else if (spec.use16BitIndices) mesh.indices[i] = reinterpret_cast<const uint16_t*>(&buffers.indexData[spec.indexOffset])[i];
+                else mesh.indices[i] = buffers.indexData[spec.indexOffset + i];
+            }
+        }
+
+        // Create the mesh instances in the same order as SceneBuilder::createMeshData(), so the instance IDs match the GPU scene.
+        std::vector<float3> positions;
+        for (const auto& meshGroup : builder.mMeshGroups)
+        {
+            for (const uint32_t meshID : meshGroup.meshList)
+            {
+                const auto& mesh = pScene->mMeshes[meshID];
+                for (uint32_t nodeID : builder.mMeshes[meshID].instances)
+                {
+                    // Compute the object->world transform for the node.
+                    glm::mat4 transform = glm::identity<glm::mat4>();
+                    while (nodeID != SceneBuilder::kInvalidNode)
+                    {
+                        assert(nodeID < builder.mSceneGraph.size());
+                        transform = builder.mSceneGraph[nodeID].transform * transform;
+                        nodeID = builder.mSceneGraph[nodeID].parent;
+                    }
+
+                    InstanceData instance;
+                    instance.meshID = meshID;
+                    instance.triangleOffset = (uint32_t)(positions.size() / 3);
+                    instance.transform = transform;
+                    instance.normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+                    pScene->mInstances.push_back(instance);
+
+                    for (uint32_t index : mesh.indices) positions.push_back(float3(transform * float4(mesh.vertices[index].position, 1.f)));
+                }
+            }
+        }
+
+        if (positions.size() / 3 >= std::numeric_limits<uint32_t>::max()) throw std::exception("CpuScene supports at most 4G instanced triangles");
+        pScene->mBVH.build(positions);
+
+        pScene->mMaterials = builder.getMaterials();
+        pScene->mLights = builder.getLights();
+        pScene->mpCamera = builder.getSelectedCamera();
+
+        logInfo("Created CPU scene with " + std::to_string(pScene->mInstances.size()) + " mesh instances, " +
+            std::to_string(pScene->mBVH.getTriangleCount()) + " triangles and " + std::to_string(pScene->mBVH.getNodeCount()) + " BVH nodes");
+
+        return pScene;
+    }
+
+    bool CpuScene::traceClosest(const CpuBVH::Ray& ray, Hit& hit) const
+    {
+        hit = Hit();
+        CpuBVH::Hit bvhHit;
+        if (!mBVH.intersect(ray, bvhHit)) return false;
+
+        // Find the instance owning the triangle. The instances are stored in order of their first triangle.
+        auto it = std::upper_bound(mInstances.begin(), mInstances.end(), bvhHit.triangleIndex, [](uint32_t triangleIndex, const InstanceData& instance) { return triangleIndex < instance.triangleOffset; });
+        assert(it != mInstances.begin());
+        --it;
+
+        hit.type = InstanceType::TriangleMesh;
+        hit.instanceID = (uint32_t)std::distance(mInstances.begin(), it);
+        hit.primitiveIndex = bvhHit.triangleIndex - it->triangleOffset;
+        hit.barycentrics = bvhHit.barycentrics;
+        hit.t = bvhHit.t;
+        return true;
+    }
+
+    bool CpuScene::traceAny(const CpuBVH::Ray& ray) const
+    {
+        return mBVH.occluded(ray);
+    }
+
+    CpuScene::SurfaceData CpuScene::getSurfaceData(const Hit& hit, const float3& rayDir) const
+    {
+        assert(hit.isValid() && hit.instanceID < mInstances.size());
+        const auto& instance = mInstances[hit.instanceID];
+        const auto& mesh = mMeshes[instance.meshID];
+        assert(hit.primitiveIndex * 3 + 2 < mesh.indices.size());
+
+        const StaticVertexData* v[3];
+        for (uint32_t i = 0; i < 3; i++) v[i] = &mesh.vertices[mesh.indices[hit.primitiveIndex * 3 + i]];
+        const float3 w = hit.getBarycentricWeights();
+
+        SurfaceData sd;
+        const float3 posObj = w.x * v[0]->position + w.y * v[1]->position + w.z * v[2]->position;
+        sd.posW = float3(instance.transform * float4(posObj, 1.f));
+        sd.texC = w.x * v[0]->texCrd + w.y * v[1]->texCrd + w.z * v[2]->texCrd;
+        sd.materialID = mesh.materialID;
+
+        // The face normal is computed in object space and transformed with the inverse transpose, as in Scene.slang.
+        // This keeps it pointing to the front side also for transforms that flip the handedness.
+        float3 faceN = glm::cross(v[1]->position - v[0]->position, v[2]->position - v[0]->position);
+        if (mesh.isFrontFaceCW) faceN = -faceN;
+        sd.faceN = glm::normalize(instance.normalTransform * faceN);
+
+        const float3 N = w.x * v[0]->normal + w.y * v[1]->normal + w.z * v[2]->normal;
+        const float3 NW = instance.normalTransform * N;
+        sd.N = glm::dot(NW, NW) > 0.f ? glm::normalize(NW) : sd.faceN;
+
+        sd.frontFacing = glm::dot(-rayDir, sd.faceN) >= 0.f;
+        return sd;
+    }
+}
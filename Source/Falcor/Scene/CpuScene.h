@@ -0,0 +1,161 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "CpuBVH.h"
+#include "HitInfoType.slang"
+#include "SceneTypes.slang"
+#include "Lights/Light.h"
+#include "Camera/Camera.h"
+#include "Material/Material.h"
+
+namespace Falcor
+{
+    class SceneBuilder;
+
+    /** CPU representation of the triangle geometry of a scene, used for software ray tracing.
+
+        The scene is created from the post-processed scene builder data, so it doesn't need a GPU device.
+        All mesh instances are transformed to world space and stored in a single CpuBVH. Hits are reported
+        with the same mesh instance IDs and primitive indices as the GPU scene, so they can be compared
+        directly with the HitInfo produced by DXR.
+
+        The scene is a static snapshot. Animated nodes use their untransformed node matrices, skinned meshes
+        use their bind pose and curves are not included. Materials, lights and cameras are the objects held
+        by the scene builder, which are shared with the GPU scene created from it.
+    */
+    class dlldecl CpuScene
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuScene>;
+
+        static const uint32_t kInvalidIndex = 0xffffffff;
+
+        /** Ray hit information. The fields match HitInfo in HitInfo.slang.
+        */
+        struct Hit
+        {
+            InstanceType type = InstanceType::TriangleMesh;     ///< Type of instance.
+            uint32_t instanceID = kInvalidIndex;                ///< Mesh instance ID at hit.
+            uint32_t primitiveIndex = kInvalidIndex;            ///< Triangle index within the mesh at hit.
+            float2 barycentrics = float2(0.f);                  ///< Barycentric coordinates at ray hit, always in [0,1].
+            float t = std::numeric_limits<float>::infinity();   ///< Hit distance in units of the ray direction.
+
+            bool isValid() const { return instanceID != kInvalidIndex; }
+
+            /** Return the barycentric weights.
+            */
+            float3 getBarycentricWeights() const { return float3(1.f - barycentrics.x - barycentrics.y, barycentrics.x, barycentrics.y); }
+        };
+
+        /** Surface attributes at a hit, computed the same way as the vertex data in Scene.slang.
+        */
+        struct SurfaceData
+        {
+            float3 posW;                ///< World-space position.
+            float3 faceN;               ///< World-space face normal, pointing to the front side.
+            float3 N;                   ///< World-space interpolated shading normal.
+            float2 texC;                ///< Texture coordinates.
+            uint32_t materialID;        ///< Global material ID.
+            bool frontFacing;           ///< True if the ray hit the front side.
+        };
+
+        /** Create the CPU scene. This runs the post-processing of the scene builder if not already done.
+            \param[in] builder Scene builder.
+            \return A new object, or throws an exception if creation failed.
+        */
+        static SharedPtr create(SceneBuilder& builder);
+
+        /** Find the closest hit along a ray.
+            \param[in] ray Ray in world space.
+            \param[out] hit Closest hit, or an invalid hit if nothing was hit.
+            \return True if a triangle was hit.
+        */
+        bool traceClosest(const CpuBVH::Ray& ray, Hit& hit) const;
+
+        /** Check if any triangle is hit along a ray, e.g. for shadow rays.
+            \param[in] ray Ray in world space.
+            \return True if a triangle was hit.
+        */
+        bool traceAny(const CpuBVH::Ray& ray) const;
+
+        /** Compute the surface attributes at a hit.
+            \param[in] hit Valid hit.
+            \param[in] rayDir Direction of the ray that produced the hit.
+            \return Surface attributes.
+        */
+        SurfaceData getSurfaceData(const Hit& hit, const float3& rayDir) const;
+
+        /** Get the number of mesh instances.
+        */
+        uint32_t getMeshInstanceCount() const { return (uint32_t)mInstances.size(); }
+
+        /** Get the total number of instanced triangles.
+        */
+        uint32_t getTriangleCount() const { return mBVH.getTriangleCount(); }
+
+        /** Get the world-space bounds of the scene.
+        */
+        const AABB& getBounds() const { return mBVH.getBounds(); }
+
+        /** Get the hierarchy over all instanced triangles.
+        */
+        const CpuBVH& getBVH() const { return mBVH; }
+
+        const std::vector<Material::SharedPtr>& getMaterials() const { return mMaterials; }
+        const Material::SharedPtr& getMaterial(uint32_t materialID) const { return mMaterials[materialID]; }
+        const std::vector<Light::SharedPtr>& getLights() const { return mLights; }
+        const Camera::SharedPtr& getCamera() const { return mpCamera; }
+
+    private:
+        CpuScene() = default;
+
+        struct MeshData
+        {
+            std::vector<StaticVertexData> vertices;
+            std::vector<uint32_t> indices;      ///< Three indices per triangle.
+            uint32_t materialID = 0;
+            bool isFrontFaceCW = false;
+        };
+
+        struct InstanceData
+        {
+            uint32_t meshID;
+            uint32_t triangleOffset;            ///< Index of the first triangle of the instance in the hierarchy.
+            glm::mat4 transform;
+            glm::mat3 normalTransform;          ///< Inverse transpose of the upper 3x3 of the transform.
+        };
+
+        std::vector<MeshData> mMeshes;
+        std::vector<InstanceData> mInstances;   ///< Mesh instances, indexed by mesh instance ID.
+        CpuBVH mBVH;
+
+        std::vector<Material::SharedPtr> mMaterials;
+        std::vector<Light::SharedPtr> mLights;
+        Camera::SharedPtr mpCamera;
+    };
+}
@@ -36,8 +36,6 @@
 #include "Core/API/Device.h"
 #include "Scene/SceneBuilder.h"
 
-#include <execution>
-
 namespace Falcor
 {
     namespace
@@ -510,8 +508,8 @@ namespace Falcor
 
             // Pre-process meshes.
             std::vector<SceneBuilder::ProcessedMesh> processedMeshes(meshCount);
-            auto range = NumericRange<uint32_t>(0, meshCount);
-            std::for_each(std::execution::par, range.begin(), range.end(), [&] (uint32_t i) {
+            // Meshes vary a lot in size, so they are distributed one at a time.
+            Threading::parallelFor(0, meshCount, [&] (uint32_t i) {
                 const aiMesh* pAiMesh = pScene->mMeshes[i];
                 const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
 
@@ -580,7 +578,7 @@ namespace Falcor
                 mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
 
                 processedMeshes[i] = data.builder.processMesh(mesh);
-            });
+            }, 1);
 
             // Add meshes to the scene.
             // We retain a deterministic order of the meshes in the global scene buffer by adding
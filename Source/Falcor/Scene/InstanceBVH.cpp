@@ -0,0 +1,318 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "InstanceBVH.h"
+#include <immintrin.h>
+
+namespace Falcor
+{
+    namespace
+    {
+        float4 getRow(const glm::mat4& m, int row)
+        {
+            return float4(m[0][row], m[1][row], m[2][row], m[3][row]);
+        }
+
+        float4 normalizePlane(const float4& plane)
+        {
+            float length = glm::length(float3(plane));
+            return length > 0.f ? plane / length : plane;
+        }
+    }
+
+    InstanceBVH::Frustum InstanceBVH::Frustum::fromViewProj(const glm::mat4& viewProj, bool includeNearFar)
+    {
+        // See Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix", 2001.
+        const float4 r0 = getRow(viewProj, 0);
+        const float4 r1 = getRow(viewProj, 1);
+        const float4 r2 = getRow(viewProj, 2);
+        const float4 r3 = getRow(viewProj, 3);
+
+        Frustum f;
+        f.planes[0] = normalizePlane(r3 + r0);  // Left
+        f.planes[1] = normalizePlane(r3 - r0);  // Right
+        f.planes[2] = normalizePlane(r3 + r1);  // Bottom
+        f.planes[3] = normalizePlane(r3 - r1);  // Top
+        f.planes[4] = includeNearFar ? normalizePlane(r3 + r2) : float4(0.f, 0.f, 0.f, 1.f);         // Near
+        f.planes[5] = includeNearFar ? normalizePlane(r3 - r2) : float4(0.f, 0.f, 0.f, 1.f);    // Far
+        return f;
+    }
+
+    bool InstanceBVH::Frustum::isCulled(const AABB& box) const
+    {
+        for (const auto& plane : planes)
+        {
+            // Test the box corner furthest along the plane normal. The operation order matches the SIMD test in cull().
+            float px = plane.x > 0.f ? box.maxPoint.x : box.minPoint.x;
+            float py = plane.y > 0.f ? box.maxPoint.y : box.minPoint.y;
+            float pz = plane.z > 0.f ? box.maxPoint.z : box.minPoint.z;
+            float d = ((plane.x * px + plane.y * py) + plane.z * pz) + plane.w;
+            if (d < 0.f) return true;
+        }
+        return false;
+    }
+
+    void InstanceBVH::build(const std::vector<AABB>& bounds)
+    {
+        if (bounds.size() >= kLeafFlag) throw std::exception("Too many instances for the instance BVH.");
+
+        mNodes.clear();
+        mInstanceNodes.assign(bounds.size(), uint32_t(kInvalidChild));
+        mRootBounds = AABB();
+        if (bounds.empty()) return;
+
+        std::vector<float3> centers(bounds.size());
+        std::vector<uint32_t> instances(bounds.size());
+        for (uint32_t i = 0; i < (uint32_t)bounds.size(); i++)
+        {
+            centers[i] = bounds[i].valid() ? bounds[i].center() : float3(0.f);
+            instances[i] = i;
+        }
+
+        // A 4-wide tree has about n/3 nodes.
+        mNodes.reserve(bounds.size() / 3 + 1);
+        buildRecursive(instances, 0, instances.size(), bounds, centers, kInvalidChild, 0);
+        mRootBounds = getNodeBounds(mNodes[0]);
+    }
+
+    uint32_t InstanceBVH::buildRecursive(std::vector<uint32_t>& instances, size_t begin, size_t end, const std::vector<AABB>& bounds, const std::vector<float3>& centers, uint32_t parent, uint32_t parentSlot)
+    {
+        assert(end > begin);
+        const uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.push_back({});
+        mNodes[nodeIndex].parent = parent;
+        mNodes[nodeIndex].parentSlot = parentSlot;
+
+        // Split the instances into up to four groups by two levels of median splits along the largest axis of the centers.
+        auto split = [&](size_t first, size_t last)
+        {
+            AABB centerBounds;
+            for (size_t i = first; i < last; i++) centerBounds.include(centers[instances[i]]);
+            float3 extent = centerBounds.extent();
+            int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+            size_t mid = first + (last - first) / 2;
+            std::nth_element(instances.begin() + first, instances.begin() + mid, instances.begin() + last, [&](uint32_t a, uint32_t b)
+            {
+                // Break ties by index so the result is deterministic.
+                float ca = centers[a][axis], cb = centers[b][axis];
+                return ca < cb || (ca == cb && a < b);
+            });
+            return mid;
+        };
+
+        size_t ranges[5] = { begin, begin + 1, begin + 2, begin + 3, end };
+        uint32_t childCount = (uint32_t)std::min<size_t>(end - begin, 4);
+        if (end - begin > 4)
+        {
+            ranges[2] = split(begin, end);
+            ranges[1] = split(begin, ranges[2]);
+            ranges[3] = split(ranges[2], end);
+        }
+
+        mNodes[nodeIndex].childCount = childCount;
+        for (uint32_t slot = 0; slot < 4; slot++)
+        {
+            if (slot >= childCount)
+            {
+                mNodes[nodeIndex].children[slot] = kInvalidChild;
+                setChildBounds(mNodes[nodeIndex], slot, AABB());
+                continue;
+            }
+
+            if (ranges[slot + 1] - ranges[slot] == 1)
+            {
+                const uint32_t instance = instances[ranges[slot]];
+                mNodes[nodeIndex].children[slot] = instance | kLeafFlag;
+                setChildBounds(mNodes[nodeIndex], slot, bounds[instance]);
+                mInstanceNodes[instance] = (nodeIndex << 2) | slot;
+            }
+            else
+            {
+                const uint32_t childIndex = buildRecursive(instances, ranges[slot], ranges[slot + 1], bounds, centers, nodeIndex, slot);
+                mNodes[nodeIndex].children[slot] = childIndex;
+                setChildBounds(mNodes[nodeIndex], slot, getNodeBounds(mNodes[childIndex]));
+            }
+        }
+
+        return nodeIndex;
+    }
+
+    void InstanceBVH::setChildBounds(Node& node, uint32_t slot, const AABB& box)
+    {
+        // Invalid boxes (e.g. empty meshes) are flagged in the empty mask and stored as a point, which keeps the SIMD math finite.
+        const AABB b = box.valid() ? box : AABB(float3(0.f), float3(0.f));
+        if (box.valid()) node.emptyMask &= ~(1u << slot);
+        else node.emptyMask |= 1u << slot;
+        node.minX[slot] = b.minPoint.x;
+        node.minY[slot] = b.minPoint.y;
+        node.minZ[slot] = b.minPoint.z;
+        node.maxX[slot] = b.maxPoint.x;
+        node.maxY[slot] = b.maxPoint.y;
+        node.maxZ[slot] = b.maxPoint.z;
+    }
+
+    AABB InstanceBVH::getNodeBounds(const Node& node) const
+    {
+        AABB box;
+        for (uint32_t slot = 0; slot < node.childCount; slot++)
+        {
+            if (node.emptyMask & (1u << slot)) continue;
+            box.include(float3(node.minX[slot], node.minY[slot], node.minZ[slot]));
+            box.include(float3(node.maxX[slot], node.maxY[slot], node.maxZ[slot]));
+        }
+        return box;
+    }
+
+    void InstanceBVH::refit(const std::vector<uint32_t>& instances, const std::vector<AABB>& bounds)
+    {
+        assert(bounds.size() == mInstanceNodes.size());
+        if (instances.empty() || mNodes.empty()) return;
+
+        std::vector<uint8_t> dirty(mNodes.size(), 0);
+        for (uint32_t instance : instances)
+        {
+            const uint32_t nodeIndex = mInstanceNodes[instance] >> 2;
+            setChildBounds(mNodes[nodeIndex], mInstanceNodes[instance] & 3, bounds[instance]);
+            dirty[nodeIndex] = 1;
+        }
+
+        // Children are stored after their parents, so a reverse sweep updates each node after all its children.
+        for (size_t i = mNodes.size(); i-- > 1;)
+        {
+            if (!dirty[i]) continue;
+            const Node& node = mNodes[i];
+            setChildBounds(mNodes[node.parent], node.parentSlot, getNodeBounds(node));
+            dirty[node.parent] = 1;
+        }
+        mRootBounds = getNodeBounds(mNodes[0]);
+    }
+
+    void InstanceBVH::cull(const std::vector<Frustum>& views, std::vector<std::vector<uint32_t>>& visibleInstances) const
+    {
+        if (views.size() > kMaxViews) throw std::exception("Too many views for instance culling.");
+
+        const uint32_t viewCount = (uint32_t)views.size();
+        visibleInstances.resize(viewCount);
+        for (auto& v : visibleInstances) v.clear();
+        if (mNodes.empty() || viewCount == 0) return;
+
+        // Splat the plane equations once for all nodes.
+        struct SimdPlane
+        {
+            __m128 x, y, z, w;
+            bool posX, posY, posZ;
+        };
+        std::vector<SimdPlane> planes(viewCount * 6);
+        for (uint32_t v = 0; v < viewCount; v++)
+        {
+            for (uint32_t p = 0; p < 6; p++)
+            {
+                const float4& plane = views[v].planes[p];
+                planes[v * 6 + p] = { _mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z), _mm_set1_ps(plane.w), plane.x > 0.f, plane.y > 0.f, plane.z > 0.f };
+            }
+        }
+
+        struct StackEntry
+        {
+            uint32_t node;
+            uint32_t testMask;      ///< Views that partially overlap the node and need to be tested.
+            uint32_t insideMask;    ///< Views that fully contain the node.
+        };
+        std::vector<StackEntry> stack;
+        stack.reserve(64);
+
+        const uint32_t allViews = viewCount == 32 ? ~0u : (1u << viewCount) - 1;
+        stack.push_back({ 0, allViews, 0 });
+
+        const __m128 zero = _mm_setzero_ps();
+
+        while (!stack.empty())
+        {
+            const StackEntry entry = stack.back();
+            stack.pop_back();
+            const Node& node = mNodes[entry.node];
+
+            const __m128 minX = _mm_load_ps(node.minX), minY = _mm_load_ps(node.minY), minZ = _mm_load_ps(node.minZ);
+            const __m128 maxX = _mm_load_ps(node.maxX), maxY = _mm_load_ps(node.maxY), maxZ = _mm_load_ps(node.maxZ);
+
+            // Test all four children against each view. The result per view is a 4-bit mask of children outside and fully inside.
+            uint32_t childTest[4] = { 0, 0, 0, 0 };
+            uint32_t childInside[4] = { entry.insideMask, entry.insideMask, entry.insideMask, entry.insideMask };
+
+            for (uint32_t testMask = entry.testMask; testMask != 0; testMask &= testMask - 1)
+            {
+                const uint32_t v = bitScanForward(testMask);
+                __m128 outside = zero;
+                __m128 intersecting = zero;
+                for (uint32_t p = 0; p < 6; p++)
+                {
+                    const SimdPlane& plane = planes[v * 6 + p];
+
+                    // Corner furthest along the plane normal decides if the box is outside, the nearest corner decides if it's inside.
+                    const __m128 farX = plane.posX ? maxX : minX, nearX = plane.posX ? minX : maxX;
+                    const __m128 farY = plane.posY ? maxY : minY, nearY = plane.posY ? minY : maxY;
+                    const __m128 farZ = plane.posZ ? maxZ : minZ, nearZ = plane.posZ ? minZ : maxZ;
+
+                    __m128 farDist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.x, farX), _mm_mul_ps(plane.y, farY)), _mm_mul_ps(plane.z, farZ)), plane.w);
+                    __m128 nearDist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.x, nearX), _mm_mul_ps(plane.y, nearY)), _mm_mul_ps(plane.z, nearZ)), plane.w);
+
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(farDist, zero));
+                    intersecting = _mm_or_ps(intersecting, _mm_cmplt_ps(nearDist, zero));
+                }
+
+                const uint32_t outsideBits = (uint32_t)_mm_movemask_ps(outside);
+                const uint32_t intersectingBits = (uint32_t)_mm_movemask_ps(intersecting);
+                for (uint32_t slot = 0; slot < node.childCount; slot++)
+                {
+                    if (outsideBits & (1u << slot)) continue;
+                    if (intersectingBits & (1u << slot)) childTest[slot] |= 1u << v;
+                    else childInside[slot] |= 1u << v;
+                }
+            }
+
+            // Push the children in reverse order so they are visited in order. Empty children are never visible.
+            for (uint32_t slot = node.childCount; slot-- > 0;)
+            {
+                if (node.emptyMask & (1u << slot)) continue;
+                const uint32_t visibleMask = childTest[slot] | childInside[slot];
+                if (visibleMask == 0) continue;
+
+                const uint32_t child = node.children[slot];
+                if (child & kLeafFlag)
+                {
+                    for (uint32_t mask = visibleMask; mask != 0; mask &= mask - 1) visibleInstances[bitScanForward(mask)].push_back(child & ~kLeafFlag);
+                }
+                else
+                {
+                    stack.push_back({ child, childTest[slot], childInside[slot] });
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Utils/Math/AABB.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU bounding volume hierarchy over the world-space bounds of instances, used for frustum culling.
+
+        The hierarchy is a 4-wide BVH. Each node stores the bounds of its four children in SoA layout,
+        so that the children are tested against a frustum plane at once using SSE. Multiple views
+        (e.g. the camera and shadow cascades) are culled in a single traversal, where a subtree is
+        only tested against the views that partially overlap it.
+
+        The topology is built once. When instances move, the bounds are refit, which is cheap but
+        degrades the culling efficiency if instances move far from their original location.
+    */
+    class dlldecl InstanceBVH
+    {
+    public:
+        /** View frustum represented by six planes.
+            A point p is inside the frustum if dot(plane.xyz, p) + plane.w >= 0 for all planes.
+        */
+        struct Frustum
+        {
+            float4 planes[6];
+
+            /** Extract the frustum planes from a view-projection matrix.
+                The near plane is at clip space z = -w as produced by glm. This is conservative for projections with z in [0,1].
+                \param[in] viewProj View-projection matrix.
+                \param[in] includeNearFar Include the near and far planes. Shadow passes with depth clamping may want to exclude them.
+                \return Frustum.
+            */
+            static Frustum fromViewProj(const glm::mat4& viewProj, bool includeNearFar = true);
+
+            /** Test if a box is completely outside the frustum.
+                This is the reference scalar implementation of the test done by the hierarchy.
+            */
+            bool isCulled(const AABB& box) const;
+        };
+
+        /** Build the hierarchy.
+            \param[in] bounds World-space bounds of the instances. The instance index is the index in this array.
+        */
+        void build(const std::vector<AABB>& bounds);
+
+        /** Update the bounds of instances that moved, and refit the hierarchy above them.
+            \param[in] instances Indices of the instances that moved.
+            \param[in] bounds World-space bounds of all instances.
+        */
+        void refit(const std::vector<uint32_t>& instances, const std::vector<AABB>& bounds);
+
+        /** Cull the instances against a set of views.
+            The visible instances of each view are returned in hierarchy order, which is deterministic.
+            \param[in] views View frustums.
+            \param[out] visibleInstances Indices of the instances intersecting each view. Resized to the number of views.
+        */
+        void cull(const std::vector<Frustum>& views, std::vector<std::vector<uint32_t>>& visibleInstances) const;
+
+        /** Get the number of instances in the hierarchy.
+        */
+        uint32_t getInstanceCount() const { return (uint32_t)mInstanceNodes.size(); }
+
+        /** Get the number of nodes in the hierarchy.
+        */
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+        /** Get the number of views that can be culled in a single traversal.
+        */
+        static const uint32_t kMaxViews = 32;
+
+    private:
+        static const uint32_t kInvalidChild = uint32_t(-1);
+        static const uint32_t kLeafFlag = 0x80000000;
+
+        /** Node with four children. Children are either nodes or instances (tagged with kLeafFlag).
+            Nodes are stored in depth-first order, so children always follow their parent.
+        */
+        struct alignas(16) Node
+        {
+            float minX[4], minY[4], minZ[4];
+            float maxX[4], maxY[4], maxZ[4];
+            uint32_t children[4];
+            uint32_t parent;
+            uint32_t parentSlot;
+            uint32_t childCount;
+            uint32_t emptyMask;     ///< Bit mask of child slots with empty bounds, which are never visible.
+        };
+
+        uint32_t buildRecursive(std::vector<uint32_t>& instances, size_t begin, size_t end, const std::vector<AABB>& bounds, const std::vector<float3>& centers, uint32_t parent, uint32_t parentSlot);
+        void setChildBounds(Node& node, uint32_t slot, const AABB& box);
+        AABB getNodeBounds(const Node& node) const;
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mInstanceNodes;   ///< Node and slot (in the low 2 bits) referencing each instance.
+        AABB mRootBounds;
+    };
+}
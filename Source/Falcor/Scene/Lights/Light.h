@@ -131,6 +131,8 @@ namespace Falcor
         float mUiLightIntensityScale = 1.0f;
         LightData mData, mPrevData;
         Changes mChanges = Changes::None;
+
+        friend class SceneCache;
     };
 
     /** Point light source.
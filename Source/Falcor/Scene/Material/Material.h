@@ -397,6 +397,8 @@ namespace Falcor
         bool mOcclusionMapEnabled = false;
         mutable UpdateFlags mUpdates = UpdateFlags::None;
         static UpdateFlags sGlobalUpdates;
+
+        friend class SceneCache;
     };
 
     enum_class_operators(Material::UpdateFlags);
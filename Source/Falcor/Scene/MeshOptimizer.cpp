@@ -0,0 +1,853 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "MeshOptimizer.h"
+#include "Utils/Math/AABB.h"
+#include <numeric>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kInvalidIndex = 0xffffffff;
+
+        // Scoring parameters from Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+        const uint32_t kForsythCacheSize = 32;
+        const float kCacheDecayPower = 1.5f;
+        const float kLastTriangleScore = 0.75f;
+        const float kValenceBoostScale = 2.f;
+        const float kValenceBoostPower = 0.5f;
+
+        // Simplification parameters.
+        const double kBorderWeight = 10.0;          ///< Weight of the planes constraining border and seam vertices to their open edges, relative to the triangle planes.
+        const float kMaxNormalChangeCos = 0.25f;    ///< Collapses that rotate an adjacent triangle normal by more than about 75 degrees are rejected.
+
+        enum class VertexKind : uint8_t
+        {
+            Manifold,   ///< Interior vertex that can collapse onto any neighbor.
+            Border,     ///< Vertex on an open border that can only collapse along the border.
+            Seam,       ///< Vertex on an attribute seam, with one wedge on each side. Both wedges collapse along the seam together.
+            Locked,     ///< Vertex that can't collapse, e.g. where seams and borders meet.
+        };
+
+        /** Symmetric 4x4 error quadric, accumulating squared distances to a set of weighted planes.
+        */
+        struct Quadric
+        {
+            double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+            double b2 = 0.0, bc = 0.0, bd = 0.0;
+            double c2 = 0.0, cd = 0.0;
+            double d2 = 0.0;
+            double weight = 0.0;    ///< Total area of the triangle planes, used for normalizing the error to a distance.
+
+            void addPlane(double a, double b, double c, double d, double w)
+            {
+                a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+                b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+                c2 += w * c * c; cd += w * c * d;
+                d2 += w * d * d;
+            }
+
+            Quadric& operator+=(const Quadric& q)
+            {
+                a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+                b2 += q.b2; bc += q.bc; bd += q.bd;
+                c2 += q.c2; cd += q.cd;
+                d2 += q.d2;
+                weight += q.weight;
+                return *this;
+            }
+
+            /** Evaluate the mean squared distance of a point to the planes.
+            */
+            double evaluate(const float3& p) const
+            {
+                const double x = p.x, y = p.y, z = p.z;
+                double e = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+                    + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+                    + c2 * z * z + 2.0 * cd * z
+                    + d2;
+                return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+            }
+        };
+
+        uint64_t edgeKey(uint32_t a, uint32_t b)
+        {
+            return ((uint64_t)a << 32) | b;
+        }
+
+        std::vector<uint64_t> getSortedEdges(const std::vector<uint32_t>& indices)
+        {
+            std::vector<uint64_t> edges;
+            edges.reserve(indices.size());
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++) edges.push_back(edgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+            }
+            std::sort(edges.begin(), edges.end());
+            return edges;
+        }
+
+        bool hasEdge(const std::vector<uint64_t>& sortedEdges, uint32_t a, uint32_t b)
+        {
+            return std::binary_search(sortedEdges.begin(), sortedEdges.end(), edgeKey(a, b));
+        }
+
+        /** Check if the edge between two vertices is used by a single triangle.
+        */
+        bool isBorderEdge(const std::vector<uint64_t>& sortedEdges, uint32_t a, uint32_t b)
+        {
+            return hasEdge(sortedEdges, a, b) != hasEdge(sortedEdges, b, a);
+        }
+
+        std::vector<uint32_t> removeDegenerateTriangles(const std::vector<uint32_t>& indices)
+        {
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                if (a != b && b != c && c != a) result.insert(result.end(), { a, b, c });
+            }
+            return result;
+        }
+
+        float computeVertexScore(int cachePosition, uint32_t remainingTriangles)
+        {
+            // Vertices without remaining triangles will never be used again.
+            if (remainingTriangles == 0) return -1.f;
+
+            float score = 0.f;
+            if (cachePosition >= 0)
+            {
+                // The vertices of the last triangle get a fixed score so that the same triangle isn't favored over its neighbors.
+                if (cachePosition < 3) score = kLastTriangleScore;
+                else score = std::pow(1.f - (float)(cachePosition - 3) / (kForsythCacheSize - 3), kCacheDecayPower);
+            }
+
+            // Boost vertices with few remaining triangles to finish them off and avoid leaving lone triangles behind.
+            score += kValenceBoostScale * std::pow((float)remainingTriangles, -kValenceBoostPower);
+            return score;
+        }
+
+        /** Simulate a FIFO cache and return the number of cache misses for each triangle.
+        */
+        std::vector<uint32_t> simulateTriangleMisses(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+        {
+            // A vertex is in the cache if fewer than 'cacheSize' vertices have been inserted after it.
+            std::vector<uint64_t> timestamps(vertexCount, 0);
+            uint64_t time = 0;
+
+            std::vector<uint32_t> misses(indices.size() / 3, 0);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                const uint32_t index = indices[i];
+                assert(index < vertexCount);
+                if (timestamps[index] == 0 || time - timestamps[index] >= cacheSize)
+                {
+                    timestamps[index] = ++time;
+                    misses[i / 3]++;
+                }
+            }
+            return misses;
+        }
+    }
+
+    MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        assert(indices.size() % 3 == 0);
+        VertexCacheStats stats;
+        if (indices.empty()) return stats;
+
+        auto misses = simulateTriangleMisses(indices, vertexCount, cacheSize);
+        for (uint32_t m : misses) stats.transformedVertexCount += m;
+
+        std::vector<bool> referenced(vertexCount, false);
+        uint64_t referencedCount = 0;
+        for (uint32_t index : indices)
+        {
+            if (!referenced[index]) referencedCount++;
+            referenced[index] = true;
+        }
+
+        stats.acmr = (double)stats.transformedVertexCount / misses.size();
+        stats.atvr = (double)stats.transformedVertexCount / referencedCount;
+        return stats;
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        assert(indices.size() % 3 == 0);
+        const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+        if (triangleCount == 0) return indices;
+
+        // Build the vertex to triangle adjacency. Emitted triangles are removed from the lists,
+        // so the first 'remainingTriangles[v]' entries of a vertex's list are its remaining triangles.
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (uint32_t index : indices)
+        {
+            assert(index < vertexCount);
+            adjacencyOffsets[index + 1]++;
+        }
+        std::vector<uint32_t> remainingTriangles(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            remainingTriangles[v] = adjacencyOffsets[v + 1];
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t t = 0; t < triangleCount; t++)
+            {
+                for (uint32_t k = 0; k < 3; k++) adjacency[fill[indices[t * 3 + k]]++] = t;
+            }
+        }
+
+        // Compute the initial scores.
+        std::vector<float> vertexScores(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) vertexScores[v] = computeVertexScore(-1, remainingTriangles[v]);
+
+        std::vector<float> triangleScores(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        uint32_t cache[kForsythCacheSize + 3];
+        uint32_t newCache[kForsythCacheSize + 3];
+        uint32_t cacheSize = 0;
+
+        // Start with the best triangle overall.
+        uint32_t bestTriangle = (uint32_t)std::distance(triangleScores.begin(), std::max_element(triangleScores.begin(), triangleScores.end()));
+        uint32_t inputCursor = 0;
+
+        for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            if (bestTriangle == kInvalidIndex)
+            {
+                // No candidates adjacent to the cache. Continue with the next triangle in input order.
+                while (emitted[inputCursor]) inputCursor++;
+                bestTriangle = inputCursor;
+            }
+
+            const uint32_t* tri = &indices[bestTriangle * 3];
+            result.insert(result.end(), tri, tri + 3);
+            emitted[bestTriangle] = true;
+
+            // Remove the triangle from the adjacency of its vertices.
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint32_t v = tri[k];
+                uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+                uint32_t* end = begin + remainingTriangles[v];
+                uint32_t* it = std::find(begin, end, bestTriangle);
+                assert(it != end);
+                std::swap(*it, *(end - 1));
+                remainingTriangles[v]--;
+            }
+
+            // The triangle's vertices move to the front of the cache, followed by the previous cache content.
+            uint32_t newCacheSize = 0;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                if (std::find(newCache, newCache + newCacheSize, tri[k]) == newCache + newCacheSize) newCache[newCacheSize++] = tri[k];
+            }
+            for (uint32_t i = 0; i < cacheSize; i++)
+            {
+                const uint32_t v = cache[i];
+                if (v != tri[0] && v != tri[1] && v != tri[2]) newCache[newCacheSize++] = v;
+            }
+
+            // Update the scores of all affected vertices, including the ones evicted from the cache, and their remaining triangles.
+            for (uint32_t i = 0; i < newCacheSize; i++)
+            {
+                const uint32_t v = newCache[i];
+                const float score = computeVertexScore(i < kForsythCacheSize ? (int)i : -1, remainingTriangles[v]);
+                const float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+
+                const uint32_t* adjacent = &adjacency[adjacencyOffsets[v]];
+                for (uint32_t j = 0; j < remainingTriangles[v]; j++) triangleScores[adjacent[j]] += delta;
+            }
+
+            cacheSize = std::min(newCacheSize, kForsythCacheSize);
+            std::copy(newCache, newCache + cacheSize, cache);
+
+            // Find the best remaining triangle adjacent to the cache.
+            bestTriangle = kInvalidIndex;
+            float bestScore = -std::numeric_limits<float>::infinity();
+            for (uint32_t i = 0; i < cacheSize; i++)
+            {
+                const uint32_t v = cache[i];
+                const uint32_t* adjacent = &adjacency[adjacencyOffsets[v]];
+                for (uint32_t j = 0; j < remainingTriangles[v]; j++)
+                {
+                    const uint32_t t = adjacent[j];
+                    if (triangleScores[t] > bestScore)
+                    {
+                        bestScore = triangleScores[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+        }
+
+        assert(result.size() == indices.size());
+        return result;
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeOverdraw(const std::vector<uint32_t>& indices, const float3* positions, uint32_t vertexCount, float threshold)
+    {
+        assert(indices.size() % 3 == 0);
+        const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+        if (triangleCount == 0) return indices;
+
+        // Split the triangles into clusters. A cluster can start wherever a triangle misses all its vertices in the
+        // cache, as the cache is effectively flushed there. Long clusters are split further as soon as their ACMR,
+        // simulated starting from an empty cache, is within the threshold of the input ACMR. Reordering such clusters
+        // costs little vertex cache efficiency.
+        const auto misses = simulateTriangleMisses(indices, vertexCount, kDefaultCacheSize);
+        uint64_t totalMisses = 0;
+        for (uint32_t m : misses) totalMisses += m;
+        const double maxAcmr = threshold * (double)totalMisses / triangleCount;
+
+        std::vector<uint32_t> clusterOffsets;
+        std::vector<uint64_t> timestamps(vertexCount, 0);
+        uint64_t time = 0;
+        uint64_t clusterStartTime = 0;
+        uint64_t clusterMisses = 0;
+
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            const uint32_t clusterSize = clusterOffsets.empty() ? 0 : t - clusterOffsets.back();
+            const bool hardBoundary = misses[t] == 3;
+            const bool softBoundary = clusterSize > 0 && (double)clusterMisses <= maxAcmr * clusterSize;
+            if (t == 0 || hardBoundary || softBoundary)
+            {
+                clusterOffsets.push_back(t);
+                clusterStartTime = time;
+                clusterMisses = 0;
+            }
+
+            // Simulate the cache for the current cluster. Vertices inserted before the cluster started count as misses.
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint32_t index = indices[t * 3 + k];
+                if (timestamps[index] <= clusterStartTime || time - timestamps[index] >= kDefaultCacheSize)
+                {
+                    timestamps[index] = ++time;
+                    clusterMisses++;
+                }
+            }
+        }
+        clusterOffsets.push_back(triangleCount);
+
+        // Compute the mesh centroid.
+        float3 meshCentroid = float3(0.f);
+        for (uint32_t index : indices) meshCentroid += positions[index];
+        meshCentroid /= (float)indices.size();
+
+        // Sort the clusters so that clusters facing away from the mesh center are drawn first, as they are likely to occlude the others.
+        const uint32_t clusterCount = (uint32_t)clusterOffsets.size() - 1;
+        std::vector<float> sortKeys(clusterCount);
+        for (uint32_t c = 0; c < clusterCount; c++)
+        {
+            float3 centroid = float3(0.f);
+            float3 normal = float3(0.f);
+            for (uint32_t t = clusterOffsets[c]; t < clusterOffsets[c + 1]; t++)
+            {
+                const float3& p0 = positions[indices[t * 3]];
+                const float3& p1 = positions[indices[t * 3 + 1]];
+                const float3& p2 = positions[indices[t * 3 + 2]];
+                const float3 n = glm::cross(p1 - p0, p2 - p0); // Area weighted.
+                centroid += (p0 + p1 + p2) * glm::length(n);
+                normal += n;
+            }
+            const float area = glm::length(normal);
+            sortKeys[c] = area > 0.f ? glm::dot(centroid / (3.f * area) - meshCentroid, normal / area) : 0.f;
+        }
+
+        std::vector<uint32_t> clusterOrder(clusterCount);
+        std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (uint32_t c : clusterOrder)
+        {
+            result.insert(result.end(), indices.begin() + clusterOffsets[c] * 3, indices.begin() + clusterOffsets[c + 1] * 3);
+        }
+
+        // The cluster boundaries don't strictly bound the cost, so keep the input order if the threshold is exceeded.
+        uint64_t resultMisses = 0;
+        for (uint32_t m : simulateTriangleMisses(result, vertexCount, kDefaultCacheSize)) resultMisses += m;
+        return (double)resultMisses / triangleCount <= maxAcmr ? result : indices;
+    }
+
+    MeshOptimizer::MeshletList MeshOptimizer::buildMeshlets(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t maxVertices, uint32_t maxTriangles)
+    {
+        assert(indices.size() % 3 == 0);
+        assert(maxVertices >= 3 && maxVertices <= 256 && maxTriangles >= 1);
+
+        MeshletList result;
+        Meshlet current;
+
+        // Local index of each vertex in the current meshlet, or invalid if not in the meshlet.
+        std::vector<uint32_t> localIndices(vertexCount, kInvalidIndex);
+
+        auto flush = [&]()
+        {
+            if (current.triangleCount == 0) return;
+            for (uint32_t i = 0; i < current.vertexCount; i++) localIndices[result.vertices[current.vertexOffset + i]] = kInvalidIndex;
+            result.meshlets.push_back(current);
+            current = {};
+            current.vertexOffset = (uint32_t)result.vertices.size();
+            current.triangleOffset = (uint32_t)result.triangles.size();
+        };
+
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const uint32_t tri[3] = { indices[i], indices[i + 1], indices[i + 2] };
+            assert(tri[0] < vertexCount && tri[1] < vertexCount && tri[2] < vertexCount);
+
+            // Count the vertices not yet in the meshlet. Repeated vertices of degenerate triangles are only counted once.
+            uint32_t newVertexCount = 0;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+                if (localIndices[tri[k]] == kInvalidIndex && !repeated) newVertexCount++;
+            }
+
+            if (current.vertexCount + newVertexCount > maxVertices || current.triangleCount + 1 > maxTriangles) flush();
+
+            uint32_t packed = 0;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t& localIndex = localIndices[tri[k]];
+                if (localIndex == kInvalidIndex)
+                {
+                    localIndex = current.vertexCount++;
+                    result.vertices.push_back(tri[k]);
+                }
+                packed |= localIndex << (k * 8);
+            }
+            result.triangles.push_back(packed);
+            current.triangleCount++;
+        }
+        flush();
+
+        return result;
+    }
+
+    MeshOptimizer::MeshletBounds MeshOptimizer::computeMeshletBounds(const MeshletList& meshlets, const Meshlet& meshlet, const float3* positions)
+    {
+        MeshletBounds bounds;
+        if (meshlet.triangleCount == 0) return bounds;
+
+        auto getPosition = [&](uint32_t localIndex) { return positions[meshlets.vertices[meshlet.vertexOffset + localIndex]]; };
+
+        // Bounding sphere centered in the bounding box.
+        AABB aabb;
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++) aabb.include(getPosition(i));
+        bounds.center = aabb.center();
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++) bounds.radius = std::max(bounds.radius, glm::length(getPosition(i) - bounds.center));
+
+        // Normal cone around the average triangle normal. Degenerate triangles are ignored.
+        std::vector<float3> normals;
+        normals.reserve(meshlet.triangleCount);
+        float3 axis = float3(0.f);
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            const uint32_t packed = meshlets.triangles[meshlet.triangleOffset + t];
+            const float3 p0 = getPosition(packed & 0xff);
+            const float3 p1 = getPosition((packed >> 8) & 0xff);
+            const float3 p2 = getPosition((packed >> 16) & 0xff);
+            const float3 n = glm::cross(p1 - p0, p2 - p0);
+            const float length = glm::length(n);
+            if (length > 0.f)
+            {
+                normals.push_back(n / length);
+                axis += normals.back();
+            }
+        }
+
+        const float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength == 0.f) return bounds;
+        axis /= axisLength;
+
+        float minDot = 1.f;
+        for (const auto& n : normals) minDot = std::min(minDot, glm::dot(n, axis));
+
+        // The cone spans a hemisphere or more, so the meshlet can't be culled based on orientation.
+        if (minDot <= 0.f) return bounds;
+
+        bounds.coneAxis = axis;
+        bounds.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        return bounds;
+    }
+
+    MeshOptimizer::SimplifyResult MeshOptimizer::simplify(const std::vector<uint32_t>& indices, const float3* positions, uint32_t vertexCount, size_t targetIndexCount, float maxError)
+    {
+        assert(indices.size() % 3 == 0);
+
+        SimplifyResult result;
+        result.indices = removeDegenerateTriangles(indices);
+        if (result.indices.size() <= targetIndexCount) return result;
+
+        // Group the vertices that share a position, e.g. the vertices on both sides of an attribute seam.
+        // positionIDs[v] is the lowest index of the vertices with the same position and wedges[v] links them in a cycle.
+        std::vector<uint32_t> positionIDs(vertexCount), wedges(vertexCount);
+        {
+            std::vector<uint32_t> order(vertexCount);
+            std::iota(order.begin(), order.end(), 0);
+            auto lessPosition = [&](uint32_t a, uint32_t b)
+            {
+                const float3& pa = positions[a];
+                const float3& pb = positions[b];
+                return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+            };
+            std::stable_sort(order.begin(), order.end(), lessPosition);
+            for (size_t begin = 0, end; begin < order.size(); begin = end)
+            {
+                for (end = begin + 1; end < order.size() && !lessPosition(order[begin], order[end]); end++) {}
+                for (size_t i = begin; i < end; i++)
+                {
+                    positionIDs[order[i]] = order[begin];
+                    wedges[order[i]] = order[i + 1 < end ? i + 1 : begin];
+                }
+            }
+        }
+
+        // Classify the vertices by their open edges, i.e. edges without a twin in the opposite direction.
+        // The edges along an attribute seam are open on both sides. A position with two wedges whose open edges
+        // lead to the same positions in opposite directions is on a seam. Other positions with several wedges are locked.
+        std::vector<VertexKind> kinds(vertexCount, VertexKind::Locked);
+        const auto initialEdges = getSortedEdges(result.indices);
+        {
+            // The open edge into and out of each vertex. A vertex with several open edges in the same direction refers to itself.
+            std::vector<uint32_t> openIn(vertexCount, kInvalidIndex), openOut(vertexCount, kInvalidIndex);
+            for (size_t i = 0; i < result.indices.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const uint32_t a = result.indices[i + k], b = result.indices[i + (k + 1) % 3];
+                    if (hasEdge(initialEdges, b, a)) continue;
+                    openOut[a] = openOut[a] == kInvalidIndex ? b : a;
+                    openIn[b] = openIn[b] == kInvalidIndex ? a : b;
+                }
+            }
+
+            auto hasSingleOpenEdges = [&](uint32_t v)
+            {
+                return openIn[v] != kInvalidIndex && openIn[v] != v && openOut[v] != kInvalidIndex && openOut[v] != v;
+            };
+
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                if (positionIDs[v] != v) continue;
+                const uint32_t w = wedges[v];
+                if (w == v)
+                {
+                    if (openIn[v] == kInvalidIndex && openOut[v] == kInvalidIndex) kinds[v] = VertexKind::Manifold;
+                    else if (hasSingleOpenEdges(v)) kinds[v] = VertexKind::Border;
+                }
+                else if (wedges[w] == v && hasSingleOpenEdges(v) && hasSingleOpenEdges(w))
+                {
+                    if (positionIDs[openIn[v]] == positionIDs[openOut[w]] && positionIDs[openOut[v]] == positionIDs[openIn[w]]) kinds[v] = VertexKind::Seam;
+                }
+            }
+            for (uint32_t v = 0; v < vertexCount; v++) kinds[v] = kinds[positionIDs[v]];
+        }
+
+        // Compute the quadrics per position from the triangle planes, so that the wedges of a vertex share the planes of all its triangles.
+        // Vertices on borders and seams are constrained to their open edges.
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            const uint32_t tri[3] = { result.indices[i], result.indices[i + 1], result.indices[i + 2] };
+            const float3 p0 = positions[tri[0]];
+            const float3 n = glm::cross(positions[tri[1]] - p0, positions[tri[2]] - p0);
+            const float length = glm::length(n);
+            if (length == 0.f) continue;
+
+            const float3 normal = n / length;
+            const double area = 0.5 * length;
+            Quadric q;
+            q.addPlane(normal.x, normal.y, normal.z, -glm::dot(normal, p0), area);
+            q.weight = area;
+            for (uint32_t k = 0; k < 3; k++) quadrics[positionIDs[tri[k]]] += q;
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint32_t a = tri[k], b = tri[(k + 1) % 3];
+                if (hasEdge(initialEdges, b, a)) continue;
+
+                // Plane through the open edge, perpendicular to the triangle.
+                const float3 edge = positions[b] - positions[a];
+                const float3 borderNormal = glm::cross(edge, normal);
+                const float borderLength = glm::length(borderNormal);
+                if (borderLength == 0.f) continue;
+
+                const float3 m = borderNormal / borderLength;
+                Quadric borderQuadric;
+                borderQuadric.addPlane(m.x, m.y, m.z, -glm::dot(m, positions[a]), kBorderWeight * glm::dot(edge, edge));
+                quadrics[positionIDs[a]] += borderQuadric;
+                quadrics[positionIDs[b]] += borderQuadric;
+            }
+        }
+
+        struct Collapse
+        {
+            double error;
+            uint32_t from;
+            uint32_t to;
+
+            bool operator<(const Collapse& other) const { return std::tie(error, from, to) < std::tie(other.error, other.from, other.to); }
+            bool operator==(const Collapse& other) const { return from == other.from && to == other.to; }
+        };
+
+        // The error of a collapse is accumulated with the errors of earlier collapses into the collapsed position,
+        // as the regions around them move with it. The result is an estimate of the geometric deviation, not a bound:
+        // the quadric error is an RMS plane distance, so individual vertices can deviate more.
+        std::vector<double> vertexErrors(vertexCount, 0.0);
+        double resultError = 0.0;
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<uint8_t> touched(vertexCount);
+        std::vector<uint32_t> linkMarks(vertexCount, 0);
+        uint32_t linkStamp = 0;
+        std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+        std::vector<uint32_t> vertexTriangles;
+        std::vector<Collapse> collapses;
+
+        // Each pass collapses a set of independent edges in order of increasing error.
+        while (result.indices.size() > targetIndexCount)
+        {
+            const auto& current = result.indices;
+            const size_t triangleCount = current.size() / 3;
+            const auto edges = getSortedEdges(current);
+
+            // Build the vertex to triangle adjacency.
+            std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+            for (uint32_t index : current) triangleOffsets[index + 1]++;
+            for (uint32_t v = 0; v < vertexCount; v++) triangleOffsets[v + 1] += triangleOffsets[v];
+            vertexTriangles.resize(current.size());
+            {
+                std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+                for (size_t i = 0; i < current.size(); i++) vertexTriangles[fill[current[i]]++] = (uint32_t)(i / 3);
+            }
+
+            // Call a function for the triangles around all wedges of a vertex.
+            auto forEachTriangle = [&](uint32_t v, const auto& func)
+            {
+                uint32_t w = v;
+                do
+                {
+                    for (uint32_t j = triangleOffsets[w]; j < triangleOffsets[w + 1]; j++) func(&current[vertexTriangles[j] * 3]);
+                    w = wedges[w];
+                } while (w != v);
+            };
+
+            // Check that a collapse doesn't flip or strongly rotate the remaining triangles around the collapsed vertex.
+            auto isFlipFree = [&](uint32_t from, uint32_t to)
+            {
+                for (uint32_t j = triangleOffsets[from]; j < triangleOffsets[from + 1]; j++)
+                {
+                    const uint32_t* tri = &current[vertexTriangles[j] * 3];
+                    if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+                    float3 p[3], q[3];
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        p[k] = positions[tri[k]];
+                        q[k] = positions[tri[k] == from ? to : tri[k]];
+                    }
+                    const float3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    const float3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    if (glm::dot(n0, n1) <= kMaxNormalChangeCos * glm::length(n0) * glm::length(n1)) return false;
+                }
+                return true;
+            };
+
+            // Check the link condition (Dey et al., "Topology Preserving Edge Contraction", 1999): the positions adjacent to both ends
+            // of the edge must be the opposite corners of the triangles sharing the edge, and these corners must not form a triangle with
+            // both ends. Otherwise the collapse pinches the surface into non-manifold edges or folds it flat, e.g. on a tetrahedron.
+            // The check is done on positions so that it includes the triangles on both sides of a seam.
+            auto satisfiesLinkCondition = [&](uint32_t from, uint32_t to)
+            {
+                const uint32_t p0 = positionIDs[from], p1 = positionIDs[to];
+                linkStamp += 2;
+                forEachTriangle(to, [&](const uint32_t* tri)
+                {
+                    for (uint32_t k = 0; k < 3; k++) linkMarks[positionIDs[tri[k]]] = linkStamp;
+                });
+
+                uint32_t opposite[2];
+                uint32_t oppositeCount = 0;
+                bool valid = true;
+                forEachTriangle(from, [&](const uint32_t* tri)
+                {
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        const uint32_t p = positionIDs[tri[k]];
+                        if (p != p0 && p != p1 && (positionIDs[tri[(k + 1) % 3]] == p1 || positionIDs[tri[(k + 2) % 3]] == p1) && linkMarks[p] == linkStamp)
+                        {
+                            // The edge is shared by more than two triangles.
+                            if (oppositeCount == 2) valid = false;
+                            else opposite[oppositeCount++] = p;
+                            linkMarks[p] = linkStamp + 1;
+                        }
+                    }
+                });
+                forEachTriangle(from, [&](const uint32_t* tri)
+                {
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        const uint32_t p = positionIDs[tri[k]];
+                        if (p != p0 && p != p1 && linkMarks[p] == linkStamp) valid = false;
+                    }
+                });
+                if (!valid || oppositeCount < 2) return valid;
+
+                auto hasTriangle = [&](uint32_t v, uint32_t p)
+                {
+                    bool found = false;
+                    forEachTriangle(v, [&](const uint32_t* tri)
+                    {
+                        uint32_t matches = 0;
+                        for (uint32_t k = 0; k < 3; k++) matches += positionIDs[tri[k]] == p || positionIDs[tri[k]] == opposite[0] || positionIDs[tri[k]] == opposite[1];
+                        if (matches == 3) found = true;
+                    });
+                    return found;
+                };
+                return !(hasTriangle(from, p0) && hasTriangle(to, p1));
+            };
+
+            // Collect the valid collapses with their errors.
+            // Border and seam vertices only collapse along their open edge onto a vertex of the same kind or a locked vertex.
+            collapses.clear();
+            for (size_t i = 0; i < current.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const uint32_t a = current[i + k], b = current[i + (k + 1) % 3];
+                    for (const auto& [from, to] : { std::make_pair(a, b), std::make_pair(b, a) })
+                    {
+                        const VertexKind kind = kinds[from];
+                        if (kind == VertexKind::Locked) continue;
+                        if (kind != VertexKind::Manifold && ((kinds[to] != kind && kinds[to] != VertexKind::Locked) || !isBorderEdge(edges, from, to))) continue;
+
+                        const uint32_t p = positionIDs[from];
+                        const double error = vertexErrors[p] + std::sqrt(quadrics[p].evaluate(positions[to]));
+                        if (error <= maxError) collapses.push_back({ error, from, to });
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end());
+            collapses.erase(std::unique(collapses.begin(), collapses.end()), collapses.end());
+
+            std::iota(remap.begin(), remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), 0);
+            size_t removedTriangles = 0;
+            const size_t targetRemovedTriangles = triangleCount - targetIndexCount / 3;
+
+            for (const auto& c : collapses)
+            {
+                if (removedTriangles >= targetRemovedTriangles) break;
+                if (touched[positionIDs[c.from]] || touched[positionIDs[c.to]]) continue;
+
+                // A seam vertex moves together with its wedge on the other side, along the seam edge on that side.
+                const bool isSeam = kinds[c.from] == VertexKind::Seam;
+                const uint32_t seamFrom = wedges[c.from];
+                uint32_t seamTo = kInvalidIndex;
+                if (isSeam)
+                {
+                    for (uint32_t w = wedges[c.to]; w != c.to && seamTo == kInvalidIndex; w = wedges[w])
+                    {
+                        if (isBorderEdge(edges, seamFrom, w)) seamTo = w;
+                    }
+                    if (seamTo == kInvalidIndex) continue;
+                }
+                if (!isFlipFree(c.from, c.to) || (isSeam && !isFlipFree(seamFrom, seamTo))) continue;
+                if (!satisfiesLinkCondition(c.from, c.to)) continue;
+
+                // Lock the neighborhood for the rest of the pass, as the checks above assume it doesn't change.
+                size_t sharedTriangles = 0;
+                forEachTriangle(c.from, [&](const uint32_t* tri)
+                {
+                    for (uint32_t k = 0; k < 3; k++) touched[positionIDs[tri[k]]] = 1;
+                    if (positionIDs[tri[0]] == positionIDs[c.to] || positionIDs[tri[1]] == positionIDs[c.to] || positionIDs[tri[2]] == positionIDs[c.to]) sharedTriangles++;
+                });
+
+                remap[c.from] = c.to;
+                if (isSeam) remap[seamFrom] = seamTo;
+
+                const uint32_t p0 = positionIDs[c.from], p1 = positionIDs[c.to];
+                quadrics[p1] += quadrics[p0];
+                vertexErrors[p1] = std::max(vertexErrors[p1], c.error);
+                resultError = std::max(resultError, c.error);
+                removedTriangles += sharedTriangles;
+            }
+
+            if (removedTriangles == 0) break;
+
+            std::vector<uint32_t> collapsed(current.size());
+            for (size_t i = 0; i < current.size(); i++) collapsed[i] = remap[current[i]];
+            result.indices = removeDegenerateTriangles(collapsed);
+        }
+
+        result.error = (float)resultError;
+        return result;
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        std::vector<uint32_t> remap(vertexCount, kInvalidIndex);
+        uint32_t nextIndex = 0;
+
+        for (uint32_t& index : indices)
+        {
+            assert(index < vertexCount);
+            if (remap[index] == kInvalidIndex) remap[index] = nextIndex++;
+            index = remap[index];
+        }
+
+        for (uint32_t& r : remap)
+        {
+            if (r == kInvalidIndex) r = nextIndex++;
+        }
+
+        assert(nextIndex == vertexCount);
+        return remap;
+    }
+}
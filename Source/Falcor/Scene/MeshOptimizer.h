@@ -0,0 +1,176 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** Utilities for optimizing the triangle and vertex order of indexed triangle lists for rasterization.
+        All functions operate on 32-bit indices into a vertex array of the given size.
+    */
+    class dlldecl MeshOptimizer
+    {
+    public:
+        /** Default size of the simulated post-transform vertex cache.
+        */
+        static const uint32_t kDefaultCacheSize = 16;
+
+        /** Post-transform vertex cache statistics.
+        */
+        struct VertexCacheStats
+        {
+            uint64_t transformedVertexCount = 0;    ///< Number of vertices transformed, i.e. number of cache misses.
+            double acmr = 0.0;                      ///< Average cache miss ratio: transformed vertices per triangle. The optimum is around 0.5 for regular meshes, the worst case is 3.
+            double atvr = 0.0;                      ///< Average transform to vertex ratio: transformed vertices per referenced vertex. The optimum is 1.
+        };
+
+        /** Simulate a FIFO post-transform vertex cache.
+            \param[in] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices.
+            \param[in] cacheSize Number of entries in the simulated cache.
+            \return Cache statistics.
+        */
+        static VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Reorder triangles for post-transform vertex cache locality.
+            This uses the greedy algorithm by Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+            The vertex order within each triangle is preserved so the winding is unchanged.
+            \param[in] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices.
+            \return Reordered triangle list indices.
+        */
+        static std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /** Reorder triangles to reduce overdraw, while keeping the vertex cache efficiency close to the input.
+            The triangles are split into clusters at points where the vertex cache efficiency allows it, and the clusters
+            are sorted so that outward facing clusters are drawn first. This is a simplified version of Sander et al.,
+            "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007.
+            The input should already be optimized for the vertex cache.
+            \param[in] indices Triangle list indices.
+            \param[in] positions Vertex positions.
+            \param[in] vertexCount Number of vertices.
+            \param[in] threshold Allowed ACMR increase factor compared to the input, e.g. 1.05.
+            \return Reordered triangle list indices, or the input indices if the reordering would exceed the threshold.
+        */
+        static std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, const float3* positions, uint32_t vertexCount, float threshold = 1.05f);
+
+        /** Compute a vertex remapping for vertex fetch locality.
+            Vertices are ordered by first use in the index buffer. Unreferenced vertices are moved to the end.
+            The indices are updated in place.
+            \param[in,out] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices.
+            \return Remap table, the new index of vertex i is remap[i].
+        */
+        static std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /** Meshlet, a small cluster of triangles of a mesh.
+        */
+        struct Meshlet
+        {
+            uint32_t vertexOffset = 0;      ///< Offset into the meshlet vertex array.
+            uint32_t triangleOffset = 0;    ///< Offset into the meshlet triangle array.
+            uint32_t vertexCount = 0;       ///< Number of vertices.
+            uint32_t triangleCount = 0;     ///< Number of triangles.
+        };
+
+        /** Meshlets of a mesh.
+        */
+        struct MeshletList
+        {
+            std::vector<Meshlet> meshlets;
+            std::vector<uint32_t> vertices;     ///< Mesh vertex indices referenced by the meshlets.
+            std::vector<uint32_t> triangles;    ///< Meshlet-local vertex indices, three 8-bit indices packed per triangle.
+        };
+
+        /** Meshlet culling bounds.
+            The meshlet is backfacing for all points of view 'viewPos' where
+            dot(normalize(center - viewPos), coneAxis) >= coneCutoff + radius / length(center - viewPos).
+        */
+        struct MeshletBounds
+        {
+            float3 center = float3(0.f);    ///< Bounding sphere center.
+            float radius = 0.f;             ///< Bounding sphere radius.
+            float3 coneAxis = float3(0.f);  ///< Normal cone axis (normalized), or zero if the cone is degenerate.
+            float coneCutoff = 1.f;         ///< Sine of the normal cone half-angle, or 1 if the cone spans a hemisphere or more.
+        };
+
+        /** Partition a mesh into meshlets.
+            The triangles are added greedily in input order, so the input should be optimized for the vertex cache
+            (see optimizeVertexCache()) to get spatially coherent meshlets. The result is deterministic.
+            \param[in] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices.
+            \param[in] maxVertices Max number of vertices per meshlet (at most 256).
+            \param[in] maxTriangles Max number of triangles per meshlet.
+            \return Meshlets.
+        */
+        static MeshletList buildMeshlets(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t maxVertices, uint32_t maxTriangles);
+
+        /** Compute the culling bounds of a meshlet.
+            \param[in] meshlets Meshlets returned by buildMeshlets().
+            \param[in] meshlet The meshlet to compute bounds for.
+            \param[in] positions Vertex positions.
+            \return Bounds.
+        */
+        static MeshletBounds computeMeshletBounds(const MeshletList& meshlets, const Meshlet& meshlet, const float3* positions);
+
+        /** Result of mesh simplification.
+        */
+        struct SimplifyResult
+        {
+            std::vector<uint32_t> indices;  ///< Triangle list indices of the simplified mesh, referencing the input vertices.
+            float error = 0.f;              ///< Estimated geometric error in object space units. This is the RMS distance of the collapsed vertices to the planes of their original triangles, accumulated over chains of collapses. It is not a bound on the maximum deviation.
+        };
+
+        /** Simplify a mesh using edge collapses ordered by quadric error, see Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997.
+            Vertices are collapsed onto one of their neighbors, so the simplified mesh references a subset of the input vertices and the vertex data is unchanged.
+            Vertices on attribute seams (e.g. UV seams), i.e. pairs of vertices with the same position, collapse together along the seam so that both sides stay connected.
+            Vertices on open borders only collapse along the border. Vertices where seams or borders meet, or whose position is shared by more than two vertices, are kept.
+            Collapses that fail the link condition are rejected, so the mesh topology is preserved and closed meshes are never reduced below a tetrahedron.
+            \param[in] indices Triangle list indices.
+            \param[in] positions Vertex positions.
+            \param[in] vertexCount Number of vertices.
+            \param[in] targetIndexCount Target number of indices. The result may have more indices if the error limit or topology prevents further collapses.
+            \param[in] maxError Max estimated geometric error in object space units, see SimplifyResult::error.
+            \return Simplified mesh.
+        */
+        static SimplifyResult simplify(const std::vector<uint32_t>& indices, const float3* positions, uint32_t vertexCount, size_t targetIndexCount, float maxError);
+
+        /** Reorder vertex data using a remap table from optimizeVertexFetch().
+            \param[in,out] vertices Vertex data.
+            \param[in] remap Remap table, the new index of vertex i is remap[i].
+        */
+        template<typename T>
+        static void remapVertices(std::vector<T>& vertices, const std::vector<uint32_t>& remap)
+        {
+            assert(vertices.size() == remap.size());
+            std::vector<T> remapped(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++) remapped[remap[i]] = vertices[i];
+            vertices = std::move(remapped);
+        }
+    };
+}
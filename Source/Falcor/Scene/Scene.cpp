@@ -36,6 +36,7 @@ namespace Falcor
 {
     static_assert(sizeof(MeshDesc) % 16 == 0, "MeshDesc size should be a multiple of 16");
     static_assert(sizeof(PackedStaticVertexData) % 16 == 0, "PackedStaticVertexData size should be a multiple of 16");
+    static_assert(sizeof(PackedCompactVertexData) == 20, "PackedCompactVertexData size should be 20B");
     static_assert(sizeof(PackedMeshInstanceData) % 16 == 0, "PackedMeshInstanceData size should be a multiple of 16");
     static_assert(sizeof(ProceduralPrimitiveData) % 16 == 0, "ProceduralPrimitiveData size should be a multiple of 16");
     static_assert(PackedMeshInstanceData::kMatrixBits + PackedMeshInstanceData::kMeshBits + PackedMeshInstanceData::kFlagsBits + PackedMeshInstanceData::kMaterialBits <= 64);
@@ -49,6 +50,9 @@ namespace Falcor
         const std::string kParameterBlockName = "gScene";
         const std::string kMeshBufferName = "meshes";
         const std::string kMeshInstanceBufferName = "meshInstances";
+        const std::string kMeshletBufferName = "meshlets";
+        const std::string kMeshletVertexBufferName = "meshletVertices";
+        const std::string kMeshletTriangleBufferName = "meshletTriangles";
         const std::string kIndexBufferName = "indexData";
         const std::string kVertexBufferName = "vertices";
         const std::string kPrevVertexBufferName = "prevVertices";
@@ -60,6 +64,7 @@ namespace Falcor
         const std::string kCurveVertexBufferName = "curveVertices";
         const std::string kCurvePrevVertexBufferName = "curvePrevVertices";
         const std::string kMaterialsBufferName = "materials";
+        const std::string kMaterialResourcesName = "materialResources";
         const std::string kLightsBufferName = "lights";
         const std::string kVolumesBufferName = "volumes";
 
@@ -120,6 +125,7 @@ namespace Falcor
         defines.add("SCENE_HAS_INDEXED_VERTICES", hasIndexBuffer() ? "1" : "0");
         defines.add("SCENE_HAS_16BIT_INDICES", mHas16BitIndices ? "1" : "0");
         defines.add("SCENE_HAS_32BIT_INDICES", mHas32BitIndices ? "1" : "0");
+        defines.add("SCENE_USE_COMPACT_VERTICES", mUseCompactVertices ? "1" : "0");
         defines.add(mHitInfo.getDefines());
         return defines;
     }
@@ -139,16 +145,28 @@ namespace Falcor
     void Scene::rasterize(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, RenderFlags flags)
     {
         PROFILE("rasterizeScene");
+        rasterizeDrawArgs(pContext, pState, pVars, mDrawArgs, flags);
+    }
+
+    void Scene::rasterize(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, uint32_t viewIndex, RenderFlags flags)
+    {
+        PROFILE("rasterizeScene");
+        if (viewIndex >= mCulledViews.size()) throw std::exception("Scene::rasterize() view index is out of range. Call cullMeshInstances() first.");
+        rasterizeDrawArgs(pContext, pState, pVars, mCulledViews[viewIndex].drawArgs, flags);
+    }
 
+    void Scene::rasterizeDrawArgs(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, const std::vector<DrawArgs>& drawArgs, RenderFlags flags)
+    {
         pVars->setParameterBlock("gScene", mpSceneBlock);
 
         bool overrideRS = !is_set(flags, RenderFlags::UserRasterizerState);
         auto pCurrentRS = pState->getRasterizerState();
         bool isIndexed = hasIndexBuffer();
 
-        for (const auto& draw : mDrawArgs)
+        for (const auto& draw : drawArgs)
         {
-            assert(draw.count > 0);
+            // Culled draw lists may be empty.
+            if (draw.count == 0) continue;
 
             // Set state.
             pState->setVao(draw.ibFormat == ResourceFormat::R16Uint ? mpVao16Bit : mpVao);
@@ -200,10 +218,18 @@ namespace Falcor
         assert(pReflection);
 
         mpSceneBlock = ParameterBlock::create(pReflection);
+        mMaterialResourcesHandle = ShaderVarHandle(mpSceneBlock->getRootVar(), kMaterialResourcesName);
         mpMeshesBuffer = Buffer::createStructured(mpSceneBlock[kMeshBufferName], (uint32_t)mMeshDesc.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
         mpMeshesBuffer->setName("Scene::mpMeshesBuffer");
         mpMeshInstancesBuffer = Buffer::createStructured(mpSceneBlock[kMeshInstanceBufferName], (uint32_t)mMeshInstanceData.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
         mpMeshInstancesBuffer->setName("Scene::mpMeshInstancesBuffer");
+        mPackedMeshInstanceData.init(mpMeshInstancesBuffer);
+
+        if (!mMeshletDesc.empty())
+        {
+            mpMeshletsBuffer = Buffer::createStructured(mpSceneBlock[kMeshletBufferName], (uint32_t)mMeshletDesc.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
+            mpMeshletsBuffer->setName("Scene::mpMeshletsBuffer");
+        }
 
         if (!mProceduralPrimData.empty())
         {
@@ -226,17 +252,20 @@ namespace Falcor
 
         mpMaterialsBuffer = Buffer::createStructured(mpSceneBlock[kMaterialsBufferName], (uint32_t)mMaterials.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
         mpMaterialsBuffer->setName("Scene::mpMaterialsBuffer");
+        mMaterialData.init(mpMaterialsBuffer);
 
         if (!mLights.empty())
         {
             mpLightsBuffer = Buffer::createStructured(mpSceneBlock[kLightsBufferName], (uint32_t)mLights.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
             mpLightsBuffer->setName("Scene::mpLightsBuffer");
+            mLightData.init(mpLightsBuffer);
         }
 
         if (!mVolumes.empty())
         {
             mpVolumesBuffer = Buffer::createStructured(mpSceneBlock[kVolumesBufferName], (uint32_t)mVolumes.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
             mpVolumesBuffer->setName("Scene::mpVolumesBuffer");
+            mVolumeData.init(mpVolumesBuffer);
         }
     }
 
@@ -246,10 +275,14 @@ namespace Falcor
 
         // Upload geometry
         mpMeshesBuffer->setBlob(mMeshDesc.data(), 0, sizeof(MeshDesc) * mMeshDesc.size());
+        if (!mMeshletDesc.empty()) mpMeshletsBuffer->setBlob(mMeshletDesc.data(), 0, sizeof(MeshletDesc) * mMeshletDesc.size());
         if (!mCurveDesc.empty()) mpCurvesBuffer->setBlob(mCurveDesc.data(), 0, sizeof(CurveDesc) * mCurveDesc.size());
 
         mpSceneBlock->setBuffer(kMeshInstanceBufferName, mpMeshInstancesBuffer);
         mpSceneBlock->setBuffer(kMeshBufferName, mpMeshesBuffer);
+        mpSceneBlock->setBuffer(kMeshletBufferName, mpMeshletsBuffer);
+        mpSceneBlock->setBuffer(kMeshletVertexBufferName, mpMeshletVerticesBuffer);
+        mpSceneBlock->setBuffer(kMeshletTriangleBufferName, mpMeshletTrianglesBuffer);
         mpSceneBlock->setBuffer(kProceduralPrimBufferName, mpProceduralPrimitivesBuffer);
         mpSceneBlock->setBuffer(kProceduralPrimAABBBufferName, mpRtAABBBuffer);
         mpSceneBlock->setBuffer(kCurveInstanceBufferName, mpCurveInstancesBuffer);
@@ -268,19 +301,19 @@ namespace Falcor
         }
     }
 
-    // TODO: On initial upload of materials, we could improve this by not having separate calls to setElement()
-    // but instead prepare a buffer containing all data.
-    void Scene::uploadMaterial(uint32_t materialID)
+    void Scene::uploadMaterial(uint32_t materialID, bool updateResources)
     {
         assert(materialID < mMaterials.size());
 
         const auto& material = mMaterials[materialID];
 
-        mpMaterialsBuffer->setElement(materialID, material->getData());
+        mMaterialData.set(materialID, material->getData());
+
+        if (!updateResources) return;
 
         const auto& resources = material->getResources();
 
-        auto var = mpSceneBlock["materialResources"][materialID];
+        auto var = mpSceneBlock[mMaterialResourcesHandle][materialID];
 
 #define set_texture(texName) var[#texName] = resources.texName;
         set_texture(baseColor);
@@ -376,18 +409,16 @@ namespace Falcor
                 throw std::exception(("Number of materials (" + std::to_string(mMaterials.size()) + ") exceeds the maximum (" + std::to_string(maxMaterials) + ").").c_str());
             }
 
-            // Prepare packed mesh instance data.
+            // Prepare packed mesh instance data. Only the instances whose packed data changed are uploaded.
             assert(mMeshInstanceData.size() > 0);
-            mPackedMeshInstanceData.resize(mMeshInstanceData.size());
+            assert(mPackedMeshInstanceData.getCount() == mMeshInstanceData.size());
 
             for (size_t i = 0; i < mMeshInstanceData.size(); i++)
             {
-                mPackedMeshInstanceData[i].pack(mMeshInstanceData[i]);
+                PackedMeshInstanceData packedData;
+                packedData.pack(mMeshInstanceData[i]);
+                mPackedMeshInstanceData.set(i, packedData);
             }
-
-            size_t byteSize = sizeof(PackedMeshInstanceData) * mPackedMeshInstanceData.size();
-            assert(mpMeshInstancesBuffer && mpMeshInstancesBuffer->getSize() == byteSize);
-            mpMeshInstancesBuffer->setBlob(mPackedMeshInstanceData.data(), 0, byteSize);
         }
     }
 
@@ -427,6 +458,7 @@ namespace Falcor
 
         updateBounds();
         createDrawList();
+        updateMeshInstanceBounds(true);
         if (mCameras.size() == 0)
         {
             // Create a new camera to use in the event of a scene with no cameras
@@ -441,6 +473,7 @@ namespace Falcor
         updateVolumes(true);
         updateEnvMap(true);
         updateMaterials(true);
+        uploadShadowBuffers();
         uploadResources(); // Upload data after initialization is complete
         updateGeometryStats();
         updateMaterialStats();
@@ -530,6 +563,7 @@ namespace Falcor
 
         s.indexMemoryInBytes += pIB ? pIB->getSize() : 0;
         s.vertexMemoryInBytes += pVB ? pVB->getSize() : 0;
+        s.vertexMemorySavedInBytes = mUseCompactVertices ? s.uniqueVertexCount * (sizeof(PackedStaticVertexData) - sizeof(PackedCompactVertexData)) : 0;
 
         s.curveIndexMemoryInBytes = 0;
         s.curveVertexMemoryInBytes = 0;
@@ -543,7 +577,23 @@ namespace Falcor
             s.curveVertexMemoryInBytes += pCurveVB ? pCurveVB->getSize() : 0;
         }
 
+        s.meshletCount = getMeshletCount();
+        s.meshletMemoryInBytes = 0;
+        s.meshletMemoryInBytes += mpMeshletsBuffer ? mpMeshletsBuffer->getSize() : 0;
+        s.meshletMemoryInBytes += mpMeshletVerticesBuffer ? mpMeshletVerticesBuffer->getSize() : 0;
+        s.meshletMemoryInBytes += mpMeshletTrianglesBuffer ? mpMeshletTrianglesBuffer->getSize() : 0;
+
+        s.meshLODCount = 0;
+        s.lodIndexMemoryInBytes = 0;
+        for (uint32_t meshID = 0; meshID < (uint32_t)mMeshLODs.size(); meshID++)
+        {
+            const size_t indexSize = mMeshDesc[meshID].use16BitIndices() ? sizeof(uint16_t) : sizeof(uint32_t);
+            for (const auto& lod : mMeshLODs[meshID]) s.lodIndexMemoryInBytes += lod.indexCount * indexSize;
+            s.meshLODCount += mMeshLODs[meshID].size();
+        }
+
         s.geometryMemoryInBytes += mpMeshesBuffer ? mpMeshesBuffer->getSize() : 0;
+        s.geometryMemoryInBytes += s.meshletMemoryInBytes;
         s.geometryMemoryInBytes += mpMeshInstancesBuffer ? mpMeshInstancesBuffer->getSize() : 0;
         s.geometryMemoryInBytes += mpRtAABBBuffer ? mpRtAABBBuffer->getSize() : 0;
         s.geometryMemoryInBytes += mpProceduralPrimitivesBuffer ? mpProceduralPrimitivesBuffer->getSize() : 0;
@@ -605,6 +655,7 @@ namespace Falcor
         }
         if (mpBlasScratch) s.blasScratchMemoryInBytes += mpBlasScratch->getSize();
         if (mpBlasStaticWorldMatrices) s.blasScratchMemoryInBytes += mpBlasStaticWorldMatrices->getSize();
+        if (mpBlasQuantizationMatrices) s.blasScratchMemoryInBytes += mpBlasQuantizationMatrices->getSize();
     }
 
     void Scene::updateRaytracingTLASStats()
@@ -753,8 +804,7 @@ namespace Falcor
 
             if (changes != Light::Changes::None || is_set(combinedChanges, Light::Changes::Active) || forceUpdate)
             {
-                // TODO: This is slow since the buffer is not CPU writable. Copy into CPU buffer and upload once instead.
-                mpLightsBuffer->setElement(lightCount, light->getData());
+                mLightData.set(lightCount, light->getData());
             }
 
             lightCount++;
@@ -811,7 +861,7 @@ namespace Falcor
                 auto data = volume->getData();
                 data.densityGrid = volume->getDensityGrid() ? mGridIDs.at(volume->getDensityGrid()) : kInvalidGrid;
                 data.emissionGrid = volume->getEmissionGrid() ? mGridIDs.at(volume->getEmissionGrid()) : kInvalidGrid;
-                mpVolumesBuffer->setElement(volumeIndex, data);
+                mVolumeData.set(volumeIndex, data);
             }
             volume->clearUpdates();
             volumeIndex++;
@@ -866,7 +916,7 @@ namespace Falcor
             if (forceUpdate || materialUpdates != Material::UpdateFlags::None)
             {
                 material->clearUpdates();
-                uploadMaterial(materialId);
+                uploadMaterial(materialId, forceUpdate || is_set(materialUpdates, Material::UpdateFlags::ResourcesChanged));
                 flags |= UpdateFlags::MaterialsChanged;
             }
         }
@@ -877,9 +927,55 @@ namespace Falcor
         return flags;
     }
 
+    void Scene::uploadShadowBuffers()
+    {
+        auto upload = [this](auto& buffer)
+        {
+            const size_t byteSize = buffer.upload();
+            if (byteSize > 0)
+            {
+                mSceneStats.bufferUploadCount++;
+                mSceneStats.bufferUploadBytes += byteSize;
+            }
+        };
+
+        upload(mPackedMeshInstanceData);
+        upload(mLightData);
+        upload(mVolumeData);
+        upload(mMaterialData);
+    }
+
+    void Scene::recordSyncCounts(RenderContext* pContext, const std::string& subsystem)
+    {
+        const uint64_t flushCount = pContext->getFlushCount() - mSyncCheckpoint.flushCount;
+        const uint64_t syncCount = pContext->getSyncCount() - mSyncCheckpoint.syncCount;
+
+        if (flushCount > 0 || syncCount > 0)
+        {
+            auto& counts = mSceneStats.updateSyncCounts[subsystem];
+            counts.flushCount += flushCount;
+            counts.syncCount += syncCount;
+            mSceneStats.updateFlushCount += flushCount;
+            mSceneStats.updateSyncCount += syncCount;
+        }
+
+        mSyncCheckpoint.flushCount = pContext->getFlushCount();
+        mSyncCheckpoint.syncCount = pContext->getSyncCount();
+    }
+
     Scene::UpdateFlags Scene::update(RenderContext* pContext, double currentTime)
     {
         mUpdates = UpdateFlags::None;
+        mSceneStats.bufferUploadCount = 0;
+        mSceneStats.bufferUploadBytes = 0;
+        mSceneStats.updateFlushCount = 0;
+        mSceneStats.updateSyncCount = 0;
+        mSceneStats.updateSyncCounts.clear();
+        mSyncCheckpoint.flushCount = pContext->getFlushCount();
+        mSyncCheckpoint.syncCount = pContext->getSyncCount();
+
+        // All updates below are recorded into the context's command list and submitted with the rest of the frame.
+        // Subsystems only flush when they have to read back GPU data, which is tracked per subsystem in the scene stats.
         if (mpAnimationController->animate(pContext, currentTime))
         {
             mUpdates |= UpdateFlags::SceneGraphChanged;
@@ -891,25 +987,30 @@ namespace Falcor
                 }
             }
         }
+        recordSyncCounts(pContext, "animation");
 
         mUpdates |= updateSelectedCamera(false);
         mUpdates |= updateLights(false);
         mUpdates |= updateVolumes(false);
         mUpdates |= updateEnvMap(false);
         mUpdates |= updateMaterials(false);
-        pContext->flush();
         if (is_set(mUpdates, UpdateFlags::MeshesMoved))
         {
-            mTlasCache.clear();
+            updateTlasInstances();
             updateMeshInstances(false);
+            updateMeshInstanceBounds(false);
         }
+        uploadShadowBuffers();
+        recordSyncCounts(pContext, "sceneData");
 
         // If a transform in the scene changed, update BLASes with skinned meshes
         if (mBlasData.size() && mHasSkinnedMesh && is_set(mUpdates, UpdateFlags::SceneGraphChanged))
         {
-            mTlasCache.clear();
             buildBlas(pContext);
+            // The skinned BLASes were updated in place (a full rebuild clears the TLAS cache), so the instance descs are still valid.
+            for (auto& [rayCount, tlas] : mTlasCache) tlas.instances.invalidate();
         }
+        recordSyncCounts(pContext, "blas");
 
         // Update light collection
         if (mpLightCollection && mpLightCollection->update(pContext))
@@ -921,6 +1022,7 @@ namespace Falcor
         {
             mSceneStats.emissiveMemoryInBytes = 0;
         }
+        recordSyncCounts(pContext, "lightCollection");
 
         if (mRenderSettings != mPrevRenderSettings)
         {
@@ -1088,7 +1190,11 @@ namespace Falcor
                 << "  Instanced triangle count: " << s.instancedTriangleCount << std::endl
                 << "  Instanced vertex count: " << s.instancedVertexCount << std::endl
                 << "  Index  buffer memory: " << formatByteSize(s.indexMemoryInBytes) << std::endl
-                << "  Vertex buffer memory: " << formatByteSize(s.vertexMemoryInBytes) << std::endl
+                << "  Vertex buffer memory: " << formatByteSize(s.vertexMemoryInBytes) << (mUseCompactVertices ? " (compact, saved " + formatByteSize(s.vertexMemorySavedInBytes) + ")" : "") << std::endl
+                << "  Meshlet count: " << s.meshletCount << std::endl
+                << "  Meshlet data memory: " << formatByteSize(s.meshletMemoryInBytes) << std::endl
+                << "  Mesh LOD count: " << s.meshLODCount << std::endl
+                << "  Mesh LOD index memory: " << formatByteSize(s.lodIndexMemoryInBytes) << std::endl
                 << "  Geometry data memory: " << formatByteSize(s.geometryMemoryInBytes) << std::endl
                 << "  Animation data memory: " << formatByteSize(s.animationMemoryInBytes) << std::endl
                 << "  Curve count: " << getCurveCount() << std::endl
@@ -1346,6 +1452,28 @@ namespace Falcor
         mpAnimationController->setEnabled(animate);
     }
 
+    void Scene::setTlasUpdateMode(UpdateMode mode)
+    {
+        // The TLASes are recreated, as the build flags and memory requirements depend on the update mode.
+        if (mode != mTlasUpdateMode)
+        {
+            mTlasCache.clear();
+            mpTlasScratch = nullptr;
+        }
+        mTlasUpdateMode = mode;
+    }
+
+    void Scene::updateTlasInstances()
+    {
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        auto isMatrixChanged = [this](uint32_t matrixID) { return mpAnimationController->isMatrixChanged(matrixID); };
+
+        for (auto& [rayCount, tlas] : mTlasCache)
+        {
+            tlas.instances.updateTransforms(globalMatrices, isMatrixChanged);
+        }
+    }
+
     void Scene::setBlasUpdateMode(UpdateMode mode)
     {
         if (mode != mBlasUpdateMode) mRebuildBlas = true;
@@ -1358,22 +1486,25 @@ namespace Falcor
         auto pMatricesBuffer = mpSceneBlock->getBuffer("worldMatrices");
         const glm::mat4* matrices = (glm::mat4*)pMatricesBuffer->map(Buffer::MapType::Read); // #SCENEV2 This will cause the pipeline to flush and sync, but it's probably not too bad as this only happens once
 
-        // Helper to create the draw-indirect buffer.
+        // Helper to create the draw-indirect buffer. Returns the index of the draw list, or kInvalidDrawList if there are no draws.
         auto createDrawBuffer = [this](const auto& drawMeshes, bool ccw, ResourceFormat ibFormat = ResourceFormat::Unknown)
         {
-            if (drawMeshes.size() > 0)
-            {
-                DrawArgs draw;
-                draw.pBuffer = Buffer::create(sizeof(drawMeshes[0]) * drawMeshes.size(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, drawMeshes.data());
-                draw.pBuffer->setName("Scene draw buffer");
-                assert(drawMeshes.size() <= std::numeric_limits<uint32_t>::max());
-                draw.count = (uint32_t)drawMeshes.size();
-                draw.ccw = ccw;
-                draw.ibFormat = ibFormat;
-                mDrawArgs.push_back(draw);
-            }
+            if (drawMeshes.size() == 0) return kInvalidDrawList;
+
+            DrawArgs draw;
+            draw.pBuffer = Buffer::create(sizeof(drawMeshes[0]) * drawMeshes.size(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, drawMeshes.data());
+            draw.pBuffer->setName("Scene draw buffer");
+            assert(drawMeshes.size() <= std::numeric_limits<uint32_t>::max());
+            draw.count = (uint32_t)drawMeshes.size();
+            draw.ccw = ccw;
+            draw.ibFormat = ibFormat;
+            mDrawArgs.push_back(draw);
+            return (uint32_t)mDrawArgs.size() - 1;
         };
 
+        // The draw list and arguments of each instance are recorded, so that culled draw lists can be built by gathering them.
+        std::vector<uint32_t> instanceDrawList(mMeshInstanceData.size());
+
         if (hasIndexBuffer())
         {
             std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> drawClockwiseMeshes[2], drawCounterClockwiseMeshes[2];
@@ -1390,16 +1521,24 @@ namespace Falcor
                 draw.InstanceCount = 1;
                 draw.StartIndexLocation = mesh.ibOffset * (use16Bit ? 2 : 1);
                 draw.BaseVertexLocation = mesh.vbOffset;
-                draw.StartInstanceLocation = instanceID++;
+                draw.StartInstanceLocation = instanceID;
 
                 int i = use16Bit ? 0 : 1;
-                (doesTransformFlip(transform)) ? drawClockwiseMeshes[i].push_back(draw) : drawCounterClockwiseMeshes[i].push_back(draw);
+                bool flipped = doesTransformFlip(transform);
+                flipped ? drawClockwiseMeshes[i].push_back(draw) : drawCounterClockwiseMeshes[i].push_back(draw);
+                instanceDrawList[instanceID] = (flipped ? 0 : 2) + i;
+                mMeshInstanceIndexedDraws.push_back(draw);
+                instanceID++;
             }
 
-            createDrawBuffer(drawClockwiseMeshes[0], false, ResourceFormat::R16Uint);
-            createDrawBuffer(drawClockwiseMeshes[1], false, ResourceFormat::R32Uint);
-            createDrawBuffer(drawCounterClockwiseMeshes[0], true, ResourceFormat::R16Uint);
-            createDrawBuffer(drawCounterClockwiseMeshes[1], true, ResourceFormat::R32Uint);
+            const uint32_t drawLists[4] =
+            {
+                createDrawBuffer(drawClockwiseMeshes[0], false, ResourceFormat::R16Uint),
+                createDrawBuffer(drawClockwiseMeshes[1], false, ResourceFormat::R32Uint),
+                createDrawBuffer(drawCounterClockwiseMeshes[0], true, ResourceFormat::R16Uint),
+                createDrawBuffer(drawCounterClockwiseMeshes[1], true, ResourceFormat::R32Uint),
+            };
+            for (auto& drawList : instanceDrawList) drawList = drawLists[drawList];
         }
         else
         {
@@ -1416,13 +1555,103 @@ namespace Falcor
                 draw.VertexCountPerInstance = mesh.vertexCount;
                 draw.InstanceCount = 1;
                 draw.StartVertexLocation = mesh.vbOffset;
-                draw.StartInstanceLocation = instanceID++;
+                draw.StartInstanceLocation = instanceID;
 
-                (doesTransformFlip(transform)) ? drawClockwiseMeshes.push_back(draw) : drawCounterClockwiseMeshes.push_back(draw);
+                bool flipped = doesTransformFlip(transform);
+                flipped ? drawClockwiseMeshes.push_back(draw) : drawCounterClockwiseMeshes.push_back(draw);
+                instanceDrawList[instanceID] = flipped ? 0 : 1;
+                mMeshInstanceDraws.push_back(draw);
+                instanceID++;
             }
 
-            createDrawBuffer(drawClockwiseMeshes, false);
-            createDrawBuffer(drawCounterClockwiseMeshes, true);
+            const uint32_t drawLists[2] =
+            {
+                createDrawBuffer(drawClockwiseMeshes, false),
+                createDrawBuffer(drawCounterClockwiseMeshes, true),
+            };
+            for (auto& drawList : instanceDrawList) drawList = drawLists[drawList];
+        }
+
+        mMeshInstanceDrawList = std::move(instanceDrawList);
+    }
+
+    void Scene::updateMeshInstanceBounds(bool forceUpdate)
+    {
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        mMeshInstanceBounds.resize(mMeshInstanceData.size());
+
+        // Skinned meshes are deformed on the GPU, so their bounds are unknown. They are never culled and are left out of the hierarchy.
+        auto updateInstance = [&](uint32_t instanceID)
+        {
+            const auto& inst = mMeshInstanceData[instanceID];
+            mMeshInstanceBounds[instanceID] = mMeshHasDynamicData[inst.meshID] ? AABB() : mMeshBBs[inst.meshID].transform(globalMatrices[inst.globalMatrixID]);
+        };
+
+        if (forceUpdate)
+        {
+            mUncullableMeshInstances.clear();
+            for (uint32_t instanceID = 0; instanceID < (uint32_t)mMeshInstanceData.size(); instanceID++)
+            {
+                updateInstance(instanceID);
+                if (mMeshHasDynamicData[mMeshInstanceData[instanceID].meshID]) mUncullableMeshInstances.push_back(instanceID);
+            }
+            mInstanceBVH.build(mMeshInstanceBounds);
+        }
+        else
+        {
+            std::vector<uint32_t> changedInstances;
+            for (uint32_t instanceID = 0; instanceID < (uint32_t)mMeshInstanceData.size(); instanceID++)
+            {
+                if (!mpAnimationController->isMatrixChanged(mMeshInstanceData[instanceID].globalMatrixID)) continue;
+                updateInstance(instanceID);
+                changedInstances.push_back(instanceID);
+            }
+            mInstanceBVH.refit(changedInstances, mMeshInstanceBounds);
+        }
+    }
+
+    void Scene::cullMeshInstances(const std::vector<InstanceBVH::Frustum>& views)
+    {
+        PROFILE("cullMeshInstances");
+
+        mInstanceBVH.cull(views, mVisibleMeshInstances);
+
+        if (mCulledViews.size() < views.size()) mCulledViews.resize(views.size());
+
+        // Gather the draw arguments of the visible instances into the draw lists of each view.
+        // The lists mirror mDrawArgs, so the draw buffers are allocated for the worst case and reused.
+        auto gatherDraws = [this](const auto& instanceDraws, CulledView& view, const std::vector<uint32_t>& visibleInstances)
+        {
+            using DrawType = typename std::decay_t<decltype(instanceDraws)>::value_type;
+
+            if (view.drawArgs.empty())
+            {
+                for (const auto& draw : mDrawArgs)
+                {
+                    DrawArgs culledDraw = draw;
+                    culledDraw.pBuffer = Buffer::create(sizeof(DrawType) * draw.count, Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, nullptr);
+                    culledDraw.pBuffer->setName("Scene culled draw buffer");
+                    view.drawArgs.push_back(culledDraw);
+                }
+            }
+
+            std::vector<std::vector<DrawType>> draws(mDrawArgs.size());
+            auto gatherInstance = [&](uint32_t instanceID) { draws[mMeshInstanceDrawList[instanceID]].push_back(instanceDraws[instanceID]); };
+            for (uint32_t instanceID : visibleInstances) gatherInstance(instanceID);
+            for (uint32_t instanceID : mUncullableMeshInstances) gatherInstance(instanceID);
+
+            view.visibleInstanceCount = (uint32_t)(visibleInstances.size() + mUncullableMeshInstances.size());
+            for (size_t i = 0; i < draws.size(); i++)
+            {
+                view.drawArgs[i].count = (uint32_t)draws[i].size();
+                if (!draws[i].empty()) view.drawArgs[i].pBuffer->setBlob(draws[i].data(), 0, sizeof(DrawType) * draws[i].size());
+            }
+        };
+
+        for (size_t viewIndex = 0; viewIndex < views.size(); viewIndex++)
+        {
+            if (hasIndexBuffer()) gatherDraws(mMeshInstanceIndexedDraws, mCulledViews[viewIndex], mVisibleMeshInstances[viewIndex]);
+            else gatherDraws(mMeshInstanceDraws, mCulledViews[viewIndex], mVisibleMeshInstances[viewIndex]);
         }
     }
 
@@ -1430,6 +1659,7 @@ namespace Falcor
     {
         assert(mBlasData.empty());
         assert(!mpBlasStaticWorldMatrices);
+        assert(!mpBlasQuantizationMatrices);
 
         const VertexBufferLayout::SharedConstPtr& pVbLayout = mpVao->getVertexLayout()->getBufferLayout(kStaticDataBufferIndex);
         const Buffer::SharedPtr& pVb = mpVao->getVertexBuffer(kStaticDataBufferIndex);
@@ -1465,6 +1695,11 @@ namespace Falcor
         mRebuildBlas = true;
         mHasSkinnedMesh = false;
 
+        // With compact vertices, the positions are quantized relative to the mesh bounds.
+        // The dequantization is folded into a per-geometry transform, premultiplied by the world transform for static meshes.
+        // The transforms are stored as 3x4 row-major matrices (3 float4 each). The GPU addresses are patched once the buffer is created.
+        std::vector<float4> quantizationMatrices;
+
         for (size_t i = 0; i < mMeshGroups.size(); i++)
         {
             const auto& meshList = mMeshGroups[i].meshList;
@@ -1482,6 +1717,7 @@ namespace Falcor
                 D3D12_RAYTRACING_GEOMETRY_DESC& desc = geomDescs[j];
                 desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
                 desc.Triangles.Transform3x4 = 0; // The default is no transform
+                glm::mat4 blasTransform = glm::identity<glm::mat4>();
 
                 if (isStatic)
                 {
@@ -1495,10 +1731,19 @@ namespace Falcor
                     if (globalMatrices[matrixID] != glm::identity<glm::mat4>())
                     {
                         // Get the GPU address of the transform in row-major format.
-                        desc.Triangles.Transform3x4 = getStaticMatricesBuffer()->getGpuAddress() + matrixID * 64ull;
+                        if (mUseCompactVertices) blasTransform = globalMatrices[matrixID];
+                        else desc.Triangles.Transform3x4 = getStaticMatricesBuffer()->getGpuAddress() + matrixID * 64ull;
                     }
                 }
 
+                if (mUseCompactVertices)
+                {
+                    glm::mat4 dequantize = glm::translate(glm::identity<glm::mat4>(), mesh.positionOffset) * glm::scale(glm::identity<glm::mat4>(), mesh.positionScale);
+                    glm::mat4 transposed = glm::transpose(blasTransform * dequantize);
+                    desc.Triangles.Transform3x4 = quantizationMatrices.size() * sizeof(float4);
+                    for (int row = 0; row < 3; row++) quantizationMatrices.push_back(transposed[row]);
+                }
+
                 // If this is an opaque mesh, set the opaque flag
                 const auto& material = mMaterials[mesh.materialID];
                 bool opaque = material->getAlphaMode() == AlphaModeOpaque;
@@ -1533,6 +1778,23 @@ namespace Falcor
             assert(!(isStatic && mHasSkinnedMesh));
         }
 
+        if (!quantizationMatrices.empty())
+        {
+            assert(mUseCompactVertices && !mHasSkinnedMesh);
+            mpBlasQuantizationMatrices = Buffer::createStructured(sizeof(float4), (uint32_t)quantizationMatrices.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, quantizationMatrices.data(), false);
+            mpBlasQuantizationMatrices->setName("Scene::mpBlasQuantizationMatrices");
+
+            // Transition the resource to non-pixel shader state as expected by DXR.
+            pContext->resourceBarrier(mpBlasQuantizationMatrices.get(), Resource::State::NonPixelShader);
+
+            // Patch the transform offsets into GPU addresses.
+            const uint64_t baseAddress = mpBlasQuantizationMatrices->getGpuAddress();
+            for (size_t i = 0; i < mMeshGroups.size(); i++)
+            {
+                for (auto& desc : mBlasData[i].geomDescs) desc.Triangles.Transform3x4 += baseAddress;
+            }
+        }
+
         if (mpRtAABBBuffer)
         {
             auto& blas = mBlasData.back();
@@ -1874,6 +2136,10 @@ namespace Falcor
 
             updateRaytracingBLASStats();
             mRebuildBlas = false;
+
+            // The BLAS buffers may have been reallocated, so the BLAS addresses in the cached instance descs are stale.
+            // Drop the TLAS cache so the descs are refilled and the TLAS is fully rebuilt on next use.
+            mTlasCache.clear();
         }
 
         // If we get here, all BLASes have previously been built and compacted. We will:
@@ -1926,9 +2192,10 @@ namespace Falcor
         }
     }
 
-    void Scene::fillInstanceDesc(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs, uint32_t rayCount, bool perMeshHitEntry) const
+    void Scene::fillInstanceDesc(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs, std::vector<uint32_t>& matrixIDs, uint32_t rayCount, bool perMeshHitEntry) const
     {
         instanceDescs.clear();
+        matrixIDs.clear();
         uint32_t instanceContributionToHitGroupIndex = 0;
         uint32_t instanceId = 0;
 
@@ -1969,15 +2236,17 @@ namespace Falcor
                 instanceId += (uint32_t)meshList.size();
 
                 glm::mat4 transform4x4 = glm::identity<glm::mat4>();
+                uint32_t matrixId = TlasInstanceList::kIdentityMatrix;
                 if (!isStatic)
                 {
                     // Dynamic meshes.
                     // Any instances of the mesh will get you the correct matrix, so just pick the first mesh then the first instance.
-                    uint32_t matrixId = mMeshInstanceData[desc.InstanceID].globalMatrixID;
+                    matrixId = mMeshInstanceData[desc.InstanceID].globalMatrixID;
                     transform4x4 = transpose(mpAnimationController->getGlobalMatrices()[matrixId]);
                 }
                 std::memcpy(desc.Transform, &transform4x4, sizeof(desc.Transform));
                 instanceDescs.push_back(desc);
+                matrixIDs.push_back(matrixId);
             }
             // If only one mesh is in the BLAS, there CAN be multiple instances of it. It is either:
             // - A non-instanced mesh that was unable to be merged with others, or
@@ -1996,6 +2265,7 @@ namespace Falcor
                     glm::mat4 transform4x4 = transpose(mpAnimationController->getGlobalMatrices()[matrixId]);
                     std::memcpy(desc.Transform, &transform4x4, sizeof(desc.Transform));
                     instanceDescs.push_back(desc);
+                    matrixIDs.push_back(matrixId);
                 }
             }
         }
@@ -2021,6 +2291,7 @@ namespace Falcor
             glm::mat4 identityMat = glm::identity<glm::mat4>();
             std::memcpy(desc.Transform, &identityMat, sizeof(desc.Transform));
             instanceDescs.push_back(desc);
+            matrixIDs.push_back(TlasInstanceList::kIdentityMatrix);
         }
     }
 
@@ -2028,28 +2299,30 @@ namespace Falcor
     {
         PROFILE("buildTlas");
 
-        TlasData tlas;
-        auto it = mTlasCache.find(rayCount);
-        if (it != mTlasCache.end()) tlas = it->second;
+        TlasData& tlas = mTlasCache[rayCount];
 
-        fillInstanceDesc(mInstanceDescs, rayCount, perMeshHitEntry);
+        // The instance descs are generated on the first build. Later builds patch the transforms of the instances that moved (see update()).
+        if (tlas.pTlas == nullptr)
+        {
+            std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
+            std::vector<uint32_t> matrixIDs;
+            fillInstanceDesc(instanceDescs, matrixIDs, rayCount, perMeshHitEntry);
+            tlas.instances.init(std::move(instanceDescs), std::move(matrixIDs));
+            tlas.updateMode = mTlasUpdateMode;
+        }
+        const auto& instanceDescs = tlas.instances.getDescs();
 
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
         inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
         inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-        inputs.NumDescs = (uint32_t)mInstanceDescs.size();
+        inputs.NumDescs = (uint32_t)instanceDescs.size();
         inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
 
-        // Add build flags for dynamic scenes if TLAS should be updating instead of rebuilt
-        if (mpAnimationController->hasAnimations() && mTlasUpdateMode == UpdateMode::Refit)
-        {
-            inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
-
-            // If TLAS has been built already and it was built with ALLOW_UPDATE
-            if (tlas.pTlas != nullptr && tlas.updateMode == UpdateMode::Refit) inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
-        }
-
-        tlas.updateMode = mTlasUpdateMode;
+        // Add build flags for dynamic scenes if TLAS should be updating instead of rebuilt.
+        // The instance topology never changes after the first build, so the TLAS is refit unless the instances moved too far since the last rebuild.
+        const bool allowRefit = mpAnimationController->hasAnimations() && tlas.updateMode == UpdateMode::Refit;
+        if (allowRefit) inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+        if (tlas.instances.beginBuild(allowRefit) == TlasInstanceList::BuildType::Refit) inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
 
         // On first build for the scene, create scratch buffer and cache prebuild info. As long as INSTANCE_DESC count doesn't change, we can reuse these
         if (mpTlasScratch == nullptr)
@@ -2074,18 +2347,22 @@ namespace Falcor
             assert(tlas.pInstanceDescs == nullptr); // Instance desc should also be null if no TLAS
             tlas.pTlas = Buffer::create(mTlasPrebuildInfo.ResultDataMaxSizeInBytes, Buffer::BindFlags::AccelerationStructure, Buffer::CpuAccess::None);
             tlas.pTlas->setName("Scene TLAS buffer");
-            tlas.pInstanceDescs = Buffer::create((uint32_t)mInstanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC), Buffer::BindFlags::None, Buffer::CpuAccess::Write, mInstanceDescs.data());
+            tlas.pInstanceDescs = Buffer::create((uint32_t)instanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC), Buffer::BindFlags::None, Buffer::CpuAccess::Write, instanceDescs.data());
             tlas.pInstanceDescs->setName("Scene instance descs buffer");
         }
-        // Else update instance descs and barrier TLAS buffers
+        // Else upload the patched instance descs and barrier TLAS buffers
         else
         {
-            assert(mpAnimationController->hasAnimations());
             pContext->uavBarrier(tlas.pTlas.get());
             pContext->uavBarrier(mpTlasScratch.get());
-            tlas.pInstanceDescs->setBlob(mInstanceDescs.data(), 0, inputs.NumDescs * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-            asDesc.SourceAccelerationStructureData = tlas.pTlas->getGpuAddress(); // Perform the update in-place
+            auto [dirtyBegin, dirtyEnd] = tlas.instances.getDirtyRange();
+            if (dirtyBegin < dirtyEnd)
+            {
+                const size_t descSize = sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+                tlas.pInstanceDescs->setBlob(instanceDescs.data() + dirtyBegin, dirtyBegin * descSize, (dirtyEnd - dirtyBegin) * descSize);
+            }
         }
+        tlas.instances.clearDirtyRange();
 
         assert((inputs.NumDescs != 0) && tlas.pInstanceDescs->getApiHandle() && tlas.pTlas->getApiHandle() && mpTlasScratch->getApiHandle());
 
@@ -2108,7 +2385,6 @@ namespace Falcor
             tlas.pSrv = ShaderResourceView::createViewForAccelerationStructure(tlas.pTlas);
         }
 
-        mTlasCache[rayCount] = tlas;
         updateRaytracingTLASStats();
     }
 
@@ -2185,7 +2461,7 @@ namespace Falcor
         // It really seems like a first-class notion of ray types (and the number thereof) is required.
         //
         auto tlasIt = mTlasCache.find(rayTypeCount);
-        if (tlasIt == mTlasCache.end())
+        if (tlasIt == mTlasCache.end() || tlasIt->second.instances.needsBuild())
         {
             // We need a hit entry per mesh right now to pass GeometryIndex()
             buildTlas(pContext, rayTypeCount, true);
@@ -2389,6 +2665,11 @@ namespace Falcor
         d["instancedVertexCount"] = instancedVertexCount;
         d["indexMemoryInBytes"] = indexMemoryInBytes;
         d["vertexMemoryInBytes"] = vertexMemoryInBytes;
+        d["vertexMemorySavedInBytes"] = vertexMemorySavedInBytes;
+        d["meshletCount"] = meshletCount;
+        d["meshletMemoryInBytes"] = meshletMemoryInBytes;
+        d["meshLODCount"] = meshLODCount;
+        d["lodIndexMemoryInBytes"] = lodIndexMemoryInBytes;
         d["geometryMemoryInBytes"] = geometryMemoryInBytes;
         d["animationMemoryInBytes"] = animationMemoryInBytes;
 
@@ -2439,6 +2720,23 @@ namespace Falcor
         d["gridVoxelCount"] = gridVoxelCount;
         d["gridMemoryInBytes"] = gridMemoryInBytes;
 
+        // Upload stats
+        d["bufferUploadCount"] = bufferUploadCount;
+        d["bufferUploadBytes"] = bufferUploadBytes;
+
+        // Sync stats
+        d["updateFlushCount"] = updateFlushCount;
+        d["updateSyncCount"] = updateSyncCount;
+        pybind11::dict syncCounts;
+        for (const auto& [subsystem, counts] : updateSyncCounts)
+        {
+            pybind11::dict c;
+            c["flushCount"] = counts.flushCount;
+            c["syncCount"] = counts.syncCount;
+            syncCounts[subsystem.c_str()] = c;
+        }
+        d["updateSyncCounts"] = syncCounts;
+
         return d;
     }
 
@@ -40,6 +40,9 @@
 #include "Experimental/Scene/Lights/EnvMap.h"
 #include "SceneTypes.slang"
 #include "HitInfo.h"
+#include "InstanceBVH.h"
+#include "ShadowBuffer.h"
+#include "TlasInstanceList.h"
 
 // Indicating the implementation of curve back-face culling is in anyhit shaders or intersection shaders.
 // Currently, the performance numbers on BabyCheetah scene with 20 indirect bounces are 77ms (with anyhit) and 73ms (without anyhit).
@@ -178,6 +181,16 @@ namespace Falcor
             SixDOF
         };
 
+        /** Simplified level of detail of a mesh. See SceneBuilder::Flags::GenerateLODs.
+            The LOD indices reference the vertices of the mesh and are stored in the global index buffer in the same format as the mesh indices.
+        */
+        struct MeshLOD
+        {
+            uint32_t ibOffset = 0;      ///< Offset into the index buffer in 32-bit words, as MeshDesc::ibOffset.
+            uint32_t indexCount = 0;    ///< Number of indices.
+            float error = 0.f;          ///< Estimated geometric error relative to the full detail mesh in object space units.
+        };
+
         /** Statistics.
         */
         struct SceneStats
@@ -189,6 +202,11 @@ namespace Falcor
             uint64_t instancedVertexCount = 0;          ///< Number of instanced vertices. This is the total number of vertices in the rendered triangles.
             uint64_t indexMemoryInBytes = 0;            ///< Total memory in bytes used by the index buffer.
             uint64_t vertexMemoryInBytes = 0;           ///< Total memory in bytes used by the vertex buffer.
+            uint64_t vertexMemorySavedInBytes = 0;      ///< Vertex buffer memory in bytes saved by the compact vertex format compared to the standard format.
+            uint64_t meshletCount = 0;                  ///< Number of meshlets.
+            uint64_t meshletMemoryInBytes = 0;          ///< Total memory in bytes used by the meshlet data.
+            uint64_t meshLODCount = 0;                  ///< Number of mesh LODs, not counting the full detail meshes.
+            uint64_t lodIndexMemoryInBytes = 0;         ///< Memory in bytes used by the mesh LOD indices. This is included in indexMemoryInBytes.
             uint64_t geometryMemoryInBytes = 0;         ///< Total memory in bytes used by the geometry data (meshes, curves, instances).
             uint64_t animationMemoryInBytes = 0;        ///< Total memory in bytes used by the animation system (transforms, skinning buffers).
 
@@ -239,6 +257,20 @@ namespace Falcor
             uint64_t gridVoxelCount = 0;            ///< Total number of voxels in all grids.
             uint64_t gridMemoryInBytes = 0;         ///< Total memory in bytes used by the grids.
 
+            // Upload stats
+            uint64_t bufferUploadCount = 0;         ///< Number of buffer uploads issued by the last scene update.
+            uint64_t bufferUploadBytes = 0;         ///< Number of bytes uploaded to scene buffers by the last scene update.
+
+            // Sync stats
+            struct SyncCounts
+            {
+                uint64_t flushCount = 0;            ///< Number of command list flushes.
+                uint64_t syncCount = 0;             ///< Number of flushes that blocked the CPU until the GPU finished.
+            };
+            uint64_t updateFlushCount = 0;          ///< Number of command list flushes triggered by the last scene update. Zero in steady-state frames.
+            uint64_t updateSyncCount = 0;           ///< Number of CPU/GPU syncs triggered by the last scene update. Zero in steady-state frames.
+            std::map<std::string, SyncCounts> updateSyncCounts; ///< Flushes and syncs of the last scene update per subsystem. Only subsystems that flushed are listed.
+
             /** Get the total memory usage.
             */
             uint64_t getTotalMemory() const
@@ -374,6 +406,28 @@ namespace Falcor
         */
         const MeshDesc& getMesh(uint32_t meshID) const { return mMeshDesc[meshID]; }
 
+        /** Get the number of meshlets. This is zero unless the scene was built with SceneBuilder::Flags::GenerateMeshlets.
+        */
+        uint32_t getMeshletCount() const { return (uint32_t)mMeshletDesc.size(); }
+
+        /** Get a meshlet desc. The meshlets of a mesh are found at MeshDesc::meshletOffset.
+        */
+        const MeshletDesc& getMeshlet(uint32_t meshletID) const { return mMeshletDesc[meshletID]; }
+
+        /** Get the number of simplified LODs of a mesh. This is zero unless the scene was built with SceneBuilder::Flags::GenerateLODs.
+        */
+        uint32_t getMeshLODCount(uint32_t meshID) const { return mMeshLODs.empty() ? 0 : (uint32_t)mMeshLODs[meshID].size(); }
+
+        /** Get a simplified LOD of a mesh. LOD 0 is the first simplified level, the full detail mesh is described by the MeshDesc.
+            The LOD is drawn as the mesh with the index buffer range replaced.
+        */
+        const MeshLOD& getMeshLOD(uint32_t meshID, uint32_t lod) const { return mMeshLODs[meshID][lod]; }
+
+        /** Check if the mesh vertices are stored in the compact format (see SceneBuilder::Flags::UseCompactVertices).
+            In that case the vertex buffer holds PackedCompactVertexData and positions are dequantized using the MeshDesc.
+        */
+        bool useCompactVertices() const { return mUseCompactVertices; }
+
         /** Get the number of mesh instances.
         */
         uint32_t getMeshInstanceCount() const { return (uint32_t)mMeshInstanceData.size(); }
@@ -467,9 +521,9 @@ namespace Falcor
         const EnvMap::SharedPtr& getEnvMap() const { return mpEnvMap; }
 
         /** Set how the scene's TLASes are updated when raytracing.
-            TLASes are REBUILT by default.
+            TLASes are REFIT by default, with a periodic rebuild when the instances have moved far from where they were at the last rebuild (see TlasInstanceList).
         */
-        void setTlasUpdateMode(UpdateMode mode) { mTlasUpdateMode = mode; }
+        void setTlasUpdateMode(UpdateMode mode);
 
         /** Get the scene's TLAS update mode when raytracing.
         */
@@ -499,6 +553,23 @@ namespace Falcor
         */
         void rasterize(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, RenderFlags flags = RenderFlags::None);
 
+        /** Cull the mesh instances against a set of views and create compacted draw lists of the visible instances of each view.
+            The views are culled together in a single traversal of a CPU bounding volume hierarchy over the instances, which is
+            refit when instances move. Instances of skinned meshes are never culled.
+            The draw lists are valid until the next call, and are rendered by rasterize() with a view index.
+            \param[in] views View frustums, see InstanceBVH::Frustum::fromViewProj(). At most InstanceBVH::kMaxViews views.
+        */
+        void cullMeshInstances(const std::vector<InstanceBVH::Frustum>& views);
+
+        /** Render the mesh instances that are visible in a view using the rasterizer.
+            \param[in] viewIndex Index of the view passed to the last call to cullMeshInstances().
+        */
+        void rasterize(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, uint32_t viewIndex, RenderFlags flags = RenderFlags::None);
+
+        /** Get the number of mesh instances that were visible in a view in the last call to cullMeshInstances().
+        */
+        uint32_t getVisibleMeshInstanceCount(uint32_t viewIndex) const { return viewIndex < mCulledViews.size() ? mCulledViews[viewIndex].visibleInstanceCount : 0; }
+
         /** Render the scene using raytracing.
         */
         void raytrace(RenderContext* pContext, RtProgram* pProgram, const std::shared_ptr<RtProgramVars>& pVars, uint3 dispatchDims);
@@ -630,9 +701,22 @@ namespace Falcor
         */
         void uploadResources();
 
-        /** Uploads a single material.
+        /** Uploads a single material. The material data is written to the CPU copy of the materials buffer, which is uploaded by uploadShadowBuffers().
+            \param[in] materialID Material ID.
+            \param[in] updateResources Set the material textures and sampler. These are not part of the material data.
+        */
+        void uploadMaterial(uint32_t materialID, bool updateResources = true);
+
+        /** Uploads the modified ranges of the CPU copies of the scene buffers (mesh instances, lights, volumes, materials).
+            Each buffer is uploaded with at most one call. The uploads are counted in the scene stats.
         */
-        void uploadMaterial(uint32_t materialID);
+        void uploadShadowBuffers();
+
+        /** Attribute the flushes and syncs recorded on the context since the previous call to a subsystem.
+            \param[in] pContext The context the scene update is recorded into.
+            \param[in] subsystem Name of the subsystem that was updated since the previous call.
+        */
+        void recordSyncCounts(RenderContext* pContext, const std::string& subsystem);
 
         /** Uploads the currently selected camera.
         */
@@ -646,6 +730,11 @@ namespace Falcor
         */
         void updateMeshInstances(bool forceUpdate);
 
+        /** Update the world-space bounds of the mesh instances and the instance BVH used for culling.
+            \param[in] forceUpdate Rebuild the BVH over all instances. Otherwise only moved instances are updated and the BVH is refit.
+        */
+        void updateMeshInstanceBounds(bool forceUpdate);
+
         /** Update procedural primitives.
         */
         void updateProceduralPrimitives(bool forceUpdate);
@@ -681,7 +770,11 @@ namespace Falcor
         /** Generate data for creating a TLAS.
             #SCENE TODO: Add argument to build descs based off a draw list.
         */
-        void fillInstanceDesc(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs, uint32_t rayCount, bool perMeshHitEntry) const;
+        void fillInstanceDesc(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs, std::vector<uint32_t>& matrixIDs, uint32_t rayCount, bool perMeshHitEntry) const;
+
+        /** Patch the instance descs of the cached TLASes for the instances whose transforms changed.
+        */
+        void updateTlasInstances();
 
         /** Generate top level acceleration structure for the scene. Automatically determines whether to build or refit.
             \param[in] rayCount Number of ray types in the shader. Required to setup how instances index into the Shader Table.
@@ -754,11 +847,34 @@ namespace Falcor
         Vao::SharedPtr mpVao16Bit;                                  ///< VAO for drawing meshes with 16-bit vertex indices.
         std::vector<DrawArgs> mDrawArgs;                            ///< List of draw arguments for rasterizing the scene.
 
+        static const uint32_t kInvalidDrawList = uint32_t(-1);
+
+        struct CulledView
+        {
+            std::vector<DrawArgs> drawArgs;                         ///< Draw arguments of the visible instances, one entry per list in mDrawArgs.
+            uint32_t visibleInstanceCount = 0;
+        };
+
+        InstanceBVH mInstanceBVH;                                   ///< Hierarchy over the mesh instance bounds for culling.
+        std::vector<AABB> mMeshInstanceBounds;                      ///< World-space bounds of each mesh instance. Invalid for instances of skinned meshes.
+        std::vector<uint32_t> mUncullableMeshInstances;             ///< Mesh instances that are never culled (skinned meshes).
+        std::vector<uint32_t> mMeshInstanceDrawList;                ///< Index of the draw list in mDrawArgs containing each mesh instance.
+        std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> mMeshInstanceIndexedDraws; ///< Draw arguments of each mesh instance, if the scene is indexed.
+        std::vector<D3D12_DRAW_ARGUMENTS> mMeshInstanceDraws;       ///< Draw arguments of each mesh instance, if the scene is non-indexed.
+        std::vector<CulledView> mCulledViews;                       ///< Draw lists created by the last call to cullMeshInstances().
+        std::vector<std::vector<uint32_t>> mVisibleMeshInstances;   ///< Visible instances per view, temporary storage for culling.
+
+        /** Issue the draws in a list of draw arguments.
+        */
+        void rasterizeDrawArgs(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, const std::vector<DrawArgs>& drawArgs, RenderFlags flags);
+
         Vao::SharedPtr mpCurveVao;                                  ///< Vertex array object for the global curve vertex/index buffers.
 
         std::vector<MeshDesc> mMeshDesc;                            ///< Copy of mesh data GPU buffer (mpMeshes).
+        std::vector<MeshletDesc> mMeshletDesc;                      ///< Copy of meshlet data GPU buffer (mpMeshletsBuffer).
+        std::vector<std::vector<MeshLOD>> mMeshLODs;                ///< Simplified LODs per mesh, indexed by mesh ID. Empty if no LODs were generated.
         std::vector<MeshInstanceData> mMeshInstanceData;            ///< Mesh instance data.
-        std::vector<PackedMeshInstanceData> mPackedMeshInstanceData;///< Copy of packed mesh instance data GPU buffer (mpMeshInstances).
+        ShadowBuffer<PackedMeshInstanceData> mPackedMeshInstanceData;///< Copy of packed mesh instance data GPU buffer (mpMeshInstancesBuffer).
         std::vector<ProceduralPrimitiveData> mProceduralPrimData;   ///< Procedural intersection AABB index data (offset, count) including all primitive types (custom primitives, curves, etc.).
         std::vector<AABB> mCustomPrimitiveAABBs;                    ///< User-defined custom primitive AABBs.
         std::vector<CurveDesc> mCurveDesc;                          ///< Copy of curve data GPU buffer (mpCurves).
@@ -776,6 +892,7 @@ namespace Falcor
 
         bool mHas16BitIndices = false;                              ///< True if any meshes use 16-bit indices.
         bool mHas32BitIndices = false;                              ///< True if any meshes use 32-bit indices.
+        bool mUseCompactVertices = false;                           ///< True if the vertex buffer uses the compact vertex format.
 
         // Materials
         std::vector<Material::SharedPtr> mMaterials;                ///< Bound to parameter block.
@@ -800,19 +917,27 @@ namespace Falcor
         AABB mSceneBB;                                              ///< Bounding boxes of the entire scene in world space.
         std::vector<bool> mMeshHasDynamicData;                      ///< Whether a Mesh has dynamic data, meaning it is skinned.
         SceneStats mSceneStats;                                     ///< Scene statistics.
+        SceneStats::SyncCounts mSyncCheckpoint;                     ///< Context flush/sync counts at the last call to recordSyncCounts().
         RenderSettings mRenderSettings;                             ///< Render settings.
         RenderSettings mPrevRenderSettings;
 
         // Scene Block Resources
         Buffer::SharedPtr mpMeshesBuffer;
         Buffer::SharedPtr mpMeshInstancesBuffer;
+        Buffer::SharedPtr mpMeshletsBuffer;
+        Buffer::SharedPtr mpMeshletVerticesBuffer;
+        Buffer::SharedPtr mpMeshletTrianglesBuffer;
         Buffer::SharedPtr mpProceduralPrimitivesBuffer;
         Buffer::SharedPtr mpCurvesBuffer;
         Buffer::SharedPtr mpCurveInstancesBuffer;
         Buffer::SharedPtr mpMaterialsBuffer;
         Buffer::SharedPtr mpLightsBuffer;
         Buffer::SharedPtr mpVolumesBuffer;
+        ShadowBuffer<MaterialData> mMaterialData;                   ///< Copy of material data GPU buffer (mpMaterialsBuffer).
+        ShadowBuffer<LightData> mLightData;                         ///< Copy of light data GPU buffer (mpLightsBuffer), in order of active lights.
+        ShadowBuffer<VolumeData> mVolumeData;                       ///< Copy of volume data GPU buffer (mpVolumesBuffer).
         ParameterBlock::SharedPtr mpSceneBlock;
+        ShaderVarHandle mMaterialResourcesHandle;                   ///< Pre-resolved handle to the material resources array in the scene block.
 
         // Camera
         CameraControllerType mCamCtrlType = CameraControllerType::FirstPerson;
@@ -841,17 +966,16 @@ namespace Falcor
         AnimationController::UniquePtr mpAnimationController;
 
         // Raytracing Data
-        UpdateMode mTlasUpdateMode = UpdateMode::Rebuild;   ///< How the TLAS should be updated when there are changes in the scene.
+        UpdateMode mTlasUpdateMode = UpdateMode::Refit;     ///< How the TLAS should be updated when there are changes in the scene.
         UpdateMode mBlasUpdateMode = UpdateMode::Refit;     ///< How the BLAS should be updated when there are changes to meshes.
 
-        std::vector<D3D12_RAYTRACING_INSTANCE_DESC> mInstanceDescs; ///< Shared between TLAS builds to avoid reallocating CPU memory.
-
         struct TlasData
         {
             Buffer::SharedPtr pTlas;
             ShaderResourceView::SharedPtr pSrv;             ///< Shader Resource View for binding the TLAS.
             Buffer::SharedPtr pInstanceDescs;               ///< Buffer holding instance descs for the TLAS.
             UpdateMode updateMode = UpdateMode::Rebuild;    ///< Update mode this TLAS was created with.
+            TlasInstanceList instances;                     ///< CPU copy of the instance descs, patched when instances move.
         };
 
         std::unordered_map<uint32_t, TlasData> mTlasCache;  ///< Top Level Acceleration Structure for scene data cached per shader ray count.
@@ -900,6 +1024,7 @@ namespace Falcor
         std::vector<BlasGroup> mBlasGroups;                 ///< BLAS group data.
         Buffer::SharedPtr mpBlasScratch;                    ///< Scratch buffer used for BLAS builds.
         Buffer::SharedPtr mpBlasStaticWorldMatrices;        ///< Object-to-world transform matrices in row-major format. Only valid for static meshes.
+        Buffer::SharedPtr mpBlasQuantizationMatrices;       ///< Per-geometry 3x4 row-major transforms dequantizing compact vertex positions. Only valid with compact vertices.
         bool mRebuildBlas = true;                           ///< Flag to indicate BLASes need to be rebuilt.
         bool mHasSkinnedMesh = false;                       ///< Whether the scene has a skinned mesh at all.
 
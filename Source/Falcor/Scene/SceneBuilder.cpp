@@ -27,6 +27,8 @@
  **************************************************************************/
 #include "stdafx.h"
 #include "SceneBuilder.h"
+#include "SceneCache.h"
+#include "MeshOptimizer.h"
 #include "Importer.h"
 #include "Utils/Math/MathConstants.slangh"
 #include "Utils/Timing/TimeReport.h"
@@ -45,6 +47,23 @@ namespace Falcor
         // We'll log a warning if the maximum quantization error exceeds this value.
         const float kMaxTexelError = 0.5f;
 
+        // Mesh LODs are generated by halving the triangle count of the mesh per level.
+        // The chain ends when the simplification stalls, e.g. at locked vertices, or the geometric error grows too large.
+        const uint32_t kMaxLODCount = 4;
+        const float kLODReductionFactor = 0.5f;
+        const float kLODMinReduction = 0.9f;            ///< Max ratio of index counts between consecutive LODs.
+        const uint32_t kLODMinTriangleCount = 32;       ///< Meshes with fewer triangles are not simplified further.
+        const float kLODMaxRelativeError = 0.05f;       ///< Max geometric error relative to the mesh bounding box diagonal.
+
+        /** Compute the dequantization transform for compact vertex positions.
+            Positions are quantized relative to the mesh bounding box: position = offset + scale * q, with q in [-1,1].
+        */
+        void computeCompactPositionTransform(const AABB& bounds, float3& offset, float3& scale)
+        {
+            offset = bounds.valid() ? bounds.center() : float3(0.f);
+            scale = bounds.valid() ? 0.5f * bounds.extent() : float3(0.f);
+        }
+
         int largestAxis(const float3& v)
         {
             if (v.x >= v.y && v.x >= v.z) return 0;
@@ -135,6 +154,134 @@ namespace Falcor
             return true;
         }
 
+        /** Hash table for merging vertices based on quantized attributes.
+            Vertices are merged if they have identical position, tangent sign and bone IDs, and all other
+            attributes fall into the same quantization cell of size 'threshold'. Any two merged vertices
+            therefore also compare equal with compareVertices(). Vertices within the threshold but in
+            neighboring cells are not merged, which is harmless as it only costs an extra vertex.
+            The table uses open addressing with linear probing and stores indices into the vertex list.
+        */
+        class VertexHashTable
+        {
+        public:
+            using Vertex = SceneBuilder::Mesh::Vertex;
+
+            VertexHashTable(std::vector<Vertex>& vertices, size_t expectedVertexCount, float threshold = 1e-6f)
+                : mVertices(vertices)
+                , mInvThreshold(1.f / threshold)
+            {
+                mTable.resize(std::max(size_t(16), nextPowerOfTwo(expectedVertexCount * 2)), kInvalidIndex);
+            }
+
+            /** Find a vertex in the list, or append it if no matching vertex exists.
+                \return Index of the vertex in the vertex list.
+            */
+            uint32_t findOrInsert(const Vertex& v)
+            {
+                size_t mask = mTable.size() - 1;
+                size_t slot = hashVertex(v) & mask;
+                while (mTable[slot] != kInvalidIndex)
+                {
+                    uint32_t index = mTable[slot];
+                    if (equalVertices(v, mVertices[index])) return index;
+                    slot = (slot + 1) & mask;
+                }
+
+                assert(mVertices.size() < std::numeric_limits<uint32_t>::max());
+                uint32_t index = (uint32_t)mVertices.size();
+                mVertices.push_back(v);
+                mTable[slot] = index;
+
+                // Keep the load factor below 0.5.
+                if (mVertices.size() * 2 > mTable.size()) rehash();
+                return index;
+            }
+
+        private:
+            static const uint32_t kInvalidIndex = 0xffffffff;
+            static const int64_t kMaxCell = 1ll << 62;
+
+            static size_t nextPowerOfTwo(size_t n)
+            {
+                size_t p = 1;
+                while (p < n) p <<= 1;
+                return p;
+            }
+
+            int64_t quantize(float x) const
+            {
+                // Non-finite values are all mapped to a single cell.
+                if (!std::isfinite(x)) return std::numeric_limits<int64_t>::min();
+
+                // Large values are not representable as cells. Floats of that magnitude are spaced much further apart than the
+                // threshold, so each value gets its own key instead, built from its bits and placed outside the range of the cells.
+                double cell = std::floor((double)x * mInvThreshold);
+                if (std::abs(cell) < (double)kMaxCell) return (int64_t)cell;
+                uint32_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                return x > 0.f ? kMaxCell + bits : -kMaxCell - bits;
+            }
+
+            template<typename T>
+            static uint64_t hashCombine(uint64_t hash, T value)
+            {
+                static_assert(sizeof(T) <= sizeof(uint64_t), "Value too large");
+                uint64_t bits = 0;
+                std::memcpy(&bits, &value, sizeof(T));
+                return (hash ^ bits) * 0x100000001b3ull;
+            }
+
+            uint64_t hashVertex(const Vertex& v) const
+            {
+                uint64_t hash = 0xcbf29ce484222325ull;
+                // Adding 0.f maps -0.f to +0.f, as they compare equal.
+                for (int i = 0; i < 3; i++) hash = hashCombine(hash, v.position[i] + 0.f);
+                for (int i = 0; i < 3; i++) hash = hashCombine(hash, quantize(v.normal[i]));
+                for (int i = 0; i < 3; i++) hash = hashCombine(hash, quantize(v.tangent[i]));
+                hash = hashCombine(hash, v.tangent.w + 0.f);
+                for (int i = 0; i < 2; i++) hash = hashCombine(hash, quantize(v.texCrd[i]));
+                for (int i = 0; i < 4; i++) hash = hashCombine(hash, v.boneIDs[i]);
+                for (int i = 0; i < 4; i++) hash = hashCombine(hash, quantize(v.boneWeights[i]));
+
+                // Final avalanche (MurmurHash3 fmix64) as the low bits are used to index the table.
+                hash ^= hash >> 33;
+                hash *= 0xff51afd7ed558ccdull;
+                hash ^= hash >> 33;
+                hash *= 0xc4ceb9fe1a85ec53ull;
+                hash ^= hash >> 33;
+                return hash;
+            }
+
+            bool equalVertices(const Vertex& lhs, const Vertex& rhs) const
+            {
+                if (lhs.position != rhs.position) return false; // Position need to be exact to avoid cracks
+                if (lhs.tangent.w != rhs.tangent.w) return false;
+                if (lhs.boneIDs != rhs.boneIDs) return false;
+                for (int i = 0; i < 3; i++) if (quantize(lhs.normal[i]) != quantize(rhs.normal[i])) return false;
+                for (int i = 0; i < 3; i++) if (quantize(lhs.tangent[i]) != quantize(rhs.tangent[i])) return false;
+                for (int i = 0; i < 2; i++) if (quantize(lhs.texCrd[i]) != quantize(rhs.texCrd[i])) return false;
+                for (int i = 0; i < 4; i++) if (quantize(lhs.boneWeights[i]) != quantize(rhs.boneWeights[i])) return false;
+                return true;
+            }
+
+            void rehash()
+            {
+                std::vector<uint32_t> table(mTable.size() * 2, kInvalidIndex);
+                size_t mask = table.size() - 1;
+                for (uint32_t index = 0; index < (uint32_t)mVertices.size(); index++)
+                {
+                    size_t slot = hashVertex(mVertices[index]) & mask;
+                    while (table[slot] != kInvalidIndex) slot = (slot + 1) & mask;
+                    table[slot] = index;
+                }
+                mTable = std::move(table);
+            }
+
+            std::vector<Vertex>& mVertices;
+            std::vector<uint32_t> mTable;
+            double mInvThreshold;
+        };
+
         std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
         {
             if (indices.empty()) return {};
@@ -159,55 +306,50 @@ namespace Falcor
 
     SceneBuilder::SharedPtr SceneBuilder::create(const std::string& filename, Flags buildFlags, const InstanceMatrices& instances)
     {
+        // Try loading the scene from the cache. Instanced imports are not cached.
+        SceneCache::Key cacheKey;
+        if (is_set(buildFlags, Flags::UseCache) && instances.empty() && SceneCache::computeKey(filename, buildFlags, cacheKey))
+        {
+            if (!is_set(buildFlags, Flags::RebuildCache))
+            {
+                auto pBuilder = create(buildFlags);
+                if (SceneCache::readCache(*pBuilder, cacheKey))
+                {
+                    pBuilder->mLoadedFromCache = true;
+                    return pBuilder;
+                }
+            }
+
+            auto pBuilder = create(buildFlags);
+            pBuilder->mCacheKey = cacheKey;
+            return pBuilder->import(filename, instances) ? pBuilder : nullptr;
+        }
+
         auto pBuilder = create(buildFlags);
         return pBuilder->import(filename, instances) ? pBuilder : nullptr;
     }
 
     bool SceneBuilder::import(const std::string& filename, const InstanceMatrices& instances, const Dictionary& dict)
     {
+        if (mSceneDataReady) throw std::runtime_error("SceneBuilder::import() - Can't import after the scene data has been prepared");
+
         bool success = Importer::import(filename, *this, instances, dict);
         mFilename = filename;
+
+        std::string fullPath;
+        if (findFileInDataDirectories(filename, fullPath)) mDependencies.push_back(fullPath);
+
         return success;
     }
 
-
     Scene::SharedPtr SceneBuilder::getScene()
     {
         if (mpScene) return mpScene;
 
-        // Finish loading textures. This blocks until all textures are loaded and assigned.
-        mpMaterialTextureLoader.reset();
-
-        // If no meshes were added, we create a dummy mesh to keep the scene generation working.
-        // Scenes with no meshes can be useful for example when using volumes in isolation.
-        if (mMeshes.empty())
-        {
-            logWarning("Scene contains no meshes. Creating a dummy mesh.");
-            // Add a dummy (degenerate) mesh.
-            auto dummyMesh = TriangleMesh::createDummy();
-            auto dummyMaterial = Material::create("Dummy");
-            auto meshID = addTriangleMesh(dummyMesh, dummyMaterial);
-            Node dummyNode = { "Dummy", glm::identity<glm::mat4>(), glm::identity<glm::mat4>() };
-            auto nodeID = addNode(dummyNode);
-            addMeshInstance(nodeID, meshID);
-        }
+        prepareSceneData();
 
-        // Post-process the scene data.
         TimeReport timeReport;
 
-        removeUnusedMeshes();
-        pretransformStaticMeshes();
-        calculateMeshBoundingBoxes();
-        createMeshGroups();
-        optimizeGeometry();
-        createGlobalBuffers();
-        createCurveGlobalBuffers();
-        removeDuplicateMaterials();
-        collectVolumeGrids();
-        quantizeTexCoords();
-
-        timeReport.measure("Post processing meshes");
-
         // Create the scene object and assign resources.
         mpScene = Scene::create();
         mpScene->mRenderSettings = mRenderSettings;
@@ -229,6 +371,8 @@ namespace Falcor
         uint32_t drawCount = createMeshData();
         createMeshVao(drawCount);
         createMeshBoundingBoxes();
+        createMeshletData();
+        timeReport.measure("Creating mesh resources");
 
         if (!mCurves.empty())
         {
@@ -236,6 +380,7 @@ namespace Falcor
             createCurveVao();
             calculateCurveBoundingBoxes();
             mapCurvesToProceduralPrimitives(Scene::kCurveIntersectionTypeID);
+            timeReport.measure("Creating curve resources");
         }
 
         createRaytracingAABBData();
@@ -245,12 +390,81 @@ namespace Falcor
         // Finalize the scene object. This is where the final setup is done.
         mpScene->finalize();
 
-        timeReport.measure("Creating resources");
+        timeReport.measure("Finalizing scene");
+        timeReport.addTotal("Scene creation total");
         timeReport.printToLog();
 
         return mpScene;
     }
 
+    void SceneBuilder::prepareSceneData()
+    {
+        if (mSceneDataReady) return;
+
+        // Finish loading textures. This blocks until all textures are loaded and assigned.
+        mpMaterialTextureLoader.reset();
+
+        // Scenes loaded from the cache are already post-processed.
+        if (mLoadedFromCache)
+        {
+            mSceneDataReady = true;
+            return;
+        }
+
+        // If no meshes were added, we create a dummy mesh to keep the scene generation working.
+        // Scenes with no meshes can be useful for example when using volumes in isolation.
+        if (mMeshes.empty())
+        {
+            logWarning("Scene contains no meshes. Creating a dummy mesh.");
+            // Add a dummy (degenerate) mesh.
+            auto dummyMesh = TriangleMesh::createDummy();
+            auto dummyMaterial = Material::create("Dummy");
+            auto meshID = addTriangleMesh(dummyMesh, dummyMaterial);
+            Node dummyNode = { "Dummy", glm::identity<glm::mat4>(), glm::identity<glm::mat4>() };
+            auto nodeID = addNode(dummyNode);
+            addMeshInstance(nodeID, meshID);
+        }
+
+        // Post-process the scene data.
+        TimeReport timeReport;
+
+        removeUnusedMeshes();
+        timeReport.measure("Removing unused meshes");
+        pretransformStaticMeshes();
+        timeReport.measure("Pre-transforming static meshes");
+        calculateMeshBoundingBoxes();
+        timeReport.measure("Calculating mesh bounding boxes");
+        createMeshGroups();
+        optimizeGeometry();
+        timeReport.measure("Creating mesh groups");
+        optimizeVertexCache();
+        timeReport.measure("Optimizing vertex cache");
+        generateMeshLODs();
+        timeReport.measure("Generating mesh LODs");
+        createMeshlets();
+        timeReport.measure("Creating meshlets");
+        createGlobalBuffers();
+        createCurveGlobalBuffers();
+        timeReport.measure("Creating global buffers");
+        removeDuplicateMaterials();
+        collectVolumeGrids();
+        quantizeTexCoords();
+        timeReport.measure("Processing materials");
+        createCompactVertexData();
+        timeReport.measure("Creating compact vertex data");
+
+        if (mCacheKey)
+        {
+            SceneCache::writeCache(*this, *mCacheKey);
+            timeReport.measure("Writing scene cache");
+        }
+
+        timeReport.addTotal("Post processing total");
+        timeReport.printToLog();
+
+        mSceneDataReady = true;
+    }
+
     // Meshes
 
     uint32_t SceneBuilder::addMesh(const Mesh& mesh)
@@ -380,53 +594,75 @@ namespace Falcor
         }
 
         // Build new vertex/index buffers by merging identical vertices.
-        // The search is based on the topology defined by the original index buffer.
-        //
-        // A linked-list of vertices is built for each original vertex index.
-        // We iterate over all vertices and first check if a vertex is identical to any of the other vertices
-        // using the same original vertex index. If not, a new vertex is inserted and added to the list.
-        // The 'heads' array point to the first vertex in each list, and each vertex has an associated next-pointer.
-        // This ensures that adding to the linked lists do not require any dynamic memory allocation.
-        //
-        const uint32_t invalidIndex = 0xffffffff;
-        std::vector<std::pair<Mesh::Vertex, uint32_t>> vertices;
+        std::vector<Mesh::Vertex> vertices;
         vertices.reserve(mesh.vertexCount);
         std::vector<uint32_t> indices(mesh.indexCount);
-        std::vector<uint32_t> heads(mesh.vertexCount, invalidIndex);
 
-        for (uint32_t face = 0; face < mesh.faceCount; face++)
+        if (is_set(mFlags, Flags::HashedVertexMerge))
+        {
+            // Identical vertices are found by a hash table lookup on the quantized vertex attributes.
+            // This is independent of the original index buffer and runs in constant time per vertex,
+            // regardless of how many different vertices share the same original vertex index.
+            VertexHashTable hashTable(vertices, mesh.vertexCount);
+
+            for (uint32_t face = 0; face < mesh.faceCount; face++)
+            {
+                for (uint32_t vert = 0; vert < 3; vert++)
+                {
+                    indices[face * 3 + vert] = hashTable.findOrInsert(mesh.getVertex(face, vert));
+                }
+            }
+        }
+        else
         {
-            for (uint32_t vert = 0; vert < 3; vert++)
+            // The search is based on the topology defined by the original index buffer.
+            //
+            // A linked-list of vertices is built for each original vertex index.
+            // We iterate over all vertices and first check if a vertex is identical to any of the other vertices
+            // using the same original vertex index. If not, a new vertex is inserted and added to the list.
+            // The 'heads' array point to the first vertex in each list, and each vertex has an associated next-pointer.
+            // This ensures that adding to the linked lists do not require any dynamic memory allocation.
+            //
+            const uint32_t invalidIndex = 0xffffffff;
+            std::vector<uint32_t> heads(mesh.vertexCount, invalidIndex);
+            std::vector<uint32_t> next;
+            next.reserve(mesh.vertexCount);
+
+            for (uint32_t face = 0; face < mesh.faceCount; face++)
             {
-                const Mesh::Vertex v = mesh.getVertex(face, vert);
-                const uint32_t origIndex = mesh.pIndices[face * 3 + vert];
+                for (uint32_t vert = 0; vert < 3; vert++)
+                {
+                    const Mesh::Vertex v = mesh.getVertex(face, vert);
+                    const uint32_t origIndex = mesh.pIndices[face * 3 + vert];
 
-                // Iterate over vertex list to check if it already exists.
-                assert(origIndex < heads.size());
-                uint32_t index = heads[origIndex];
-                bool found = false;
+                    // Iterate over vertex list to check if it already exists.
+                    assert(origIndex < heads.size());
+                    uint32_t index = heads[origIndex];
+                    bool found = false;
 
-                while (index != invalidIndex)
-                {
-                    if (compareVertices(v, vertices[index].first))
+                    while (index != invalidIndex)
                     {
-                        found = true;
-                        break;
+                        if (compareVertices(v, vertices[index]))
+                        {
+                            found = true;
+                            break;
+                        }
+                        index = next[index];
                     }
-                    index = vertices[index].second;
-                }
 
-                // Insert new vertex if we couldn't find it.
-                if (!found)
-                {
-                    assert(vertices.size() < std::numeric_limits<uint32_t>::max());
-                    index = (uint32_t)vertices.size();
-                    vertices.push_back({ v, heads[origIndex] });
-                    heads[origIndex] = index;
-                }
+                    // Insert new vertex if we couldn't find it.
+                    if (!found)
+                    {
+                        assert(vertices.size() < std::numeric_limits<uint32_t>::max());
+                        index = (uint32_t)vertices.size();
+                        vertices.push_back(v);
+                        next.push_back(heads[origIndex]);
+                        heads[origIndex] = index;
+                    }
 
-                // Store new vertex index.
-                indices[face * 3 + vert] = index;
+                    // Store new vertex index.
+                    indices[face * 3 + vert] = index;
+                }
             }
         }
 
@@ -442,7 +678,7 @@ namespace Falcor
         size_t zeroCount = 0;
         for (const auto& v : vertices)
         {
-            validateVertex(v.first, invalidCount, zeroCount);
+            validateVertex(v, invalidCount, zeroCount);
         }
         if (invalidCount > 0) logWarning("The mesh '" + mesh.name + "' has inf/nan vertex attributes at " + std::to_string(invalidCount) + " vertices. Please fix the asset.");
         if (zeroCount > 0) logWarning("The mesh '" + mesh.name + "' has zero-length normals/tangents at " + std::to_string(zeroCount) + " vertices. Please fix the asset.");
@@ -469,7 +705,7 @@ namespace Falcor
         {
             uint32_t index = isIndexed ? i : indices[i];
             assert(index < vertices.size());
-            const Mesh::Vertex& v = vertices[index].first;
+            const Mesh::Vertex& v = vertices[index];
 
             StaticVertexData s;
             s.position = v.position;
@@ -883,18 +1119,22 @@ namespace Falcor
         uint32_t identityNodeID = addNode(Node{ "Identity", glm::identity<glm::mat4>(), glm::identity<glm::mat4>() });
         auto& identityNode = mSceneGraph[identityNodeID];
 
-        size_t transformedMeshCount = 0;
-        for (uint32_t meshID = 0; meshID < (uint32_t)mMeshes.size(); meshID++)
-        {
+        // Transform the vertices of all static meshes to world space. This step runs in parallel over the meshes.
+        // It only reads the scene graph, which is not modified until all meshes have been processed.
+        std::vector<uint8_t> isPretransformed(mMeshes.size(), 0);
+        std::vector<uint8_t> isTransformed(mMeshes.size(), 0);
+
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshID) {
             auto& mesh = mMeshes[meshID];
 
             // Skip instanced/animated/skinned meshes.
             assert(!mesh.instances.empty());
             //if (mesh.instances.size() > 1 || isNodeAnimated(mesh.instances[0]) || mesh.hasDynamicData)
-                continue;
+                return;
 
             assert(mesh.dynamicData.empty() && mesh.dynamicVertexCount == 0);
             mesh.isStatic = true;
+            isPretransformed[meshID] = 1;
 
             // Compute the object->world transform for the node.
             auto nodeID = mesh.instances[0];
@@ -932,8 +1172,16 @@ namespace Falcor
                     // Leaving that out for now for consistency with the shader code that needs the same fix.
                 }
 
-                transformedMeshCount++;
+                isTransformed[meshID] = 1;
             }
+        }, 1);
+
+        // Relink the pre-transformed meshes to the identity node. This is done serially in mesh order
+        // so that the resulting scene graph is deterministic.
+        for (uint32_t meshID = 0; meshID < (uint32_t)mMeshes.size(); meshID++)
+        {
+            if (!isPretransformed[meshID]) continue;
+            auto& mesh = mMeshes[meshID];
 
             // Unlink mesh from its previous transform node.
             // TODO: This will leave some nodes unused. We could run a separate pass to compact the node list.
@@ -948,13 +1196,14 @@ namespace Falcor
             mesh.instances[0] = identityNodeID;
         }
 
+        size_t transformedMeshCount = std::count(isTransformed.begin(), isTransformed.end(), 1);
         logDebug("Pre-transformed " + std::to_string(transformedMeshCount) + " static meshes to world space");
     }
 
     void SceneBuilder::calculateMeshBoundingBoxes()
     {
-        for (auto& mesh : mMeshes)
-        {
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            auto& mesh = mMeshes[meshIndex];
             assert(!mesh.staticData.empty());
             assert((size_t)mesh.vertexCount == mesh.staticData.size());
 
@@ -965,7 +1214,7 @@ namespace Falcor
             }
 
             mesh.boundingBox = meshBB;
-        }
+        }, 1);
     }
 
     void SceneBuilder::createMeshGroups()
@@ -1394,6 +1643,222 @@ namespace Falcor
         mMeshGroups = std::move(optimizedGroups);
     }
 
+    void SceneBuilder::optimizeVertexCache()
+    {
+        if (!is_set(mFlags, Flags::OptimizeVertexCache)) return;
+
+        // The meshes are processed in parallel. The cache statistics are collected per mesh and logged afterwards in mesh order.
+        std::vector<MeshOptimizer::VertexCacheStats> statsBefore(mMeshes.size());
+        std::vector<MeshOptimizer::VertexCacheStats> statsAfter(mMeshes.size());
+        std::vector<uint8_t> optimized(mMeshes.size(), 0); // Not vector<bool>, which packs bits and can't be written concurrently.
+
+        // Meshes vary a lot in size, so they are distributed one at a time.
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            auto& mesh = mMeshes[meshIndex];
+            if (mesh.topology != Vao::Topology::TriangleList || mesh.indexCount == 0) return;
+            assert(mesh.staticData.size() == mesh.vertexCount);
+
+            std::vector<uint32_t> indices(mesh.indexCount);
+            for (uint32_t i = 0; i < mesh.indexCount; i++) indices[i] = mesh.getIndex(i);
+
+            statsBefore[meshIndex] = MeshOptimizer::analyzeVertexCache(indices, mesh.vertexCount);
+
+            // Reorder the triangles for the vertex cache and overdraw, then the vertices in order of first use.
+            std::vector<float3> positions(mesh.vertexCount);
+            for (uint32_t i = 0; i < mesh.vertexCount; i++) positions[i] = mesh.staticData[i].position;
+
+            indices = MeshOptimizer::optimizeVertexCache(indices, mesh.vertexCount);
+            indices = MeshOptimizer::optimizeOverdraw(indices, positions.data(), mesh.vertexCount);
+            auto remap = MeshOptimizer::optimizeVertexFetch(indices, mesh.vertexCount);
+
+            MeshOptimizer::remapVertices(mesh.staticData, remap);
+            if (!mesh.dynamicData.empty())
+            {
+                // The dynamic vertices map 1:1 to the static vertices and reference them by local index.
+                MeshOptimizer::remapVertices(mesh.dynamicData, remap);
+                for (uint32_t i = 0; i < (uint32_t)mesh.dynamicData.size(); i++) mesh.dynamicData[i].staticIndex = i;
+            }
+
+            statsAfter[meshIndex] = MeshOptimizer::analyzeVertexCache(indices, mesh.vertexCount);
+            mesh.indexData = mesh.use16BitIndices ? compact16BitIndices(indices) : std::move(indices);
+            optimized[meshIndex] = 1;
+        }, 1);
+
+        std::ostringstream oss;
+        oss << "Optimized vertex cache (simulated FIFO size " << MeshOptimizer::kDefaultCacheSize << "):" << std::endl;
+        uint64_t totalTriangles = 0, transformedBefore = 0, transformedAfter = 0;
+        for (size_t meshIndex = 0; meshIndex < mMeshes.size(); meshIndex++)
+        {
+            if (!optimized[meshIndex]) continue;
+            const auto& before = statsBefore[meshIndex];
+            const auto& after = statsAfter[meshIndex];
+            oss << "  Mesh '" << mMeshes[meshIndex].name << "': ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+
+            totalTriangles += mMeshes[meshIndex].getTriangleCount();
+            transformedBefore += before.transformedVertexCount;
+            transformedAfter += after.transformedVertexCount;
+        }
+        if (totalTriangles > 0)
+        {
+            oss << "  Total: ACMR " << (double)transformedBefore / totalTriangles << " -> " << (double)transformedAfter / totalTriangles;
+            logInfo(oss.str());
+        }
+    }
+
+    void SceneBuilder::generateMeshLODs()
+    {
+        if (!is_set(mFlags, Flags::GenerateLODs)) return;
+
+        // The meshes are simplified in parallel, one at a time as they vary a lot in size.
+        // Each LOD is simplified from the full detail mesh, so the errors are relative to it.
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            auto& mesh = mMeshes[meshIndex];
+            assert(mesh.lods.empty() && mesh.lodIndexData.empty());
+            if (mesh.topology != Vao::Topology::TriangleList || mesh.indexCount == 0) return;
+            if (mesh.getTriangleCount() < kLODMinTriangleCount) return;
+            assert(mesh.staticData.size() == mesh.vertexCount);
+
+            std::vector<uint32_t> indices(mesh.indexCount);
+            for (uint32_t i = 0; i < mesh.indexCount; i++) indices[i] = mesh.getIndex(i);
+
+            std::vector<float3> positions(mesh.vertexCount);
+            for (uint32_t i = 0; i < mesh.vertexCount; i++) positions[i] = mesh.staticData[i].position;
+
+            const float maxError = kLODMaxRelativeError * glm::length(mesh.boundingBox.extent());
+            size_t prevIndexCount = indices.size();
+
+            for (uint32_t lod = 1; lod <= kMaxLODCount; lod++)
+            {
+                const size_t targetIndexCount = (size_t)(indices.size() * std::pow(kLODReductionFactor, (float)lod)) / 3 * 3;
+                if (targetIndexCount < kLODMinTriangleCount * 3) break;
+
+                auto result = MeshOptimizer::simplify(indices, positions.data(), mesh.vertexCount, targetIndexCount, maxError);
+                if (result.indices.empty() || result.indices.size() > prevIndexCount * kLODMinReduction) break;
+                prevIndexCount = result.indices.size();
+
+                result.indices = MeshOptimizer::optimizeVertexCache(result.indices, mesh.vertexCount);
+
+                Scene::MeshLOD meshLOD;
+                meshLOD.indexCount = (uint32_t)result.indices.size();
+                meshLOD.error = result.error;
+                mesh.lods.push_back(meshLOD);
+                mesh.lodIndexData.push_back(mesh.use16BitIndices ? compact16BitIndices(result.indices) : std::move(result.indices));
+            }
+        }, 1);
+
+        std::ostringstream oss;
+        oss << "Generated mesh LODs:" << std::endl;
+        size_t lodCount = 0;
+        for (const auto& mesh : mMeshes)
+        {
+            if (mesh.lods.empty()) continue;
+            oss << "  Mesh '" << mesh.name << "': " << mesh.getTriangleCount() << " triangles";
+            for (const auto& lod : mesh.lods) oss << " -> " << lod.indexCount / 3 << " (error " << lod.error << ")";
+            oss << std::endl;
+            lodCount += mesh.lods.size();
+        }
+        if (lodCount > 0) logInfo(oss.str());
+    }
+
+    void SceneBuilder::createMeshlets()
+    {
+        if (!is_set(mFlags, Flags::GenerateMeshlets)) return;
+
+        assert(mBuffersData.meshlets.empty());
+        assert(mBuffersData.meshletVertices.empty());
+        assert(mBuffersData.meshletTriangles.empty());
+
+        // Partition the meshes in parallel. The meshlets reference mesh-local vertex indices,
+        // so they are independent of the global buffer layout.
+        std::vector<MeshOptimizer::MeshletList> meshMeshlets(mMeshes.size());
+        std::vector<std::vector<MeshOptimizer::MeshletBounds>> meshBounds(mMeshes.size());
+
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            const auto& mesh = mMeshes[meshIndex];
+            if (mesh.topology != Vao::Topology::TriangleList) return;
+            assert(mesh.staticData.size() == mesh.vertexCount);
+
+            std::vector<uint32_t> indices(mesh.indexCount > 0 ? mesh.indexCount : mesh.vertexCount);
+            if (mesh.indexCount > 0)
+            {
+                for (uint32_t i = 0; i < mesh.indexCount; i++) indices[i] = mesh.getIndex(i);
+            }
+            else
+            {
+                std::iota(indices.begin(), indices.end(), 0);
+            }
+
+            std::vector<float3> positions(mesh.vertexCount);
+            for (uint32_t i = 0; i < mesh.vertexCount; i++) positions[i] = mesh.staticData[i].position;
+
+            auto& meshlets = meshMeshlets[meshIndex];
+            meshlets = MeshOptimizer::buildMeshlets(indices, mesh.vertexCount, MeshletDesc::kMaxVertices, MeshletDesc::kMaxTriangles);
+
+            auto& bounds = meshBounds[meshIndex];
+            bounds.reserve(meshlets.meshlets.size());
+            for (const auto& meshlet : meshlets.meshlets) bounds.push_back(MeshOptimizer::computeMeshletBounds(meshlets, meshlet, positions.data()));
+        }, 1);
+
+        // Concatenate the meshlets into the global arrays in mesh order, so the layout is deterministic.
+        size_t totalMeshletCount = 0;
+        size_t totalVertexCount = 0;
+        size_t totalTriangleCount = 0;
+        for (size_t meshIndex = 0; meshIndex < mMeshes.size(); meshIndex++)
+        {
+            totalMeshletCount += meshMeshlets[meshIndex].meshlets.size();
+            totalVertexCount += meshMeshlets[meshIndex].vertices.size();
+            totalTriangleCount += meshMeshlets[meshIndex].triangles.size();
+        }
+
+        if (totalVertexCount > std::numeric_limits<uint32_t>::max() || totalTriangleCount > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::exception("Trying to build a scene that exceeds supported meshlet data size.");
+        }
+
+        mBuffersData.meshlets.reserve(totalMeshletCount);
+        mBuffersData.meshletVertices.reserve(totalVertexCount);
+        mBuffersData.meshletTriangles.reserve(totalTriangleCount);
+
+        for (size_t meshIndex = 0; meshIndex < mMeshes.size(); meshIndex++)
+        {
+            auto& mesh = mMeshes[meshIndex];
+            const auto& meshlets = meshMeshlets[meshIndex];
+            const uint32_t vertexOffset = (uint32_t)mBuffersData.meshletVertices.size();
+            const uint32_t triangleOffset = (uint32_t)mBuffersData.meshletTriangles.size();
+
+            mesh.meshletOffset = (uint32_t)mBuffersData.meshlets.size();
+            mesh.meshletCount = (uint32_t)meshlets.meshlets.size();
+
+            for (size_t i = 0; i < meshlets.meshlets.size(); i++)
+            {
+                const auto& meshlet = meshlets.meshlets[i];
+                const auto& bounds = meshBounds[meshIndex][i];
+
+                MeshletDesc desc;
+                desc.meshID = (uint32_t)meshIndex;
+                desc.vertexOffset = vertexOffset + meshlet.vertexOffset;
+                desc.triangleOffset = triangleOffset + meshlet.triangleOffset;
+                desc.counts = meshlet.vertexCount | (meshlet.triangleCount << 16);
+                desc.center = bounds.center;
+                desc.radius = bounds.radius;
+                desc.coneAxis = bounds.coneAxis;
+                desc.coneCutoff = bounds.coneCutoff;
+                mBuffersData.meshlets.push_back(desc);
+            }
+
+            mBuffersData.meshletVertices.insert(mBuffersData.meshletVertices.end(), meshlets.vertices.begin(), meshlets.vertices.end());
+            mBuffersData.meshletTriangles.insert(mBuffersData.meshletTriangles.end(), meshlets.triangles.begin(), meshlets.triangles.end());
+        }
+
+        if (!mBuffersData.meshlets.empty())
+        {
+            std::ostringstream oss;
+            oss << "Created " << mBuffersData.meshlets.size() << " meshlets with on average " << (double)totalVertexCount / totalMeshletCount
+                << " vertices and " << (double)totalTriangleCount / totalMeshletCount << " triangles.";
+            logInfo(oss.str());
+        }
+    }
+
     void SceneBuilder::createGlobalBuffers()
     {
         assert(mBuffersData.indexData.empty());
@@ -1402,18 +1867,35 @@ namespace Falcor
 
         const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
 
-        // Count total number of vertex and index data elements.
+        // Count total number of vertex and index data elements and assign the offsets of each mesh.
+        // The offsets are assigned in mesh order, so the layout of the global buffers is deterministic.
         size_t totalIndexDataCount = 0;
         size_t totalStaticVertexCount = 0;
         size_t totalDynamicVertexCount = 0;
 
-        for (const auto& mesh : mMeshes)
+        for (auto& mesh : mMeshes)
         {
-            totalIndexDataCount += mesh.indexData.size();
+            mesh.staticVertexOffset = (uint32_t)totalStaticVertexCount;
+            mesh.dynamicVertexOffset = (uint32_t)totalDynamicVertexCount;
+            if (isIndexed) mesh.indexOffset = (uint32_t)totalIndexDataCount;
+
+            totalIndexDataCount += isIndexed ? mesh.indexData.size() : 0;
             totalStaticVertexCount += mesh.staticData.size();
             totalDynamicVertexCount += mesh.dynamicData.size();
         }
 
+        // The LOD indices are placed after the indices of all meshes, so the base mesh layout is the same with and without LODs.
+        for (auto& mesh : mMeshes)
+        {
+            assert(mesh.lods.size() == mesh.lodIndexData.size());
+            if (!isIndexed) continue;
+            for (size_t i = 0; i < mesh.lods.size(); i++)
+            {
+                mesh.lods[i].ibOffset = (uint32_t)totalIndexDataCount;
+                totalIndexDataCount += mesh.lodIndexData[i].size();
+            }
+        }
+
         // Check the range. We currently use 32-bit offsets.
         if (totalIndexDataCount > std::numeric_limits<uint32_t>::max() ||
             totalStaticVertexCount > std::numeric_limits<uint32_t>::max() ||
@@ -1422,29 +1904,30 @@ namespace Falcor
             throw std::exception("Trying to build a scene that exceeds supported mesh data size.");
         }
 
-        mBuffersData.indexData.reserve(totalIndexDataCount);
-        mBuffersData.staticData.reserve(totalStaticVertexCount);
-        mBuffersData.dynamicData.reserve(totalDynamicVertexCount);
-
-        // Copy all vertex and index data into the global buffers.
-        for (auto& mesh : mMeshes)
-        {
-            mesh.staticVertexOffset = (uint32_t)mBuffersData.staticData.size();
-            mesh.dynamicVertexOffset = (uint32_t)mBuffersData.dynamicData.size();
+        mBuffersData.indexData.resize(totalIndexDataCount);
+        mBuffersData.staticData.resize(totalStaticVertexCount);
+        mBuffersData.dynamicData.resize(totalDynamicVertexCount);
 
-            // Insert the static vertex data in the global array.
+        // Copy all vertex and index data into the global buffers. Each mesh writes to its own range, so this runs in parallel.
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            auto& mesh = mMeshes[meshIndex];
+            // Copy the static vertex data to the global array.
             // The vertices are automatically converted to their packed format in this step.
-            mBuffersData.staticData.insert(mBuffersData.staticData.end(), mesh.staticData.begin(), mesh.staticData.end());
+            std::copy(mesh.staticData.begin(), mesh.staticData.end(), mBuffersData.staticData.begin() + mesh.staticVertexOffset);
 
             if (isIndexed)
             {
-                mesh.indexOffset = (uint32_t)mBuffersData.indexData.size();
-                mBuffersData.indexData.insert(mBuffersData.indexData.end(), mesh.indexData.begin(), mesh.indexData.end());
+                std::copy(mesh.indexData.begin(), mesh.indexData.end(), mBuffersData.indexData.begin() + mesh.indexOffset);
+
+                for (size_t i = 0; i < mesh.lods.size(); i++)
+                {
+                    std::copy(mesh.lodIndexData[i].begin(), mesh.lodIndexData[i].end(), mBuffersData.indexData.begin() + mesh.lods[i].ibOffset);
+                }
             }
 
             if (!mesh.dynamicData.empty())
             {
-                mBuffersData.dynamicData.insert(mBuffersData.dynamicData.end(), mesh.dynamicData.begin(), mesh.dynamicData.end());
+                std::copy(mesh.dynamicData.begin(), mesh.dynamicData.end(), mBuffersData.dynamicData.begin() + mesh.dynamicVertexOffset);
 
                 // Patch vertex index references.
                 for (uint32_t i = 0; i < mesh.dynamicData.size(); ++i)
@@ -1454,10 +1937,11 @@ namespace Falcor
             }
 
             // Free the mesh local data.
-            mesh.indexData.clear();
-            mesh.staticData.clear();
-            mesh.dynamicData.clear();
-        }
+            mesh.indexData = {};
+            mesh.lodIndexData = {};
+            mesh.staticData = {};
+            mesh.dynamicData = {};
+        }, 1);
     }
 
     void SceneBuilder::createCurveGlobalBuffers()
@@ -1556,8 +2040,11 @@ namespace Falcor
         // Match texture coordinate quantization for textured emissives to format of PackedEmissiveTriangle.
         // This is to avoid mismatch when sampling and evaluating emissive triangles.
         // Note that non-emissive meshes are unmodified and use full precision texcoords.
-        for (auto& mesh : mMeshes)
-        {
+        // The meshes are processed in parallel. Warnings are collected per mesh and logged afterwards in mesh order.
+        std::vector<std::string> warnings(mMeshes.size());
+
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            const auto& mesh = mMeshes[meshIndex];
             const auto& pMaterial = mMaterials[mesh.materialId];
             if (pMaterial->getEmissiveTexture() != nullptr)
             {
@@ -1580,7 +2067,7 @@ namespace Falcor
                 float2 maxAbsCrd = max(abs(minTexCrd), abs(maxTexCrd));
                 if (maxAbsCrd.x > HLF_MAX || maxAbsCrd.y > HLF_MAX)
                 {
-                    logWarning("Texture coordinates for emissive textured mesh '" + mesh.name + "' are outside the representable range, expect rendering errors.");
+                    warnings[meshIndex] = "Texture coordinates for emissive textured mesh '" + mesh.name + "' are outside the representable range, expect rendering errors.";
                 }
                 else
                 {
@@ -1596,13 +2083,99 @@ namespace Falcor
                         oss << "Texture coordinates for emissive textured mesh '" << mesh.name << "' have a large quantization error of " << maxTexelError << " texels. "
                             << "The coordinate range is [" << minTexCrd.x << ", " << maxTexCrd.x << "] x [" << minTexCrd.y << ", " << maxTexCrd.y << "] for maximum texture dimensions ("
                             << maxTexDim.x << ", " << maxTexDim.y << ").";
-                        logWarning(oss.str());
+                        warnings[meshIndex] = oss.str();
                     }
                 }
             }
+        }, 1);
+
+        for (const auto& warning : warnings)
+        {
+            if (!warning.empty()) logWarning(warning);
         }
     }
 
+    void SceneBuilder::createCompactVertexData()
+    {
+        if (!is_set(mFlags, Flags::UseCompactVertices)) return;
+
+        // Skinning operates on the standard vertex format, so we keep it for scenes with skinned meshes.
+        if (!mBuffersData.dynamicData.empty())
+        {
+            logWarning("Scene has skinned meshes. Ignoring the compact vertex format flag.");
+            return;
+        }
+
+        assert(mBuffersData.compactData.empty());
+        mBuffersData.compactData.resize(mBuffersData.staticData.size());
+
+        // Encode the vertices of each mesh relative to its bounding box. The meshes are processed in parallel.
+        // Warnings are collected per mesh and logged afterwards in mesh order.
+        std::vector<std::string> warnings(mMeshes.size());
+        std::vector<float> maxPositionErrors(mMeshes.size(), 0.f);
+
+        Threading::parallelFor(0, (uint32_t)mMeshes.size(), [&](uint32_t meshIndex) {
+            const auto& mesh = mMeshes[meshIndex];
+            float3 positionOffset, positionScale;
+            computeCompactPositionTransform(mesh.boundingBox, positionOffset, positionScale);
+
+            float maxPositionError = 0.f;
+            float2 maxAbsTexCrd = float2(0);
+            float2 maxTexCrdError = float2(0);
+
+            for (uint32_t i = 0; i < mesh.staticVertexCount; ++i)
+            {
+                const uint32_t index = mesh.staticVertexOffset + i;
+                const StaticVertexData v = mBuffersData.staticData[index].unpack();
+                auto& c = mBuffersData.compactData[index];
+                c.pack(v, positionOffset, positionScale);
+
+                float3 positionError = abs(c.unpackPosition(positionOffset, positionScale) - v.position);
+                maxPositionError = std::max({ maxPositionError, positionError.x, positionError.y, positionError.z });
+                maxAbsTexCrd = max(maxAbsTexCrd, abs(v.texCrd));
+                maxTexCrdError = max(maxTexCrdError, abs(glm::unpackHalf2x16(c.packedTexCrd) - v.texCrd));
+            }
+            maxPositionErrors[meshIndex] = maxPositionError;
+
+            // Issue warning if texture coordinate quantization errors are too large.
+            if (maxAbsTexCrd.x > HLF_MAX || maxAbsTexCrd.y > HLF_MAX)
+            {
+                warnings[meshIndex] = "Texture coordinates for mesh '" + mesh.name + "' are outside the range representable by the compact vertex format, expect rendering errors.";
+            }
+            else
+            {
+                uint2 maxTexDim = mMaterials[mesh.materialId]->getMaxTextureDimensions();
+                float2 texelError = maxTexCrdError * float2(maxTexDim);
+                float maxTexelError = std::max(texelError.x, texelError.y);
+
+                if (maxTexelError > kMaxTexelError)
+                {
+                    std::ostringstream oss;
+                    oss << "Texture coordinates for mesh '" << mesh.name << "' have a large quantization error of " << maxTexelError << " texels in the compact vertex format.";
+                    warnings[meshIndex] = oss.str();
+                }
+            }
+        }, 1);
+
+        for (const auto& warning : warnings)
+        {
+            if (!warning.empty()) logWarning(warning);
+        }
+
+        const size_t vertexCount = mBuffersData.compactData.size();
+        const size_t standardSize = vertexCount * sizeof(PackedStaticVertexData);
+        const size_t compactSize = vertexCount * sizeof(PackedCompactVertexData);
+        const float maxPositionError = maxPositionErrors.empty() ? 0.f : *std::max_element(maxPositionErrors.begin(), maxPositionErrors.end());
+
+        std::ostringstream oss;
+        oss << "Using compact vertex format. Vertex data reduced from " << formatByteSize(standardSize) << " to " << formatByteSize(compactSize)
+            << " (saved " << formatByteSize(standardSize - compactSize) << "). Max position quantization error is " << maxPositionError << ".";
+        logInfo(oss.str());
+
+        // Release the standard format vertex data. The compact data replaces it from here on.
+        mBuffersData.staticData = {};
+    }
+
     void SceneBuilder::createMeshVao(uint32_t drawCount)
     {
         for (auto& mesh : mMeshes) assert(mesh.topology == mMeshes[0].topology);
@@ -1622,15 +2195,20 @@ namespace Falcor
         }
 
         // Create the vertex data structured buffer.
-        const size_t vertexCount = (uint32_t)mBuffersData.staticData.size();
-        size_t staticVbSize = sizeof(PackedStaticVertexData) * vertexCount;
+        // The standard vertex data is uploaded by the animation controller, the compact vertex data is uploaded here.
+        const bool useCompactVertices = !mBuffersData.compactData.empty();
+        const size_t vertexCount = useCompactVertices ? mBuffersData.compactData.size() : mBuffersData.staticData.size();
+        const uint32_t vertexStride = useCompactVertices ? sizeof(PackedCompactVertexData) : sizeof(PackedStaticVertexData);
+        size_t staticVbSize = vertexStride * vertexCount;
         if (staticVbSize > std::numeric_limits<uint32_t>::max())
         {
             throw std::exception("Vertex buffer size exceeds 4GB");
         }
 
         ResourceBindFlags vbBindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess | ResourceBindFlags::Vertex;
-        Buffer::SharedPtr pStaticBuffer = Buffer::createStructured(sizeof(PackedStaticVertexData), (uint32_t)vertexCount, vbBindFlags, Buffer::CpuAccess::None, nullptr, false);
+        const void* pInitData = useCompactVertices ? mBuffersData.compactData.data() : nullptr;
+        Buffer::SharedPtr pStaticBuffer = Buffer::createStructured(vertexStride, (uint32_t)vertexCount, vbBindFlags, Buffer::CpuAccess::None, pInitData, false);
+        mpScene->mUseCompactVertices = useCompactVertices;
 
         Vao::BufferVec pVBs(Scene::kVertexBufferCount);
         pVBs[Scene::kStaticDataBufferIndex] = pStaticBuffer;
@@ -1663,10 +2241,20 @@ namespace Falcor
         VertexLayout::SharedPtr pLayout = VertexLayout::create();
 
         // Add the packed static vertex data layout.
+        // The position element must be first as its format is used for the BLAS builds.
         VertexBufferLayout::SharedPtr pStaticLayout = VertexBufferLayout::create();
-        pStaticLayout->addElement(VERTEX_POSITION_NAME, offsetof(PackedStaticVertexData, position), ResourceFormat::RGB32Float, 1, VERTEX_POSITION_LOC);
-        pStaticLayout->addElement(VERTEX_PACKED_NORMAL_TANGENT_NAME, offsetof(PackedStaticVertexData, packedNormalTangent), ResourceFormat::RGB32Float, 1, VERTEX_PACKED_NORMAL_TANGENT_LOC);
-        pStaticLayout->addElement(VERTEX_TEXCOORD_NAME, offsetof(PackedStaticVertexData, texCrd), ResourceFormat::RG32Float, 1, VERTEX_TEXCOORD_LOC);
+        if (useCompactVertices)
+        {
+            pStaticLayout->addElement(VERTEX_POSITION_NAME, offsetof(PackedCompactVertexData, packedPositionXY), ResourceFormat::RGBA16Snorm, 1, VERTEX_POSITION_LOC);
+            pStaticLayout->addElement(VERTEX_PACKED_NORMAL_TANGENT_NAME, offsetof(PackedCompactVertexData, packedNormal), ResourceFormat::RG32Uint, 1, VERTEX_PACKED_NORMAL_TANGENT_LOC);
+            pStaticLayout->addElement(VERTEX_TEXCOORD_NAME, offsetof(PackedCompactVertexData, packedTexCrd), ResourceFormat::RG16Float, 1, VERTEX_TEXCOORD_LOC);
+        }
+        else
+        {
+            pStaticLayout->addElement(VERTEX_POSITION_NAME, offsetof(PackedStaticVertexData, position), ResourceFormat::RGB32Float, 1, VERTEX_POSITION_LOC);
+            pStaticLayout->addElement(VERTEX_PACKED_NORMAL_TANGENT_NAME, offsetof(PackedStaticVertexData, packedNormalTangent), ResourceFormat::RGB32Float, 1, VERTEX_PACKED_NORMAL_TANGENT_LOC);
+            pStaticLayout->addElement(VERTEX_TEXCOORD_NAME, offsetof(PackedStaticVertexData, texCrd), ResourceFormat::RG32Float, 1, VERTEX_TEXCOORD_LOC);
+        }
         pLayout->addBufferLayout(Scene::kStaticDataBufferIndex, pStaticLayout);
 
         // Add the draw ID layout.
@@ -1683,6 +2271,20 @@ namespace Falcor
         mpScene->mpVao16Bit = Vao::create(mMeshes[0].topology, pLayout, pVBs, pIB, ResourceFormat::R16Uint);
     }
 
+    void SceneBuilder::createMeshletData()
+    {
+        assert(mpScene->mMeshletDesc.empty());
+        if (mBuffersData.meshlets.empty()) return;
+
+        mpScene->mMeshletDesc = mBuffersData.meshlets;
+
+        // The meshlet vertex and triangle data is static, so it is uploaded at creation and not kept on the CPU by the scene.
+        mpScene->mpMeshletVerticesBuffer = Buffer::createStructured(sizeof(uint32_t), (uint32_t)mBuffersData.meshletVertices.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, mBuffersData.meshletVertices.data(), false);
+        mpScene->mpMeshletVerticesBuffer->setName("Scene::mpMeshletVerticesBuffer");
+        mpScene->mpMeshletTrianglesBuffer = Buffer::createStructured(sizeof(uint32_t), (uint32_t)mBuffersData.meshletTriangles.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, mBuffersData.meshletTriangles.data(), false);
+        mpScene->mpMeshletTrianglesBuffer->setName("Scene::mpMeshletTrianglesBuffer");
+    }
+
     uint32_t SceneBuilder::createMeshData()
     {
         assert(mpScene->mMeshDesc.empty());
@@ -1690,6 +2292,7 @@ namespace Falcor
         assert(mpScene->mMeshHasDynamicData.empty());
         assert(mpScene->mMeshIdToInstanceIds.empty());
         assert(mpScene->mMeshGroups.empty());
+        assert(mpScene->mMeshLODs.empty());
 
         auto& meshData = mpScene->mMeshDesc;
         auto& instanceData = mpScene->mMeshInstanceData;
@@ -1707,6 +2310,14 @@ namespace Falcor
             meshData[meshID].vertexCount = mesh.vertexCount;
             meshData[meshID].indexCount = mesh.indexCount;
             meshData[meshID].dynamicVbOffset = mesh.hasDynamicData ? mesh.dynamicVertexOffset : 0;
+            meshData[meshID].meshletOffset = mesh.meshletOffset;
+            meshData[meshID].meshletCount = mesh.meshletCount;
+            if (!mesh.lods.empty())
+            {
+                mpScene->mMeshLODs.resize(mMeshes.size());
+                mpScene->mMeshLODs[meshID] = mesh.lods;
+            }
+            computeCompactPositionTransform(mesh.boundingBox, meshData[meshID].positionOffset, meshData[meshID].positionScale);
             assert(mesh.dynamicVertexCount == 0 || mesh.dynamicVertexCount == mesh.staticVertexCount);
 
             mpScene->mMeshNames.push_back(mesh.name);
@@ -1957,8 +2568,8 @@ namespace Falcor
     {
         // Calculate curve bounding boxes.
         mpScene->mCurveBBs.resize(mCurves.size());
-        for (size_t i = 0; i < mCurves.size(); i++)
-        {
+
+        Threading::parallelFor(0, (uint32_t)mCurves.size(), [&](uint32_t i) {
             const auto& curve = mCurves[i];
             AABB curveBB;
 
@@ -1971,7 +2582,7 @@ namespace Falcor
             }
 
             mpScene->mCurveBBs[i] = curveBB;
-        }
+        });
     }
 
     void SceneBuilder::pushProceduralPrimitive(uint32_t typeID, uint32_t instanceIdx, uint32_t AABBOffset, uint32_t AABBCount)
@@ -2007,6 +2618,13 @@ namespace Falcor
         flags.value("Force32BitIndices", SceneBuilder::Flags::Force32BitIndices);
         flags.value("RTDontMergeStatic", SceneBuilder::Flags::RTDontMergeStatic);
         flags.value("RTDontMergeDynamic", SceneBuilder::Flags::RTDontMergeDynamic);
+        flags.value("UseCache", SceneBuilder::Flags::UseCache);
+        flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
+        flags.value("HashedVertexMerge", SceneBuilder::Flags::HashedVertexMerge);
+        flags.value("UseCompactVertices", SceneBuilder::Flags::UseCompactVertices);
+        flags.value("OptimizeVertexCache", SceneBuilder::Flags::OptimizeVertexCache);
+        flags.value("GenerateMeshlets", SceneBuilder::Flags::GenerateMeshlets);
+        flags.value("GenerateLODs", SceneBuilder::Flags::GenerateLODs);
         ScriptBindings::addEnumBinaryOperators(flags);
 
         pybind11::class_<SceneBuilder, SceneBuilder::SharedPtr> sceneBuilder(m, "SceneBuilder");
@@ -61,6 +61,13 @@ namespace Falcor
             Force32BitIndices           = 0x80,   ///< Force 32-bit indices for all meshes. By default, 16-bit indices are used for small meshes.
             RTDontMergeStatic           = 0x100,  ///< For raytracing, don't merge all static meshes into single pre-transformed BLAS.
             RTDontMergeDynamic          = 0x200,  ///< For raytracing, don't merge all dynamic meshes with identical transforms into single BLAS.
+            UseCache                    = 0x400,  ///< Load the scene from the scene cache if a valid cache exists, otherwise build the scene and write it to the cache. See SceneCache.
+            RebuildCache                = 0x800,  ///< Always build the scene and overwrite any existing cache. Only applies together with UseCache.
+            HashedVertexMerge           = 0x1000, ///< Merge identical vertices using a hash table over quantized vertex attributes instead of searching the vertices sharing an original vertex index. This is faster for meshes with many split vertices. Note that identical vertices with different original indices are merged as well.
+            UseCompactVertices          = 0x2000, ///< Store vertices in a compact 20B format: positions quantized to 16 bits relative to the mesh bounds, octahedral normals/tangents and fp16 texture coordinates. Ignored for scenes with skinned meshes.
+            OptimizeVertexCache         = 0x4000, ///< Reorder triangles for post-transform vertex cache locality and reduced overdraw, and vertices for fetch locality. Only applies to indexed meshes.
+            GenerateMeshlets            = 0x8000, ///< Partition the meshes into meshlets of at most 64 vertices and 124 triangles with bounding spheres and normal cones for culling. See MeshletDesc.
+            GenerateLODs                = 0x10000,///< Generate a chain of simplified index buffers per mesh using quadric error metrics. The LODs share the vertices of the mesh. See Scene::getMeshLOD().
 
             Default = None
         };
@@ -272,6 +279,16 @@ namespace Falcor
         */
         Scene::SharedPtr getScene();
 
+        /** Run the CPU-side post-processing of the scene data (mesh optimization, creation of the global buffers etc.).
+            This is called by getScene() and only needs to be called explicitly to run the CPU part of the build in isolation.
+            Subsequent calls have no effect. No objects can be added after this call.
+        */
+        void prepareSceneData();
+
+        /** Check if the scene data was loaded from the scene cache.
+        */
+        bool isLoadedFromCache() const { return mLoadedFromCache; }
+
         /** Get the build flags
         */
         Flags getFlags() const { return mFlags; }
@@ -513,6 +530,9 @@ namespace Falcor
             uint32_t indexOffset = 0;           ///< Offset into the shared 'indexData' array. This is calculated in createGlobalBuffers().
             uint32_t indexCount = 0;            ///< Number of indices, or zero if non-indexed.
             uint32_t vertexCount = 0;           ///< Number of vertices.
+            uint32_t meshletOffset = 0;         ///< Offset into the shared 'meshlets' array. This is calculated in createMeshlets().
+            uint32_t meshletCount = 0;          ///< Number of meshlets, or zero if meshlets are not generated.
+            std::vector<Scene::MeshLOD> lods;   ///< Simplified levels of detail in order of decreasing detail. The offsets are calculated in createGlobalBuffers().
             bool use16BitIndices = false;       ///< True if the indices are in 16-bit format.
             bool hasDynamicData = false;        ///< True if mesh has dynamic vertices.
             bool isStatic = false;              ///< True if mesh is non-instanced and static (not dynamic or animated).
@@ -522,6 +542,7 @@ namespace Falcor
 
             // Pre-processed vertex data.
             std::vector<uint32_t> indexData;    ///< Vertex indices in either 32-bit or 16-bit format packed tightly, or empty if non-indexed.
+            std::vector<std::vector<uint32_t>> lodIndexData; ///< Vertex indices of each LOD in the same format as 'indexData'.
             std::vector<StaticVertexData> staticData;
             std::vector<DynamicVertexData> dynamicData;
 
@@ -563,6 +584,10 @@ namespace Falcor
             std::vector<uint32_t> indexData;                ///< Vertex indices for all meshes in either 32-bit or 16-bit format packed tightly, decided per mesh.
             std::vector<PackedStaticVertexData> staticData; ///< Vertex attributes for all meshes in packed format.
             std::vector<DynamicVertexData> dynamicData;     ///< Additional vertex attributes for dynamic (skinned) meshes.
+            std::vector<PackedCompactVertexData> compactData; ///< Vertex attributes for all meshes in compact format. Replaces 'staticData' when Flags::UseCompactVertices is set.
+            std::vector<MeshletDesc> meshlets;              ///< Meshlets for all meshes. Only generated when Flags::GenerateMeshlets is set.
+            std::vector<uint32_t> meshletVertices;          ///< Mesh-local vertex indices referenced by the meshlets.
+            std::vector<uint32_t> meshletTriangles;         ///< Meshlet-local vertex indices, three 8-bit indices packed per triangle.
         } mBuffersData;
 
         struct CurveBuffersData
@@ -582,6 +607,11 @@ namespace Falcor
         SceneGraph mSceneGraph;
         const Flags mFlags;
         std::string mFilename;
+        std::vector<std::string> mDependencies;     ///< Full paths of all imported files. Used for validating the scene cache.
+
+        std::optional<uint64_t> mCacheKey;          ///< Scene cache key, set if the scene should be written to the cache.
+        bool mLoadedFromCache = false;              ///< True if the post-processed scene data was loaded from the scene cache.
+        bool mSceneDataReady = false;               ///< True if the scene data has been post-processed.
 
         Scene::RenderSettings mRenderSettings;
 
@@ -631,15 +661,20 @@ namespace Falcor
         void calculateMeshBoundingBoxes();
         void createMeshGroups();
         void optimizeGeometry();
+        void optimizeVertexCache();
+        void generateMeshLODs();
+        void createMeshlets();
         void createGlobalBuffers();
         void createCurveGlobalBuffers();
         void removeDuplicateMaterials();
         void collectVolumeGrids();
         void quantizeTexCoords();
+        void createCompactVertexData();
 
         // Scene setup
         uint32_t createMeshData();
         void createMeshVao(uint32_t drawCount);
+        void createMeshletData();
         void createCurveData();
         void createCurveVao();
         void mapCurvesToProceduralPrimitives(uint32_t typeID);
@@ -649,6 +684,9 @@ namespace Falcor
         void calculateCurveBoundingBoxes();
 
         void pushProceduralPrimitive(uint32_t typeID, uint32_t instanceIdx, uint32_t AABBOffset, uint32_t AABBCount);
+
+        friend class SceneCache;
+        friend class CpuScene;
     };
 
     enum_class_operators(SceneBuilder::Flags);
@@ -0,0 +1,779 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "SceneCache.h"
+#include <filesystem>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMagic = 0x4e435346; // 'FSCN'
+        const std::string kCacheFileExtension = ".scenecache";
+
+        std::string gCacheDirectory;
+
+        bool hashFile(const std::string& fullPath, uint64_t& hash)
+        {
+            MappedFile file;
+            if (!mapFile(fullPath, file)) return false;
+            hash = hashBytes(file.pData, file.size);
+            unmapFile(file);
+            return true;
+        }
+    }
+
+    /** Serializes data into a memory buffer.
+    */
+    class SceneCache::Writer
+    {
+    public:
+        template<typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+            writeBytes(&value, sizeof(T));
+        }
+
+        void write(const std::string& str)
+        {
+            write((uint64_t)str.size());
+            writeBytes(str.data(), str.size());
+        }
+
+        template<typename T>
+        void writeVector(const std::vector<T>& v)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+            write((uint64_t)v.size());
+            writeBytes(v.data(), v.size() * sizeof(T));
+        }
+
+        void writeBytes(const void* pData, size_t size)
+        {
+            const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+            mData.insert(mData.end(), pBytes, pBytes + size);
+        }
+
+        const std::vector<uint8_t>& getData() const { return mData; }
+
+    private:
+        std::vector<uint8_t> mData;
+    };
+
+    /** Deserializes data from a memory range, typically a memory-mapped cache file.
+        Throws an exception if reading past the end of the data.
+    */
+    class SceneCache::Reader
+    {
+    public:
+        Reader(const void* pData, size_t size) : mpData(reinterpret_cast<const uint8_t*>(pData)), mSize(size) {}
+
+        template<typename T>
+        void read(T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+            readBytes(&value, sizeof(T));
+        }
+
+        void read(std::string& str)
+        {
+            uint64_t size = 0;
+            read(size);
+            checkRemaining(size);
+            str.assign(reinterpret_cast<const char*>(mpData + mOffset), (size_t)size);
+            mOffset += (size_t)size;
+        }
+
+        template<typename T>
+        T read()
+        {
+            T value;
+            read(value);
+            return value;
+        }
+
+        template<typename T>
+        void readVector(std::vector<T>& v)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+            uint64_t count = 0;
+            read(count);
+            if (count > (mSize - mOffset) / sizeof(T)) throw std::runtime_error("Unexpected end of scene cache data");
+            v.resize((size_t)count);
+            readBytes(v.data(), v.size() * sizeof(T));
+        }
+
+        void readBytes(void* pData, size_t size)
+        {
+            if (size == 0) return;
+            checkRemaining(size);
+            std::memcpy(pData, mpData + mOffset, size);
+            mOffset += size;
+        }
+
+    private:
+        void checkRemaining(uint64_t size) const
+        {
+            if (size > mSize - mOffset) throw std::runtime_error("Unexpected end of scene cache data");
+        }
+
+        const uint8_t* mpData;
+        size_t mSize;
+        size_t mOffset = 0;
+    };
+
+    namespace
+    {
+        struct Dependency
+        {
+            std::string path;
+            uint64_t hash = 0;
+        };
+
+        /** Reads the cache file header and validates it against the key.
+            \return True if the header is valid and all dependencies are unchanged.
+        */
+        template<typename ReaderType>
+        bool readHeader(ReaderType& reader, SceneCache::Key key)
+        {
+            if (reader.template read<uint32_t>() != kMagic) return false;
+            if (reader.template read<uint32_t>() != SceneCache::kVersion) return false;
+            if (reader.template read<uint64_t>() != key) return false;
+
+            uint64_t dependencyCount = reader.template read<uint64_t>();
+            for (uint64_t i = 0; i < dependencyCount; i++)
+            {
+                Dependency dependency;
+                reader.read(dependency.path);
+                reader.read(dependency.hash);
+
+                uint64_t hash = 0;
+                if (!hashFile(dependency.path, hash) || hash != dependency.hash)
+                {
+                    logInfo("Scene cache is out of date, '" + dependency.path + "' has changed.");
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename WriterType>
+        void writeAnimatable(WriterType& writer, const Animatable& animatable)
+        {
+            writer.write(animatable.hasAnimation());
+            writer.write(animatable.isAnimated());
+            writer.write(animatable.getNodeID());
+        }
+
+        template<typename ReaderType>
+        void readAnimatable(ReaderType& reader, Animatable& animatable)
+        {
+            animatable.setHasAnimation(reader.template read<bool>());
+            animatable.setIsAnimated(reader.template read<bool>());
+            animatable.setNodeID(reader.template read<uint32_t>());
+        }
+    }
+
+    bool SceneCache::computeKey(const std::string& filename, SceneBuilder::Flags flags, Key& key)
+    {
+        std::string fullPath;
+        if (!findFileInDataDirectories(filename, fullPath)) return false;
+
+        uint64_t contentHash = 0;
+        if (!hashFile(fullPath, contentHash)) return false;
+
+        // The cache flags themselves don't affect the built scene.
+        uint32_t buildFlags = (uint32_t)(flags & ~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache));
+
+        std::string path = canonicalizeFilename(fullPath);
+        uint64_t hash = hashBytes(path.data(), path.size());
+        hash = hashBytes(&contentHash, sizeof(contentHash), hash);
+        hash = hashBytes(&buildFlags, sizeof(buildFlags), hash);
+        hash = hashBytes(&kVersion, sizeof(kVersion), hash);
+
+        key = hash;
+        return true;
+    }
+
+    const std::string& SceneCache::getCacheDirectory()
+    {
+        if (gCacheDirectory.empty()) gCacheDirectory = getAppDataDirectory() + "/Falcor/SceneCache";
+        return gCacheDirectory;
+    }
+
+    void SceneCache::setCacheDirectory(const std::string& directory)
+    {
+        gCacheDirectory = directory;
+    }
+
+    std::string SceneCache::getCacheFilename(Key key)
+    {
+        return getCacheDirectory() + "/" + toHexString(key) + kCacheFileExtension;
+    }
+
+    bool SceneCache::hasValidCache(Key key)
+    {
+        MappedFile file;
+        if (!mapFile(getCacheFilename(key), file)) return false;
+
+        bool valid = false;
+        try
+        {
+            Reader reader(file.pData, file.size);
+            valid = readHeader(reader, key);
+        }
+        catch (const std::exception&)
+        {
+            valid = false;
+        }
+
+        unmapFile(file);
+        return valid;
+    }
+
+    bool SceneCache::writeCache(const SceneBuilder& builder, Key key)
+    {
+        if (!isCacheable(builder)) return false;
+
+        Writer writer;
+
+        // Header.
+        writer.write(kMagic);
+        writer.write(kVersion);
+        writer.write(key);
+
+        writer.write((uint64_t)builder.mDependencies.size());
+        for (const auto& path : builder.mDependencies)
+        {
+            uint64_t hash = 0;
+            if (!hashFile(path, hash))
+            {
+                logWarning("Not writing scene cache, failed to read scene dependency '" + path + "'.");
+                return false;
+            }
+            writer.write(path);
+            writer.write(hash);
+        }
+
+        writeSceneData(writer, builder);
+
+        // Write to a temporary file and rename it, so that other processes never see a partially written cache file.
+        const std::string& directory = getCacheDirectory();
+        if (!isDirectoryExists(directory) && !std::filesystem::create_directories(directory))
+        {
+            logWarning("Not writing scene cache, failed to create cache directory '" + directory + "'.");
+            return false;
+        }
+
+        std::string filename = getCacheFilename(key);
+        std::string tempFilename = getUniqueTempFilename(filename);
+
+        {
+            BinaryFileStream stream(tempFilename, BinaryFileStream::Mode::Write);
+            stream.write(writer.getData().data(), writer.getData().size());
+            if (stream.isFail())
+            {
+                stream.remove();
+                logWarning("Not writing scene cache, failed to write '" + tempFilename + "'.");
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempFilename, filename, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tempFilename, ec);
+            logWarning("Not writing scene cache, failed to rename '" + tempFilename + "'.");
+            return false;
+        }
+
+        logInfo("Wrote scene cache '" + filename + "' (" + formatByteSize(writer.getData().size()) + ").");
+        return true;
+    }
+
+    bool SceneCache::readCache(SceneBuilder& builder, Key key)
+    {
+        std::string filename = getCacheFilename(key);
+
+        MappedFile file;
+        if (!mapFile(filename, file)) return false;
+
+        bool success = false;
+        try
+        {
+            Reader reader(file.pData, file.size);
+            if (readHeader(reader, key))
+            {
+                readSceneData(reader, builder);
+                success = true;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Failed to read scene cache '" + filename + "': " + e.what());
+        }
+
+        unmapFile(file);
+
+        if (success) logInfo("Loaded scene from cache '" + filename + "'.");
+        return success;
+    }
+
+    bool SceneCache::isCacheable(const SceneBuilder& builder)
+    {
+        if (!builder.mVolumes.empty())
+        {
+            logWarning("Not writing scene cache, scenes with volumes are not supported.");
+            return false;
+        }
+
+        for (const auto& pMaterial : builder.mMaterials)
+        {
+            for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+            {
+                auto pTexture = pMaterial->getTexture((Material::TextureSlot)slot);
+                if (pTexture && pTexture->getSourceFilename().empty())
+                {
+                    logWarning("Not writing scene cache, material '" + pMaterial->getName() + "' uses a texture that was not loaded from a file.");
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void SceneCache::writeSceneData(Writer& writer, const SceneBuilder& builder)
+    {
+        writer.write(builder.mFilename);
+        writer.write(builder.mRenderSettings);
+
+        // Geometry.
+        writer.writeVector(builder.mBuffersData.indexData);
+        writer.writeVector(builder.mBuffersData.staticData);
+        writer.writeVector(builder.mBuffersData.dynamicData);
+        writer.writeVector(builder.mBuffersData.compactData);
+        writer.writeVector(builder.mBuffersData.meshlets);
+        writer.writeVector(builder.mBuffersData.meshletVertices);
+        writer.writeVector(builder.mBuffersData.meshletTriangles);
+        writer.writeVector(builder.mCurveBuffersData.indexData);
+        writer.writeVector(builder.mCurveBuffersData.staticData);
+
+        writer.write((uint64_t)builder.mMeshes.size());
+        for (const auto& mesh : builder.mMeshes)
+        {
+            // The per-mesh vertex/index data has been moved to the global buffers at this point.
+            assert(mesh.indexData.empty() && mesh.staticData.empty() && mesh.dynamicData.empty());
+            writer.write(mesh.name);
+            writer.write(mesh.topology);
+            writer.write(mesh.materialId);
+            writer.write(mesh.staticVertexOffset);
+            writer.write(mesh.staticVertexCount);
+            writer.write(mesh.dynamicVertexOffset);
+            writer.write(mesh.dynamicVertexCount);
+            writer.write(mesh.indexOffset);
+            writer.write(mesh.indexCount);
+            writer.write(mesh.vertexCount);
+            writer.write(mesh.meshletOffset);
+            writer.write(mesh.meshletCount);
+            writer.writeVector(mesh.lods);
+            writer.write(mesh.use16BitIndices);
+            writer.write(mesh.hasDynamicData);
+            writer.write(mesh.isStatic);
+            writer.write(mesh.isFrontFaceCW);
+            writer.write(mesh.boundingBox);
+            writer.writeVector(mesh.instances);
+        }
+
+        writer.write((uint64_t)builder.mMeshGroups.size());
+        for (const auto& meshGroup : builder.mMeshGroups)
+        {
+            writer.writeVector(meshGroup.meshList);
+            writer.write(meshGroup.isStatic);
+        }
+
+        writer.write((uint64_t)builder.mCurves.size());
+        for (const auto& curve : builder.mCurves)
+        {
+            assert(curve.indexData.empty() && curve.staticData.empty());
+            writer.write(curve.name);
+            writer.write(curve.topology);
+            writer.write(curve.materialId);
+            writer.write(curve.staticVertexOffset);
+            writer.write(curve.staticVertexCount);
+            writer.write(curve.indexOffset);
+            writer.write(curve.indexCount);
+            writer.write(curve.vertexCount);
+            writer.write(curve.degree);
+            writer.writeVector(curve.instances);
+        }
+
+        writer.writeVector(builder.mProceduralPrimitives);
+        writer.writeVector(builder.mCustomPrimitiveAABBs);
+        writer.write((uint64_t)builder.mProceduralPrimInstanceCount.size());
+        for (const auto& [typeID, count] : builder.mProceduralPrimInstanceCount)
+        {
+            writer.write(typeID);
+            writer.write(count);
+        }
+
+        // Scene graph.
+        writer.write((uint64_t)builder.mSceneGraph.size());
+        for (const auto& node : builder.mSceneGraph)
+        {
+            writer.write(node.name);
+            writer.write(node.transform);
+            writer.write(node.localToBindPose);
+            writer.write(node.parent);
+            writer.writeVector(node.children);
+            writer.writeVector(node.meshes);
+            writer.writeVector(node.curves);
+        }
+
+        // Materials, lights, cameras and animations.
+        writer.write((uint64_t)builder.mMaterials.size());
+        for (const auto& pMaterial : builder.mMaterials) writeMaterial(writer, pMaterial);
+
+        writer.write((uint64_t)builder.mLights.size());
+        for (const auto& pLight : builder.mLights) writeLight(writer, pLight);
+
+        writer.write((uint64_t)builder.mCameras.size());
+        for (const auto& pCamera : builder.mCameras) writeCamera(writer, pCamera);
+
+        auto selectedCamera = std::find(builder.mCameras.begin(), builder.mCameras.end(), builder.mpSelectedCamera);
+        writer.write(selectedCamera != builder.mCameras.end() ? (uint32_t)std::distance(builder.mCameras.begin(), selectedCamera) : uint32_t(-1));
+        writer.write(builder.mCameraSpeed);
+
+        writer.write((uint64_t)builder.mAnimations.size());
+        for (const auto& pAnimation : builder.mAnimations) writeAnimation(writer, pAnimation);
+
+        // Environment map.
+        writer.write(builder.mpEnvMap != nullptr);
+        if (builder.mpEnvMap)
+        {
+            writer.write(builder.mpEnvMap->getFilename());
+            writer.write(builder.mpEnvMap->getRotation());
+            writer.write(builder.mpEnvMap->getIntensity());
+            writer.write(builder.mpEnvMap->getTint());
+        }
+    }
+
+    void SceneCache::readSceneData(Reader& reader, SceneBuilder& builder)
+    {
+        reader.read(builder.mFilename);
+        reader.read(builder.mRenderSettings);
+
+        // Geometry.
+        reader.readVector(builder.mBuffersData.indexData);
+        reader.readVector(builder.mBuffersData.staticData);
+        reader.readVector(builder.mBuffersData.dynamicData);
+        reader.readVector(builder.mBuffersData.compactData);
+        reader.readVector(builder.mBuffersData.meshlets);
+        reader.readVector(builder.mBuffersData.meshletVertices);
+        reader.readVector(builder.mBuffersData.meshletTriangles);
+        reader.readVector(builder.mCurveBuffersData.indexData);
+        reader.readVector(builder.mCurveBuffersData.staticData);
+
+        builder.mMeshes.resize((size_t)reader.read<uint64_t>());
+        for (auto& mesh : builder.mMeshes)
+        {
+            reader.read(mesh.name);
+            reader.read(mesh.topology);
+            reader.read(mesh.materialId);
+            reader.read(mesh.staticVertexOffset);
+            reader.read(mesh.staticVertexCount);
+            reader.read(mesh.dynamicVertexOffset);
+            reader.read(mesh.dynamicVertexCount);
+            reader.read(mesh.indexOffset);
+            reader.read(mesh.indexCount);
+            reader.read(mesh.vertexCount);
+            reader.read(mesh.meshletOffset);
+            reader.read(mesh.meshletCount);
+            reader.readVector(mesh.lods);
+            reader.read(mesh.use16BitIndices);
+            reader.read(mesh.hasDynamicData);
+            reader.read(mesh.isStatic);
+            reader.read(mesh.isFrontFaceCW);
+            reader.read(mesh.boundingBox);
+            reader.readVector(mesh.instances);
+        }
+
+        builder.mMeshGroups.resize((size_t)reader.read<uint64_t>());
+        for (auto& meshGroup : builder.mMeshGroups)
+        {
+            reader.readVector(meshGroup.meshList);
+            reader.read(meshGroup.isStatic);
+        }
+
+        builder.mCurves.resize((size_t)reader.read<uint64_t>());
+        for (auto& curve : builder.mCurves)
+        {
+            reader.read(curve.name);
+            reader.read(curve.topology);
+            reader.read(curve.materialId);
+            reader.read(curve.staticVertexOffset);
+            reader.read(curve.staticVertexCount);
+            reader.read(curve.indexOffset);
+            reader.read(curve.indexCount);
+            reader.read(curve.vertexCount);
+            reader.read(curve.degree);
+            reader.readVector(curve.instances);
+        }
+
+        reader.readVector(builder.mProceduralPrimitives);
+        reader.readVector(builder.mCustomPrimitiveAABBs);
+        uint64_t procPrimTypeCount = reader.read<uint64_t>();
+        for (uint64_t i = 0; i < procPrimTypeCount; i++)
+        {
+            uint32_t typeID = reader.read<uint32_t>();
+            builder.mProceduralPrimInstanceCount[typeID] = reader.read<uint32_t>();
+        }
+
+        // Scene graph.
+        builder.mSceneGraph.resize((size_t)reader.read<uint64_t>());
+        for (auto& node : builder.mSceneGraph)
+        {
+            reader.read(node.name);
+            reader.read(node.transform);
+            reader.read(node.localToBindPose);
+            reader.read(node.parent);
+            reader.readVector(node.children);
+            reader.readVector(node.meshes);
+            reader.readVector(node.curves);
+        }
+
+        // Materials, lights, cameras and animations.
+        builder.mMaterials.resize((size_t)reader.read<uint64_t>());
+        for (auto& pMaterial : builder.mMaterials) pMaterial = readMaterial(reader, builder);
+
+        builder.mLights.resize((size_t)reader.read<uint64_t>());
+        for (auto& pLight : builder.mLights) pLight = readLight(reader);
+
+        builder.mCameras.resize((size_t)reader.read<uint64_t>());
+        for (auto& pCamera : builder.mCameras) pCamera = readCamera(reader);
+
+        uint32_t selectedCamera = reader.read<uint32_t>();
+        builder.mpSelectedCamera = selectedCamera < builder.mCameras.size() ? builder.mCameras[selectedCamera] : nullptr;
+        reader.read(builder.mCameraSpeed);
+
+        builder.mAnimations.resize((size_t)reader.read<uint64_t>());
+        for (auto& pAnimation : builder.mAnimations) pAnimation = readAnimation(reader);
+
+        // Environment map.
+        if (reader.read<bool>())
+        {
+            std::string filename;
+            reader.read(filename);
+            builder.mpEnvMap = EnvMap::create(filename);
+            if (!builder.mpEnvMap) throw std::runtime_error("Failed to load environment map '" + filename + "'");
+            builder.mpEnvMap->setRotation(reader.read<float3>());
+            builder.mpEnvMap->setIntensity(reader.read<float>());
+            builder.mpEnvMap->setTint(reader.read<float3>());
+        }
+    }
+
+    void SceneCache::writeMaterial(Writer& writer, const Material::SharedPtr& pMaterial)
+    {
+        writer.write(pMaterial->mName);
+        writer.write(pMaterial->mData);
+        writer.write(pMaterial->mOcclusionMapEnabled);
+
+        const Transform& texTransform = pMaterial->getTextureTransform();
+        writer.write(texTransform.getTranslation());
+        writer.write(texTransform.getScaling());
+        writer.write(texTransform.getRotation());
+
+        for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+        {
+            auto pTexture = pMaterial->getTexture((Material::TextureSlot)slot);
+            writer.write(pTexture ? pTexture->getSourceFilename() : std::string());
+        }
+    }
+
+    Material::SharedPtr SceneCache::readMaterial(Reader& reader, SceneBuilder& builder)
+    {
+        auto pMaterial = Material::create(reader.read<std::string>());
+        reader.read(pMaterial->mData);
+        reader.read(pMaterial->mOcclusionMapEnabled);
+
+        Transform texTransform;
+        texTransform.setTranslation(reader.read<float3>());
+        texTransform.setScaling(reader.read<float3>());
+        texTransform.setRotation(reader.read<glm::quat>());
+        pMaterial->setTextureTransform(texTransform);
+
+        // Textures are loaded asynchronously and assigned when the scene builder finishes loading.
+        for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+        {
+            auto filename = reader.read<std::string>();
+            if (!filename.empty()) builder.loadMaterialTexture(pMaterial, (Material::TextureSlot)slot, filename);
+        }
+
+        return pMaterial;
+    }
+
+    void SceneCache::writeLight(Writer& writer, const Light::SharedPtr& pLight)
+    {
+        writer.write(pLight->mData);
+        writer.write(pLight->mName);
+        writer.write(pLight->mActive);
+        writer.write(pLight->mUiLightIntensityColor);
+        writer.write(pLight->mUiLightIntensityScale);
+        writeAnimatable(writer, *pLight);
+
+        switch ((LightType)pLight->mData.type)
+        {
+        case LightType::Distant:
+            writer.write(std::static_pointer_cast<DistantLight>(pLight)->getAngle());
+            break;
+        case LightType::Rect:
+        case LightType::Disc:
+        case LightType::Sphere:
+        {
+            auto pAreaLight = std::static_pointer_cast<AnalyticAreaLight>(pLight);
+            writer.write(pAreaLight->getScaling());
+            writer.write(pAreaLight->getTransformMatrix());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    Light::SharedPtr SceneCache::readLight(Reader& reader)
+    {
+        auto data = reader.read<LightData>();
+        auto name = reader.read<std::string>();
+
+        Light::SharedPtr pLight;
+        switch ((LightType)data.type)
+        {
+        case LightType::Point: pLight = PointLight::create(name); break;
+        case LightType::Directional: pLight = DirectionalLight::create(name); break;
+        case LightType::Distant: pLight = DistantLight::create(name); break;
+        case LightType::Rect: pLight = RectLight::create(name); break;
+        case LightType::Disc: pLight = DiscLight::create(name); break;
+        case LightType::Sphere: pLight = SphereLight::create(name); break;
+        default: throw std::runtime_error("Unknown light type");
+        }
+
+        reader.read(pLight->mActive);
+        reader.read(pLight->mUiLightIntensityColor);
+        reader.read(pLight->mUiLightIntensityScale);
+        readAnimatable(reader, *pLight);
+
+        switch ((LightType)data.type)
+        {
+        case LightType::Distant:
+            std::static_pointer_cast<DistantLight>(pLight)->setAngle(reader.read<float>());
+            break;
+        case LightType::Rect:
+        case LightType::Disc:
+        case LightType::Sphere:
+        {
+            auto pAreaLight = std::static_pointer_cast<AnalyticAreaLight>(pLight);
+            pAreaLight->setScaling(reader.read<float3>());
+            pAreaLight->setTransformMatrix(reader.read<glm::mat4>());
+            break;
+        }
+        default:
+            break;
+        }
+
+        // The setters above recompute parts of the light data, overwrite it with the exact cached state.
+        pLight->mData = data;
+        pLight->mPrevData = data;
+
+        return pLight;
+    }
+
+    void SceneCache::writeCamera(Writer& writer, const Camera::SharedPtr& pCamera)
+    {
+        writer.write(pCamera->mName);
+        writer.write(pCamera->getData());
+        writer.write(pCamera->mPreserveHeight);
+        writeAnimatable(writer, *pCamera);
+    }
+
+    Camera::SharedPtr SceneCache::readCamera(Reader& reader)
+    {
+        auto pCamera = Camera::create(reader.read<std::string>());
+        reader.read(pCamera->mData);
+        reader.read(pCamera->mPreserveHeight);
+        readAnimatable(reader, *pCamera);
+        pCamera->mDirty = true;
+        return pCamera;
+    }
+
+    void SceneCache::writeAnimation(Writer& writer, const Animation::SharedPtr& pAnimation)
+    {
+        writer.write(pAnimation->getName());
+        writer.write(pAnimation->getNodeID());
+        writer.write(pAnimation->getDuration());
+        writer.write(pAnimation->getPreInfinityBehavior());
+        writer.write(pAnimation->getPostInfinityBehavior());
+        writer.write(pAnimation->getInterpolationMode());
+        writer.write(pAnimation->isWarpingEnabled());
+
+        writer.write((uint64_t)pAnimation->mKeyframes.size());
+        for (const auto& keyframe : pAnimation->mKeyframes)
+        {
+            writer.write(keyframe.time);
+            writer.write(keyframe.translation);
+            writer.write(keyframe.scaling);
+            writer.write(keyframe.rotation);
+        }
+    }
+
+    Animation::SharedPtr SceneCache::readAnimation(Reader& reader)
+    {
+        auto name = reader.read<std::string>();
+        auto nodeID = reader.read<uint32_t>();
+        auto duration = reader.read<double>();
+
+        auto pAnimation = Animation::create(name, nodeID, duration);
+        pAnimation->setPreInfinityBehavior(reader.read<Animation::Behavior>());
+        pAnimation->setPostInfinityBehavior(reader.read<Animation::Behavior>());
+        pAnimation->setInterpolationMode(reader.read<Animation::InterpolationMode>());
+        pAnimation->setEnableWarping(reader.read<bool>());
+
+        // Keyframes are stored sorted by time.
+        pAnimation->mKeyframes.resize((size_t)reader.read<uint64_t>());
+        for (auto& keyframe : pAnimation->mKeyframes)
+        {
+            reader.read(keyframe.time);
+            reader.read(keyframe.translation);
+            reader.read(keyframe.scaling);
+            reader.read(keyframe.rotation);
+        }
+
+        return pAnimation;
+    }
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneBuilder.h"
+
+namespace Falcor
+{
+    /** On-disk cache of the post-processed scene builder state.
+
+        The cache stores everything the scene builder holds after the CPU-side post-processing
+        (global vertex/index buffers, mesh and curve specs, mesh groups, scene graph, materials,
+        lights, cameras and animations). Loading a cached scene skips the importers and all
+        mesh processing. Textures are not stored in the cache, they are loaded from their
+        source files as usual.
+
+        Cache files are keyed by a hash of the scene file contents, its path and the build flags.
+        In addition, the content hash of every file imported while building the scene is stored
+        in the cache and re-validated on load, so that changes to files referenced from a scene
+        script invalidate the cache.
+    */
+    class dlldecl SceneCache
+    {
+    public:
+        using Key = uint64_t;
+
+        /** Version of the cache format. Must be incremented whenever the layout of the cached data changes.
+        */
+        static const uint32_t kVersion = 4;
+
+        /** Compute the cache key for a scene file.
+            \param[in] filename Scene filename. Searched for in the data directories.
+            \param[in] flags Scene builder flags.
+            \param[out] key The cache key.
+            \return True if the key was computed, false if the file was not found.
+        */
+        static bool computeKey(const std::string& filename, SceneBuilder::Flags flags, Key& key);
+
+        /** Get the directory where cache files are stored.
+        */
+        static const std::string& getCacheDirectory();
+
+        /** Set the directory where cache files are stored.
+        */
+        static void setCacheDirectory(const std::string& directory);
+
+        /** Get the full path of the cache file for a given key.
+        */
+        static std::string getCacheFilename(Key key);
+
+        /** Check if a valid cache file exists for a given key.
+            This validates the header and all the file dependencies, but not the cached data itself.
+        */
+        static bool hasValidCache(Key key);
+
+        /** Write the state of a scene builder to the cache.
+            The scene builder is expected to have finished post-processing (see SceneBuilder::prepareSceneData()).
+            Scenes that contain data the cache cannot represent (e.g. volumes) are not written.
+            \param[in] builder Scene builder.
+            \param[in] key Cache key.
+            \return True if the cache file was written.
+        */
+        static bool writeCache(const SceneBuilder& builder, Key key);
+
+        /** Read the state of a scene builder from the cache.
+            \param[in] builder A newly created scene builder. Its flags must match the flags the key was computed with.
+            \param[in] key Cache key.
+            \return True if the cache was loaded. If false is returned, the builder may be partially initialized and should be discarded.
+        */
+        static bool readCache(SceneBuilder& builder, Key key);
+
+    private:
+        class Writer;
+        class Reader;
+
+        static bool isCacheable(const SceneBuilder& builder);
+        static void writeSceneData(Writer& writer, const SceneBuilder& builder);
+        static void readSceneData(Reader& reader, SceneBuilder& builder);
+
+        static void writeMaterial(Writer& writer, const Material::SharedPtr& pMaterial);
+        static Material::SharedPtr readMaterial(Reader& reader, SceneBuilder& builder);
+        static void writeLight(Writer& writer, const Light::SharedPtr& pLight);
+        static Light::SharedPtr readLight(Reader& reader);
+        static void writeCamera(Writer& writer, const Camera::SharedPtr& pCamera);
+        static Camera::SharedPtr readCamera(Reader& reader);
+        static void writeAnimation(Writer& writer, const Animation::SharedPtr& pAnimation);
+        static Animation::SharedPtr readAnimation(Reader& reader);
+    };
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/API/Buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU copy of a structured GPU buffer with tracking of the modified element range.
+
+        Elements are written to the CPU copy and the range spanning all modified elements is uploaded
+        with a single call, instead of one upload per element. Writes that don't change an element are
+        ignored, so rewriting unchanged data every frame doesn't cause uploads.
+    */
+    template<typename T>
+    class ShadowBuffer
+    {
+    public:
+        static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+
+        /** Attach a structured buffer. The CPU copy is resized to the buffer and marked dirty in full.
+            \param[in] pBuffer Structured buffer with elements of type T, or nullptr to detach.
+        */
+        void init(const Buffer::SharedPtr& pBuffer)
+        {
+            assert(!pBuffer || pBuffer->getStructSize() == sizeof(T));
+            mpBuffer = pBuffer;
+            mData.assign(pBuffer ? pBuffer->getElementCount() : 0, T{});
+            mDirtyBegin = 0;
+            mDirtyEnd = mData.size();
+        }
+
+        /** Get the number of elements.
+        */
+        size_t getCount() const { return mData.size(); }
+
+        /** Get an element of the CPU copy.
+        */
+        const T& operator[](size_t index) const { return mData[index]; }
+
+        /** Write an element. The element is only marked dirty if its contents changed.
+        */
+        void set(size_t index, const T& value)
+        {
+            assert(index < mData.size());
+            if (std::memcmp(&mData[index], &value, sizeof(T)) == 0) return;
+            mData[index] = value;
+            mDirtyBegin = std::min(mDirtyBegin, index);
+            mDirtyEnd = std::max(mDirtyEnd, index + 1);
+        }
+
+        /** Check if there are modified elements that haven't been uploaded.
+        */
+        bool isDirty() const { return mDirtyBegin < mDirtyEnd; }
+
+        /** Upload the range of modified elements to the GPU buffer.
+            \return Number of bytes uploaded.
+        */
+        size_t upload()
+        {
+            if (!isDirty()) return 0;
+            const size_t byteSize = (mDirtyEnd - mDirtyBegin) * sizeof(T);
+            mpBuffer->setBlob(mData.data() + mDirtyBegin, mDirtyBegin * sizeof(T), byteSize);
+            mDirtyBegin = std::numeric_limits<size_t>::max();
+            mDirtyEnd = 0;
+            return byteSize;
+        }
+
+    private:
+        Buffer::SharedPtr mpBuffer;
+        std::vector<T> mData;
+        size_t mDirtyBegin = std::numeric_limits<size_t>::max();    ///< First modified element.
+        size_t mDirtyEnd = 0;                                       ///< One past the last modified element.
+    };
+}
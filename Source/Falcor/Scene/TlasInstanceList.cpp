@@ -0,0 +1,134 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "TlasInstanceList.h"
+#include "Utils/Math/AABB.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        void setTransform(D3D12_RAYTRACING_INSTANCE_DESC& desc, const glm::mat4& matrix)
+        {
+            // The instance desc holds a row-major 3x4 matrix, which is the first three rows of the transposed column-major matrix.
+            glm::mat4 transform4x4 = transpose(matrix);
+            std::memcpy(desc.Transform, &transform4x4, sizeof(desc.Transform));
+        }
+
+        float3 getPosition(const D3D12_RAYTRACING_INSTANCE_DESC& desc)
+        {
+            return float3(desc.Transform[0][3], desc.Transform[1][3], desc.Transform[2][3]);
+        }
+    }
+
+    void TlasInstanceList::init(std::vector<D3D12_RAYTRACING_INSTANCE_DESC> descs, std::vector<uint32_t> matrixIDs)
+    {
+        assert(descs.size() == matrixIDs.size());
+        mDescs = std::move(descs);
+        mMatrixIDs = std::move(matrixIDs);
+        mDirtyBegin = 0;
+        mDirtyEnd = mDescs.size();
+        mNeedsBuild = true;
+        mIsBuilt = false;
+    }
+
+    uint32_t TlasInstanceList::updateTransforms(const std::vector<glm::mat4>& globalMatrices, const std::function<bool(uint32_t)>& isMatrixChanged)
+    {
+        uint32_t patchedCount = 0;
+
+        for (size_t i = 0; i < mDescs.size(); i++)
+        {
+            const uint32_t matrixID = mMatrixIDs[i];
+            if (matrixID == kIdentityMatrix || !isMatrixChanged(matrixID)) continue;
+
+            // Skip instances whose transform was flagged as changed but is identical, e.g. animations that are paused.
+            D3D12_RAYTRACING_INSTANCE_DESC desc = mDescs[i];
+            setTransform(desc, globalMatrices[matrixID]);
+            if (std::memcmp(desc.Transform, mDescs[i].Transform, sizeof(desc.Transform)) == 0) continue;
+            mDescs[i] = desc;
+
+            if (mDirtyBegin == mDirtyEnd) mDirtyBegin = i;
+            mDirtyEnd = i + 1;
+            patchedCount++;
+
+            // Track how far the instance moved since the last rebuild.
+            if (mIsBuilt)
+            {
+                const float displacement = glm::length(getPosition(desc) - mBuildPositions[i]);
+                mTotalDisplacement += displacement - mDisplacements[i];
+                mDisplacements[i] = displacement;
+            }
+        }
+
+        if (patchedCount > 0) mNeedsBuild = true;
+        return patchedCount;
+    }
+
+    TlasInstanceList::BuildType TlasInstanceList::beginBuild(bool allowRefit)
+    {
+        mNeedsBuild = false;
+
+        const bool exceedsHeuristic = mRefitCount >= mMaxRefitCount || getRelativeDisplacement() > mMaxDisplacement;
+        if (allowRefit && mIsBuilt && !exceedsHeuristic)
+        {
+            mRefitCount++;
+            return BuildType::Refit;
+        }
+
+        // Record the instance positions as the reference for the rebuild heuristic.
+        AABB bounds;
+        mBuildPositions.resize(mDescs.size());
+        for (size_t i = 0; i < mDescs.size(); i++)
+        {
+            mBuildPositions[i] = getPosition(mDescs[i]);
+            bounds.include(mBuildPositions[i]);
+        }
+        mDisplacements.assign(mDescs.size(), 0.f);
+        mTotalDisplacement = 0.0;
+        mExtent = bounds.valid() ? glm::length(bounds.extent()) : 0.f;
+        mRefitCount = 0;
+        mIsBuilt = true;
+
+        return BuildType::Rebuild;
+    }
+
+    void TlasInstanceList::clearDirtyRange()
+    {
+        mDirtyBegin = 0;
+        mDirtyEnd = 0;
+    }
+
+    float TlasInstanceList::getRelativeDisplacement() const
+    {
+        if (mDescs.empty() || mTotalDisplacement <= 0.0) return 0.f;
+
+        // Instances at a single position have no extent. Any displacement then changes the spatial layout completely.
+        if (mExtent <= 0.f) return std::numeric_limits<float>::infinity();
+        return (float)(mTotalDisplacement / mDescs.size()) / mExtent;
+    }
+}
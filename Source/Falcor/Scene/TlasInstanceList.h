@@ -0,0 +1,126 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <functional>
+#include <vector>
+
+namespace Falcor
+{
+    /** Persistent list of TLAS instance descs, patched in place when instance transforms change.
+
+        The descs are generated once per TLAS. When transforms change, only the descs referencing a changed
+        matrix are patched, and the range of patched descs is uploaded. The list also decides whether the TLAS
+        is refit or rebuilt: refitting keeps the topology of the original build, which degrades the trace
+        performance as instances move away from where they were at the last rebuild. A rebuild is requested
+        when the mean displacement of the instances since the last rebuild exceeds a fraction of the extent of
+        the instances, or after a maximum number of consecutive refits.
+    */
+    class dlldecl TlasInstanceList
+    {
+    public:
+        /** Matrix ID of instances with a constant identity transform.
+        */
+        static const uint32_t kIdentityMatrix = uint32_t(-1);
+
+        enum class BuildType
+        {
+            Rebuild,    ///< Build the TLAS from scratch.
+            Refit,      ///< Update the TLAS from its previous state.
+        };
+
+        /** Set the instance descs. All descs are marked for upload and the next build is a rebuild.
+            \param[in] descs Instance descs. The transforms must correspond to the matrices referenced by 'matrixIDs'.
+            \param[in] matrixIDs Global matrix ID of each instance desc, or kIdentityMatrix.
+        */
+        void init(std::vector<D3D12_RAYTRACING_INSTANCE_DESC> descs, std::vector<uint32_t> matrixIDs);
+
+        /** Patch the transforms of the instances whose matrix changed.
+            \param[in] globalMatrices Global matrices, indexed by matrix ID.
+            \param[in] isMatrixChanged Returns true if a matrix changed since the last update.
+            \return Number of patched instance descs.
+        */
+        uint32_t updateTransforms(const std::vector<glm::mat4>& globalMatrices, const std::function<bool(uint32_t)>& isMatrixChanged);
+
+        /** Request a TLAS build without changing the descs, e.g. after the referenced BLASes were updated.
+        */
+        void invalidate() { mNeedsBuild = true; }
+
+        /** Check if the TLAS needs to be built because the instances changed since the last build.
+        */
+        bool needsBuild() const { return mNeedsBuild; }
+
+        /** Decide how to build the TLAS and reset the build request. Call this once per TLAS build.
+            \param[in] allowRefit True if the TLAS was built with support for updates.
+            \return Build type.
+        */
+        BuildType beginBuild(bool allowRefit);
+
+        /** Get the range of descs patched since the last call to clearDirtyRange().
+            \return Pair of first desc and one past the last desc. The range is empty if no descs were patched.
+        */
+        std::pair<size_t, size_t> getDirtyRange() const { return { mDirtyBegin, mDirtyEnd }; }
+
+        /** Clear the dirty range after the descs were uploaded.
+        */
+        void clearDirtyRange();
+
+        const std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& getDescs() const { return mDescs; }
+        const std::vector<uint32_t>& getMatrixIDs() const { return mMatrixIDs; }
+
+        /** Set the rebuild heuristic.
+            \param[in] maxDisplacement Rebuild when the mean instance displacement since the last rebuild exceeds this fraction of the instance extent.
+            \param[in] maxRefitCount Rebuild after this many consecutive refits.
+        */
+        void setRebuildHeuristic(float maxDisplacement, uint32_t maxRefitCount) { mMaxDisplacement = maxDisplacement; mMaxRefitCount = maxRefitCount; }
+
+        /** Get the mean displacement of the instances since the last rebuild, relative to the extent of the instances.
+        */
+        float getRelativeDisplacement() const;
+
+        /** Get the number of refits since the last rebuild.
+        */
+        uint32_t getRefitCount() const { return mRefitCount; }
+
+    private:
+        std::vector<D3D12_RAYTRACING_INSTANCE_DESC> mDescs;
+        std::vector<uint32_t> mMatrixIDs;
+        size_t mDirtyBegin = 0;
+        size_t mDirtyEnd = 0;
+        bool mNeedsBuild = true;
+        bool mIsBuilt = false;
+
+        // Rebuild heuristic
+        float mMaxDisplacement = 0.05f;
+        uint32_t mMaxRefitCount = 256;
+        uint32_t mRefitCount = 0;
+        std::vector<float3> mBuildPositions;    ///< Instance positions at the last rebuild.
+        std::vector<float> mDisplacements;      ///< Distance of each instance from its position at the last rebuild.
+        double mTotalDisplacement = 0.0;
+        float mExtent = 0.f;                    ///< Diagonal of the bounds of the instance positions at the last rebuild.
+    };
+}
@@ -35,95 +35,44 @@ namespace Falcor
         constexpr size_t kUploadsPerFlush = 16; ///< Number of texture uploads before issuing a flush (to keep upload heap from growing).
     }
 
-    AsyncTextureLoader::AsyncTextureLoader(size_t threadCount)
-    {
-        runWorkers(threadCount);
-    }
-
     AsyncTextureLoader::~AsyncTextureLoader()
     {
-        terminateWorkers();
+        Threading::wait(mTasks);
 
         gpDevice->flushAndSync();
     }
 
     std::future<Texture::SharedPtr> AsyncTextureLoader::loadFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Resource::BindFlags bindFlags)
     {
-        std::lock_guard<std::mutex> lock(mMutex);
-        mRequestQueue.push(Request{filename, generateMipLevels, loadAsSrgb, bindFlags});
-        mCondition.notify_one();
-        return mRequestQueue.back().promise.get_future();
-    }
-
-    void AsyncTextureLoader::runWorkers(size_t threadCount)
-    {
-        // Create a barrier to synchronize worker threads before issuing a global flush.
-        auto barrier = std::make_shared<Barrier>(threadCount, [&] () {
-            gpDevice->flushAndSync();
-            mFlushPending = false;
-            mUploadCounter = 0;
+        auto pPromise = std::make_shared<std::promise<Texture::SharedPtr>>();
+        auto future = pPromise->get_future();
+
+        auto task = Threading::dispatchTask([=] () {
+            // Load the texture (this part is running in parallel).
+            // Errors are reported through the future, as finished tasks are not kept.
+            try
+            {
+                std::shared_lock<std::shared_mutex> lock(mUploadMutex);
+                pPromise->set_value(Texture::createFromFile(filename, generateMipLevels, loadAsSrgb, bindFlags));
+            }
+            catch (...)
+            {
+                pPromise->set_exception(std::current_exception());
+            }
+
+            // Issue a global flush if necessary. The exclusive lock waits for uploads in progress on other threads.
+            // TODO: It would be better to check the size of the upload heap instead.
+            if (++mUploadCounter % kUploadsPerFlush == 0)
+            {
+                std::unique_lock<std::shared_mutex> lock(mUploadMutex);
+                gpDevice->flushAndSync();
+            }
         });
 
-        // Start worker threads.
-        for (size_t i = 0; i < threadCount; ++i)
-        {
-            mThreads.emplace_back([&, barrier] () {
-                while (true)
-                {
-                    // Wait on condition until more work is ready.
-                    std::unique_lock<std::mutex> lock(mMutex);
-                    mCondition.wait(lock, [&] () { return mTerminate || !mRequestQueue.empty() || mFlushPending; });
-
-                    // Sync thread if a flush is pending.
-                    if (mFlushPending)
-                    {
-                        lock.unlock();
-                        barrier->wait();
-                        mCondition.notify_one();
-                        continue;
-                    }
-
-                    // Terminate thread unless there is more work to do.
-                    if (mTerminate && mRequestQueue.empty() && !mFlushPending) break;
-
-                    // Go back waiting if queue is currently empty.
-                    if (mRequestQueue.empty()) continue;
-
-                    // Pop next loading request from queue.
-                    auto request = std::move(mRequestQueue.front());
-                    mRequestQueue.pop();
-
-                    lock.unlock();
-
-                    // Load the textures (this part is running in parallel).
-                    Texture::SharedPtr pTexture = Texture::createFromFile(request.filename, request.generateMipLevels, request.loadAsSrgb, request.bindFlags);
-                    request.promise.set_value(pTexture);
-
-                    lock.lock();
-
-                    // Issue a global flush if necessary.
-                    // TODO: It would be better to check the size of the upload heap instead.
-                    if (!mTerminate && ++mUploadCounter >= kUploadsPerFlush)
-                    {
-                        mFlushPending = true;
-                        mCondition.notify_all();
-                    }
-
-                    mCondition.notify_one();
-                }
-            });
-        }
-    }
-
-    void AsyncTextureLoader::terminateWorkers()
-    {
-        {
-            std::lock_guard<std::mutex> lock(mMutex);
-            mTerminate = true;
-        }
-
-        mCondition.notify_all();
-
-        for (auto& thread : mThreads) thread.join();
+        // Drop the handles of finished tasks, so the list only grows with the number of loads in flight.
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.erase(std::remove_if(mTasks.begin(), mTasks.end(), [] (const Threading::Task& t) { return !t.isRunning(); }), mTasks.end());
+        mTasks.push_back(task);
+        return future;
     }
 }
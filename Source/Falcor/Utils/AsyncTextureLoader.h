@@ -27,19 +27,17 @@
  **************************************************************************/
 #pragma once
 #include <future>
+#include <shared_mutex>
 #include "Falcor.h"
 
 namespace Falcor
 {
-    /** Utility class to load textures asynchronously using multiple worker threads.
+    /** Utility class to load textures asynchronously on the global thread pool.
     */
     class dlldecl AsyncTextureLoader
     {
     public:
-        /** Constructor.
-            \param[in] threadCount Number of worker threads.
-        */
-        AsyncTextureLoader(size_t threadCount = std::thread::hardware_concurrency());
+        AsyncTextureLoader() = default;
 
         /** Destructor.
             Blocks until all textures are loaded.
@@ -56,24 +54,9 @@ namespace Falcor
         std::future<Texture::SharedPtr> loadFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource);
 
     private:
-        void runWorkers(size_t threadCount);
-        void terminateWorkers();
-
-        struct Request
-        {
-            std::string filename;
-            bool generateMipLevels;
-            bool loadAsSrgb;
-            Resource::BindFlags bindFlags;
-            std::promise<Texture::SharedPtr> promise;
-        };
-
-        std::queue<Request> mRequestQueue;      ///< Texture loading request queue.
-        std::condition_variable mCondition;     ///< Condition variable for workers to wait on.
-        std::mutex mMutex;                      ///< Mutex for synchronizing access to shared resources.
-        std::vector<std::thread> mThreads;      ///< Worker threads.
-        bool mTerminate = false;                ///< Flag to terminate worker threads.
-        bool mFlushPending = false;             ///< Flag to indicate a flush is pending.
-        uint32_t mUploadCounter = 0;            ///< Counter to issue a flush every few uploads.
+        std::vector<Threading::Task> mTasks;    ///< Loading tasks. Finished tasks are removed when new ones are added.
+        std::mutex mMutex;                      ///< Mutex for synchronizing access to the task list.
+        std::shared_mutex mUploadMutex;         ///< Held shared while loading textures and exclusively while flushing.
+        std::atomic<uint32_t> mUploadCounter = 0; ///< Counter to issue a flush every few uploads.
     };
 }
@@ -0,0 +1,75 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "Hash.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        // Primes from xxHash64.
+        const uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+        const uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+        const uint64_t kPrime4 = 0x85ebca77c2b2ae63ull;
+
+        uint64_t rotl(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        uint64_t mixWord(uint64_t hash, uint64_t word)
+        {
+            word = rotl(word * kPrime2, 31) * kPrime1;
+            return rotl(hash ^ word, 27) * kPrime1 + kPrime4;
+        }
+    }
+
+    uint64_t hashBytes(const void* pData, size_t size, uint64_t seed)
+    {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+        uint64_t hash = seed + kPrime1 + (uint64_t)size * kPrime2;
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, pBytes + i, sizeof(uint64_t));
+            hash = mixWord(hash, word);
+        }
+
+        // The remaining bytes are zero padded into a last word. The size is part of the initial value, so padding can't collide with zeros in the data.
+        if (i < size)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, pBytes + i, size - i);
+            hash = mixWord(hash, word);
+        }
+
+        return hashMix64(hash);
+    }
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "TextureReadback.h"
+
+namespace Falcor
+{
+    TextureReadback::SharedPtr TextureReadback::create(uint32_t stagingBufferCount)
+    {
+        if (stagingBufferCount == 0) throw std::exception("TextureReadback::create() - stagingBufferCount must be at least 1");
+        return SharedPtr(new TextureReadback(stagingBufferCount));
+    }
+
+    TextureReadback::TextureReadback(uint32_t stagingBufferCount)
+        : mStagingTasks(stagingBufferCount)
+    {
+        mpQueue = WorkQueue::create(stagingBufferCount);
+    }
+
+    TextureReadback::~TextureReadback()
+    {
+        // Destroying the queue waits for the pending callbacks while the staging buffers are still alive.
+        mpQueue = nullptr;
+    }
+
+    void TextureReadback::readTexture(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, const DataCallback& callback)
+    {
+        assert(pCtx && pTexture);
+
+        // Tasks finish in order, so once fewer than stagingBufferCount tasks are pending, the oldest staging buffer is free.
+        uint32_t stagingBufferCount = getStagingBufferCount();
+        mpQueue->wait(stagingBufferCount - 1);
+
+        auto& pTask = mStagingTasks[mNextStagingBuffer];
+        pTask = pCtx->asyncReadTextureSubresource(pTexture, subresourceIndex, pTask);
+        mNextStagingBuffer = (mNextStagingBuffer + 1) % stagingBufferCount;
+
+        mpQueue->push([pTask, callback] ()
+        {
+            callback(pTask->getData());
+        });
+    }
+
+    void TextureReadback::flush()
+    {
+        mpQueue->flush();
+    }
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/API/CopyContext.h"
+#include "Utils/WorkQueue.h"
+
+namespace Falcor
+{
+    /** Asynchronous texture readback for capturing frames without stalling the render thread.
+        Each readback records a copy into one of a ring of staging buffers and signals a fence, but does not wait for it.
+        The data is consumed on a dedicated worker thread, which waits for the fence and then calls a user callback,
+        e.g. to encode a video frame or write an image. Callbacks are called in submission order.
+        Staging buffers are recycled once their data has been consumed. If all of them are in flight, readTexture()
+        blocks until the oldest one is done, which bounds the memory and latency of the capture.
+    */
+    class dlldecl TextureReadback
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TextureReadback>;
+
+        /** Callback receiving the tightly packed texture data on the worker thread.
+        */
+        using DataCallback = std::function<void(const std::vector<uint8_t>& data)>;
+
+        static const uint32_t kDefaultStagingBufferCount = 3;
+
+        /** Create a readback object.
+            \param[in] stagingBufferCount Number of staging buffers, i.e. the maximum number of readbacks in flight.
+            \return A new object.
+        */
+        static SharedPtr create(uint32_t stagingBufferCount = kDefaultStagingBufferCount);
+
+        /** Destructor. Waits for all pending readbacks to finish.
+        */
+        ~TextureReadback();
+
+        /** Read a texture subresource asynchronously.
+            Blocks only if all staging buffers are in flight.
+            \param[in] pCtx Context to record the copy on. The context is flushed, but the call does not wait for the GPU.
+            \param[in] pTexture Texture to read.
+            \param[in] subresourceIndex Subresource to read.
+            \param[in] callback Function to call with the data once the copy has finished.
+        */
+        void readTexture(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex, const DataCallback& callback);
+
+        /** Wait for all pending readbacks and callbacks to finish.
+            Rethrows the first exception thrown by a callback.
+        */
+        void flush();
+
+        /** Get the number of staging buffers.
+        */
+        uint32_t getStagingBufferCount() const { return (uint32_t)mStagingTasks.size(); }
+
+        /** Get the number of readbacks that are in flight or whose callback has not finished yet.
+        */
+        uint32_t getPendingCount() const { return mpQueue->getPendingCount(); }
+
+    private:
+        TextureReadback(uint32_t stagingBufferCount);
+
+        std::vector<CopyContext::ReadTextureTask::SharedPtr> mStagingTasks;     ///< Last task issued for each staging buffer.
+        uint32_t mNextStagingBuffer = 0;
+        WorkQueue::SharedPtr mpQueue;
+    };
+}
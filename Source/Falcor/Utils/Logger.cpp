@@ -38,6 +38,7 @@ namespace Falcor
         Logger::Level sVerbosity = Logger::Level::Info;
 
 #if _LOG_ENABLED
+        std::mutex sLogMutex; // Serializes output of messages logged from multiple threads.
         bool sInitialized = false;
         FILE* sLogFile = nullptr;
 
@@ -99,6 +100,7 @@ namespace Falcor
     void Logger::shutdown()
     {
 #if _LOG_ENABLED
+        std::lock_guard<std::mutex> lock(sLogMutex);
         if(sLogFile)
         {
             fclose(sLogFile);
@@ -134,6 +136,7 @@ namespace Falcor
         if (level <= sVerbosity)
         {
             std::string s = getLogLevelString(level) + std::string(" ") + msg + "\n";
+            std::lock_guard<std::mutex> lock(sLogMutex);
 
             // Write to log file.
             printToLogFile(s);
@@ -30,98 +30,65 @@
 
 namespace Falcor
 {
-    AliasTable::SharedPtr AliasTable::create(std::vector<float> weights, std::mt19937& rng)
+    namespace
     {
-        return SharedPtr(new AliasTable(std::move(weights), rng));
+        struct Item
+        {
+            float threshold;
+            uint32_t indexA;
+            uint32_t indexB;
+            uint32_t _pad;
+        };
     }
 
-    void AliasTable::setShaderData(const ShaderVar& var) const
+    AliasTable::SharedPtr AliasTable::create(std::vector<float> weights, std::mt19937& rng, bool parallelBuild)
     {
-        var["items"] = mpItems;
-        var["weights"] = mpWeights;
-        var["count"] = mCount;
-        var["weightSum"] = (float)mWeightSum;
+        return SharedPtr(new AliasTable(std::move(weights), rng, parallelBuild));
     }
 
-    AliasTable::AliasTable(std::vector<float> weights, std::mt19937& rng)
-        : mCount((uint32_t)weights.size())
+    bool AliasTable::updateWeights(const std::vector<uint32_t>& indices, const std::vector<float>& weights, std::mt19937& rng)
     {
-        if (weights.size() > std::numeric_limits<uint32_t>::max()) throw std::exception("Too many entries for alias table.");
+        if (!mBuilder.updateWeights(indices, weights)) return false;
 
-        std::uniform_int_distribution<uint32_t> rngDist;
+        // Upload the range of weights that changed.
+        auto [minIt, maxIt] = std::minmax_element(indices.begin(), indices.end());
+        const auto& allWeights = mBuilder.getWeights();
+        mpWeights->setBlob(allWeights.data() + *minIt, *minIt * sizeof(float), (*maxIt - *minIt + 1) * sizeof(float));
 
-        mpWeights = Buffer::createStructured(sizeof(float), mCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, weights.data());
-
-        mWeightSum = 0.0;
-        for (float f : weights) mWeightSum += f;
-
-        double factor = mCount / mWeightSum;
-        for (float& f : weights) f = (float)(f * factor);
-
-        std::vector<uint32_t> permutation(mCount);
-        for (uint32_t i = 0; i < mCount; ++i) permutation[i] = i;
-        std::sort(permutation.begin(), permutation.end(), [&](uint32_t a, uint32_t b) { return weights[a] < weights[b]; });
-
-        std::vector<float> thresholds(mCount);
-        std::vector<uint32_t> redirect(mCount);
-        std::vector<uint2> mergedTable(mCount);
-
-        uint32_t head = 0;
-        uint32_t tail = mCount - 1;
-
-        while (head != tail)
-        {
-            int i = permutation[head];
-            int j = permutation[tail];
-
-            thresholds[i] = weights[i];
-            redirect[i] = j;
-            weights[j] -= 1.f - weights[i];
-
-            if (head == tail - 1)
-            {
-                thresholds[j] = 1.f;
-                redirect[j] = j;
-                break;
-            }
-            else if (weights[j] < 1.f)
-            {
-                std::swap(permutation[head], permutation[tail]);
-                tail--;
-            }
-            else
-            {
-                head++;
-            }
-        }
+        mBuilder.shuffle(rng);
+        uploadItems();
+        return true;
+    }
 
-        for (uint32_t i = 0; i < mCount; ++i)
-        {
-            permutation[i] = i;
-        }
+    void AliasTable::setShaderData(const ShaderVar& var) const
+    {
+        var["items"] = mpItems;
+        var["weights"] = mpWeights;
+        var["count"] = getCount();
+        var["weightSum"] = (float)getWeightSum();
+    }
 
-        for (uint32_t i = 0; i < mCount; ++i)
-        {
-            uint32_t dst = i + (rngDist(rng) % (mCount - i));
-            std::swap(thresholds[i], thresholds[dst]);
-            std::swap(redirect[i], redirect[dst]);
-            std::swap(permutation[i], permutation[dst]);
-        }
+    AliasTable::AliasTable(std::vector<float> weights, std::mt19937& rng, bool parallelBuild)
+        : mBuilder(parallelBuild)
+    {
+        mBuilder.build(std::move(weights));
+        mBuilder.shuffle(rng);
 
-        struct Item
-        {
-            float threshold;
-            uint32_t indexA;
-            uint32_t indexB;
-            uint32_t _pad;
-        };
+        const uint32_t count = getCount();
+        mpWeights = Buffer::createStructured(sizeof(float), count, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, mBuilder.getWeights().data());
+        mpItems = Buffer::createStructured(sizeof(Item), count, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None);
+        uploadItems();
+    }
 
-        std::vector<Item> items(mCount);
-        for (uint32_t i = 0; i < mCount; ++i)
+    void AliasTable::uploadItems()
+    {
+        const auto& entries = mBuilder.getEntries();
+        std::vector<Item> items(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
         {
-            items[i] = { thresholds[i], redirect[i], permutation[i], 0 };
+            items[i] = { entries[i].threshold, entries[i].indexA, entries[i].indexB, 0 };
         }
 
-        mpItems = Buffer::createStructured(sizeof(Item), mCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, items.data());
+        mpItems->setBlob(items.data(), 0, items.size() * sizeof(Item));
     }
 }
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include "AliasTableBuilder.h"
 #include <random>
 
 namespace Falcor
@@ -41,9 +42,19 @@ namespace Falcor
             The weights don't need to be normalized to sum up to 1.
             \param[in] weights The weights we'd like to sample each entry proportional to.
             \param[in] rng The random number generator to use when creating the table.
+            \param[in] parallelBuild Use the parallel build for large tables.
             \returns The alias table.
         */
-        static SharedPtr create(std::vector<float> weights, std::mt19937& rng);
+        static SharedPtr create(std::vector<float> weights, std::mt19937& rng, bool parallelBuild = false);
+
+        /** Update a subset of the weights and rebuild the table in place.
+            The table is rebuilt on the CPU and uploaded into the existing GPU buffers.
+            \param[in] indices Indices of the weights to update.
+            \param[in] weights New weights. Must have the same size as indices.
+            \param[in] rng The random number generator to use when rebuilding the table.
+            \return True if any weight changed and the table was rebuilt, false otherwise.
+        */
+        bool updateWeights(const std::vector<uint32_t>& indices, const std::vector<float>& weights, std::mt19937& rng);
 
         /** Bind the alias table data to a given shader var.
             \param[in] var The shader variable to set the data into.
@@ -52,17 +63,18 @@ namespace Falcor
 
         /** Get the number of weights in the table.
         */
-        uint32_t getCount() const { return mCount; }
+        uint32_t getCount() const { return mBuilder.getCount(); }
 
         /** Get the total sum of all weights in the table.
         */
-        double getWeightSum() const { return mWeightSum; }
+        double getWeightSum() const { return mBuilder.getWeightSum(); }
 
     private:
-        AliasTable(std::vector<float> weights, std::mt19937& rng);
+        AliasTable(std::vector<float> weights, std::mt19937& rng, bool parallelBuild);
+
+        void uploadItems();
 
-        uint32_t mCount;                    ///< Number of items in the alias table.
-        double mWeightSum;                  ///< Total weight of all elements used to create the alias table.
+        AliasTableBuilder mBuilder;         ///< CPU alias table builder. Holds the weights and table entries.
         Buffer::SharedPtr mpItems;          ///< Buffer containing table items.
         Buffer::SharedPtr mpWeights;        ///< Buffer containing item weights.
     };
@@ -0,0 +1,292 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "AliasTableBuilder.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kParallelBuildThreshold = 1 << 18;   ///< Minimum number of items for using the parallel build.
+        const uint32_t kChunkSize = 1 << 16;                ///< Number of items per chunk (and light items per partition) in the parallel build.
+
+        /** Calls a function for consecutive chunks of the range [0, count), optionally in parallel.
+            The function is called as func(chunkIndex, begin, end).
+        */
+        template<typename Func>
+        void forEachChunk(uint32_t count, bool parallel, const Func& func)
+        {
+            const uint32_t chunkCount = div_round_up(count, kChunkSize);
+            auto run = [&](uint32_t chunk)
+            {
+                const uint32_t begin = chunk * kChunkSize;
+                func(chunk, begin, count - begin > kChunkSize ? begin + kChunkSize : count);
+            };
+            if (parallel) Threading::parallelFor(0, chunkCount, run, 1);
+            else for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) run(chunk);
+        }
+    }
+
+    void AliasTableBuilder::build(std::vector<float> weights)
+    {
+        if (weights.size() > std::numeric_limits<uint32_t>::max()) throw std::exception("Too many entries for alias table.");
+
+        mWeights = std::move(weights);
+        buildEntries();
+    }
+
+    bool AliasTableBuilder::updateWeights(const std::vector<uint32_t>& indices, const std::vector<float>& weights)
+    {
+        if (indices.size() != weights.size()) throw std::exception("Alias table weight update has mismatching index and weight counts.");
+
+        bool changed = false;
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            const uint32_t index = indices[i];
+            if (index >= mWeights.size()) throw std::exception("Alias table weight index is out of range.");
+            if (mWeights[index] != weights[i])
+            {
+                mWeights[index] = weights[i];
+                changed = true;
+            }
+        }
+
+        if (changed) buildEntries();
+        return changed;
+    }
+
+    void AliasTableBuilder::shuffle(std::mt19937& rng)
+    {
+        std::uniform_int_distribution<uint32_t> rngDist;
+
+        const uint32_t count = getCount();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t dst = i + (rngDist(rng) % (count - i));
+            std::swap(mEntries[i], mEntries[dst]);
+        }
+    }
+
+    void AliasTableBuilder::buildEntries()
+    {
+        const uint32_t count = getCount();
+        const uint32_t chunkCount = div_round_up(count, kChunkSize);
+        const bool parallel = mParallel && count >= kParallelBuildThreshold;
+
+        mEntries.resize(count);
+        mScaledWeights.resize(count);
+
+        // Compute the weight sum. The parallel build combines the per-chunk sums in order to get a deterministic result.
+        mWeightSum = 0.0;
+        if (parallel)
+        {
+            std::vector<double> chunkSums(chunkCount);
+            forEachChunk(count, true, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+            {
+                double sum = 0.0;
+                for (uint32_t i = begin; i < end; ++i) sum += mWeights[i];
+                chunkSums[chunk] = sum;
+            });
+            for (double sum : chunkSums) mWeightSum += sum;
+        }
+        else
+        {
+            for (float w : mWeights) mWeightSum += w;
+        }
+
+        // Each entry samples its own item if there is nothing to distribute (empty table or all weights zero).
+        auto setIdentityEntries = [&]()
+        {
+            forEachChunk(count, parallel, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; ++i) mEntries[i] = { 1.f, i, i };
+            });
+        };
+
+        if (!(mWeightSum > 0.0))
+        {
+            setIdentityEntries();
+            return;
+        }
+
+        // Normalize the weights to sum up to the item count and count the light items in each chunk.
+        const double factor = count / mWeightSum;
+        std::vector<uint32_t> chunkLightOffsets(chunkCount);
+        forEachChunk(count, parallel, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+        {
+            uint32_t lightCount = 0;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                mScaledWeights[i] = (float)(mWeights[i] * factor);
+                if (mScaledWeights[i] < 1.f) lightCount++;
+            }
+            chunkLightOffsets[chunk] = lightCount;
+        });
+
+        uint32_t lightCount = 0;
+        for (auto& offset : chunkLightOffsets)
+        {
+            uint32_t chunkLightCount = offset;
+            offset = lightCount;
+            lightCount += chunkLightCount;
+        }
+        const uint32_t heavyCount = count - lightCount;
+
+        // All items can end up light due to rounding when the weights are (almost) uniform.
+        if (heavyCount == 0)
+        {
+            setIdentityEntries();
+            return;
+        }
+
+        // Classify the items into light and heavy items, keeping both lists in index order.
+        mLightItems.resize(lightCount);
+        mHeavyItems.resize(heavyCount);
+        forEachChunk(count, parallel, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+        {
+            uint32_t lightIndex = chunkLightOffsets[chunk];
+            uint32_t heavyIndex = begin - lightIndex;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (mScaledWeights[i] < 1.f) mLightItems[lightIndex++] = i;
+                else mHeavyItems[heavyIndex++] = i;
+            }
+        });
+
+        // The light items are swept in partitions of kChunkSize items. Each partition starts at the heavy item the
+        // sequential sweep would be at, with the same residual weight. The heavy item j in use when reaching light item i
+        // is the first one whose cumulative surplus sum(w - 1) over heavy items [0..j] covers the cumulative
+        // deficit sum(1 - w) over light items [0..i). Its residual weight is what is left after covering that deficit.
+        struct PartitionStart
+        {
+            uint32_t heavyIndex;
+            double residual;
+        };
+
+        // The light item thresholds are stored as floats, so their deficits are computed from the rounded values.
+        // The heavy items use their weights at full precision, as a large weight would lose too much in the conversion.
+        auto heavyWeight = [&](uint32_t heavyIndex) { return mWeights[mHeavyItems[heavyIndex]] * factor; };
+
+        const uint32_t partitionCount = parallel ? std::max(1u, div_round_up(lightCount, kChunkSize)) : 1;
+        std::vector<PartitionStart> partitionStarts(partitionCount);
+        partitionStarts[0] = { 0, heavyWeight(0) };
+
+        if (partitionCount > 1)
+        {
+            // Compute the cumulative deficit at the start of each partition.
+            std::vector<double> partitionDeficits(partitionCount);
+            forEachChunk(lightCount, true, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+            {
+                double deficit = 0.0;
+                for (uint32_t i = begin; i < end; ++i) deficit += 1.0 - mScaledWeights[mLightItems[i]];
+                partitionDeficits[chunk] = deficit;
+            });
+
+            // Compute the cumulative surplus at the start of each chunk of heavy items.
+            std::vector<double> heavyChunkSurpluses(div_round_up(heavyCount, kChunkSize));
+            forEachChunk(heavyCount, true, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+            {
+                double surplus = 0.0;
+                for (uint32_t i = begin; i < end; ++i) surplus += heavyWeight(i) - 1.0;
+                heavyChunkSurpluses[chunk] = surplus;
+            });
+
+            double deficit = 0.0;
+            for (auto& d : partitionDeficits) { double sum = deficit + d; d = deficit; deficit = sum; }
+            double surplus = 0.0;
+            for (auto& s : heavyChunkSurpluses) { double sum = surplus + s; s = surplus; surplus = sum; }
+
+            Threading::parallelFor(1, partitionCount, [&](uint32_t partition)
+            {
+                const double partitionDeficit = partitionDeficits[partition];
+
+                // Find the last heavy chunk starting below the deficit and search it for the first heavy item covering the deficit.
+                // The search is clamped to the last heavy item to be robust against rounding errors.
+                auto it = std::lower_bound(heavyChunkSurpluses.begin(), heavyChunkSurpluses.end(), partitionDeficit);
+                uint32_t chunk = it == heavyChunkSurpluses.begin() ? 0 : (uint32_t)(it - heavyChunkSurpluses.begin()) - 1;
+
+                uint32_t j = chunk * kChunkSize;
+                double s = heavyChunkSurpluses[chunk];
+                while (j + 1 < heavyCount)
+                {
+                    double next = s + (heavyWeight(j) - 1.0);
+                    if (next >= partitionDeficit) break;
+                    s = next;
+                    j++;
+                }
+                partitionStarts[partition] = { j, heavyWeight(j) - (partitionDeficit - s) };
+            });
+        }
+
+        // Sweep the partitions.
+        auto sweep = [&](uint32_t partition)
+        {
+            const bool isLast = partition + 1 == partitionCount;
+            const uint32_t lightBegin = partition * kChunkSize;
+            const uint32_t lightEnd = isLast ? lightCount : lightBegin + kChunkSize;
+
+            // Heavy items before the limit are finished by this partition. The heavy item at the start of the next partition is finished by that partition.
+            const uint32_t heavyLimit = isLast ? heavyCount - 1 : partitionStarts[partition + 1].heavyIndex;
+            uint32_t j = partitionStarts[partition].heavyIndex;
+            double residual = partitionStarts[partition].residual;
+
+            // Fills the entry of the current heavy item with its residual weight and takes the rest from the next heavy item.
+            auto finishHeavy = [&]()
+            {
+                const uint32_t item = mHeavyItems[j];
+                mEntries[item] = { (float)std::clamp(residual, 0.0, 1.0), mHeavyItems[j + 1], item };
+                residual = heavyWeight(j + 1) - (1.0 - residual);
+                j++;
+            };
+
+            for (uint32_t i = lightBegin; i < lightEnd; ++i)
+            {
+                while (residual < 1.0 && j < heavyLimit) finishHeavy();
+
+                const uint32_t item = mLightItems[i];
+                mEntries[item] = { mScaledWeights[item], mHeavyItems[j], item };
+                residual -= 1.0 - mScaledWeights[item];
+            }
+
+            if (!isLast)
+            {
+                while (j < heavyLimit) finishHeavy();
+            }
+            else
+            {
+                while (residual < 1.0 && j < heavyLimit) finishHeavy();
+
+                // The remaining heavy items have a residual weight of one up to rounding errors.
+                for (; j < heavyCount; ++j) mEntries[mHeavyItems[j]] = { 1.f, mHeavyItems[j], mHeavyItems[j] };
+            }
+        };
+
+        if (partitionCount > 1) Threading::parallelFor(0, partitionCount, sweep, 1);
+        else sweep(0);
+    }
+}
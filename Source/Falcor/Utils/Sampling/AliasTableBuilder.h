@@ -0,0 +1,117 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <random>
+
+namespace Falcor
+{
+    /** CPU construction of alias tables for sampling from a discrete probability distribution.
+
+        The table is built with Vose's O(N) alias method. Items are classified into light (normalized weight < 1)
+        and heavy (normalized weight >= 1) items, which are then swept in index order. Each light item fills its
+        own table entry and the remainder is taken from the current heavy item. When a heavy item drops below 1,
+        its own entry is filled from the next heavy item.
+
+        The optional parallel build splits the light items into fixed-size partitions. The heavy item and its
+        residual weight at the start of each partition are found from prefix sums, so the partitions can be
+        swept independently. The result only depends on the input weights, not on the number of threads.
+
+        This class only does the math. Uploading the table to the GPU is left to the users (AliasTable, EmissivePowerSampler).
+    */
+    class dlldecl AliasTableBuilder
+    {
+    public:
+        /** Alias table entry. A table entry is selected uniformly at random and then
+            returns indexB if a uniform random number is below the threshold, or indexA otherwise.
+        */
+        struct Entry
+        {
+            float threshold;        ///< Probability of selecting indexB.
+            uint32_t indexA;        ///< Item selected when rnd >= threshold (the alias).
+            uint32_t indexB;        ///< Item selected when rnd < threshold.
+        };
+
+        /** Create an alias table builder.
+            \param[in] parallel Use the parallel build for large tables.
+        */
+        AliasTableBuilder(bool parallel = false) : mParallel(parallel) {}
+
+        /** Build the alias table from scratch.
+            The weights don't need to be normalized to sum up to 1.
+            \param[in] weights The weights we'd like to sample each entry proportional to.
+        */
+        void build(std::vector<float> weights);
+
+        /** Update a subset of the weights and rebuild the table in place.
+            The per-item storage is reused, so updating the weights of an existing table does not reallocate it.
+            \param[in] indices Indices of the weights to update.
+            \param[in] weights New weights. Must have the same size as indices.
+            \return True if any weight changed and the table was rebuilt, false otherwise.
+        */
+        bool updateWeights(const std::vector<uint32_t>& indices, const std::vector<float>& weights);
+
+        /** Randomly permute the table entries.
+            This does not affect the sampled distribution, but decorrelates neighboring table entries.
+            \param[in] rng The random number generator to use.
+        */
+        void shuffle(std::mt19937& rng);
+
+        /** Enable/disable the parallel build. Takes effect on the next (re)build.
+        */
+        void setParallel(bool parallel) { mParallel = parallel; }
+
+        /** Get the number of items in the table.
+        */
+        uint32_t getCount() const { return (uint32_t)mWeights.size(); }
+
+        /** Get the total sum of all weights in the table.
+        */
+        double getWeightSum() const { return mWeightSum; }
+
+        /** Get the original (unnormalized) weights.
+        */
+        const std::vector<float>& getWeights() const { return mWeights; }
+
+        /** Get the table entries.
+        */
+        const std::vector<Entry>& getEntries() const { return mEntries; }
+
+    private:
+        void buildEntries();
+
+        bool mParallel;                     ///< Use the parallel build for large tables.
+        double mWeightSum = 0.0;            ///< Total weight of all items.
+        std::vector<float> mWeights;        ///< Original item weights.
+        std::vector<Entry> mEntries;        ///< Table entries.
+
+        // Scratch data kept between builds to avoid reallocations.
+        std::vector<float> mScaledWeights;  ///< Weights normalized to sum up to the item count.
+        std::vector<uint32_t> mLightItems;  ///< Indices of items with normalized weight < 1, in index order.
+        std::vector<uint32_t> mHeavyItems;  ///< Indices of items with normalized weight >= 1, in index order.
+    };
+}
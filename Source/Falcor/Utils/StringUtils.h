@@ -285,6 +285,15 @@ namespace Falcor
         return oss.str();
     }
 
+    /** Convert a 64-bit value to a hex string of 16 digits, padded with zeros.
+    */
+    inline std::string toHexString(uint64_t value)
+    {
+        std::ostringstream oss;
+        oss << std::hex << std::setw(16) << std::setfill('0') << value;
+        return oss.str();
+    }
+
     /** Convert an ASCII string to a UTF-8 wstring
     */
     inline std::wstring string_2_wstring(const std::string& s)
@@ -27,69 +27,378 @@
  **************************************************************************/
 #include "stdafx.h"
 #include "Threading.h"
+#include <atomic>
+#include <deque>
 
 namespace Falcor
 {
     namespace
     {
+        using Job = std::function<void()>;
+
+        const uint32_t kNoWorker = uint32_t(-1);
+
+        // Number of chunks per thread used by parallelFor() when no grain size is given. More chunks balance uneven work better.
+        const uint32_t kChunksPerThread = 8;
+
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
         struct ThreadingData
         {
-            bool initialized = false;
+            std::mutex startMutex;                      ///< Serializes start() and shutdown().
+            std::atomic<bool> initialized = false;
             std::vector<std::thread> threads;
-            uint32_t current;
-        } gData;
+            std::vector<std::unique_ptr<JobQueue>> workerQueues;
+            JobQueue globalQueue;                       ///< Jobs dispatched from threads outside the pool.
+
+            std::atomic<int32_t> queuedJobs = 0;        ///< Jobs waiting in any of the queues.
+            std::atomic<int32_t> pendingJobs = 0;       ///< Jobs queued or executing.
+            std::mutex sleepMutex;
+            std::condition_variable sleepCondition;     ///< Signaled when jobs are queued or the pool terminates.
+            std::condition_variable idleCondition;      ///< Signaled when all jobs have finished.
+            bool terminate = false;
+        };
+
+        // The pool is intentionally never destroyed, so worker threads never access freed data during process exit.
+        ThreadingData& getData()
+        {
+            static ThreadingData* pData = new ThreadingData();
+            return *pData;
+        }
+
+        thread_local uint32_t tWorkerIndex = kNoWorker;
+
+        void ensureStarted()
+        {
+            if (!getData().initialized.load(std::memory_order_acquire)) Threading::start();
+        }
+
+        void pushJob(Job job)
+        {
+            auto& data = getData();
+            data.pendingJobs++;
+            data.queuedJobs++;
+
+            JobQueue& queue = tWorkerIndex != kNoWorker ? *data.workerQueues[tWorkerIndex] : data.globalQueue;
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.jobs.push_back(std::move(job));
+            }
+
+            // Lock the mutex so a worker can't miss the notification between checking for jobs and going to sleep.
+            {
+                std::lock_guard<std::mutex> lock(data.sleepMutex);
+            }
+            data.sleepCondition.notify_one();
+        }
+
+        bool popJob(Job& job)
+        {
+            auto& data = getData();
+            if (data.queuedJobs.load(std::memory_order_relaxed) <= 0) return false;
+
+            auto tryPop = [&job] (JobQueue& queue, bool back)
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.jobs.empty()) return false;
+                if (back)
+                {
+                    job = std::move(queue.jobs.back());
+                    queue.jobs.pop_back();
+                }
+                else
+                {
+                    job = std::move(queue.jobs.front());
+                    queue.jobs.pop_front();
+                }
+                return true;
+            };
+
+            // Take the most recent job from the own queue, then the oldest jobs from the global queue and the other workers.
+            bool found = false;
+            const uint32_t workerCount = (uint32_t)data.workerQueues.size();
+            if (tWorkerIndex != kNoWorker) found = tryPop(*data.workerQueues[tWorkerIndex], true);
+            if (!found) found = tryPop(data.globalQueue, false);
+            uint32_t first = tWorkerIndex != kNoWorker ? tWorkerIndex + 1 : 0;
+            for (uint32_t i = 0; i < workerCount && !found; i++)
+            {
+                found = tryPop(*data.workerQueues[(first + i) % workerCount], false);
+            }
+
+            if (found) data.queuedJobs--;
+            return found;
+        }
+
+        void runJob(Job& job)
+        {
+            job();
+            job = nullptr;
+
+            auto& data = getData();
+            if (--data.pendingJobs == 0)
+            {
+                std::lock_guard<std::mutex> lock(data.sleepMutex);
+                data.idleCondition.notify_all();
+            }
+        }
+
+        /** Blocks until a condition is met. Worker threads execute other jobs while waiting to avoid deadlocks with nested tasks.
+            \param[in] isDone Returns true when done waiting.
+            \param[in] mutex Mutex protecting the condition, used by non-worker threads.
+            \param[in] condition Condition variable signaled when the condition changes, used by non-worker threads.
+        */
+        template<typename Predicate>
+        void waitUntil(Predicate isDone, std::mutex& mutex, std::condition_variable& condition)
+        {
+            if (tWorkerIndex != kNoWorker)
+            {
+                while (!isDone())
+                {
+                    Job job;
+                    if (popJob(job)) runJob(job);
+                    else std::this_thread::yield();
+                }
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, isDone);
+            }
+        }
+
+        void workerLoop(uint32_t workerIndex)
+        {
+            tWorkerIndex = workerIndex;
+            auto& data = getData();
+
+            while (true)
+            {
+                Job job;
+                if (popJob(job))
+                {
+                    runJob(job);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(data.sleepMutex);
+                data.sleepCondition.wait(lock, [&data] () { return data.terminate || data.queuedJobs > 0; });
+                if (data.terminate && data.queuedJobs <= 0) break;
+            }
+        }
     }
 
+    struct Threading::Task::State
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::atomic<bool> done = false;
+        std::vector<Job> continuations;
+        std::exception_ptr exception;
+
+        // Creates a job executing the function and completing this task.
+        static Job createJob(const std::shared_ptr<State>& pState, const std::function<void(void)>& func)
+        {
+            return [pState, func] ()
+            {
+                try
+                {
+                    func();
+                }
+                catch (...)
+                {
+                    pState->exception = std::current_exception();
+                }
+                pState->complete();
+            };
+        }
+
+        void complete()
+        {
+            std::vector<Job> jobs;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+                jobs.swap(continuations);
+            }
+            condition.notify_all();
+            for (auto& job : jobs) pushJob(std::move(job));
+        }
+    };
+
     void Threading::start(uint32_t threadCount)
     {
-        if (gData.initialized) return;
+        auto& data = getData();
+        std::lock_guard<std::mutex> lock(data.startMutex);
+        if (data.initialized) return;
 
-        gData.threads.resize(threadCount);
-        gData.initialized = true;
+        if (threadCount == 0) threadCount = std::max(1u, getLogicalThreadCount() - 1);
+
+        data.terminate = false;
+        data.workerQueues.resize(threadCount);
+        for (auto& pQueue : data.workerQueues) pQueue = std::make_unique<JobQueue>();
+        for (uint32_t i = 0; i < threadCount; i++) data.threads.emplace_back(workerLoop, i);
+        data.initialized.store(true, std::memory_order_release);
     }
 
     void Threading::shutdown()
     {
-        for (auto& t : gData.threads)
+        auto& data = getData();
+        std::lock_guard<std::mutex> lock(data.startMutex);
+        if (!data.initialized) return;
+
+        finish();
+
         {
-            if (t.joinable()) t.join();
+            std::lock_guard<std::mutex> sleepLock(data.sleepMutex);
+            data.terminate = true;
         }
+        data.sleepCondition.notify_all();
+        for (auto& thread : data.threads) thread.join();
+
+        data.threads.clear();
+        data.workerQueues.clear();
+        data.initialized = false;
+    }
 
-        gData.initialized = false;
+    void Threading::finish()
+    {
+        assert(!isWorkerThread());
+        auto& data = getData();
+        std::unique_lock<std::mutex> lock(data.sleepMutex);
+        data.idleCondition.wait(lock, [&data] () { return data.pendingJobs == 0; });
+    }
+
+    uint32_t Threading::getThreadCount()
+    {
+        ensureStarted();
+        return (uint32_t)getData().threads.size();
+    }
+
+    bool Threading::isWorkerThread()
+    {
+        return tWorkerIndex != kNoWorker;
     }
 
     Threading::Task Threading::dispatchTask(const std::function<void(void)>& func)
     {
-        assert(gData.initialized);
+        ensureStarted();
 
-        std::thread& t = gData.threads[gData.current];
-        if (t.joinable()) t.join();
-        t = std::thread(func);
-        gData.current = (gData.current + 1) % gData.threads.size();
+        auto pState = std::make_shared<Task::State>();
+        pushJob(Task::State::createJob(pState, func));
+        return Task(pState);
+    }
 
-        return Task();
+    void Threading::wait(std::vector<Task>& tasks)
+    {
+        for (auto& task : tasks) task.finish();
     }
 
-    void Threading::finish()
+    void Threading::parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& func, uint32_t grainSize)
     {
-        for (auto& t : gData.threads)
+        if (begin >= end) return;
+        ensureStarted();
+
+        const uint32_t count = end - begin;
+        const uint32_t threadCount = getThreadCount() + 1;
+        if (grainSize == 0) grainSize = std::max(1u, count / (threadCount * kChunksPerThread));
+        const uint32_t chunkCount = div_round_up(count, grainSize);
+
+        if (chunkCount == 1)
         {
-            if (t.joinable()) t.join();
+            for (uint32_t i = begin; i < end; i++) func(i);
+            return;
         }
+
+        // Helper jobs may start after the loop has finished, so the shared state is reference counted.
+        struct Context
+        {
+            std::function<void(uint32_t)> func;
+            uint32_t begin;
+            uint32_t end;
+            uint32_t grainSize;
+            uint32_t chunkCount;
+            std::atomic<uint32_t> nextChunk = 0;
+            std::atomic<uint32_t> finishedChunks = 0;
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::exception_ptr exception;
+
+            void run()
+            {
+                for (uint32_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+                {
+                    try
+                    {
+                        uint32_t chunkEnd = std::min(end, begin + (chunk + 1) * grainSize);
+                        for (uint32_t i = begin + chunk * grainSize; i < chunkEnd; i++) func(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!exception) exception = std::current_exception();
+                    }
+
+                    if (++finishedChunks == chunkCount)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        condition.notify_all();
+                    }
+                }
+            }
+        };
+
+        auto pContext = std::make_shared<Context>();
+        pContext->func = func;
+        pContext->begin = begin;
+        pContext->end = end;
+        pContext->grainSize = grainSize;
+        pContext->chunkCount = chunkCount;
+
+        uint32_t helperCount = std::min(chunkCount, threadCount) - 1;
+        for (uint32_t i = 0; i < helperCount; i++) pushJob([pContext] () { pContext->run(); });
+
+        pContext->run();
+        waitUntil([&pContext] () { return pContext->finishedChunks == pContext->chunkCount; }, pContext->mutex, pContext->condition);
+
+        if (pContext->exception) std::rethrow_exception(pContext->exception);
     }
 
-    Threading::Task::Task()
+    bool Threading::Task::isRunning() const
     {
+        return mpState && !mpState->done;
     }
 
-    bool Threading::Task::isRunning()
+    void Threading::Task::finish()
     {
-        logError("Threading::Task::isRunning() not implemented");
-        return true;
+        if (!mpState) return;
+
+        State& state = *mpState;
+        waitUntil([&state] () { return state.done.load(); }, state.mutex, state.condition);
+
+        if (state.exception) std::rethrow_exception(state.exception);
     }
 
-    void Threading::Task::finish()
+    Threading::Task Threading::Task::then(const std::function<void(void)>& func)
     {
-        logError("Threading::Task::finish() not implemented");
+        auto pNext = std::make_shared<State>();
+        Job job = State::createJob(pNext, func);
+
+        if (mpState)
+        {
+            std::unique_lock<std::mutex> lock(mpState->mutex);
+            if (!mpState->done)
+            {
+                mpState->continuations.push_back(std::move(job));
+                return Task(pNext);
+            }
+        }
+
+        ensureStarted();
+        pushJob(std::move(job));
+        return Task(pNext);
     }
 }
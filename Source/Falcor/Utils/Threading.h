@@ -29,44 +29,63 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace Falcor
 {
+    /** Global job system.
+        A persistent pool of worker threads executes dispatched tasks. Each worker has its own job queue, new jobs
+        dispatched from a worker are pushed to its queue and idle workers steal jobs from the other queues.
+        Threads waiting for tasks from within a worker execute other jobs in the meantime, so tasks can be nested.
+        The pool is started on first use if start() was not called before.
+    */
     class dlldecl Threading
     {
     public:
-        const static uint32_t kDefaultThreadCount = 16;
-
-        /** Handle to a dispatched task
-
-            TODO: Implementation
+        /** Handle to a dispatched task.
         */
-        class Task
+        class dlldecl Task
         {
         public:
+            /** Create an empty handle. An empty task is never running.
+            */
+            Task() = default;
+
             /** Check if task is still executing
             */
-            bool isRunning();
+            bool isRunning() const;
 
-            /** Wait for task to finish executing
+            /** Wait for task to finish executing.
+                Rethrows an exception thrown by the task.
             */
             void finish();
 
+            /** Dispatch a continuation that is started after this task has finished.
+                \param[in] func Function to execute.
+                \return Handle to the continuation.
+            */
+            Task then(const std::function<void(void)>& func);
+
         private:
-            Task();
+            struct State;
+            Task(std::shared_ptr<State> pState) : mpState(std::move(pState)) {}
+            std::shared_ptr<State> mpState;
             friend class Threading;
         };
 
-        /** Initializes the global thread pool
-            \param[in] threadCount Number of threads in the pool
+        /** Initializes the global thread pool.
+            \param[in] threadCount Number of worker threads. If zero, one less than the number of logical cores is used, leaving a core for the calling thread.
         */
-        static void start(uint32_t threadCount = kDefaultThreadCount);
+        static void start(uint32_t threadCount = 0);
 
-        /** Waits for all currently executing threads to finish
+        /** Waits for all dispatched tasks to finish.
+            Must not be called from a task.
         */
         static void finish();
 
-        /** Waits for all currently executing threads to finish and shuts down the thread pool
+        /** Waits for all dispatched tasks to finish and shuts down the thread pool
         */
         static void shutdown();
 
@@ -74,10 +93,33 @@ namespace Falcor
         */
         static uint32_t getLogicalThreadCount() { return std::thread::hardware_concurrency(); }
 
+        /** Returns the number of worker threads in the pool.
+        */
+        static uint32_t getThreadCount();
+
+        /** Returns true if called from one of the worker threads.
+        */
+        static bool isWorkerThread();
+
         /** Starts a task on an available thread.
             \return Handle to the task
         */
         static Task dispatchTask(const std::function<void(void)>& func);
+
+        /** Waits for a set of tasks to finish.
+            \param[in] tasks Tasks to wait for.
+        */
+        static void wait(std::vector<Task>& tasks);
+
+        /** Calls a function for each index in a range, distributing chunks of the range over the worker threads.
+            The calling thread participates and the call returns once all indices are processed.
+            An exception thrown by the function is rethrown after all chunks have finished.
+            \param[in] begin First index.
+            \param[in] end One past the last index.
+            \param[in] func Function to call for each index.
+            \param[in] grainSize Number of indices per chunk. If zero, a chunk size is chosen based on the range and thread count.
+        */
+        static void parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& func, uint32_t grainSize = 0);
     };
 
     /** Simple thread barrier class.
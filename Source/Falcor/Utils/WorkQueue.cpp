@@ -0,0 +1,129 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "WorkQueue.h"
+
+namespace Falcor
+{
+    WorkQueue::SharedPtr WorkQueue::create(uint32_t capacity)
+    {
+        if (capacity == 0) throw std::exception("WorkQueue::create() - capacity must be at least 1");
+        return SharedPtr(new WorkQueue(capacity));
+    }
+
+    WorkQueue::WorkQueue(uint32_t capacity)
+        : mCapacity(capacity)
+    {
+        mThread = std::thread(&WorkQueue::run, this);
+    }
+
+    WorkQueue::~WorkQueue()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskDone.wait(lock, [this] () { return mTasks.empty(); });
+            mStop = true;
+        }
+        mTaskAdded.notify_one();
+        mThread.join();
+
+        if (mpException)
+        {
+            try { std::rethrow_exception(mpException); }
+            catch (const std::exception& e) { logError(std::string("WorkQueue task failed: ") + e.what()); }
+            catch (...) { logError("WorkQueue task failed with an unknown exception"); }
+        }
+    }
+
+    void WorkQueue::push(const Task& task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (mTasks.size() >= mCapacity)
+            {
+                mStallCount++;
+                mTaskDone.wait(lock, [this] () { return mTasks.size() < mCapacity; });
+            }
+            mTasks.push_back(task);
+        }
+        mTaskAdded.notify_one();
+    }
+
+    void WorkQueue::wait(uint32_t maxPendingCount)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mTaskDone.wait(lock, [this, maxPendingCount] () { return mTasks.size() <= maxPendingCount; });
+    }
+
+    void WorkQueue::flush()
+    {
+        std::exception_ptr pException;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskDone.wait(lock, [this] () { return mTasks.empty(); });
+            std::swap(pException, mpException);
+        }
+        if (pException) std::rethrow_exception(pException);
+    }
+
+    uint32_t WorkQueue::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return (uint32_t)mTasks.size();
+    }
+
+    uint64_t WorkQueue::getStallCount() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStallCount;
+    }
+
+    void WorkQueue::run()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true)
+        {
+            mTaskAdded.wait(lock, [this] () { return mStop || !mTasks.empty(); });
+            if (mTasks.empty()) break;
+
+            // The task stays in the queue while executing so that it counts as pending, and is destroyed before
+            // waiting producers are notified. References to deque elements stay valid on push_back().
+            const Task& task = mTasks.front();
+            lock.unlock();
+
+            std::exception_ptr pException;
+            try { task(); }
+            catch (...) { pException = std::current_exception(); }
+
+            lock.lock();
+            if (pException && !mpException) mpException = pException;
+            mTasks.pop_front();
+            mTaskDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <exception>
+
+namespace Falcor
+{
+    /** Bounded FIFO queue of tasks executed in order on a dedicated worker thread.
+        Unlike the global thread pool, tasks never run concurrently with each other, which makes the queue suitable
+        for consumers that are not thread-safe or need their input in order, such as video encoders and file writers.
+        The number of pending tasks is bounded: push() blocks while the queue is full, so a producer that is faster
+        than the consumer is throttled instead of accumulating unbounded memory.
+    */
+    class dlldecl WorkQueue
+    {
+    public:
+        using SharedPtr = std::shared_ptr<WorkQueue>;
+        using Task = std::function<void(void)>;
+
+        /** Create a work queue and start its worker thread.
+            \param[in] capacity Maximum number of pending (queued or executing) tasks. Must be at least 1.
+            \return A new object.
+        */
+        static SharedPtr create(uint32_t capacity);
+
+        /** Destructor. Waits for all pending tasks to finish and stops the worker thread.
+        */
+        ~WorkQueue();
+
+        /** Append a task to the queue. Blocks while the queue is full.
+            \param[in] task Function to execute on the worker thread.
+        */
+        void push(const Task& task);
+
+        /** Block until at most the given number of tasks are pending.
+            \param[in] maxPendingCount Maximum number of pending tasks to return.
+        */
+        void wait(uint32_t maxPendingCount);
+
+        /** Block until all pending tasks have finished.
+            Rethrows the first exception thrown by a task since the last flush.
+        */
+        void flush();
+
+        /** Get the maximum number of pending tasks.
+        */
+        uint32_t getCapacity() const { return mCapacity; }
+
+        /** Get the number of tasks that are queued or executing.
+        */
+        uint32_t getPendingCount() const;
+
+        /** Get the number of push() calls that had to wait for the worker to make room.
+        */
+        uint64_t getStallCount() const;
+
+    private:
+        WorkQueue(uint32_t capacity);
+        void run();
+
+        const uint32_t mCapacity;
+        mutable std::mutex mMutex;
+        std::condition_variable mTaskAdded;     ///< Signaled when a task is pushed or the queue is stopped.
+        std::condition_variable mTaskDone;      ///< Signaled when a task has finished.
+        std::deque<Task> mTasks;                ///< Pending tasks. The front task is the one executing.
+        bool mStop = false;
+        uint64_t mStallCount = 0;
+        std::exception_ptr mpException;         ///< First exception thrown by a task.
+        std::thread mThread;
+    };
+}
@@ -41,6 +41,9 @@ namespace Mogwai
         const std::string kOutputs = "outputs";
         const std::string kCapture = "capture";
 
+        // Number of frames of an output that can be in flight between the GPU readback and the image writer before the render thread blocks.
+        const uint32_t kReadbackFrameCount = 2;
+
         template<typename T>
         std::vector<typename T::value_type::first_type> getFirstOfPair(const T& pair)
         {
@@ -137,8 +140,12 @@ namespace Mogwai
             assert(pTex);
             auto ext = Bitmap::getFileExtFromResourceFormat(pTex->getFormat());
             auto format = Bitmap::getFormatFromFileExtension(ext);
-            std::string filename = getOutputNamePrefix(pGraph->getOutputName(i)) + std::to_string(gpFramework->getGlobalClock().getFrame()) + "." + ext;
-            pTex->captureToFile(0, 0, filename, format);
+            std::string outputName = pGraph->getOutputName(i);
+            std::string filename = getOutputNamePrefix(outputName) + std::to_string(gpFramework->getGlobalClock().getFrame()) + "." + ext;
+
+            auto& pReadback = mReadbacks[outputName];
+            if (!pReadback) pReadback = TextureReadback::create(kReadbackFrameCount);
+            pTex->captureToFile(0, 0, filename, format, Bitmap::ExportFlags::None, pReadback.get());
         }
 
         if (mCaptureAllOutputs && !unmarkedOutputs.empty())
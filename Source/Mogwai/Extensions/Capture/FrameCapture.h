@@ -28,6 +28,7 @@
 #pragma once
 #include "../../Mogwai.h"
 #include "CaptureTrigger.h"
+#include "Utils/Image/TextureReadback.h"
 
 namespace Mogwai
 {
@@ -49,5 +50,6 @@ namespace Mogwai
         std::string graphFramesStr(const RenderGraph* pGraph);
 
         bool mCaptureAllOutputs = false;
+        std::unordered_map<std::string, TextureReadback::SharedPtr> mReadbacks; ///< Readback per output. Each writes its images on its own worker thread, so outputs are written in parallel.
     };
 }
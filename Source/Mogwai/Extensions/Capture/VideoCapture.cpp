@@ -43,6 +43,9 @@ namespace Mogwai
         const std::string kPrint = "print";
         const std::string kOutputs = "outputs";
 
+        // Number of frames that can be in flight between the GPU readback and the encoder before the render thread blocks.
+        const uint32_t kReadbackFrameCount = 4;
+
         Texture::SharedPtr createTextureForBlit(const Texture* pSource)
         {
             assert(pSource->getType() == Texture::Type::Texture2D);
@@ -107,13 +110,19 @@ namespace Mogwai
             d.filename = getOutputNamePrefix(outputName) + std::to_string(r.first) + "." + std::to_string(r.second) + "." + VideoEncoder::getSupportedContainerForCodec(d.codec)[0].ext;
             encoder.output = outputName;
             encoder.pEncoder = VideoEncoder::create(d);
+            encoder.pReadback = TextureReadback::create(kReadbackFrameCount);
             mEncoders.push_back(std::move(encoder));
         }
     }
 
     void VideoCapture::endRange(RenderGraph* pGraph, const Range& r)
     {
-        for (const auto& e : mEncoders) e.pEncoder->endCapture();
+        for (const auto& e : mEncoders)
+        {
+            e.pReadback->flush();
+            e.pEncoder->endCapture();
+        }
+        mEncoders.clear();
     }
 
     void VideoCapture::triggerFrame(RenderContext* pCtx, RenderGraph* pGraph, uint64_t frameID)
@@ -127,7 +136,8 @@ namespace Mogwai
                 pTex = e.pBlitTex;
             }
 
-            e.pEncoder->appendFrame(pCtx->readTextureSubresource(pTex.get(), 0).data());
+            VideoEncoder* pEncoder = e.pEncoder.get();
+            e.pReadback->readTexture(pCtx, pTex.get(), 0, [pEncoder] (const std::vector<uint8_t>& data) { pEncoder->appendFrame(data.data()); });
         }
     }
 
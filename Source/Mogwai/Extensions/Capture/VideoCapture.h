@@ -30,6 +30,7 @@
 #include "CaptureTrigger.h"
 #include "Utils/Video/VideoEncoderUI.h"
 #include "Utils/Video/VideoEncoder.h"
+#include "Utils/Image/TextureReadback.h"
 
 namespace Mogwai
 {
@@ -59,6 +60,7 @@ namespace Mogwai
             std::string output;
             VideoEncoder::UniquePtr pEncoder;
             Texture::SharedPtr pBlitTex;
+            TextureReadback::SharedPtr pReadback;   ///< Reads back frames and encodes them on a worker thread. Declared after pEncoder so it is destroyed first.
         };
         std::vector<EncodeData> mEncoders;
     };
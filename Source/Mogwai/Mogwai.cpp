@@ -68,6 +68,8 @@ namespace Mogwai
 
     void Renderer::onShutdown()
     {
+        if (!mOptions.recordPermutationsFile.empty()) Program::savePermutations(mOptions.recordPermutationsFile);
+
         resetEditor();
         gpDevice->flushAndSync(); // Need to do that because clearing the graphs will try to release some state objects which might be in use
         mGraphs.clear();
@@ -85,6 +87,10 @@ namespace Mogwai
         auto regBinding = [this](pybind11::module& m) {this->registerScriptBindings(m); };
         ScriptBindings::registerBinding(regBinding);
 
+        Program::setAsyncCompilation(mOptions.asyncShaderCompilation);
+        if (!mOptions.recordPermutationsFile.empty()) Program::setPermutationRecording(true);
+        if (!mOptions.prewarmFile.empty()) Program::loadPermutations(mOptions.prewarmFile);
+
         // Load script provided via command line.
         if (!mOptions.scriptFile.empty())
         {
@@ -672,6 +678,9 @@ int main(int argc, char** argv)
     args::Flag silentFlag(parser, "", "Starts Mogwai with a minimized window and disables mouse/keyboard input as well as error message dialogs.", {"silent"});
     args::ValueFlag<uint32_t> widthFlag(parser, "pixels", "Initial window width.", {"width"});
     args::ValueFlag<uint32_t> heightFlag(parser, "pixels", "Initial window height.", {"height"});
+    args::Flag asyncShadersFlag(parser, "", "Compile shader permutations in the background, keep rendering with the previous permutation until they are ready.", {"async-shaders"});
+    args::ValueFlag<std::string> recordPermutationsFlag(parser, "path", "Record the shader permutations compiled during the run and save them to a file on exit.", {"record-permutations"});
+    args::ValueFlag<std::string> prewarmFlag(parser, "path", "Shader permutations file to compile in the background at startup (see --record-permutations).", {"prewarm"});
     args::CompletionFlag completionFlag(parser, {"complete"});
 
     try
@@ -722,6 +731,9 @@ int main(int argc, char** argv)
 
     if (scriptFlag) options.scriptFile = args::get(scriptFlag);
     if (silentFlag) options.silentMode = true;
+    if (asyncShadersFlag) options.asyncShaderCompilation = true;
+    if (recordPermutationsFlag) options.recordPermutationsFile = args::get(recordPermutationsFlag);
+    if (prewarmFlag) options.prewarmFile = args::get(prewarmFlag);
 
     try
     {
@@ -72,6 +72,9 @@ namespace Mogwai
         struct Options
         {
             std::string scriptFile;
+            std::string prewarmFile;            ///< Program permutations to compile in the background at startup, see Program::loadPermutations().
+            std::string recordPermutationsFile; ///< File to save the program permutations compiled during the run to.
+            bool asyncShaderCompilation = false;
             bool silentMode = false;
         };
 
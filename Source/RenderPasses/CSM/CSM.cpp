@@ -616,7 +616,11 @@ void CSM::renderScene(RenderContext* pCtx)
 
     pCB->setBlob(&mCsmData, 0, sizeof(mCsmData));
     mpLightCamera->setProjectionMatrix(mCsmData.globalMat);
-    mpScene->rasterize(pCtx, mShadowPass.pState.get(), mShadowPass.pVars.get());
+
+    // All cascades are rendered in a single pass and lie within the global shadow frustum, so we cull against it.
+    // The near and far planes are ignored, as casters outside the depth range still cast shadows when depth clamping is enabled.
+    mpScene->cullMeshInstances({ InstanceBVH::Frustum::fromViewProj(mCsmData.globalMat, false) });
+    mpScene->rasterize(pCtx, mShadowPass.pState.get(), mShadowPass.pVars.get(), 0);
     //        mpCsmSceneRenderer->renderScene(pCtx, mShadowPass.pState.get(), mShadowPass.pVars.get(), mpLightCamera.get());
 }
 
@@ -132,6 +132,7 @@ void VBufferRaster::execute(RenderContext* pRenderContext, const RenderData& ren
     mpFbo->attachDepthStencilTarget(pDepth);
     mRaster.pState->setFbo(mpFbo); // Sets the viewport
 
-    // Rasterize the scene.
-    mpScene->rasterize(pRenderContext, mRaster.pState.get(), mRaster.pVars.get());
+    // Rasterize the mesh instances visible to the camera.
+    mpScene->cullMeshInstances({ InstanceBVH::Frustum::fromViewProj(mpScene->getCamera()->getViewProjMatrix()) });
+    mpScene->rasterize(pRenderContext, mRaster.pState.get(), mRaster.pVars.get(), 0);
 }
@@ -0,0 +1,104 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        bool waitFor(const std::function<bool()>& condition, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000))
+        {
+            auto end = std::chrono::steady_clock::now() + timeout;
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() > end) return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return true;
+        }
+
+        void appendToFile(const std::string& filePath, const std::string& text)
+        {
+            std::ofstream file(filePath, std::ios::app);
+            file << text;
+        }
+    }
+
+    CPU_TEST(FileMonitor_Updates)
+    {
+        std::string filePath = getTempFilename();
+        appendToFile(filePath, "");
+        std::atomic<uint32_t> updateCount = 0;
+        monitorFileUpdates(filePath, [&]() { updateCount++; });
+
+        // A burst of writes triggers the callback at least once.
+        for (uint32_t i = 0; i < 10; i++) appendToFile(filePath, std::to_string(i));
+        EXPECT(waitFor([&]() { return updateCount > 0; })) << "No update reported for " << filePath;
+        EXPECT_LE(updateCount, 10u);
+
+        // No callbacks after closing the file.
+        closeSharedFile(filePath);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        uint32_t closedCount = updateCount;
+        appendToFile(filePath, "closed");
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        EXPECT_EQ(updateCount, closedCount);
+
+        std::remove(filePath.c_str());
+    }
+
+    CPU_TEST(FileMonitor_MultipleFiles)
+    {
+        std::string filePathA = getTempFilename();
+        std::string filePathB = getTempFilename();
+        appendToFile(filePathA, "");
+        appendToFile(filePathB, "");
+        std::atomic<uint32_t> updateCountA = 0;
+        std::atomic<uint32_t> updateCountB = 0;
+        monitorFileUpdates(filePathA, [&]() { updateCountA++; });
+        monitorFileUpdates(filePathB, [&]() { updateCountB++; });
+
+        // Only the callback of the written file is called.
+        appendToFile(filePathB, "update");
+        EXPECT(waitFor([&]() { return updateCountB > 0; })) << "No update reported for " << filePathB;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        EXPECT_EQ(updateCountA, 0u);
+
+        appendToFile(filePathA, "update");
+        EXPECT(waitFor([&]() { return updateCountA > 0; })) << "No update reported for " << filePathA;
+
+        closeSharedFile(filePathA);
+        closeSharedFile(filePathB);
+        std::remove(filePathA.c_str());
+        std::remove(filePathB.c_str());
+    }
+}
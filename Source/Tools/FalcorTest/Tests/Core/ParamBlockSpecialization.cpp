@@ -0,0 +1,91 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    /** Test the specialized layout cache of parameter blocks with interface-type members.
+    */
+    GPU_TEST(ParamBlockSpecialization)
+    {
+        ctx.createProgram("Tests/Core/ParamBlockSpecialization.cs.slang", "main", Program::DefineList(), Shader::CompilerFlags::None);
+        ctx.allocateStructuredBuffer("result", 1);
+
+        auto pVersion = ctx.getProgram()->getActiveVersion();
+        auto pParams = ParameterBlock::create(pVersion->getReflector()->getParameterBlock("gParams"));
+
+        auto pValueA = ParameterBlock::create(pVersion, "ValueA");
+        pValueA["a"] = 3.f;
+        auto pValueB = ParameterBlock::create(pVersion, "ValueB");
+        pValueB["b"] = 5.f;
+
+        ParameterBlock::resetSpecializationStats();
+
+        // First specialization computes the layout.
+        pParams["value"] = pValueA;
+        EXPECT(pParams->updateSpecialization());
+        auto pLayoutA = pParams->getSpecializedReflector();
+        EXPECT(pLayoutA != nullptr);
+
+        // Unchanged arguments take the early out.
+        EXPECT(!pParams->updateSpecialization());
+        EXPECT_EQ(pParams->getSpecializedReflector(), pLayoutA);
+
+        // Switching to a new type computes a new layout, switching back hits the cache.
+        pParams["value"] = pValueB;
+        EXPECT(pParams->updateSpecialization());
+        auto pLayoutB = pParams->getSpecializedReflector();
+        EXPECT_NE(pLayoutB, pLayoutA);
+
+        pParams["value"] = pValueA;
+        EXPECT(pParams->updateSpecialization());
+        EXPECT_EQ(pParams->getSpecializedReflector(), pLayoutA);
+
+        // A second block of the same program version shares the cached layouts.
+        auto pOtherParams = ParameterBlock::create(pVersion->getReflector()->getParameterBlock("gParams"));
+        pOtherParams["value"] = pValueB;
+        EXPECT(pOtherParams->updateSpecialization());
+        EXPECT_EQ(pOtherParams->getSpecializedReflector(), pLayoutB);
+
+        auto stats = ParameterBlock::getSpecializationStats();
+        EXPECT_EQ(stats.cacheMisses, 2u);
+        EXPECT_EQ(stats.cacheHits, 2u);
+        EXPECT_EQ(stats.unchanged, 1u);
+
+        // Run the program with each concrete type bound.
+        ctx["gParams"] = pParams;
+        ctx.runProgram(1, 1, 1);
+        EXPECT_EQ(ctx.mapBuffer<const float>("result")[0], 3.f);
+        ctx.unmapBuffer("result");
+
+        pParams["value"] = pValueB;
+        ctx.runProgram(1, 1, 1);
+        EXPECT_EQ(ctx.mapBuffer<const float>("result")[0], 10.f);
+        ctx.unmapBuffer("result");
+    }
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <chrono>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        const std::string kShaderFile = "Tests/Core/ProgramCompileTests.cs.slang";
+
+        /** Enables asynchronous compilation for the lifetime of the object.
+        */
+        class AsyncCompilationScope
+        {
+        public:
+            AsyncCompilationScope() : mWasEnabled(Program::isAsyncCompilationEnabled()) { Program::setAsyncCompilation(true); }
+            ~AsyncCompilationScope() { Program::setAsyncCompilation(mWasEnabled); }
+        private:
+            bool mWasEnabled;
+        };
+
+        bool waitForActiveVersion(const Program* pProgram)
+        {
+            auto end = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+            while (pProgram->isActiveVersionPending())
+            {
+                if (std::chrono::steady_clock::now() > end) return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return true;
+        }
+
+        uint32_t runAndReadResult(GPUUnitTestContext& ctx)
+        {
+            ctx.runProgram();
+            uint32_t result = *ctx.mapBuffer<const uint32_t>("result");
+            ctx.unmapBuffer("result");
+            return result;
+        }
+    }
+
+    GPU_TEST(ProgramAsyncCompilation)
+    {
+        AsyncCompilationScope asyncScope;
+        auto statsBefore = Program::getCompileStats();
+
+        ctx.createProgram(kShaderFile, "main", { { "VALUE", "1" } });
+        ctx.allocateStructuredBuffer("result", 1);
+        EXPECT_EQ(runAndReadResult(ctx), 1u);
+
+        // Changing the defines keeps the previous version active until the new one is compiled.
+        Program* pProgram = ctx.getProgram();
+        auto pVersion1 = pProgram->getActiveVersion();
+        pProgram->addDefine("VALUE", "2");
+        auto pVersion = pProgram->getActiveVersion();
+        if (pProgram->isActiveVersionPending()) EXPECT(pVersion == pVersion1);
+
+        EXPECT(waitForActiveVersion(pProgram));
+        auto pVersion2 = pProgram->getActiveVersion();
+        EXPECT(pVersion2 != pVersion1);
+        EXPECT_EQ(pVersion2->getDefines().at("VALUE"), "2");
+        EXPECT(!pProgram->isCompiling());
+
+        // The program was compiled without specialization parameters, so its kernels were generated on the compile thread too.
+        EXPECT_EQ(runAndReadResult(ctx), 2u);
+
+        auto stats = Program::getCompileStats();
+        EXPECT_EQ(stats.versionsCompiled, statsBefore.versionsCompiled + 1);
+        EXPECT_GE(stats.versionsCompiledAsync, statsBefore.versionsCompiledAsync + 1);
+        EXPECT_GE(stats.kernelsCompiledAsync, statsBefore.kernelsCompiledAsync + 1);
+        EXPECT_GT(stats.stalls, statsBefore.stalls);
+        EXPECT_GE(stats.maxStallTime, 0.0);
+
+        // Switching back to a compiled version is immediate.
+        pProgram->addDefine("VALUE", "1");
+        EXPECT(!pProgram->isActiveVersionPending());
+        EXPECT(pProgram->getActiveVersion() == pVersion1);
+    }
+
+    GPU_TEST(ProgramPermutationPrewarm)
+    {
+        std::string filename = getTempFilename();
+
+        // Record the permutations used by a program.
+        Program::setPermutationRecording(true);
+        ctx.createProgram(kShaderFile, "main", { { "VALUE", "3" } });
+        ctx.getProgram()->getActiveVersion();
+        ctx.getProgram()->addDefine("VALUE", "4");
+        ctx.getProgram()->getActiveVersion();
+        Program::setPermutationRecording(false);
+        EXPECT(Program::savePermutations(filename));
+
+        // A new program with the same source compiles all recorded permutations on the compile threads on first use.
+        EXPECT(Program::loadPermutations(filename));
+        auto statsBefore = Program::getCompileStats();
+
+        ctx.createProgram(kShaderFile, "main", { { "VALUE", "3" } });
+        ctx.allocateStructuredBuffer("result", 1);
+        EXPECT_EQ(runAndReadResult(ctx), 3u);
+        ctx.getProgram()->addDefine("VALUE", "4");
+        EXPECT_EQ(runAndReadResult(ctx), 4u);
+
+        auto stats = Program::getCompileStats();
+        EXPECT_EQ(stats.versionsCompiled, statsBefore.versionsCompiled);
+        EXPECT_GE(stats.versionsCompiledAsync, statsBefore.versionsCompiledAsync + 2);
+
+        std::remove(filename.c_str());
+    }
+}
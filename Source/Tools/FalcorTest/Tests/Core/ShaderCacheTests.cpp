@@ -0,0 +1,285 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/Program/ShaderCache.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        namespace fs = std::filesystem;
+
+        /** Creates an empty cache directory for a test and removes it afterwards.
+        */
+        class TempDirectory
+        {
+        public:
+            TempDirectory(const std::string& name)
+                : mPath((fs::temp_directory_path() / name).string())
+            {
+                std::error_code ec;
+                fs::remove_all(mPath, ec);
+            }
+
+            ~TempDirectory()
+            {
+                std::error_code ec;
+                fs::remove_all(mPath, ec);
+            }
+
+            const std::string& getPath() const { return mPath; }
+
+        private:
+            std::string mPath;
+        };
+
+        ShaderCache::Key makeKey(uint32_t i)
+        {
+            return ShaderCache::KeyBuilder().add(std::string("key")).add(i).getKey();
+        }
+
+        /** Deterministic payload for a key, so that readers can validate what they get.
+        */
+        std::vector<uint8_t> makePayload(uint32_t i, size_t size)
+        {
+            std::vector<uint8_t> data(size);
+            for (size_t j = 0; j < size; j++) data[j] = (uint8_t)(i * 31 + j * 7);
+            return data;
+        }
+
+        void setLastUse(const std::string& filename, std::chrono::hours age)
+        {
+            fs::last_write_time(filename, fs::file_time_type::clock::now() - age);
+        }
+    }
+
+    CPU_TEST(ShaderCache_Keys)
+    {
+        auto key = [](const std::vector<std::string>& strings)
+        {
+            ShaderCache::KeyBuilder builder;
+            for (const auto& str : strings) builder.add(str);
+            return builder.getKey();
+        };
+
+        EXPECT(key({ "a", "b" }) == key({ "a", "b" }));
+        EXPECT(key({ "a", "b" }) != key({ "b", "a" }));
+        EXPECT(key({ "ab", "" }) != key({ "a", "b" }));
+        EXPECT(key({}) != key({ "" }));
+        EXPECT(makeKey(1) != makeKey(2));
+        EXPECT_EQ(makeKey(1).toString().size(), 32);
+
+        // Both halves of the key depend on the input.
+        auto k0 = makeKey(0);
+        auto k1 = makeKey(1);
+        EXPECT_NE(k0.hash[0], k1.hash[0]);
+        EXPECT_NE(k0.hash[1], k1.hash[1]);
+
+        // Flipping the same high bit in two words must change both halves of the key.
+        uint64_t words[2] = { 0x1234, 0x5678 };
+        auto k2 = ShaderCache::KeyBuilder().add(words).getKey();
+        words[0] ^= 1ull << 63;
+        words[1] ^= 1ull << 63;
+        auto k3 = ShaderCache::KeyBuilder().add(words).getKey();
+        EXPECT_NE(k2.hash[0], k3.hash[0]);
+        EXPECT_NE(k2.hash[1], k3.hash[1]);
+    }
+
+    CPU_TEST(ShaderCache_StoreLoad)
+    {
+        TempDirectory dir("FalcorShaderCacheTests_StoreLoad");
+        auto pCache = ShaderCache::create(dir.getPath());
+
+        std::vector<uint8_t> data;
+        EXPECT(!pCache->load(makeKey(0), data));
+        EXPECT(!pCache->contains(makeKey(0)));
+
+        auto payload = makePayload(0, 1000);
+        EXPECT(pCache->store(makeKey(0), payload.data(), payload.size()));
+        EXPECT(pCache->contains(makeKey(0)));
+        EXPECT(pCache->load(makeKey(0), data));
+        EXPECT(data == payload);
+        EXPECT(!pCache->load(makeKey(1), data));
+
+        // Empty payloads are valid entries.
+        EXPECT(pCache->store(makeKey(2), nullptr, 0));
+        EXPECT(pCache->load(makeKey(2), data));
+        EXPECT(data.empty());
+
+        // Replacing an entry.
+        auto payload2 = makePayload(3, 500);
+        EXPECT(pCache->store(makeKey(0), payload2.data(), payload2.size()));
+        EXPECT(pCache->load(makeKey(0), data));
+        EXPECT(data == payload2);
+
+        // Entries persist across cache instances.
+        auto pCache2 = ShaderCache::create(dir.getPath());
+        EXPECT(pCache2->load(makeKey(0), data));
+        EXPECT(data == payload2);
+        EXPECT_GT(pCache2->getSize(), payload2.size());
+
+        auto stats = pCache->getStats();
+        EXPECT_EQ(stats.hits, 3);
+        EXPECT_EQ(stats.misses, 2);
+        EXPECT_EQ(stats.stores, 3);
+        EXPECT_EQ(stats.corruptEntries, 0);
+
+        pCache->clear();
+        EXPECT_EQ(pCache->getSize(), 0);
+        EXPECT(!pCache->load(makeKey(0), data));
+    }
+
+    CPU_TEST(ShaderCache_CorruptEntries)
+    {
+        TempDirectory dir("FalcorShaderCacheTests_Corrupt");
+        auto pCache = ShaderCache::create(dir.getPath());
+        auto payload = makePayload(0, 256);
+        std::vector<uint8_t> data;
+
+        // Flipped payload byte.
+        EXPECT(pCache->store(makeKey(0), payload.data(), payload.size()));
+        {
+            std::fstream file(pCache->getEntryFilename(makeKey(0)), std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(-10, std::ios::end);
+            file.put('x');
+        }
+        EXPECT(!pCache->load(makeKey(0), data));
+        EXPECT(!pCache->contains(makeKey(0))) << "Corrupt entries should be removed";
+
+        // Truncated entry.
+        EXPECT(pCache->store(makeKey(1), payload.data(), payload.size()));
+        fs::resize_file(pCache->getEntryFilename(makeKey(1)), 100);
+        EXPECT(!pCache->load(makeKey(1), data));
+
+        // Entry stored under a different key.
+        EXPECT(pCache->store(makeKey(2), payload.data(), payload.size()));
+        fs::copy_file(pCache->getEntryFilename(makeKey(2)), pCache->getEntryFilename(makeKey(3)));
+        EXPECT(!pCache->load(makeKey(3), data));
+        EXPECT(pCache->load(makeKey(2), data));
+        EXPECT(data == payload);
+
+        auto stats = pCache->getStats();
+        EXPECT_EQ(stats.corruptEntries, 3);
+        EXPECT_EQ(stats.misses, 3);
+        EXPECT_EQ(stats.hits, 1);
+    }
+
+    CPU_TEST(ShaderCache_Eviction)
+    {
+        TempDirectory dir("FalcorShaderCacheTests_Eviction");
+        const size_t kPayloadSize = 1000;
+        auto pCache = ShaderCache::create(dir.getPath(), 10 * kPayloadSize);
+
+        // Fill the cache with entries of increasing age, the entry with index 0 is the oldest.
+        const uint32_t kCount = 8;
+        for (uint32_t i = 0; i < kCount; i++)
+        {
+            auto payload = makePayload(i, kPayloadSize);
+            EXPECT(pCache->store(makeKey(i), payload.data(), payload.size()));
+            setLastUse(pCache->getEntryFilename(makeKey(i)), std::chrono::hours(kCount - i));
+        }
+        EXPECT_EQ(pCache->getStats().evictions, 0);
+
+        // Using the oldest entry makes it the most recently used.
+        std::vector<uint8_t> data;
+        EXPECT(pCache->load(makeKey(0), data));
+
+        // Going over the limit evicts the least recently used entries.
+        for (uint32_t i = kCount; i < kCount + 3; i++)
+        {
+            auto payload = makePayload(i, kPayloadSize);
+            EXPECT(pCache->store(makeKey(i), payload.data(), payload.size()));
+        }
+
+        EXPECT_LE(pCache->getSize(), pCache->getMaxSize());
+        EXPECT_GT(pCache->getStats().evictions, 0);
+        EXPECT(pCache->contains(makeKey(0))) << "Recently used entry was evicted";
+        EXPECT(!pCache->contains(makeKey(1))) << "Least recently used entry was not evicted";
+        EXPECT(pCache->contains(makeKey(kCount + 2))) << "Newest entry was evicted";
+
+        // Lowering the limit evicts immediately.
+        pCache->setMaxSize(3 * kPayloadSize);
+        EXPECT_LE(pCache->getSize(), 3 * kPayloadSize);
+        EXPECT(pCache->contains(makeKey(kCount + 2)));
+    }
+
+    CPU_TEST(ShaderCache_Concurrent)
+    {
+        TempDirectory dir("FalcorShaderCacheTests_Concurrent");
+
+        // Each thread uses its own cache instance to mimic separate processes sharing the cache directory.
+        // All threads store and load the same small set of keys, and must never observe a partial or mismatching entry.
+        const uint32_t kThreadCount = 8;
+        const uint32_t kKeyCount = 16;
+        const uint32_t kIterations = 200;
+
+        std::atomic<uint32_t> badPayloads = 0;
+        std::atomic<uint32_t> failedStores = 0;
+        std::atomic<uint64_t> corruptEntries = 0;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                // Tight size limit so that eviction runs concurrently with loads and stores.
+                auto pCache = ShaderCache::create(dir.getPath(), kKeyCount * 2000);
+                std::vector<uint8_t> data;
+                for (uint32_t i = 0; i < kIterations; i++)
+                {
+                    uint32_t k = (i * 7 + t * 3) % kKeyCount;
+                    size_t size = 1000 + k * 100;
+                    if (pCache->load(makeKey(k), data))
+                    {
+                        if (data != makePayload(k, size)) badPayloads++;
+                    }
+                    else
+                    {
+                        auto payload = makePayload(k, size);
+                        // Storing may fail on platforms that can't replace files that are open in another thread.
+                        if (!pCache->store(makeKey(k), payload.data(), payload.size())) failedStores++;
+                    }
+                }
+                corruptEntries += pCache->getStats().corruptEntries;
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        EXPECT_EQ(badPayloads.load(), 0u);
+        EXPECT_EQ(corruptEntries.load(), 0ull);
+        EXPECT_LT(failedStores.load(), kThreadCount * kIterations);
+
+        // No temporary files are left behind.
+        for (const auto& entry : fs::directory_iterator(dir.getPath()))
+        {
+            EXPECT(entry.path().extension() == ".shadercache") << entry.path().string();
+        }
+    }
+}
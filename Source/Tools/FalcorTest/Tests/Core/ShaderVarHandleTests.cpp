@@ -0,0 +1,136 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kValueCount = 150;
+        const uint32_t kCountCount = 50;
+
+        std::string getParamName(const char* prefix, uint32_t index)
+        {
+            return prefix + std::to_string(index / 10) + std::to_string(index % 10);
+        }
+
+        bool isSameVar(const ShaderVar& a, const ShaderVar& b)
+        {
+            return a.isValid() && b.isValid() && a.getOffset() == b.getOffset() && *a.getType() == *b.getType();
+        }
+    }
+
+    GPU_TEST(ShaderVarHandle)
+    {
+        ctx.createProgram("Tests/Core/ShaderVarHandleTests.cs.slang", "main", Program::DefineList(), Shader::CompilerFlags::None);
+        ctx.allocateStructuredBuffer("result", 4);
+        ShaderVar var = ctx.vars().getRootVar();
+
+        ShaderVarHandle firstValue(var, "PerFrameCB.gValue00");
+        ShaderVarHandle lastValue(var, "PerFrameCB.gValue149");
+        ShaderVarHandle lastCount(var, "gCount49");
+        ShaderVarHandle lightIntensity(var, "LightCB.gLights[2].intensity");
+        EXPECT(firstValue.isValid());
+        EXPECT(lastValue.isValid());
+        EXPECT(lastCount.isValid());
+        EXPECT(lightIntensity.isValid());
+        EXPECT_EQ(lightIntensity.getPath(), "LightCB.gLights[2].intensity");
+
+        // Handles resolve to the same variables as string lookups.
+        EXPECT(isSameVar(var[firstValue], var["PerFrameCB"]["gValue00"]));
+        EXPECT(isSameVar(var[lastValue], var["PerFrameCB"]["gValue149"]));
+        EXPECT(isSameVar(var[lastCount], var["gCount49"]));
+        EXPECT(isSameVar(var[lightIntensity], var["LightCB"]["gLights"][2]["intensity"]));
+
+        // Handles resolved against a constant buffer are relative to its contents.
+        ShaderVarHandle lightColor(var["LightCB"], "gLights[1].color");
+        EXPECT(isSameVar(var["LightCB"][lightColor], var["LightCB"]["gLights"][1]["color"]));
+
+        var[firstValue] = float4(1.f, 2.f, 3.f, 4.f);
+        var[lastValue] = float4(5.f, 6.f, 7.f, 8.f);
+        var[lastCount] = 9u;
+        var[lightIntensity] = 10.f;
+        ctx.runProgram(1, 1, 1);
+
+        const float* result = ctx.mapBuffer<const float>("result");
+        EXPECT_EQ(result[0], 1.f);
+        EXPECT_EQ(result[1], 8.f);
+        EXPECT_EQ(result[2], 9.f);
+        EXPECT_EQ(result[3], 10.f);
+        ctx.unmapBuffer("result");
+    }
+
+    GPU_TEST(ShaderVarHandle_Benchmark)
+    {
+        ctx.createProgram("Tests/Core/ShaderVarHandleTests.cs.slang", "main", Program::DefineList(), Shader::CompilerFlags::None);
+        ShaderVar var = ctx.vars().getRootVar();
+
+        std::vector<std::string> valueNames, countNames;
+        for (uint32_t i = 0; i < kValueCount; i++) valueNames.push_back(getParamName("gValue", i));
+        for (uint32_t i = 0; i < kCountCount; i++) countNames.push_back(getParamName("gCount", i));
+
+        std::vector<ShaderVarHandle> valueHandles, countHandles;
+        for (const auto& name : valueNames) valueHandles.emplace_back(var, "PerFrameCB." + name);
+        for (const auto& name : countNames) countHandles.emplace_back(var, name);
+
+        // Measure without validation, which would add a string lookup to every handle access.
+        bool validation = ShaderVarHandle::isValidationEnabled();
+        ShaderVarHandle::setValidationEnabled(false);
+
+        const uint32_t frameCount = 1000;
+        CpuTimer timer;
+
+        timer.update();
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            auto cb = var["PerFrameCB"];
+            for (uint32_t i = 0; i < kValueCount; i++) cb[valueNames[i]] = float4((float)frame);
+            for (uint32_t i = 0; i < kCountCount; i++) var[countNames[i]] = frame;
+        }
+        timer.update();
+        double stringTime = timer.delta() * 1000.0 / frameCount;
+
+        timer.update();
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            for (uint32_t i = 0; i < kValueCount; i++) var[valueHandles[i]] = float4((float)frame);
+            for (uint32_t i = 0; i < kCountCount; i++) var[countHandles[i]] = frame;
+        }
+        timer.update();
+        double handleTime = timer.delta() * 1000.0 / frameCount;
+
+        ShaderVarHandle::setValidationEnabled(validation);
+
+        logInfo("ShaderVarHandle: setting " + std::to_string(kValueCount + kCountCount) + " parameters took " + std::to_string(stringTime) + " ms/frame with string lookups and " +
+            std::to_string(handleTime) + " ms/frame with handles (" + std::to_string(stringTime / handleTime) + "x)");
+
+        // Both paths write the same variables.
+        EXPECT(isSameVar(var[valueHandles.back()], var["PerFrameCB"][valueNames.back()]));
+        EXPECT(isSameVar(var[countHandles.back()], var[countNames.back()]));
+    }
+}
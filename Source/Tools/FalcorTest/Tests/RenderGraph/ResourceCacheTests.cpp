@@ -0,0 +1,170 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "RenderGraph/ResourceCache.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        ResourceCache::ResourceDesc createTextureDesc(uint32_t width, uint32_t height, ResourceFormat format)
+        {
+            ResourceCache::ResourceDesc desc;
+            desc.type = RenderPassReflection::Field::Type::Texture2D;
+            desc.width = width;
+            desc.height = height;
+            desc.depth = 1;
+            desc.sampleCount = 1;
+            desc.arraySize = 1;
+            desc.mipLevels = 1;
+            desc.format = format;
+            desc.bindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess;
+            return desc;
+        }
+
+        /** Verifies that resources sharing an allocation have identical descs and non-overlapping lifetimes.
+        */
+        void verifyPlan(CPUUnitTestContext& ctx, const std::vector<ResourceCache::ResourceUsage>& resources, const ResourceCache::MemoryPlan& plan)
+        {
+            EXPECT_EQ(plan.allocationIndices.size(), resources.size());
+            for (size_t i = 0; i < resources.size(); i++)
+            {
+                for (size_t j = i + 1; j < resources.size(); j++)
+                {
+                    if (plan.allocationIndices[i] != plan.allocationIndices[j]) continue;
+                    const auto& a = resources[i];
+                    const auto& b = resources[j];
+                    EXPECT(a.transient && b.transient) << "resources " << i << " and " << j;
+                    EXPECT(a.desc == b.desc) << "resources " << i << " and " << j;
+                    EXPECT(a.lifetime.second < b.lifetime.first || b.lifetime.second < a.lifetime.first) << "resources " << i << " and " << j;
+                }
+            }
+
+            uint64_t unaliasedMemory = 0;
+            for (const auto& r : resources) unaliasedMemory += r.desc.getSizeInBytes();
+            EXPECT_EQ(plan.unaliasedMemory, unaliasedMemory);
+
+            uint64_t aliasedMemory = 0;
+            for (auto size : plan.allocationSizes) aliasedMemory += size;
+            EXPECT_EQ(plan.aliasedMemory, aliasedMemory);
+        }
+    }
+
+    CPU_TEST(ResourceCache_ResourceDescSize)
+    {
+        EXPECT_EQ(createTextureDesc(1920, 1080, ResourceFormat::RGBA32Float).getSizeInBytes(), 1920ull * 1080 * 16);
+        EXPECT_EQ(createTextureDesc(256, 256, ResourceFormat::BC1Unorm).getSizeInBytes(), 64ull * 64 * 8);
+
+        auto desc = createTextureDesc(4, 4, ResourceFormat::R8Unorm);
+        desc.mipLevels = Texture::kMaxPossible;
+        EXPECT_EQ(desc.getSizeInBytes(), 16ull + 4 + 1);
+
+        desc.sampleCount = 4;
+        EXPECT_EQ(desc.getSizeInBytes(), 4 * (16ull + 4 + 1));
+
+        ResourceCache::ResourceDesc buffer;
+        buffer.type = RenderPassReflection::Field::Type::RawBuffer;
+        buffer.width = 1000;
+        EXPECT_EQ(buffer.getSizeInBytes(), 1000ull);
+    }
+
+    CPU_TEST(ResourceCache_PlanChain)
+    {
+        // A chain of passes where each pass reads the output of the previous one.
+        // Resources alternate between two allocations.
+        const auto desc = createTextureDesc(1920, 1080, ResourceFormat::RGBA16Float);
+        std::vector<ResourceCache::ResourceUsage> resources;
+        for (uint32_t i = 0; i < 6; i++) resources.push_back({ desc, { i, i + 1 }, true });
+
+        auto plan = ResourceCache::planMemory(resources);
+        verifyPlan(ctx, resources, plan);
+        EXPECT_EQ(plan.allocationSizes.size(), 2u);
+        EXPECT_EQ(plan.unaliasedMemory, 6 * desc.getSizeInBytes());
+        EXPECT_EQ(plan.aliasedMemory, 2 * desc.getSizeInBytes());
+    }
+
+    CPU_TEST(ResourceCache_PlanCompatibility)
+    {
+        // Resources with different descs or non-transient resources never share allocations.
+        std::vector<ResourceCache::ResourceUsage> resources =
+        {
+            { createTextureDesc(1920, 1080, ResourceFormat::RGBA16Float), { 0, 0 }, true },
+            { createTextureDesc(1920, 1080, ResourceFormat::RGBA32Float), { 1, 1 }, true },
+            { createTextureDesc(1280, 720, ResourceFormat::RGBA16Float), { 2, 2 }, true },
+            { createTextureDesc(1920, 1080, ResourceFormat::RGBA16Float), { 3, 3 }, false },
+            { createTextureDesc(1920, 1080, ResourceFormat::RGBA16Float), { 4, 4 }, true },
+        };
+
+        auto plan = ResourceCache::planMemory(resources);
+        verifyPlan(ctx, resources, plan);
+        EXPECT_EQ(plan.allocationSizes.size(), 4u);
+        EXPECT_EQ(plan.allocationIndices[0], plan.allocationIndices[4]);
+    }
+
+    CPU_TEST(ResourceCache_PlanOptimal)
+    {
+        // Pseudo-random lifetimes of a few compatibility classes.
+        // Interval coloring uses as many allocations per class as there are overlapping lifetimes at the busiest time point.
+        const ResourceCache::ResourceDesc descs[] =
+        {
+            createTextureDesc(1920, 1080, ResourceFormat::RGBA32Float),
+            createTextureDesc(1920, 1080, ResourceFormat::R32Float),
+            createTextureDesc(960, 540, ResourceFormat::RGBA32Float),
+        };
+        const uint32_t kTimePoints = 20;
+
+        std::mt19937 rng;
+        std::vector<ResourceCache::ResourceUsage> resources;
+        for (uint32_t i = 0; i < 200; i++)
+        {
+            uint32_t first = rng() % kTimePoints;
+            uint32_t last = std::min(kTimePoints - 1, first + rng() % 4);
+            resources.push_back({ descs[rng() % std::size(descs)], { first, last }, rng() % 8 != 0 });
+        }
+
+        auto plan = ResourceCache::planMemory(resources);
+        verifyPlan(ctx, resources, plan);
+
+        size_t expectedAllocations = 0;
+        for (const auto& desc : descs)
+        {
+            uint32_t maxOverlap = 0;
+            for (uint32_t t = 0; t < kTimePoints; t++)
+            {
+                uint32_t overlap = 0;
+                for (const auto& r : resources) overlap += (r.transient && r.desc == desc && r.lifetime.first <= t && t <= r.lifetime.second) ? 1 : 0;
+                maxOverlap = std::max(maxOverlap, overlap);
+            }
+            expectedAllocations += maxOverlap;
+        }
+        for (const auto& r : resources) expectedAllocations += r.transient ? 0 : 1;
+
+        EXPECT_EQ(plan.allocationSizes.size(), expectedAllocations);
+        EXPECT_LT(plan.aliasedMemory, plan.unaliasedMemory);
+    }
+}
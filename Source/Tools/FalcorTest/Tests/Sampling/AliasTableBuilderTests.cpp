@@ -0,0 +1,300 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Sampling/AliasTableBuilder.h"
+
+#include "hypothesis/hypothesis.h"
+
+// The large alias table benchmarks are disabled by default as they take a long time and use a lot of memory.
+//#define RUN_LARGE_ALIAS_TABLE_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Generates pseudo-random weights with about 1% zero weights.
+        */
+        std::vector<float> createRandomWeights(uint32_t count, std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> uniform;
+            std::vector<float> weights(count);
+            for (auto& w : weights) w = uniform(rng) < 0.01f ? 0.f : uniform(rng);
+            return weights;
+        }
+
+        /** Verifies that the table entries sample each item with a probability proportional to its weight.
+            The probability of each item is computed exactly by summing its share of all table entries.
+        */
+        void verifyDistribution(CPUUnitTestContext& ctx, const AliasTableBuilder& builder)
+        {
+            const auto& weights = builder.getWeights();
+            const auto& entries = builder.getEntries();
+            const uint32_t count = builder.getCount();
+            EXPECT_EQ(entries.size(), count);
+
+            std::vector<double> probabilities(count, 0.0);
+            for (const auto& entry : entries)
+            {
+                EXPECT(entry.threshold >= 0.f && entry.threshold <= 1.f);
+                EXPECT(entry.indexA < count && entry.indexB < count);
+                if (entry.indexA >= count || entry.indexB >= count) return;
+                probabilities[entry.indexB] += entry.threshold;
+                probabilities[entry.indexA] += 1.0 - entry.threshold;
+            }
+
+            // Compare in units of table entries, i.e., relative to the probability of sampling a single entry.
+            // The tolerance grows with the expected value, as heavy items collect the rounding errors of many light items.
+            double maxError = 0.0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                double expected = builder.getWeightSum() > 0.0 ? count * (weights[i] / builder.getWeightSum()) : 1.0;
+                maxError = std::max(maxError, std::abs(probabilities[i] - expected) / std::max(1.0, expected));
+            }
+            EXPECT_LE(maxError, 1e-3) << "count = " << count;
+        }
+
+        /** Reference implementation of the sort-based alias table construction used before the O(N) builder.
+        */
+        void buildReferenceTable(std::vector<float> weights, std::mt19937& rng, std::vector<float>& thresholds, std::vector<uint32_t>& redirect, std::vector<uint32_t>& permutation)
+        {
+            const uint32_t count = (uint32_t)weights.size();
+            std::uniform_int_distribution<uint32_t> rngDist;
+
+            double weightSum = 0.0;
+            for (float f : weights) weightSum += f;
+
+            double factor = count / weightSum;
+            for (float& f : weights) f = (float)(f * factor);
+
+            permutation.resize(count);
+            for (uint32_t i = 0; i < count; ++i) permutation[i] = i;
+            std::sort(permutation.begin(), permutation.end(), [&](uint32_t a, uint32_t b) { return weights[a] < weights[b]; });
+
+            thresholds.resize(count);
+            redirect.resize(count);
+
+            uint32_t head = 0;
+            uint32_t tail = count - 1;
+
+            while (head != tail)
+            {
+                int i = permutation[head];
+                int j = permutation[tail];
+
+                thresholds[i] = weights[i];
+                redirect[i] = j;
+                weights[j] -= 1.f - weights[i];
+
+                if (head == tail - 1)
+                {
+                    thresholds[j] = 1.f;
+                    redirect[j] = j;
+                    break;
+                }
+                else if (weights[j] < 1.f)
+                {
+                    std::swap(permutation[head], permutation[tail]);
+                    tail--;
+                }
+                else
+                {
+                    head++;
+                }
+            }
+
+            for (uint32_t i = 0; i < count; ++i) permutation[i] = i;
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t dst = i + (rngDist(rng) % (count - i));
+                std::swap(thresholds[i], thresholds[dst]);
+                std::swap(redirect[i], redirect[dst]);
+                std::swap(permutation[i], permutation[dst]);
+            }
+        }
+
+        void benchmarkBuild(uint32_t count)
+        {
+            std::mt19937 rng;
+            auto weights = createRandomWeights(count, rng);
+
+            CpuTimer timer;
+            timer.update();
+            std::vector<float> thresholds;
+            std::vector<uint32_t> redirect, permutation;
+            buildReferenceTable(weights, rng, thresholds, redirect, permutation);
+            timer.update();
+            double referenceTime = timer.delta() * 1000.0;
+
+            double time[2] = {};
+            for (uint32_t parallel = 0; parallel < 2; parallel++)
+            {
+                AliasTableBuilder builder(parallel != 0);
+                timer.update();
+                builder.build(weights);
+                builder.shuffle(rng);
+                timer.update();
+                time[parallel] = timer.delta() * 1000.0;
+            }
+
+            logInfo("AliasTableBuilder: " + std::to_string(count) + " weights. Sort-based reference: " + std::to_string(referenceTime) + " ms, " +
+                "serial: " + std::to_string(time[0]) + " ms, parallel: " + std::to_string(time[1]) + " ms.");
+        }
+    }
+
+    CPU_TEST(AliasTableBuilder_Distribution)
+    {
+        std::mt19937 rng;
+
+        for (uint32_t count : { 1u, 2u, 3u, 100u, 1000u, 100000u })
+        {
+            AliasTableBuilder builder;
+            builder.build(createRandomWeights(count, rng));
+            verifyDistribution(ctx, builder);
+        }
+
+        // Specific weights: uniform, single dominant weight, all zero, mostly zero.
+        std::vector<std::vector<float>> weightLists =
+        {
+            { 1.f },
+            { 1.f, 2.f },
+            std::vector<float>(1000, 1.f),
+            { 1.f, 1.f, 1.f, 1e6f, 1.f, 1.f },
+            { 0.f, 0.f, 0.f },
+            { 0.f, 0.f, 5.f, 0.f },
+        };
+        for (auto& weights : weightLists)
+        {
+            AliasTableBuilder builder;
+            builder.build(weights);
+            verifyDistribution(ctx, builder);
+        }
+    }
+
+    CPU_TEST(AliasTableBuilder_Parallel)
+    {
+        // Use a table large enough for the parallel build to run with several partitions.
+        std::mt19937 rng;
+        auto weights = createRandomWeights(1 << 20, rng);
+        weights[1234] = 1e5f;
+
+        AliasTableBuilder serial(false);
+        serial.build(weights);
+        verifyDistribution(ctx, serial);
+
+        AliasTableBuilder parallel(true);
+        parallel.build(weights);
+        verifyDistribution(ctx, parallel);
+
+        // The parallel build is deterministic.
+        AliasTableBuilder parallel2(true);
+        parallel2.build(weights);
+        const auto& a = parallel.getEntries();
+        const auto& b = parallel2.getEntries();
+        bool equal = true;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            equal &= a[i].threshold == b[i].threshold && a[i].indexA == b[i].indexA && a[i].indexB == b[i].indexB;
+        }
+        EXPECT(equal);
+        EXPECT_EQ(parallel.getWeightSum(), parallel2.getWeightSum());
+    }
+
+    CPU_TEST(AliasTableBuilder_UpdateWeights)
+    {
+        std::mt19937 rng;
+        auto weights = createRandomWeights(10000, rng);
+
+        AliasTableBuilder builder;
+        builder.build(weights);
+
+        // Updating with the current weights doesn't rebuild.
+        EXPECT(!builder.updateWeights({ 0, 1, 2 }, { weights[0], weights[1], weights[2] }));
+
+        // Update a few weights and compare against a table built from scratch.
+        std::vector<uint32_t> indices = { 5, 17, 4000, 9999 };
+        std::vector<float> newWeights = { 0.f, 3.f, 0.5f, 100.f };
+        EXPECT(builder.updateWeights(indices, newWeights));
+        verifyDistribution(ctx, builder);
+
+        for (size_t i = 0; i < indices.size(); i++) weights[indices[i]] = newWeights[i];
+        AliasTableBuilder reference;
+        reference.build(weights);
+
+        EXPECT_EQ(builder.getWeightSum(), reference.getWeightSum());
+        const auto& a = builder.getEntries();
+        const auto& b = reference.getEntries();
+        bool equal = true;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            equal &= a[i].threshold == b[i].threshold && a[i].indexA == b[i].indexA && a[i].indexB == b[i].indexB;
+        }
+        EXPECT(equal);
+    }
+
+    CPU_TEST(AliasTableBuilder_Sampling)
+    {
+        const uint32_t count = 1000;
+        const uint32_t samplesPerWeight = 10000;
+
+        std::mt19937 rng;
+        auto weights = createRandomWeights(count, rng);
+
+        AliasTableBuilder builder;
+        builder.build(weights);
+        builder.shuffle(rng);
+        verifyDistribution(ctx, builder);
+
+        // Sample the table the same way as AliasTable.slang and verify the histogram using a chi-square test.
+        std::uniform_real_distribution<float> uniform;
+        std::vector<double> obsFrequencies(count, 0.0);
+        const auto& entries = builder.getEntries();
+        for (uint32_t i = 0; i < count * samplesPerWeight; i++)
+        {
+            uint32_t index = std::min(count - 1, (uint32_t)(uniform(rng) * count));
+            const auto& entry = entries[index];
+            obsFrequencies[uniform(rng) >= entry.threshold ? entry.indexA : entry.indexB] += 1.0;
+        }
+
+        std::vector<double> expFrequencies(count);
+        for (uint32_t i = 0; i < count; i++) expFrequencies[i] = (weights[i] / builder.getWeightSum()) * count * samplesPerWeight;
+
+        const auto& [success, report] = hypothesis::chi2_test(count, obsFrequencies.data(), expFrequencies.data(), count * samplesPerWeight, 5, 0.1);
+        if (!success) std::cout << report << std::endl;
+        EXPECT(success);
+    }
+
+    CPU_TEST(AliasTableBuilder_Benchmark)
+    {
+        benchmarkBuild(100000);
+        benchmarkBuild(1000000);
+#ifdef RUN_LARGE_ALIAS_TABLE_BENCHMARKS
+        benchmarkBuild(16000000);
+#endif
+    }
+}
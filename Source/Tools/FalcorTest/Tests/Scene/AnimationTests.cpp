@@ -0,0 +1,205 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Animation/Animation.h"
+#include <random>
+
+// The large animation benchmarks are disabled by default as they take a long time to run.
+//#define RUN_LARGE_ANIMATION_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create an animation translating along x by the current time, with keyframes at irregular times in [0, duration].
+        */
+        Animation::SharedPtr createLinearAnimation(uint32_t keyframeCount, double duration, std::mt19937& rng)
+        {
+            std::uniform_real_distribution<double> u(0.0, duration);
+            std::vector<double> times = { 0.0, duration };
+            while (times.size() < keyframeCount) times.push_back(u(rng));
+            std::sort(times.begin(), times.end());
+
+            auto pAnimation = Animation::create("test", 0, duration);
+            for (double time : times) pAnimation->addKeyframe({ time, float3((float)time, 0.f, 0.f) });
+            return pAnimation;
+        }
+
+        Animation::SharedPtr createRandomAnimation(uint32_t keyframeCount, double duration, std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> u(-1.f, 1.f);
+            auto pAnimation = Animation::create("test", 0, duration);
+            for (uint32_t i = 0; i < keyframeCount; i++)
+            {
+                Animation::Keyframe keyframe;
+                keyframe.time = duration * i / (keyframeCount - 1);
+                keyframe.translation = float3(u(rng), u(rng), u(rng));
+                keyframe.scaling = float3(1.f) + 0.5f * float3(u(rng), u(rng), u(rng));
+                keyframe.rotation = glm::normalize(glm::quat(u(rng), u(rng), u(rng), u(rng)));
+                pAnimation->addKeyframe(keyframe);
+            }
+            pAnimation->setPostInfinityBehavior(Animation::Behavior::Cycle);
+            if (rng() % 2) pAnimation->setInterpolationMode(Animation::InterpolationMode::Hermite);
+            return pAnimation;
+        }
+
+        float maxDifference(const glm::mat4& a, const glm::mat4& b)
+        {
+            float d = 0.f;
+            for (int c = 0; c < 4; c++) for (int r = 0; r < 4; r++) d = std::max(d, std::abs(a[c][r] - b[c][r]));
+            return d;
+        }
+    }
+
+    CPU_TEST(Animation_Keyframes)
+    {
+        auto pAnimation = Animation::create("test", 0, 10.0);
+        pAnimation->addKeyframe({ 5.0, float3(5.f) });
+        pAnimation->addKeyframe({ 1.0, float3(1.f) });
+        pAnimation->addKeyframe({ 10.0, float3(10.f) });
+        pAnimation->addKeyframe({ 3.0, float3(3.f) });
+        pAnimation->addKeyframe({ 5.0, float3(6.f) });
+
+        EXPECT(pAnimation->doesKeyframeExists(1.0));
+        EXPECT(pAnimation->doesKeyframeExists(3.0));
+        EXPECT(pAnimation->doesKeyframeExists(10.0));
+        EXPECT(!pAnimation->doesKeyframeExists(0.0));
+        EXPECT(!pAnimation->doesKeyframeExists(4.0));
+        EXPECT(!pAnimation->doesKeyframeExists(11.0));
+        EXPECT_EQ(pAnimation->getKeyframe(5.0).translation.x, 6.f);
+
+        // Keyframes are kept sorted, so lookups between them interpolate the neighbors.
+        EXPECT_LE(std::abs(pAnimation->animate(2.0)[3][0] - 2.f), 1e-5f);
+        EXPECT_LE(std::abs(pAnimation->animate(4.0)[3][0] - 4.5f), 1e-5f);
+        EXPECT_LE(std::abs(pAnimation->animate(0.0)[3][0] - 1.f), 1e-5f);
+    }
+
+    CPU_TEST(Animation_Lookup)
+    {
+        const double duration = 100.0;
+        std::mt19937 rng;
+        auto pAnimation = createLinearAnimation(1000, duration, rng);
+
+        // Forward playback, backward playback and random seeking must all find the correct segment.
+        std::vector<double> times;
+        for (uint32_t i = 0; i <= 1000; i++) times.push_back(duration * i / 1000);
+        for (uint32_t i = 0; i <= 1000; i++) times.push_back(duration * (1000 - i) / 1000);
+        std::uniform_real_distribution<double> u(0.0, duration);
+        for (uint32_t i = 0; i < 1000; i++) times.push_back(u(rng));
+
+        float maxError = 0.f;
+        for (double time : times) maxError = std::max(maxError, std::abs(pAnimation->animate(time)[3][0] - (float)time));
+        EXPECT_LE(maxError, 1e-3f);
+
+        // Oscillating playback mirrors the time after the last keyframe.
+        pAnimation->setPostInfinityBehavior(Animation::Behavior::Oscillate);
+        maxError = 0.f;
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            double time = 4.0 * duration * i / 1000;
+            double offset = std::fmod(time, 2.0 * duration);
+            double expected = offset > duration ? 2.0 * duration - offset : offset;
+            maxError = std::max(maxError, std::abs(pAnimation->animate(time)[3][0] - (float)expected));
+        }
+        EXPECT_LE(maxError, 1e-3f);
+    }
+
+    CPU_TEST(Animation_Batch)
+    {
+        std::mt19937 rng;
+        std::vector<Animation::SharedPtr> animations;
+        for (uint32_t i = 0; i < 1000; i++) animations.push_back(createRandomAnimation(2 + rng() % 20, 10.0, rng));
+
+        Animation::BatchResult result;
+        std::vector<glm::mat4> matrices;
+        for (double time : { 0.0, 3.3, 1.7, 9.9, 25.1 })
+        {
+            Animation::animate(animations, time, result);
+            result.getMatrices(matrices);
+            EXPECT_EQ(matrices.size(), animations.size());
+
+            float maxDiff = 0.f;
+            for (size_t i = 0; i < animations.size(); i++) maxDiff = std::max(maxDiff, maxDifference(matrices[i], animations[i]->animate(time)));
+            EXPECT_LE(maxDiff, 1e-5f) << "time " << time;
+        }
+    }
+
+    CPU_TEST(Animation_Benchmark)
+    {
+        std::mt19937 rng;
+
+        // Random seeking in an animation with many keyframes.
+        {
+            const uint32_t keyframeCount = 100000;
+            const uint32_t lookupCount = 100000;
+            auto pAnimation = createLinearAnimation(keyframeCount, 1000.0, rng);
+            std::uniform_real_distribution<double> u(0.0, 1000.0);
+
+            CpuTimer timer;
+            timer.update();
+            float sum = 0.f;
+            for (uint32_t i = 0; i < lookupCount; i++) sum += pAnimation->animate(u(rng))[3][0];
+            timer.update();
+            logInfo("Animation: " + std::to_string(lookupCount) + " random lookups in " + std::to_string(keyframeCount) + " keyframes took " + std::to_string(timer.delta() * 1000.0) + " ms (checksum " + std::to_string(sum) + ")");
+        }
+
+        auto benchmarkBatch = [&](uint32_t animationCount)
+        {
+            std::vector<Animation::SharedPtr> animations;
+            for (uint32_t i = 0; i < animationCount; i++) animations.push_back(createRandomAnimation(100, 10.0, rng));
+
+            const uint32_t frameCount = 10;
+            std::vector<glm::mat4> matrices(animationCount);
+            CpuTimer timer;
+            timer.update();
+            for (uint32_t frame = 0; frame < frameCount; frame++)
+            {
+                for (uint32_t i = 0; i < animationCount; i++) matrices[i] = animations[i]->animate(frame * 0.1);
+            }
+            timer.update();
+            double serialTime = timer.delta() * 1000.0 / frameCount;
+
+            Animation::BatchResult result;
+            timer.update();
+            for (uint32_t frame = 0; frame < frameCount; frame++)
+            {
+                Animation::animate(animations, frame * 0.1, result);
+                result.getMatrices(matrices);
+            }
+            timer.update();
+            double batchTime = timer.delta() * 1000.0 / frameCount;
+
+            logInfo("Animation: " + std::to_string(animationCount) + " animations. Individual: " + std::to_string(serialTime) + " ms, batched: " + std::to_string(batchTime) + " ms per frame");
+        };
+
+        benchmarkBatch(10000);
+#ifdef RUN_LARGE_ANIMATION_BENCHMARKS
+        benchmarkBatch(1000000);
+#endif
+    }
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        StaticVertexData randomVertex(std::mt19937& rng, const AABB& bounds)
+        {
+            auto dist = std::uniform_real_distribution<float>();
+            auto u = [&]() { return dist(rng); };
+            auto dir = [&]()
+            {
+                float z = 1.f - 2.f * u();
+                float r = std::sqrt(std::max(0.f, 1.f - z * z));
+                float phi = 2.f * (float)M_PI * u();
+                return float3(r * std::cos(phi), r * std::sin(phi), z);
+            };
+
+            StaticVertexData v;
+            v.position = bounds.minPoint + float3(u(), u(), u()) * bounds.extent();
+            v.normal = dir();
+            v.tangent = float4(dir(), u() < 0.5f ? -1.f : 1.f);
+            v.texCrd = float2(u(), u()) * 8.f - 4.f;
+            return v;
+        }
+
+        void testRoundTrip(CPUUnitTestContext& ctx, const AABB& bounds, size_t count)
+        {
+            std::mt19937 rng;
+            const float3 positionOffset = bounds.center();
+            const float3 positionScale = 0.5f * bounds.extent();
+
+            // 16-bit snorm quantization has a max error of half a quantization step, plus some slack for float rounding.
+            const float3 maxPositionError = positionScale / 32767.f + 1e-6f * glm::abs(bounds.maxPoint);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                StaticVertexData v = randomVertex(rng, bounds);
+                PackedCompactVertexData c(v, positionOffset, positionScale);
+                StaticVertexData r = c.unpack(positionOffset, positionScale);
+
+                float3 positionError = glm::abs(r.position - v.position);
+                EXPECT(positionError.x <= maxPositionError.x && positionError.y <= maxPositionError.y && positionError.z <= maxPositionError.z)
+                    << "i = " << i << " error = (" << positionError.x << ", " << positionError.y << ", " << positionError.z << ")";
+
+                // Octahedral encoding with 2x16 bits is accurate to well below 1e-3.
+                EXPECT_LE(glm::length(r.normal - v.normal), 1e-3f) << "i = " << i;
+                EXPECT_LE(glm::length(float3(r.tangent) - float3(v.tangent)), 1e-3f) << "i = " << i;
+                EXPECT_EQ(r.tangent.w, v.tangent.w) << "i = " << i;
+
+                // Texture coordinates in [-4,4] are stored as fp16 with 10 mantissa bits.
+                float2 texCrdError = glm::abs(r.texCrd - v.texCrd);
+                EXPECT_LE(std::max(texCrdError.x, texCrdError.y), 4.f / 2048.f) << "i = " << i;
+            }
+        }
+    }
+
+    CPU_TEST(CompactVertex_RoundTrip)
+    {
+        testRoundTrip(ctx, AABB(float3(-1.f), float3(1.f)), 10000);
+        testRoundTrip(ctx, AABB(float3(-1000.f, 20.f, 0.f), float3(-980.f, 5000.f, 0.01f)), 10000);
+    }
+
+    CPU_TEST(CompactVertex_FlatBounds)
+    {
+        // Meshes that are flat along an axis have zero scale. The positions along that axis must be reproduced exactly.
+        AABB bounds(float3(-2.f, 3.f, -2.f), float3(2.f, 3.f, 2.f));
+        StaticVertexData v = {};
+        v.position = float3(0.5f, 3.f, -1.25f);
+        v.normal = float3(0.f, 1.f, 0.f);
+        v.tangent = float4(1.f, 0.f, 0.f, 1.f);
+
+        PackedCompactVertexData c(v, bounds.center(), 0.5f * bounds.extent());
+        StaticVertexData r = c.unpack(bounds.center(), 0.5f * bounds.extent());
+
+        EXPECT_EQ(r.position.y, 3.f);
+        EXPECT_LE(std::abs(r.position.x - v.position.x), 2.f / 32767.f);
+        EXPECT_LE(std::abs(r.position.z - v.position.z), 2.f / 32767.f);
+        EXPECT_EQ(r.normal, v.normal);
+        EXPECT_EQ(r.tangent, v.tangent);
+    }
+
+    CPU_TEST(CompactVertex_MatchesStandardFormat)
+    {
+        // Converting from the standard packed format, as the scene builder does, must give the same result as encoding directly.
+        std::mt19937 rng;
+        AABB bounds(float3(-10.f), float3(10.f));
+
+        for (size_t i = 0; i < 1000; i++)
+        {
+            StaticVertexData v = randomVertex(rng, bounds);
+            v.texCrd = f16tof32(f32tof16(v.texCrd));
+            StaticVertexData s = PackedStaticVertexData(v).unpack();
+
+            PackedCompactVertexData a(v, bounds.center(), 0.5f * bounds.extent());
+            PackedCompactVertexData b(s, bounds.center(), 0.5f * bounds.extent());
+
+            EXPECT_EQ(a.packedPositionXY, b.packedPositionXY) << "i = " << i;
+            EXPECT_EQ(a.packedPositionZW, b.packedPositionZW) << "i = " << i;
+            EXPECT_EQ(a.packedTexCrd, b.packedTexCrd) << "i = " << i;
+
+            // The normal and tangent have been through another lossy encoding in the standard format.
+            StaticVertexData r = b.unpack(bounds.center(), 0.5f * bounds.extent());
+            EXPECT_LE(glm::length(r.normal - v.normal), 2e-3f) << "i = " << i;
+            EXPECT_LE(glm::length(float3(r.tangent) - float3(v.tangent)), 2e-3f) << "i = " << i;
+        }
+    }
+}
@@ -0,0 +1,167 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/CpuBVH.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create random small triangles in a box, including some duplicates which have identical centers.
+        */
+        std::vector<float3> createRandomTriangles(uint32_t triangleCount, std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> u(-1.f, 1.f);
+            std::vector<float3> positions;
+            for (uint32_t i = 0; i < triangleCount; i++)
+            {
+                float3 center = 10.f * float3(u(rng), u(rng), u(rng));
+                for (uint32_t j = 0; j < 3; j++) positions.push_back(center + 0.5f * float3(u(rng), u(rng), u(rng)));
+            }
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                positions.push_back(float3(0.f, 0.f, 0.f));
+                positions.push_back(float3(1.f, 0.f, 0.f));
+                positions.push_back(float3(0.f, 1.f, 0.f));
+            }
+            return positions;
+        }
+
+        /** Reference closest-hit and any-hit query by testing all triangles.
+        */
+        CpuBVH::Hit bruteForceIntersect(const std::vector<float3>& positions, const CpuBVH::Ray& ray)
+        {
+            CpuBVH::Hit hit;
+            float tMax = ray.tMax;
+            for (uint32_t i = 0; i < (uint32_t)positions.size() / 3; i++)
+            {
+                const float3 v0 = positions[3 * i];
+                const float3 e1 = positions[3 * i + 1] - v0;
+                const float3 e2 = positions[3 * i + 2] - v0;
+                const float3 p = glm::cross(ray.dir, e2);
+                const float det = glm::dot(e1, p);
+                if (det == 0.f) continue;
+                const float3 s = ray.origin - v0;
+                const float u = glm::dot(s, p) / det;
+                const float3 q = glm::cross(s, e1);
+                const float v = glm::dot(ray.dir, q) / det;
+                const float t = glm::dot(e2, q) / det;
+                if (u < 0.f || v < 0.f || u + v > 1.f || t < ray.tMin || t > tMax) continue;
+                tMax = t;
+                hit.triangleIndex = i;
+                hit.t = t;
+                hit.barycentrics = float2(u, v);
+            }
+            return hit;
+        }
+
+        CpuBVH::Ray createRandomRay(std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> u(-1.f, 1.f);
+            CpuBVH::Ray ray;
+            ray.origin = 12.f * float3(u(rng), u(rng), u(rng));
+            ray.dir = float3(u(rng), u(rng), u(rng));
+            // Some rays are axis aligned to test the handling of zero direction components.
+            if (rng() % 8 == 0) ray.dir = float3(0.f, 0.f, 1.f);
+            ray.tMin = 0.01f;
+            ray.tMax = rng() % 2 ? 100.f : 5.f;
+            return ray;
+        }
+    }
+
+    CPU_TEST(CpuBVH_ClosestHit)
+    {
+        std::mt19937 rng(1);
+        uint32_t hitCount = 0;
+        for (uint32_t triangleCount : { 1u, 5u, 100u, 10000u })
+        {
+            const std::vector<float3> positions = createRandomTriangles(triangleCount, rng);
+            CpuBVH bvh;
+            bvh.build(positions);
+            EXPECT_EQ(bvh.getTriangleCount(), positions.size() / 3);
+
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                const CpuBVH::Ray ray = createRandomRay(rng);
+                const CpuBVH::Hit ref = bruteForceIntersect(positions, ray);
+
+                CpuBVH::Hit hit;
+                EXPECT_EQ(bvh.intersect(ray, hit), ref.isValid()) << "triangleCount = " << triangleCount << ", i = " << i;
+                if (!ref.isValid() || !hit.isValid()) continue;
+                hitCount++;
+
+                // Overlapping triangles may give the same distance, so compare the distance and the hit point.
+                EXPECT_LE(std::abs(hit.t - ref.t), 1e-5f * ref.t) << "triangleCount = " << triangleCount << ", i = " << i;
+                const float3 v0 = positions[3 * hit.triangleIndex];
+                const float3 p = v0 + hit.barycentrics.x * (positions[3 * hit.triangleIndex + 1] - v0) + hit.barycentrics.y * (positions[3 * hit.triangleIndex + 2] - v0);
+                EXPECT_LE(glm::length(p - (ray.origin + hit.t * ray.dir)), 1e-4f) << "triangleCount = " << triangleCount << ", i = " << i;
+            }
+        }
+        EXPECT_GT(hitCount, 0u);
+    }
+
+    CPU_TEST(CpuBVH_AnyHit)
+    {
+        std::mt19937 rng(2);
+        const std::vector<float3> positions = createRandomTriangles(5000, rng);
+        CpuBVH bvh;
+        bvh.build(positions);
+
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            const CpuBVH::Ray ray = createRandomRay(rng);
+            EXPECT_EQ(bvh.occluded(ray), bruteForceIntersect(positions, ray).isValid()) << "i = " << i;
+        }
+
+        // Triangles beyond tMax or before tMin are not hit.
+        CpuBVH single;
+        single.build({ float3(-1.f, -1.f, 2.f), float3(1.f, -1.f, 2.f), float3(0.f, 1.f, 2.f) });
+        CpuBVH::Ray ray;
+        ray.dir = float3(0.f, 0.f, 1.f);
+        EXPECT(single.occluded(ray));
+        ray.tMax = 1.f;
+        EXPECT(!single.occluded(ray));
+        ray.tMin = 3.f;
+        ray.tMax = 10.f;
+        EXPECT(!single.occluded(ray));
+    }
+
+    CPU_TEST(CpuBVH_Empty)
+    {
+        CpuBVH bvh;
+        bvh.build({});
+        EXPECT_EQ(bvh.getTriangleCount(), 0u);
+
+        CpuBVH::Ray ray;
+        CpuBVH::Hit hit;
+        EXPECT(!bvh.intersect(ray, hit));
+        EXPECT(!bvh.occluded(ray));
+        EXPECT(!hit.isValid());
+    }
+}
@@ -0,0 +1,249 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/CpuPathTracer.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Add a square in the xz-plane with its front side facing +y.
+            \param[in] builder Scene builder.
+            \param[in] pMaterial Material.
+            \param[in] transform Transform of the square, which has size 2x2 in object space.
+        */
+        void addQuad(SceneBuilder& builder, const Material::SharedPtr& pMaterial, const glm::mat4& transform)
+        {
+            static const std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+            static const std::vector<float3> positions = { float3(-1.f, 0.f, -1.f), float3(-1.f, 0.f, 1.f), float3(1.f, 0.f, -1.f), float3(1.f, 0.f, 1.f) };
+            static const std::vector<float3> normals(positions.size(), float3(0.f, 1.f, 0.f));
+            static const std::vector<float2> texCrds = { float2(0.f, 0.f), float2(0.f, 1.f), float2(1.f, 0.f), float2(1.f, 1.f) };
+
+            SceneBuilder::Mesh mesh;
+            mesh.name = pMaterial->getName();
+            mesh.faceCount = (uint32_t)indices.size() / 3;
+            mesh.vertexCount = (uint32_t)positions.size();
+            mesh.indexCount = (uint32_t)indices.size();
+            mesh.pIndices = indices.data();
+            mesh.topology = Vao::Topology::TriangleList;
+            mesh.pMaterial = pMaterial;
+            mesh.positions = { positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.normals = { normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.texCrds = { texCrds.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+
+            uint32_t meshID = builder.addMesh(mesh);
+            uint32_t nodeID = builder.addNode(SceneBuilder::Node{ mesh.name, transform, glm::identity<glm::mat4>() });
+            builder.addMeshInstance(nodeID, meshID);
+        }
+
+        Material::SharedPtr createMaterial(const std::string& name, const float3& baseColor)
+        {
+            auto pMaterial = Material::create(name);
+            pMaterial->setBaseColor(float4(baseColor, 1.f));
+            return pMaterial;
+        }
+
+        /** Create a row of unit quads along x, each with its own material.
+        */
+        SceneBuilder::SharedPtr createQuadRow(uint32_t quadCount)
+        {
+            auto pBuilder = SceneBuilder::create();
+            for (uint32_t i = 0; i < quadCount; i++)
+            {
+                addQuad(*pBuilder, createMaterial("Quad" + std::to_string(i), float3(0.1f * (i + 1))), glm::translate(float3(3.f * i, 0.f, 0.f)));
+            }
+            return pBuilder;
+        }
+
+        CpuBVH::Ray createRay(const float3& origin, const float3& dir)
+        {
+            CpuBVH::Ray ray;
+            ray.origin = origin;
+            ray.dir = dir;
+            return ray;
+        }
+
+        Camera::SharedPtr createCamera(const float3& position, const float3& target, const float3& up)
+        {
+            auto pCamera = Camera::create("Camera");
+            pCamera->setPosition(position);
+            pCamera->setTarget(target);
+            pCamera->setUpVector(up);
+            return pCamera;
+        }
+    }
+
+    CPU_TEST(CpuScene_Hit)
+    {
+        const uint32_t quadCount = 4;
+        auto pBuilder = createQuadRow(quadCount);
+        auto pScene = CpuScene::create(*pBuilder);
+        EXPECT_EQ(pScene->getMeshInstanceCount(), quadCount);
+        EXPECT_EQ(pScene->getTriangleCount(), 2 * quadCount);
+
+        std::vector<bool> instanceHit(quadCount, false);
+        for (uint32_t i = 0; i < quadCount; i++)
+        {
+            // Hit each quad from above.
+            const float3 target = float3(3.f * i + 0.25f, 0.f, 0.5f);
+            CpuScene::Hit hit;
+            const auto ray = createRay(target + float3(0.f, 2.f, 0.f), float3(0.f, -1.f, 0.f));
+            EXPECT(pScene->traceClosest(ray, hit)) << "i = " << i;
+            if (!hit.isValid()) continue;
+
+            EXPECT(hit.type == InstanceType::TriangleMesh);
+            EXPECT_LT(hit.instanceID, quadCount);
+            EXPECT_LT(hit.primitiveIndex, 2u);
+            EXPECT_LE(std::abs(hit.t - 2.f), 1e-5f) << "i = " << i;
+            instanceHit[hit.instanceID] = true;
+
+            auto sd = pScene->getSurfaceData(hit, ray.dir);
+            EXPECT_LE(glm::length(sd.posW - target), 1e-5f) << "i = " << i;
+            EXPECT_GE(glm::dot(sd.faceN, float3(0.f, 1.f, 0.f)), 0.999f) << "i = " << i;
+            EXPECT_GE(glm::dot(sd.N, float3(0.f, 1.f, 0.f)), 0.999f) << "i = " << i;
+            EXPECT(sd.frontFacing);
+            EXPECT_EQ(pScene->getMaterial(sd.materialID)->getName(), "Quad" + std::to_string(i));
+
+            // Hit from below.
+            const auto rayBelow = createRay(target - float3(0.f, 1.f, 0.f), float3(0.f, 1.f, 0.f));
+            EXPECT(pScene->traceClosest(rayBelow, hit)) << "i = " << i;
+            EXPECT(!pScene->getSurfaceData(hit, rayBelow.dir).frontFacing) << "i = " << i;
+
+            EXPECT(pScene->traceAny(ray));
+        }
+        for (uint32_t i = 0; i < quadCount; i++) EXPECT(instanceHit[i]) << "i = " << i;
+
+        // Miss between the quads.
+        CpuScene::Hit hit;
+        EXPECT(!pScene->traceClosest(createRay(float3(1.5f, 2.f, 0.f), float3(0.f, -1.f, 0.f)), hit));
+        EXPECT(!hit.isValid());
+        EXPECT(!pScene->traceAny(createRay(float3(1.5f, 2.f, 0.f), float3(0.f, -1.f, 0.f))));
+    }
+
+    GPU_TEST(CpuScene_MatchesSceneInstances)
+    {
+        // The CPU scene must report the same mesh instance IDs as the GPU scene.
+        const uint32_t quadCount = 4;
+        auto pBuilder = createQuadRow(quadCount);
+        auto pCpuScene = CpuScene::create(*pBuilder);
+        auto pScene = pBuilder->getScene();
+        EXPECT_EQ(pCpuScene->getMeshInstanceCount(), pScene->getMeshInstanceCount());
+
+        for (uint32_t i = 0; i < quadCount; i++)
+        {
+            const auto ray = createRay(float3(3.f * i, 1.f, 0.f), float3(0.f, -1.f, 0.f));
+            CpuScene::Hit hit;
+            EXPECT(pCpuScene->traceClosest(ray, hit)) << "i = " << i;
+            if (!hit.isValid()) continue;
+
+            auto sd = pCpuScene->getSurfaceData(hit, ray.dir);
+            EXPECT_EQ(sd.materialID, pScene->getMeshInstance(hit.instanceID).materialID) << "i = " << i;
+        }
+    }
+
+    CPU_TEST(CpuPathTracer_DirectLight)
+    {
+        // A diffuse floor lit from straight above has radiance albedo / pi * E everywhere.
+        const float albedo = 0.5f;
+        const float irradiance = 2.f;
+
+        auto pBuilder = SceneBuilder::create();
+        addQuad(*pBuilder, createMaterial("Floor", float3(albedo)), glm::scale(float3(100.f)));
+        auto pLight = DirectionalLight::create("Sun");
+        pLight->setWorldDirection(float3(0.f, -1.f, 0.f));
+        pLight->setIntensity(float3(irradiance));
+        pBuilder->addLight(pLight);
+        pBuilder->addCamera(createCamera(float3(0.f, 5.f, 0.f), float3(0.f, 0.f, 0.f), float3(0.f, 0.f, 1.f)));
+
+        // Rays bouncing off the floor escape, so indirect bounces don't add anything.
+        for (uint32_t maxBounces : { 0u, 2u })
+        {
+            CpuPathTracer::Options options;
+            options.samplesPerPixel = 2;
+            options.maxBounces = maxBounces;
+            auto pPathTracer = CpuPathTracer::create(CpuScene::create(*pBuilder), options);
+
+            const uint2 frameDim(16, 8);
+            auto image = pPathTracer->render(frameDim);
+            EXPECT_EQ(image.size(), (size_t)frameDim.x * frameDim.y);
+
+            const float expected = albedo / (float)M_PI * irradiance;
+            for (size_t i = 0; i < image.size(); i++)
+            {
+                EXPECT_LE(std::abs(image[i].r - expected), 1e-5f) << "i = " << i << ", maxBounces = " << maxBounces;
+                EXPECT_EQ(image[i].a, 1.f);
+            }
+        }
+    }
+
+    CPU_TEST(CpuPathTracer_Emissive)
+    {
+        // An emissive quad in front of the camera on a constant background.
+        auto pBuilder = SceneBuilder::create();
+        auto pMaterial = createMaterial("Emitter", float3(0.f));
+        pMaterial->setEmissiveColor(float3(1.f, 2.f, 3.f));
+        addQuad(*pBuilder, pMaterial, glm::identity<glm::mat4>());
+        pBuilder->addCamera(createCamera(float3(0.f, 10.f, 0.f), float3(0.f, 0.f, 0.f), float3(0.f, 0.f, 1.f)));
+
+        CpuPathTracer::Options options;
+        options.samplesPerPixel = 4;
+        options.backgroundColor = float3(0.25f);
+        auto pScene = CpuScene::create(*pBuilder);
+        auto pPathTracer = CpuPathTracer::create(pScene, options);
+
+        const uint2 frameDim(32, 32);
+        auto image = pPathTracer->render(frameDim);
+        const float4 center = image[(frameDim.y / 2) * frameDim.x + frameDim.x / 2];
+        const float4 corner = image[0];
+        EXPECT_EQ(center.r, 1.f);
+        EXPECT_EQ(center.g, 2.f);
+        EXPECT_EQ(center.b, 3.f);
+        EXPECT_EQ(corner.r, 0.25f);
+
+        // The result is deterministic.
+        auto image2 = pPathTracer->render(frameDim);
+        EXPECT(std::memcmp(image.data(), image2.data(), image.size() * sizeof(float4)) == 0);
+
+        // A wide image widens the view without modifying the scene camera.
+        const float aspectRatio = pScene->getCamera()->getAspectRatio();
+        auto wideImage = pPathTracer->render(uint2(64, 32));
+        EXPECT_EQ(pScene->getCamera()->getAspectRatio(), aspectRatio);
+        EXPECT_EQ(wideImage[16 * 64 + 32].r, 1.f);
+        EXPECT_EQ(wideImage[0].r, 0.25f);
+
+        // The back side doesn't emit unless the material is double-sided.
+        auto pBackBuilder = SceneBuilder::create();
+        addQuad(*pBackBuilder, pMaterial, glm::identity<glm::mat4>());
+        pBackBuilder->addCamera(createCamera(float3(0.f, -10.f, 0.f), float3(0.f, 0.f, 0.f), float3(0.f, 0.f, 1.f)));
+        auto pBackScene = CpuScene::create(*pBackBuilder);
+        EXPECT_EQ(CpuPathTracer::create(pBackScene, options)->render(frameDim)[(frameDim.y / 2) * frameDim.x + frameDim.x / 2].r, 0.f);
+
+        pMaterial->setDoubleSided(true);
+        EXPECT_EQ(CpuPathTracer::create(pBackScene, options)->render(frameDim)[(frameDim.y / 2) * frameDim.x + frameDim.x / 2].r, 1.f);
+    }
+}
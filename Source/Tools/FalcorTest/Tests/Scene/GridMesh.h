@@ -0,0 +1,135 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Testing/UnitTest.h"
+#include <functional>
+#include <random>
+
+namespace Falcor
+{
+    /** Regular grid mesh of n x n quads in the xz-plane used by the scene tests.
+        The vertex at grid point (x, y) has index y * (n + 1) + x and the triangles face +y.
+    */
+    struct GridMesh
+    {
+        /** Function returning the height (y coordinate) at a grid point.
+        */
+        using HeightFunc = std::function<float(uint32_t x, uint32_t y)>;
+
+        uint32_t n;
+        std::vector<uint32_t> indices;
+        std::vector<float3> positions;
+        std::vector<float3> normals;        ///< Always +y, also for a displaced grid.
+        std::vector<float2> texCrds;        ///< Grid point divided by n.
+
+        /** Create a grid mesh.
+            \param[in] n Number of quads along each side.
+            \param[in] spacing Distance between neighboring grid points.
+            \param[in] height Optional height function. The grid is flat if none is given.
+            \param[in] shuffle Put the triangles in a random (but deterministic) order.
+        */
+        GridMesh(uint32_t n, float spacing = 1.f, const HeightFunc& height = nullptr, bool shuffle = false) : n(n)
+        {
+            for (uint32_t y = 0; y <= n; y++)
+            {
+                for (uint32_t x = 0; x <= n; x++)
+                {
+                    positions.push_back(float3(x * spacing, height ? height(x, y) : 0.f, y * spacing));
+                    normals.push_back(float3(0.f, 1.f, 0.f));
+                    texCrds.push_back(float2(x, y) / float(n));
+                }
+            }
+
+            std::vector<uint3> triangles;
+            for (uint32_t y = 0; y < n; y++)
+            {
+                for (uint32_t x = 0; x < n; x++)
+                {
+                    uint32_t i = y * (n + 1) + x;
+                    triangles.push_back(uint3(i, i + n + 1, i + 1));
+                    triangles.push_back(uint3(i + 1, i + n + 1, i + n + 2));
+                }
+            }
+
+            if (shuffle)
+            {
+                std::mt19937 rng;
+                std::shuffle(triangles.begin(), triangles.end(), rng);
+            }
+            for (const auto& t : triangles) indices.insert(indices.end(), { t.x, t.y, t.z });
+        }
+
+        uint32_t getVertexCount() const { return (uint32_t)positions.size(); }
+
+        /** Smooth waves along the x axis. The grid is then curved but still faces +y everywhere.
+        */
+        static float waves(uint32_t x, uint32_t y) { return std::sin(0.1f * x); }
+
+        /** Get a scene builder mesh referencing the grid data with per-vertex attributes.
+            The grid must outlive the returned mesh.
+        */
+        SceneBuilder::Mesh getMesh(const std::string& name, const Material::SharedPtr& pMaterial) const
+        {
+            SceneBuilder::Mesh mesh;
+            mesh.name = name;
+            mesh.faceCount = (uint32_t)indices.size() / 3;
+            mesh.vertexCount = (uint32_t)positions.size();
+            mesh.indexCount = (uint32_t)indices.size();
+            mesh.pIndices = indices.data();
+            mesh.topology = Vao::Topology::TriangleList;
+            mesh.pMaterial = pMaterial;
+            mesh.positions = { positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.normals = { normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            mesh.texCrds = { texCrds.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            return mesh;
+        }
+    };
+
+    /** Add a row of grid instances along the x axis, each with its own copy of the mesh.
+        Instance i is named "Grid<i>" and placed at (i * spacing, 0, 0).
+        \param[in] builder Scene builder to add the instances to.
+        \param[in] grid Grid mesh.
+        \param[in] pMaterial Material of the instances.
+        \param[in] count Number of instances.
+        \param[in] spacing Distance between neighboring instances.
+        \return Node IDs of the instances.
+    */
+    inline std::vector<uint32_t> addGridInstances(SceneBuilder& builder, const GridMesh& grid, const Material::SharedPtr& pMaterial, uint32_t count, float spacing)
+    {
+        std::vector<uint32_t> nodeIDs;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t meshID = builder.addMesh(grid.getMesh("Grid" + std::to_string(i), pMaterial));
+            glm::mat4 transform = glm::translate(float3(i * spacing, 0.f, 0.f));
+            uint32_t nodeID = builder.addNode(SceneBuilder::Node{ "Node" + std::to_string(i), transform, glm::identity<glm::mat4>() });
+            builder.addMeshInstance(nodeID, meshID);
+            nodeIDs.push_back(nodeID);
+        }
+        return nodeIDs;
+    }
+}
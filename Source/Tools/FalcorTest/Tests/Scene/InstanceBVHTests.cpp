@@ -0,0 +1,219 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/InstanceBVH.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// The large instance BVH benchmarks are disabled by default as they take a long time to run.
+//#define RUN_LARGE_INSTANCE_BVH_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        std::vector<AABB> createRandomBoxes(uint32_t count, float sceneSize, std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> posDist(-sceneSize, sceneSize);
+            std::uniform_real_distribution<float> sizeDist(0.5f, 5.f);
+
+            std::vector<AABB> boxes(count);
+            for (auto& box : boxes)
+            {
+                float3 center(posDist(rng), posDist(rng), posDist(rng));
+                float3 halfExtent(sizeDist(rng), sizeDist(rng), sizeDist(rng));
+                box = AABB(center - halfExtent, center + halfExtent);
+            }
+            return boxes;
+        }
+
+        /** Camera looking along -z from a set of positions, plus cascade-like views without near/far planes.
+        */
+        std::vector<InstanceBVH::Frustum> createViews(uint32_t count)
+        {
+            std::vector<InstanceBVH::Frustum> views;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float3 eye(100.f * i, 0.f, 500.f);
+                glm::mat4 view = glm::lookAt(eye, eye + float3(0.f, 0.f, -1.f), float3(0.f, 1.f, 0.f));
+                glm::mat4 proj = glm::perspective(1.f, 1.5f, 0.1f, 200.f * (i + 1));
+                views.push_back(InstanceBVH::Frustum::fromViewProj(proj * view, i % 2 == 0));
+            }
+            return views;
+        }
+
+        std::vector<uint32_t> cullReference(const std::vector<AABB>& boxes, const InstanceBVH::Frustum& view)
+        {
+            std::vector<uint32_t> visible;
+            for (uint32_t i = 0; i < (uint32_t)boxes.size(); i++)
+            {
+                if (boxes[i].valid() && !view.isCulled(boxes[i])) visible.push_back(i);
+            }
+            return visible;
+        }
+
+        void checkCulling(CPUUnitTestContext& ctx, const InstanceBVH& bvh, const std::vector<AABB>& boxes, const std::vector<InstanceBVH::Frustum>& views)
+        {
+            std::vector<std::vector<uint32_t>> visible;
+            bvh.cull(views, visible);
+            EXPECT_EQ(visible.size(), views.size());
+
+            for (size_t v = 0; v < views.size(); v++)
+            {
+                std::sort(visible[v].begin(), visible[v].end());
+                EXPECT(visible[v] == cullReference(boxes, views[v])) << "view = " << v;
+            }
+        }
+
+        /** Build, cull and refit a BVH over random instances against a camera and four shadow cascades.
+        */
+        void benchmarkCulling(CPUUnitTestContext& ctx, uint32_t instanceCount)
+        {
+            std::mt19937 rng;
+            auto boxes = createRandomBoxes(instanceCount, 1000.f, rng);
+            auto views = createViews(5);
+
+            CpuTimer timer;
+            timer.update();
+            InstanceBVH bvh;
+            bvh.build(boxes);
+            timer.update();
+            double buildTime = timer.delta() * 1000.0;
+
+            std::vector<std::vector<uint32_t>> visible;
+            timer.update();
+            bvh.cull(views, visible);
+            timer.update();
+            double cullTime = timer.delta() * 1000.0;
+
+            // Scalar reference testing each box against each view, as Camera::isObjectCulled() does.
+            size_t referenceVisibleCount = 0;
+            timer.update();
+            for (const auto& view : views)
+            {
+                for (const auto& box : boxes) referenceVisibleCount += view.isCulled(box) ? 0 : 1;
+            }
+            timer.update();
+            double referenceTime = timer.delta() * 1000.0;
+
+            size_t visibleCount = 0;
+            for (const auto& v : visible) visibleCount += v.size();
+            EXPECT_EQ(visibleCount, referenceVisibleCount);
+
+            std::vector<uint32_t> moved;
+            for (uint32_t i = 0; i < instanceCount; i += 10) moved.push_back(i);
+            timer.update();
+            bvh.refit(moved, boxes);
+            timer.update();
+            double refitTime = timer.delta() * 1000.0;
+
+            logInfo("InstanceBVH: " + std::to_string(instanceCount) + " instances, " + std::to_string(views.size()) + " views, " + std::to_string(visibleCount) + " visible. " +
+                "Build: " + std::to_string(buildTime) + " ms, cull: " + std::to_string(cullTime) + " ms, scalar reference: " + std::to_string(referenceTime) + " ms, " +
+                "refit 10%: " + std::to_string(refitTime) + " ms.");
+        }
+    }
+
+    CPU_TEST(InstanceBVH_Frustum)
+    {
+        glm::mat4 view = glm::lookAt(float3(0.f), float3(0.f, 0.f, -1.f), float3(0.f, 1.f, 0.f));
+        glm::mat4 proj = glm::perspective(glm::radians(90.f), 1.f, 1.f, 100.f);
+        auto frustum = InstanceBVH::Frustum::fromViewProj(proj * view);
+
+        EXPECT(!frustum.isCulled(AABB(float3(-1.f, -1.f, -11.f), float3(1.f, 1.f, -9.f))));
+        EXPECT(frustum.isCulled(AABB(float3(-1.f, -1.f, 9.f), float3(1.f, 1.f, 11.f))));         // Behind the camera.
+        EXPECT(frustum.isCulled(AABB(float3(20.f, -1.f, -11.f), float3(22.f, 1.f, -9.f))));     // Right of the frustum.
+        EXPECT(!frustum.isCulled(AABB(float3(9.f, -1.f, -11.f), float3(12.f, 1.f, -9.f))));     // Straddling the right plane.
+        EXPECT(frustum.isCulled(AABB(float3(-1.f, -1.f, -201.f), float3(1.f, 1.f, -199.f))));   // Beyond the far plane.
+
+        // Without near/far planes, only the side planes are tested.
+        frustum = InstanceBVH::Frustum::fromViewProj(proj * view, false);
+        EXPECT(!frustum.isCulled(AABB(float3(-1.f, -1.f, -201.f), float3(1.f, 1.f, -199.f))));
+    }
+
+    CPU_TEST(InstanceBVH_Cull)
+    {
+        std::mt19937 rng;
+        auto views = createViews(5);
+
+        // Small hierarchies exercise partially filled nodes.
+        for (uint32_t count : { 0u, 1u, 3u, 4u, 5u, 17u, 1000u, 20000u })
+        {
+            auto boxes = createRandomBoxes(count, count < 100 ? 50.f : 1000.f, rng);
+            InstanceBVH bvh;
+            bvh.build(boxes);
+            EXPECT_EQ(bvh.getInstanceCount(), count);
+            checkCulling(ctx, bvh, boxes, views);
+        }
+
+        // Empty boxes are never visible.
+        auto boxes = createRandomBoxes(1000, 100.f, rng);
+        for (size_t i = 0; i < boxes.size(); i += 7) boxes[i] = AABB();
+        InstanceBVH bvh;
+        bvh.build(boxes);
+        checkCulling(ctx, bvh, boxes, views);
+    }
+
+    CPU_TEST(InstanceBVH_Refit)
+    {
+        std::mt19937 rng;
+        auto views = createViews(3);
+        auto boxes = createRandomBoxes(20000, 1000.f, rng);
+
+        InstanceBVH bvh;
+        bvh.build(boxes);
+
+        // Move some instances, including moving them far away, and make some empty and some non-empty again.
+        std::uniform_real_distribution<float> offsetDist(-500.f, 500.f);
+        for (uint32_t iteration = 0; iteration < 3; iteration++)
+        {
+            std::vector<uint32_t> moved;
+            for (uint32_t i = iteration; i < (uint32_t)boxes.size(); i += 13)
+            {
+                moved.push_back(i);
+                if (i % 5 == 0)
+                {
+                    boxes[i] = AABB();
+                    continue;
+                }
+                float3 offset(offsetDist(rng), offsetDist(rng), offsetDist(rng));
+                float3 center = boxes[i].valid() ? boxes[i].center() : float3(0.f);
+                boxes[i] = AABB(center + offset - float3(1.f), center + offset + float3(1.f));
+            }
+            bvh.refit(moved, boxes);
+            checkCulling(ctx, bvh, boxes, views);
+        }
+    }
+
+    CPU_TEST(InstanceBVH_Benchmark)
+    {
+        benchmarkCulling(ctx, 10000);
+#ifdef RUN_LARGE_INSTANCE_BVH_BENCHMARKS
+        benchmarkCulling(ctx, 1000000);
+#endif
+    }
+}
@@ -0,0 +1,145 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Experimental/Scene/Lights/LightBVHBuilder.h"
+#include <random>
+
+// The large light BVH benchmarks are disabled by default as they take a long time to run.
+//#define RUN_LARGE_LIGHT_BVH_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        const LightBVHBuilder::SplitHeuristic kSplitHeuristics[] =
+        {
+            LightBVHBuilder::SplitHeuristic::Equal,
+            LightBVHBuilder::SplitHeuristic::BinnedSAH,
+            LightBVHBuilder::SplitHeuristic::BinnedSAOH,
+        };
+
+        const char* kSplitHeuristicNames[] = { "Equal", "BinnedSAH", "BinnedSAOH" };
+
+        /** Generates small randomly placed and oriented emissive triangles in the unit cube.
+        */
+        std::vector<LightCollection::MeshLightTriangle> createRandomTriangles(uint32_t count)
+        {
+            std::mt19937 rng;
+            auto dist = std::uniform_real_distribution<float>();
+            auto r = [&]() { return dist(rng); };
+
+            std::vector<LightCollection::MeshLightTriangle> triangles(count);
+            for (auto& tri : triangles)
+            {
+                float3 center = float3(r(), r(), r());
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    tri.vtx[j].pos = center + 0.01f * float3(r(), r(), r());
+                }
+                float3 n = glm::cross(tri.vtx[1].pos - tri.vtx[0].pos, tri.vtx[2].pos - tri.vtx[0].pos);
+                tri.normal = glm::length(n) > 0.f ? glm::normalize(n) : float3(0.f, 0.f, 1.f);
+                tri.flux = r() < 0.05f ? 0.f : r();
+                tri.area = 0.5f * glm::length(n);
+            }
+            return triangles;
+        }
+
+        struct BuildResult
+        {
+            std::vector<PackedNode> nodes;
+            std::vector<uint32_t> triangleIndices;
+            std::vector<uint64_t> triangleBitmasks;
+        };
+
+        BuildResult build(const std::vector<LightCollection::MeshLightTriangle>& triangles, LightBVHBuilder::SplitHeuristic heuristic, bool parallel)
+        {
+            LightBVHBuilder::Options options;
+            options.splitHeuristicSelection = heuristic;
+            options.useParallelBuild = parallel;
+            auto pBuilder = LightBVHBuilder::create(options);
+
+            BuildResult result;
+            pBuilder->buildNodes(triangles, result.nodes, result.triangleIndices, result.triangleBitmasks);
+            return result;
+        }
+
+        void benchmarkBuild(uint32_t triangleCount)
+        {
+            auto triangles = createRandomTriangles(triangleCount);
+            for (size_t i = 0; i < std::size(kSplitHeuristics); i++)
+            {
+                double time[2] = {};
+                size_t nodeCount = 0;
+                for (uint32_t parallel = 0; parallel < 2; parallel++)
+                {
+                    CpuTimer timer;
+                    timer.update();
+                    auto result = build(triangles, kSplitHeuristics[i], parallel != 0);
+                    timer.update();
+                    time[parallel] = timer.delta() * 1000.0;
+                    nodeCount = result.nodes.size();
+                }
+                logInfo("LightBVHBuilder " + std::string(kSplitHeuristicNames[i]) + ": " + std::to_string(triangleCount) + " triangles, " + std::to_string(nodeCount) + " nodes. " +
+                    "Serial: " + std::to_string(time[0]) + " ms, parallel: " + std::to_string(time[1]) + " ms.");
+            }
+        }
+    }
+
+    CPU_TEST(LightBVHBuilder_ParallelDeterministic)
+    {
+        // Use enough triangles to build subtrees and bins in parallel.
+        auto triangles = createRandomTriangles(300000);
+
+        for (auto heuristic : kSplitHeuristics)
+        {
+            BuildResult serial = build(triangles, heuristic, false);
+            EXPECT(!serial.nodes.empty());
+
+            // Build twice in parallel to also check that the parallel build is deterministic.
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                BuildResult parallel = build(triangles, heuristic, true);
+                EXPECT_EQ(parallel.nodes.size(), serial.nodes.size()) << "heuristic = " << (uint32_t)heuristic;
+                if (parallel.nodes.size() != serial.nodes.size()) continue;
+                EXPECT(std::memcmp(parallel.nodes.data(), serial.nodes.data(), serial.nodes.size() * sizeof(PackedNode)) == 0) << "heuristic = " << (uint32_t)heuristic;
+                EXPECT(parallel.triangleIndices == serial.triangleIndices) << "heuristic = " << (uint32_t)heuristic;
+                EXPECT(parallel.triangleBitmasks == serial.triangleBitmasks) << "heuristic = " << (uint32_t)heuristic;
+            }
+        }
+    }
+
+    CPU_TEST(LightBVHBuilder_Benchmark)
+    {
+        benchmarkBuild(10000);
+        benchmarkBuild(100000);
+#ifdef RUN_LARGE_LIGHT_BVH_BENCHMARKS
+        benchmarkBuild(1000000);
+        benchmarkBuild(4000000);
+#endif
+    }
+}
@@ -0,0 +1,379 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/MeshOptimizer.h"
+#include "GridMesh.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Returns the triangles as a sorted list, for comparing triangle sets including their winding.
+        */
+        std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> getSortedTriangles(const std::vector<uint32_t>& indices)
+        {
+            std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> triangles;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                // Rotate the smallest index first, which preserves the winding.
+                uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                if (b < a && b <= c) triangles.push_back({ b, c, a });
+                else if (c < a && c < b) triangles.push_back({ c, a, b });
+                else triangles.push_back({ a, b, c });
+            }
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        }
+
+        /** Returns true if each edge is used by exactly two triangles with opposite winding, i.e. the mesh is closed and edge-manifold.
+        */
+        bool isClosedManifold(const std::vector<uint32_t>& indices)
+        {
+            std::vector<std::pair<uint32_t, uint32_t>> edges;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++) edges.push_back({ indices[i + k], indices[i + (k + 1) % 3] });
+            }
+            std::sort(edges.begin(), edges.end());
+            for (size_t i = 0; i < edges.size(); i++)
+            {
+                if (i > 0 && edges[i] == edges[i - 1]) return false;
+                if (!std::binary_search(edges.begin(), edges.end(), std::make_pair(edges[i].second, edges[i].first))) return false;
+            }
+            return true;
+        }
+
+        /** Unit sphere with shared vertices and counter-clockwise outward-facing triangles.
+        */
+        struct SphereMesh
+        {
+            std::vector<float3> positions;
+            std::vector<uint32_t> indices;
+
+            SphereMesh(uint32_t rings, uint32_t segments)
+            {
+                positions.push_back(float3(0.f, 1.f, 0.f));
+                for (uint32_t r = 1; r < rings; r++)
+                {
+                    for (uint32_t s = 0; s < segments; s++)
+                    {
+                        float theta = (float)M_PI * r / rings;
+                        float phi = 2.f * (float)M_PI * s / segments;
+                        positions.push_back(float3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+                    }
+                }
+                positions.push_back(float3(0.f, -1.f, 0.f));
+
+                auto getVertex = [&](uint32_t r, uint32_t s)
+                {
+                    if (r == 0) return 0u;
+                    if (r == rings) return (uint32_t)positions.size() - 1;
+                    return 1 + (r - 1) * segments + s % segments;
+                };
+
+                for (uint32_t r = 0; r < rings; r++)
+                {
+                    for (uint32_t s = 0; s < segments; s++)
+                    {
+                        uint32_t a = getVertex(r, s), b = getVertex(r, s + 1), c = getVertex(r + 1, s), d = getVertex(r + 1, s + 1);
+                        if (r > 0) indices.insert(indices.end(), { a, b, c });
+                        if (r < rings - 1) indices.insert(indices.end(), { b, d, c });
+                    }
+                }
+            }
+
+            uint32_t getVertexCount() const { return (uint32_t)positions.size(); }
+        };
+
+        float distanceToTriangle(const float3& p, const float3& a, const float3& b, const float3& c)
+        {
+            // Find the closest point by its Voronoi region (Ericson, Real-Time Collision Detection, 5.1.5).
+            float3 ab = b - a, ac = c - a, ap = p - a;
+            float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+            if (d1 <= 0.f && d2 <= 0.f) return glm::length(p - a);
+
+            float3 bp = p - b;
+            float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+            if (d3 >= 0.f && d4 <= d3) return glm::length(p - b);
+
+            float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+
+            float3 cp = p - c;
+            float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+            if (d6 >= 0.f && d5 <= d6) return glm::length(p - c);
+
+            float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+
+            float va = d3 * d6 - d5 * d4;
+            if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+
+            float denom = 1.f / (va + vb + vc);
+            return glm::length(p - (a + ab * (vb * denom) + ac * (vc * denom)));
+        }
+
+        /** Returns the largest distance from a vertex of the original mesh to the simplified mesh.
+        */
+        float getMaxDeviation(const std::vector<float3>& positions, const std::vector<uint32_t>& original, const std::vector<uint32_t>& simplified)
+        {
+            std::vector<bool> used(positions.size(), false);
+            for (uint32_t index : original) used[index] = true;
+
+            float maxDistance = 0.f;
+            for (size_t v = 0; v < positions.size(); v++)
+            {
+                if (!used[v]) continue;
+                float distance = std::numeric_limits<float>::max();
+                for (size_t i = 0; i < simplified.size(); i += 3)
+                {
+                    distance = std::min(distance, distanceToTriangle(positions[v], positions[simplified[i]], positions[simplified[i + 1]], positions[simplified[i + 2]]));
+                }
+                maxDistance = std::max(maxDistance, distance);
+            }
+            return maxDistance;
+        }
+    }
+
+    CPU_TEST(MeshOptimizer_AnalyzeVertexCache)
+    {
+        // A single triangle transforms each vertex once.
+        auto stats = MeshOptimizer::analyzeVertexCache({ 0, 1, 2 }, 3);
+        EXPECT_EQ(stats.transformedVertexCount, 3u);
+        EXPECT_EQ(stats.acmr, 3.0);
+        EXPECT_EQ(stats.atvr, 1.0);
+
+        // Two triangles sharing an edge hit the cache for the shared vertices.
+        stats = MeshOptimizer::analyzeVertexCache({ 0, 1, 2, 2, 1, 3 }, 4);
+        EXPECT_EQ(stats.transformedVertexCount, 4u);
+        EXPECT_EQ(stats.acmr, 2.0);
+        EXPECT_EQ(stats.atvr, 1.0);
+
+        // With a FIFO cache of size 3, vertex 0 is evicted before it's used again, which in turn evicts 1 and 2.
+        stats = MeshOptimizer::analyzeVertexCache({ 0, 1, 2, 3, 1, 2, 0, 1, 2 }, 4, 3);
+        EXPECT_EQ(stats.transformedVertexCount, 7u);
+        EXPECT_EQ(stats.atvr, 1.75);
+    }
+
+    CPU_TEST(MeshOptimizer_OptimizeVertexCache)
+    {
+        GridMesh mesh(64, 1.f, GridMesh::waves, true);
+        const uint32_t vertexCount = mesh.getVertexCount();
+
+        auto before = MeshOptimizer::analyzeVertexCache(mesh.indices, vertexCount);
+        auto indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+        auto after = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
+
+        // The triangles must be the same with unchanged winding.
+        EXPECT(getSortedTriangles(indices) == getSortedTriangles(mesh.indices));
+
+        // A randomly ordered grid misses almost every vertex. An optimized grid gets close to the optimum of 0.5.
+        EXPECT_GE(before.acmr, 2.5);
+        EXPECT_LE(after.acmr, 0.75);
+        EXPECT_LE(after.atvr, 1.5);
+    }
+
+    CPU_TEST(MeshOptimizer_OptimizeOverdraw)
+    {
+        GridMesh mesh(64, 1.f, GridMesh::waves, true);
+        const uint32_t vertexCount = mesh.getVertexCount();
+        const float threshold = 1.05f;
+
+        auto indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+        auto optimized = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
+        indices = MeshOptimizer::optimizeOverdraw(indices, mesh.positions.data(), vertexCount, threshold);
+        auto reordered = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
+
+        EXPECT(getSortedTriangles(indices) == getSortedTriangles(mesh.indices));
+        EXPECT_LE(reordered.acmr, optimized.acmr * threshold);
+    }
+
+    CPU_TEST(MeshOptimizer_OptimizeVertexFetch)
+    {
+        GridMesh mesh(16, 1.f, GridMesh::waves, true);
+        const uint32_t vertexCount = mesh.getVertexCount() + 1; // Add an unreferenced vertex.
+        mesh.positions.push_back(float3(-1.f));
+
+        auto indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+        auto original = indices;
+        auto remap = MeshOptimizer::optimizeVertexFetch(indices, vertexCount);
+
+        // The vertices must be referenced in order of first use.
+        uint32_t nextIndex = 0;
+        for (uint32_t index : indices)
+        {
+            EXPECT_LE(index, nextIndex);
+            if (index == nextIndex) nextIndex++;
+        }
+        EXPECT_EQ(nextIndex, vertexCount - 1);
+        EXPECT_EQ(remap[vertexCount - 1], vertexCount - 1);
+
+        // The remapped vertex data must give the same triangles.
+        auto positions = mesh.positions;
+        MeshOptimizer::remapVertices(positions, remap);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            EXPECT(positions[indices[i]] == mesh.positions[original[i]]) << "i = " << i;
+        }
+    }
+
+    CPU_TEST(MeshOptimizer_DegenerateTriangles)
+    {
+        std::vector<uint32_t> indices = { 0, 0, 1, 1, 2, 0, 2, 2, 2, 3, 1, 2 };
+        auto result = MeshOptimizer::optimizeVertexCache(indices, 4);
+        EXPECT(getSortedTriangles(result) == getSortedTriangles(indices));
+    }
+
+    CPU_TEST(MeshOptimizer_SimplifyReduction)
+    {
+        SphereMesh mesh(48, 96);
+        const uint32_t vertexCount = mesh.getVertexCount();
+
+        float prevError = 0.f;
+        for (uint32_t lod = 1; lod <= 4; lod++)
+        {
+            const size_t targetIndexCount = mesh.indices.size() >> lod;
+            auto result = MeshOptimizer::simplify(mesh.indices, mesh.positions.data(), vertexCount, targetIndexCount, 1.f);
+
+            // The target is reached on a closed smooth mesh, with an error that grows with the reduction.
+            EXPECT_EQ(result.indices.size() % 3, 0u);
+            EXPECT_LE(result.indices.size(), targetIndexCount) << "lod = " << lod;
+            EXPECT_GE(result.indices.size(), targetIndexCount * 9 / 10) << "lod = " << lod;
+            EXPECT_GE(result.error, prevError) << "lod = " << lod;
+            prevError = result.error;
+
+            // The reported error is an RMS estimate, not a bound. Check that it is in proportion to the max distance
+            // of the original vertices to the simplified surface on this smooth mesh.
+            const float deviation = getMaxDeviation(mesh.positions, mesh.indices, result.indices);
+            EXPECT_LE(deviation, 1.5f * result.error + 1e-4f) << "lod = " << lod;
+
+            // The mesh must stay closed, with non-degenerate triangles that keep facing outwards.
+            EXPECT(isClosedManifold(result.indices)) << "lod = " << lod;
+            for (size_t i = 0; i < result.indices.size(); i += 3)
+            {
+                const float3& a = mesh.positions[result.indices[i]];
+                const float3& b = mesh.positions[result.indices[i + 1]];
+                const float3& c = mesh.positions[result.indices[i + 2]];
+                EXPECT_GT(glm::dot(glm::cross(b - a, c - a), a + b + c), 0.f) << "lod = " << lod << ", i = " << i;
+            }
+        }
+    }
+
+    CPU_TEST(MeshOptimizer_SimplifyErrorLimit)
+    {
+        SphereMesh mesh(48, 96);
+        const uint32_t vertexCount = mesh.getVertexCount();
+
+        for (float maxError : { 0.001f, 0.01f, 0.05f })
+        {
+            // Simplify as far as the error limit allows.
+            auto result = MeshOptimizer::simplify(mesh.indices, mesh.positions.data(), vertexCount, 0, maxError);
+            EXPECT_LE(result.error, maxError) << "maxError = " << maxError;
+            EXPECT_LT(result.indices.size(), mesh.indices.size()) << "maxError = " << maxError;
+
+            const float deviation = getMaxDeviation(mesh.positions, mesh.indices, result.indices);
+            EXPECT_LE(deviation, 1.5f * maxError) << "maxError = " << maxError;
+        }
+
+        // A zero error limit leaves the curved surface unchanged.
+        auto result = MeshOptimizer::simplify(mesh.indices, mesh.positions.data(), vertexCount, 0, 0.f);
+        EXPECT(getSortedTriangles(result.indices) == getSortedTriangles(mesh.indices));
+        EXPECT_EQ(result.error, 0.f);
+    }
+
+    CPU_TEST(MeshOptimizer_SimplifyTopology)
+    {
+        // Without a target or error limit, closed meshes are simplified down to a tetrahedron, the smallest closed mesh.
+        // The link condition rejects the collapses that would pinch them into non-manifold edges or fold them flat.
+        for (const auto& [rings, segments] : { std::make_pair(48u, 96u), std::make_pair(32u, 3u), std::make_pair(8u, 4u) })
+        {
+            SphereMesh mesh(rings, segments);
+            auto result = MeshOptimizer::simplify(mesh.indices, mesh.positions.data(), mesh.getVertexCount(), 0, FLT_MAX);
+            EXPECT_EQ(result.indices.size(), 12u) << "rings = " << rings << ", segments = " << segments;
+            EXPECT(isClosedManifold(result.indices)) << "rings = " << rings << ", segments = " << segments;
+        }
+    }
+
+    CPU_TEST(MeshOptimizer_SimplifySeams)
+    {
+        // Planar grid with a UV seam down the middle, i.e. the vertices on the seam are split with the same positions.
+        const uint32_t n = 32;
+        std::vector<float3> positions;
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y <= n; y++)
+        {
+            for (uint32_t x = 0; x <= n; x++) positions.push_back(float3(x, 0, y));
+        }
+        const uint32_t seamOffset = (uint32_t)positions.size();
+        for (uint32_t y = 0; y <= n; y++) positions.push_back(float3(n / 2, 0, y));
+
+        auto getVertex = [&](uint32_t x, uint32_t y, bool right) { return right && x == n / 2 ? seamOffset + y : y * (n + 1) + x; };
+        for (uint32_t y = 0; y < n; y++)
+        {
+            for (uint32_t x = 0; x < n; x++)
+            {
+                bool right = x >= n / 2;
+                uint32_t a = getVertex(x, y, right), b = getVertex(x + 1, y, right), c = getVertex(x, y + 1, right), d = getVertex(x + 1, y + 1, right);
+                indices.insert(indices.end(), { a, c, b, b, c, d });
+            }
+        }
+
+        auto result = MeshOptimizer::simplify(indices, positions.data(), (uint32_t)positions.size(), 0, 1e-3f);
+
+        // A plane is simplified without error. The seam vertices collapse along the seam, down to the corners of the two halves.
+        EXPECT_EQ(result.error, 0.f);
+        EXPECT_LE(result.indices.size(), 3u * 8u);
+
+        // The seam vertices on both sides move together, so the halves stay connected. The ends of the seam on the border are kept.
+        std::vector<bool> used(positions.size(), false);
+        for (uint32_t index : result.indices) used[index] = true;
+        for (uint32_t y = 0; y <= n; y++)
+        {
+            EXPECT_EQ(used[getVertex(n / 2, y, false)], used[getVertex(n / 2, y, true)]) << "y = " << y;
+        }
+        EXPECT(used[getVertex(n / 2, 0, false)] && used[getVertex(n / 2, n, false)]);
+
+        // No triangle crosses the seam and the area is unchanged.
+        float area = 0.f;
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            bool left = false, right = false;
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                uint32_t index = result.indices[i + j];
+                if (index >= seamOffset || positions[index].x > n / 2) right = true;
+                else if (positions[index].x < n / 2) left = true;
+            }
+            EXPECT(!(left && right)) << "i = " << i;
+
+            const float3& a = positions[result.indices[i]];
+            area += 0.5f * glm::length(glm::cross(positions[result.indices[i + 1]] - a, positions[result.indices[i + 2]] - a));
+        }
+        EXPECT_LE(std::abs(area - n * n), 1e-3f);
+    }
+}
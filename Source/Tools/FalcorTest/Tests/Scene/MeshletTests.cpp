@@ -0,0 +1,240 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/MeshOptimizer.h"
+#include "GridMesh.h"
+
+// The large meshlet benchmarks are disabled by default as they take a long time to run.
+//#define RUN_LARGE_MESHLET_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Returns the mesh indices of the meshlet triangles in meshlet order.
+        */
+        std::vector<uint32_t> getMeshletIndices(const MeshOptimizer::MeshletList& meshlets)
+        {
+            std::vector<uint32_t> indices;
+            for (const auto& meshlet : meshlets.meshlets)
+            {
+                for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+                {
+                    const uint32_t packed = meshlets.triangles[meshlet.triangleOffset + t];
+                    for (uint32_t k = 0; k < 3; k++) indices.push_back(meshlets.vertices[meshlet.vertexOffset + ((packed >> (k * 8)) & 0xff)]);
+                }
+            }
+            return indices;
+        }
+
+        /** Returns true if the meshlet is culled by its normal cone when viewed from the given position.
+        */
+        bool isBackfacing(const MeshOptimizer::MeshletBounds& bounds, const float3& viewPos)
+        {
+            float3 dir = bounds.center - viewPos;
+            float dist = glm::length(dir);
+            return glm::dot(dir, bounds.coneAxis) >= bounds.coneCutoff * dist + bounds.radius;
+        }
+
+        /** Partition the given number of n x n grid meshes, first serially then in parallel as done by the scene builder.
+        */
+        void benchmarkMeshlets(CPUUnitTestContext& ctx, uint32_t meshCount, uint32_t n)
+        {
+            GridMesh mesh(n, 1.f, GridMesh::waves);
+            const uint32_t vertexCount = mesh.getVertexCount();
+            const auto indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+
+            auto buildMeshlets = [&]()
+            {
+                auto meshlets = MeshOptimizer::buildMeshlets(indices, vertexCount, MeshletDesc::kMaxVertices, MeshletDesc::kMaxTriangles);
+                for (const auto& meshlet : meshlets.meshlets) MeshOptimizer::computeMeshletBounds(meshlets, meshlet, mesh.positions.data());
+                return meshlets.meshlets.size();
+            };
+
+            std::vector<size_t> serialCounts(meshCount), parallelCounts(meshCount);
+
+            CpuTimer timer;
+            timer.update();
+            for (uint32_t i = 0; i < meshCount; i++) serialCounts[i] = buildMeshlets();
+            timer.update();
+            double serialTime = timer.delta() * 1000.0;
+
+            timer.update();
+            Threading::parallelFor(0, meshCount, [&](uint32_t i) { parallelCounts[i] = buildMeshlets(); }, 1);
+            timer.update();
+            double parallelTime = timer.delta() * 1000.0;
+
+            EXPECT(serialCounts == parallelCounts);
+
+            uint64_t triangleCount = (uint64_t)meshCount * indices.size() / 3;
+            logInfo("Meshlets: " + std::to_string(meshCount) + " meshes, " + std::to_string(triangleCount) + " triangles, " + std::to_string(serialCounts[0] * meshCount) + " meshlets. " +
+                "Serial: " + std::to_string(serialTime) + " ms, parallel: " + std::to_string(parallelTime) + " ms.");
+        }
+    }
+
+    CPU_TEST(Meshlets_Limits)
+    {
+        GridMesh mesh(64, 1.f, GridMesh::waves, true);
+        const uint32_t vertexCount = mesh.getVertexCount();
+        const auto indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+
+        for (uint32_t maxVertices : { 3u, 32u, 64u, 256u })
+        {
+            auto meshlets = MeshOptimizer::buildMeshlets(indices, vertexCount, maxVertices, MeshletDesc::kMaxTriangles);
+
+            // The meshlets reproduce the input triangles in order with unchanged winding.
+            EXPECT(getMeshletIndices(meshlets) == indices) << "maxVertices = " << maxVertices;
+
+            uint32_t vertexOffset = 0, triangleOffset = 0;
+            for (const auto& meshlet : meshlets.meshlets)
+            {
+                EXPECT_LE(meshlet.vertexCount, maxVertices);
+                EXPECT_LE(meshlet.triangleCount, MeshletDesc::kMaxTriangles);
+                EXPECT_GE(meshlet.triangleCount, 1u);
+                EXPECT_EQ(meshlet.vertexOffset, vertexOffset);
+                EXPECT_EQ(meshlet.triangleOffset, triangleOffset);
+                vertexOffset += meshlet.vertexCount;
+                triangleOffset += meshlet.triangleCount;
+            }
+            EXPECT_EQ(vertexOffset, meshlets.vertices.size());
+            EXPECT_EQ(triangleOffset, meshlets.triangles.size());
+        }
+
+        // A vertex cache optimized grid fills the meshlets well.
+        auto meshlets = MeshOptimizer::buildMeshlets(indices, vertexCount, MeshletDesc::kMaxVertices, MeshletDesc::kMaxTriangles);
+        double averageTriangleCount = (double)meshlets.triangles.size() / meshlets.meshlets.size();
+        EXPECT_GE(averageTriangleCount, 60.0);
+
+        // Degenerate triangles only use the unique vertices.
+        meshlets = MeshOptimizer::buildMeshlets({ 0, 0, 1, 2, 2, 2 }, 3, 3, 1);
+        EXPECT_EQ(meshlets.meshlets.size(), 2u);
+        EXPECT_EQ(meshlets.meshlets[0].vertexCount, 2u);
+        EXPECT_EQ(meshlets.meshlets[1].vertexCount, 1u);
+    }
+
+    CPU_TEST(Meshlets_Bounds)
+    {
+        GridMesh mesh(64, 1.f, GridMesh::waves);
+        const uint32_t vertexCount = mesh.getVertexCount();
+        const auto indices = MeshOptimizer::optimizeVertexCache(mesh.indices, vertexCount);
+        auto meshlets = MeshOptimizer::buildMeshlets(indices, vertexCount, MeshletDesc::kMaxVertices, MeshletDesc::kMaxTriangles);
+
+        for (size_t i = 0; i < meshlets.meshlets.size(); i++)
+        {
+            const auto& meshlet = meshlets.meshlets[i];
+            auto bounds = MeshOptimizer::computeMeshletBounds(meshlets, meshlet, mesh.positions.data());
+
+            // The bounding sphere contains all vertices.
+            for (uint32_t j = 0; j < meshlet.vertexCount; j++)
+            {
+                const float3 p = mesh.positions[meshlets.vertices[meshlet.vertexOffset + j]];
+                EXPECT_LE(glm::length(p - bounds.center), bounds.radius * 1.0001f) << "i = " << i;
+            }
+
+            // The grid is a height field facing +y, so every meshlet has a valid normal cone.
+            EXPECT_LT(bounds.coneCutoff, 1.f) << "i = " << i;
+            EXPECT_GT(bounds.coneAxis.y, 0.9f) << "i = " << i;
+
+            // Viewed from far below, the meshlets are culled. Viewed from above, they are not.
+            EXPECT(isBackfacing(bounds, float3(32.f, -1000.f, 32.f))) << "i = " << i;
+            EXPECT(!isBackfacing(bounds, float3(32.f, 1000.f, 32.f))) << "i = " << i;
+            EXPECT(!isBackfacing(bounds, bounds.center + float3(0.f, 1.f, 0.f))) << "i = " << i;
+        }
+
+        // A meshlet with opposing triangles can't be culled by orientation.
+        std::vector<float3> positions = { float3(0, 0, 0), float3(1, 0, 0), float3(0, 0, 1) };
+        meshlets = MeshOptimizer::buildMeshlets({ 0, 1, 2, 0, 2, 1 }, 3, 64, 124);
+        auto bounds = MeshOptimizer::computeMeshletBounds(meshlets, meshlets.meshlets[0], positions.data());
+        EXPECT_EQ(bounds.coneCutoff, 1.f);
+        EXPECT(!isBackfacing(bounds, float3(0.f, -1000.f, 0.f)));
+    }
+
+    GPU_TEST(Meshlets_SceneBuilder)
+    {
+        // The scene builder partitions the meshes in parallel. Its meshlets must match a serial build of each mesh.
+        // The meshes have different sizes so that the scene meshes can be matched to them by vertex count.
+        const uint32_t kGridSizes[] = { 16, 40, 7, 64, 23, 48 };
+        std::vector<GridMesh> meshes;
+        for (uint32_t n : kGridSizes) meshes.emplace_back(n, 1.f, GridMesh::waves, true);
+
+        auto pBuilder = SceneBuilder::create(SceneBuilder::Flags::GenerateMeshlets);
+        auto pMaterial = Material::create("Grid");
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            auto mesh = meshes[i].getMesh("Grid" + std::to_string(i), pMaterial);
+            uint32_t meshID = pBuilder->addMesh(mesh);
+            uint32_t nodeID = pBuilder->addNode(SceneBuilder::Node{ mesh.name, glm::identity<glm::mat4>(), glm::identity<glm::mat4>() });
+            pBuilder->addMeshInstance(nodeID, meshID);
+        }
+
+        auto pScene = pBuilder->getScene();
+        EXPECT_EQ(pScene->getMeshCount(), (uint32_t)meshes.size());
+
+        uint32_t totalMeshletCount = 0;
+        for (uint32_t meshID = 0; meshID < pScene->getMeshCount(); meshID++)
+        {
+            const auto& meshDesc = pScene->getMesh(meshID);
+            auto it = std::find_if(meshes.begin(), meshes.end(), [&](const GridMesh& grid) { return grid.getVertexCount() == meshDesc.vertexCount; });
+            EXPECT(it != meshes.end()) << "meshID = " << meshID;
+            if (it == meshes.end()) continue;
+
+            // The scene builder may renumber the vertices but keeps the triangle order. The meshlet partition and bounds
+            // only depend on the triangle order and positions, so they match exactly.
+            auto meshlets = MeshOptimizer::buildMeshlets(it->indices, it->getVertexCount(), MeshletDesc::kMaxVertices, MeshletDesc::kMaxTriangles);
+            EXPECT_EQ(meshDesc.meshletCount, (uint32_t)meshlets.meshlets.size()) << "meshID = " << meshID;
+            if (meshDesc.meshletCount != meshlets.meshlets.size()) continue;
+            totalMeshletCount += meshDesc.meshletCount;
+
+            const auto& firstDesc = pScene->getMeshlet(meshDesc.meshletOffset);
+            for (uint32_t i = 0; i < meshDesc.meshletCount; i++)
+            {
+                const auto& meshlet = meshlets.meshlets[i];
+                const auto bounds = MeshOptimizer::computeMeshletBounds(meshlets, meshlet, it->positions.data());
+                const auto& desc = pScene->getMeshlet(meshDesc.meshletOffset + i);
+
+                EXPECT_EQ(desc.meshID, meshID) << "meshID = " << meshID << ", i = " << i;
+                EXPECT_EQ(desc.getVertexCount(), meshlet.vertexCount) << "meshID = " << meshID << ", i = " << i;
+                EXPECT_EQ(desc.getTriangleCount(), meshlet.triangleCount) << "meshID = " << meshID << ", i = " << i;
+                EXPECT_EQ(desc.vertexOffset - firstDesc.vertexOffset, meshlet.vertexOffset) << "meshID = " << meshID << ", i = " << i;
+                EXPECT_EQ(desc.triangleOffset - firstDesc.triangleOffset, meshlet.triangleOffset) << "meshID = " << meshID << ", i = " << i;
+                EXPECT(desc.center == bounds.center && desc.radius == bounds.radius) << "meshID = " << meshID << ", i = " << i;
+                EXPECT(desc.coneAxis == bounds.coneAxis && desc.coneCutoff == bounds.coneCutoff) << "meshID = " << meshID << ", i = " << i;
+            }
+        }
+        EXPECT_EQ(pScene->getMeshletCount(), totalMeshletCount);
+    }
+
+    CPU_TEST(Meshlets_Benchmark)
+    {
+        benchmarkMeshlets(ctx, 4, 128);
+#ifdef RUN_LARGE_MESHLET_BENCHMARKS
+        // 16 meshes of 512 x 512 quads (8M triangles total).
+        benchmarkMeshlets(ctx, 16, 512);
+#endif
+    }
+}
@@ -0,0 +1,188 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "GridMesh.h"
+
+// The large vertex merge benchmarks are disabled by default as they take a long time and use a lot of memory.
+//#define RUN_LARGE_VERTEX_MERGE_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Synthetic flat shaded grid mesh of n x n quads.
+            Normals are specified per face and texture coordinates per face corner, so each grid vertex
+            is split into several vertices with different attributes, which is the worst case for vertex merging.
+        */
+        struct SplitGridMesh : GridMesh
+        {
+            std::vector<float4> tangents;
+
+            SplitGridMesh(uint32_t n) : GridMesh(n, 1.f, [](uint32_t x, uint32_t y) { return std::sin(float(x + y)); })
+            {
+                normals.clear();
+                texCrds.clear();
+                for (size_t i = 0; i < indices.size(); i += 3)
+                {
+                    // Texture coordinates are mirrored per quad, so shared corners get different values.
+                    const uint32_t x = uint32_t(i / 6) % n;
+                    for (size_t j = i; j < i + 3; j++)
+                    {
+                        texCrds.push_back(float2((indices[j] % (n + 1)) & 1, (indices[j] / (n + 1)) & 1) * float2((x & 1) ? -1.f : 1.f, 1.f));
+                        tangents.push_back(float4(1.f, 0.f, 0.f, 1.f));
+                    }
+                    float3 e0 = positions[indices[i + 1]] - positions[indices[i]];
+                    float3 e1 = positions[indices[i + 2]] - positions[indices[i]];
+                    normals.push_back(glm::normalize(glm::cross(e0, e1)));
+                }
+            }
+
+            SceneBuilder::Mesh getMesh(const Material::SharedPtr& pMaterial) const
+            {
+                SceneBuilder::Mesh mesh = GridMesh::getMesh("SplitGrid", pMaterial);
+                mesh.normals = { normals.data(), SceneBuilder::Mesh::AttributeFrequency::Uniform };
+                mesh.tangents = { tangents.data(), SceneBuilder::Mesh::AttributeFrequency::FaceVarying };
+                mesh.texCrds = { texCrds.data(), SceneBuilder::Mesh::AttributeFrequency::FaceVarying };
+                mesh.useOriginalTangentSpace = true;
+                return mesh;
+            }
+        };
+
+        SceneBuilder::ProcessedMesh processMesh(const SceneBuilder::Mesh& mesh, SceneBuilder::Flags flags)
+        {
+            auto pBuilder = SceneBuilder::create(flags | SceneBuilder::Flags::Force32BitIndices);
+            return pBuilder->processMesh(mesh);
+        }
+
+        void testVertexMergeEquivalence(CPUUnitTestContext& ctx, const SceneBuilder::Mesh& mesh)
+        {
+            auto ref = processMesh(mesh, SceneBuilder::Flags::None);
+            auto res = processMesh(mesh, SceneBuilder::Flags::HashedVertexMerge);
+
+            EXPECT_EQ(ref.indexCount, res.indexCount);
+            EXPECT_LE(res.staticData.size(), ref.staticData.size());
+            if (ref.indexCount != res.indexCount) return;
+
+            // Each triangle corner must reference an equivalent vertex.
+            const float threshold = 1e-6f;
+            for (size_t i = 0; i < ref.indexCount; i++)
+            {
+                const auto& a = ref.staticData[ref.indexData[i]];
+                const auto& b = res.staticData[res.indexData[i]];
+                EXPECT(a.position == b.position) << "i = " << i;
+                EXPECT(glm::all(glm::lessThanEqual(glm::abs(a.normal - b.normal), float3(threshold)))) << "i = " << i;
+                EXPECT(glm::all(glm::lessThanEqual(glm::abs(a.tangent - b.tangent), float4(threshold)))) << "i = " << i;
+                EXPECT(glm::all(glm::lessThanEqual(glm::abs(a.texCrd - b.texCrd), float2(threshold)))) << "i = " << i;
+            }
+        }
+
+        void benchmarkVertexMerge(uint32_t n)
+        {
+            SplitGridMesh grid(n);
+            auto pMaterial = Material::create("Grid");
+            auto mesh = grid.getMesh(pMaterial);
+
+            auto run = [&](SceneBuilder::Flags flags, size_t& vertexCount)
+            {
+                CpuTimer timer;
+                timer.update();
+                auto processed = processMesh(mesh, flags);
+                timer.update();
+                vertexCount = processed.staticData.size();
+                return timer.delta() * 1000.0;
+            };
+
+            size_t refVertexCount = 0, hashVertexCount = 0;
+            double refTime = run(SceneBuilder::Flags::None, refVertexCount);
+            double hashTime = run(SceneBuilder::Flags::HashedVertexMerge, hashVertexCount);
+
+            logInfo("Vertex merge: " + std::to_string(mesh.indexCount) + " indices. " +
+                "Default: " + std::to_string(refTime) + " ms (" + std::to_string(refVertexCount) + " vertices), " +
+                "hashed: " + std::to_string(hashTime) + " ms (" + std::to_string(hashVertexCount) + " vertices).");
+        }
+    }
+
+    CPU_TEST(HashedVertexMerge_SplitVertices)
+    {
+        SplitGridMesh grid(32);
+        auto pMaterial = Material::create("Grid");
+        auto mesh = grid.getMesh(pMaterial);
+        testVertexMergeEquivalence(ctx, mesh);
+
+        // All vertices in the grid have unique positions, so both methods should find the same set of vertices.
+        auto ref = processMesh(mesh, SceneBuilder::Flags::None);
+        auto res = processMesh(mesh, SceneBuilder::Flags::HashedVertexMerge);
+        EXPECT_EQ(ref.staticData.size(), res.staticData.size());
+    }
+
+    CPU_TEST(HashedVertexMerge_FaceVaryingPositions)
+    {
+        // Specify all attributes per face corner with a trivial index buffer.
+        // The default method only merges vertices sharing an original index, so nothing is merged.
+        SplitGridMesh grid(16);
+        std::vector<float3> positions;
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < grid.indices.size(); i++)
+        {
+            positions.push_back(grid.positions[grid.indices[i]]);
+            indices.push_back(i);
+        }
+
+        auto pMaterial = Material::create("Grid");
+        auto mesh = grid.getMesh(pMaterial);
+        mesh.vertexCount = (uint32_t)positions.size();
+        mesh.pIndices = indices.data();
+        mesh.positions = { positions.data(), SceneBuilder::Mesh::AttributeFrequency::FaceVarying };
+        testVertexMergeEquivalence(ctx, mesh);
+
+        auto ref = processMesh(mesh, SceneBuilder::Flags::None);
+        auto res = processMesh(mesh, SceneBuilder::Flags::HashedVertexMerge);
+        EXPECT_EQ(ref.staticData.size(), indices.size());
+        EXPECT_LT(res.staticData.size(), ref.staticData.size());
+    }
+
+    CPU_TEST(HashedVertexMerge_LargeValues)
+    {
+        // Texture coordinates far beyond the range of the quantization cells must still be merged correctly.
+        SplitGridMesh grid(8);
+        for (auto& texCrd : grid.texCrds) texCrd = texCrd * 1e13f + float2(3e18f, -3e18f);
+
+        auto pMaterial = Material::create("Grid");
+        testVertexMergeEquivalence(ctx, grid.getMesh(pMaterial));
+    }
+
+    CPU_TEST(HashedVertexMerge_Benchmark)
+    {
+        // Grid sizes for approx 1M, 10M and 50M indices.
+        benchmarkVertexMerge(408);
+#ifdef RUN_LARGE_VERTEX_MERGE_BENCHMARKS
+        benchmarkVertexMerge(1291);
+        benchmarkVertexMerge(2887);
+#endif
+    }
+}
@@ -0,0 +1,168 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneCache.h"
+#include "GridMesh.h"
+#include <filesystem>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        const SceneCache::Key kTestKey = 0x5ce9eca4ef1e5701ull;
+
+        SceneBuilder::SharedPtr createTestScene(uint32_t meshCount, uint32_t gridSize)
+        {
+            auto pBuilder = SceneBuilder::create();
+            GridMesh grid(gridSize, 1.f / gridSize);
+
+            auto pMaterial = Material::create("Grid");
+            pMaterial->setBaseColor(float4(0.5f, 0.25f, 0.125f, 1.f));
+            addGridInstances(*pBuilder, grid, pMaterial, meshCount, 1.f);
+
+            auto pCamera = Camera::create("Camera");
+            pCamera->setPosition(float3(1.f, 2.f, 3.f));
+            pBuilder->addCamera(pCamera);
+
+            return pBuilder;
+        }
+
+        /** Sets a temporary cache directory for the duration of a test.
+        */
+        class ScopedCacheDirectory
+        {
+        public:
+            ScopedCacheDirectory()
+                : mPrevDirectory(SceneCache::getCacheDirectory())
+                , mDirectory((std::filesystem::temp_directory_path() / "FalcorSceneCacheTests").string())
+            {
+                SceneCache::setCacheDirectory(mDirectory);
+            }
+
+            ~ScopedCacheDirectory()
+            {
+                SceneCache::setCacheDirectory(mPrevDirectory);
+                std::error_code ec;
+                std::filesystem::remove_all(mDirectory, ec);
+            }
+
+        private:
+            std::string mPrevDirectory;
+            std::string mDirectory;
+        };
+
+        std::vector<uint8_t> readBytes(const std::string& filename)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+    }
+
+    CPU_TEST(SceneCache_RoundTrip)
+    {
+        ScopedCacheDirectory cacheDirectory;
+
+        auto pBuilder = createTestScene(4, 8);
+        pBuilder->prepareSceneData();
+        EXPECT(SceneCache::writeCache(*pBuilder, kTestKey));
+        EXPECT(SceneCache::hasValidCache(kTestKey));
+        EXPECT(!SceneCache::hasValidCache(kTestKey + 1));
+
+        auto pCached = SceneBuilder::create();
+        EXPECT(SceneCache::readCache(*pCached, kTestKey));
+
+        EXPECT_EQ(pCached->getMaterials().size(), pBuilder->getMaterials().size());
+        EXPECT_EQ(pCached->getCameras().size(), pBuilder->getCameras().size());
+        if (!pCached->getMaterials().empty())
+        {
+            EXPECT(*pCached->getMaterials()[0] == *pBuilder->getMaterials()[0]);
+        }
+        if (!pCached->getCameras().empty())
+        {
+            EXPECT(pCached->getCameras()[0]->getPosition() == float3(1.f, 2.f, 3.f));
+        }
+
+        // Writing the state read back from the cache must reproduce the cache file exactly.
+        const std::string filename = SceneCache::getCacheFilename(kTestKey);
+        auto expected = readBytes(filename);
+        EXPECT(SceneCache::writeCache(*pCached, kTestKey));
+        auto actual = readBytes(filename);
+        EXPECT(!expected.empty());
+        EXPECT(expected == actual);
+    }
+
+    CPU_TEST(SceneCache_Corrupted)
+    {
+        ScopedCacheDirectory cacheDirectory;
+
+        auto pBuilder = createTestScene(1, 4);
+        pBuilder->prepareSceneData();
+        EXPECT(SceneCache::writeCache(*pBuilder, kTestKey));
+
+        // Truncate the cache file. Reading it must fail gracefully.
+        const std::string filename = SceneCache::getCacheFilename(kTestKey);
+        auto bytes = readBytes(filename);
+        {
+            std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+            file.write((const char*)bytes.data(), bytes.size() / 2);
+        }
+
+        auto pCached = SceneBuilder::create();
+        EXPECT(!SceneCache::readCache(*pCached, kTestKey));
+    }
+
+    CPU_TEST(SceneCache_Benchmark)
+    {
+        ScopedCacheDirectory cacheDirectory;
+
+        const uint32_t kMeshCount = 64;
+        const uint32_t kGridSize = 64;
+
+        // Cold: build the scene and run all the post-processing.
+        CpuTimer timer;
+        timer.update();
+        auto pBuilder = createTestScene(kMeshCount, kGridSize);
+        pBuilder->prepareSceneData();
+        timer.update();
+        double coldTime = timer.delta() * 1000.0;
+
+        EXPECT(SceneCache::writeCache(*pBuilder, kTestKey));
+
+        // Warm: load the post-processed state from the cache.
+        timer.update();
+        auto pCached = SceneBuilder::create();
+        EXPECT(SceneCache::readCache(*pCached, kTestKey));
+        pCached->prepareSceneData();
+        timer.update();
+        double warmTime = timer.delta() * 1000.0;
+
+        logInfo("SceneCache: " + std::to_string(kMeshCount) + " meshes with " + std::to_string(2 * kGridSize * kGridSize) + " triangles each. " +
+            "Cold: " + std::to_string(coldTime) + " ms, warm: " + std::to_string(warmTime) + " ms.");
+    }
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "GridMesh.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create a scene with a row of quads, where the last one is animated along the y axis.
+        */
+        Scene::SharedPtr createTestScene(uint32_t meshCount)
+        {
+            auto pBuilder = SceneBuilder::create();
+            GridMesh quad(1);
+            auto nodeIDs = addGridInstances(*pBuilder, quad, Material::create("Quad"), meshCount, 2.f);
+
+            auto pAnimation = Animation::create("Move", nodeIDs.back(), 1.0);
+            pAnimation->addKeyframe({ 0.0, float3(2.f * (meshCount - 1), 0.f, 0.f) });
+            pAnimation->addKeyframe({ 1.0, float3(2.f * (meshCount - 1), 1.f, 0.f) });
+            pAnimation->setPostInfinityBehavior(Animation::Behavior::Cycle);
+            pBuilder->addAnimation(pAnimation);
+
+            auto pCamera = Camera::create("Camera");
+            pCamera->setPosition(float3(0.f, 2.f, 4.f));
+            pBuilder->addCamera(pCamera);
+
+            return pBuilder->getScene();
+        }
+    }
+
+    GPU_TEST(CopyContext_FlushCounts)
+    {
+        RenderContext* pContext = ctx.getRenderContext();
+        const uint64_t flushCount = pContext->getFlushCount();
+        const uint64_t syncCount = pContext->getSyncCount();
+
+        pContext->flush();
+        EXPECT_EQ(pContext->getFlushCount(), flushCount + 1);
+        EXPECT_EQ(pContext->getSyncCount(), syncCount);
+
+        pContext->flush(true);
+        EXPECT_EQ(pContext->getFlushCount(), flushCount + 2);
+        EXPECT_EQ(pContext->getSyncCount(), syncCount + 1);
+    }
+
+    GPU_TEST(Scene_UpdateDoesNotFlush)
+    {
+        RenderContext* pContext = ctx.getRenderContext();
+        auto pScene = createTestScene(8);
+        EXPECT(pScene->hasAnimation());
+
+        // The first update may build resources. All following frames move the animated quad.
+        pScene->update(pContext, 0.0);
+
+        for (uint32_t frame = 1; frame <= 8; frame++)
+        {
+            const uint64_t flushCount = pContext->getFlushCount();
+            auto updates = pScene->update(pContext, frame / 16.0);
+            EXPECT(is_set(updates, Scene::UpdateFlags::MeshesMoved)) << "frame = " << frame;
+
+            const auto& stats = pScene->getSceneStats();
+            EXPECT_EQ(stats.updateFlushCount, 0u) << "frame = " << frame;
+            EXPECT_EQ(stats.updateSyncCount, 0u) << "frame = " << frame;
+            EXPECT(stats.updateSyncCounts.empty()) << "frame = " << frame;
+            EXPECT_EQ(pContext->getFlushCount(), flushCount) << "frame = " << frame;
+        }
+
+        // Material edits are uploaded without a flush.
+        pScene->getMaterial(0)->setBaseColor(float4(1.f, 0.f, 0.f, 1.f));
+        auto updates = pScene->update(pContext, 0.5);
+        EXPECT(is_set(updates, Scene::UpdateFlags::MaterialsChanged));
+
+        const auto& stats = pScene->getSceneStats();
+        EXPECT_GT(stats.bufferUploadCount, 0u);
+        EXPECT_EQ(stats.updateFlushCount, 0u);
+        EXPECT_EQ(stats.updateSyncCount, 0u);
+    }
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/ShadowBuffer.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kElementCount = 1000;
+
+        void verifyBuffer(GPUUnitTestContext& ctx, const Buffer::SharedPtr& pBuffer, const ShadowBuffer<uint4>& shadow)
+        {
+            const uint4* pData = reinterpret_cast<const uint4*>(pBuffer->map(Buffer::MapType::Read));
+            for (uint32_t i = 0; i < kElementCount; i++)
+            {
+                EXPECT(pData[i] == shadow[i]) << "i = " << i;
+            }
+            pBuffer->unmap();
+        }
+    }
+
+    GPU_TEST(ShadowBuffer)
+    {
+        auto pBuffer = Buffer::createStructured(sizeof(uint4), kElementCount, ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
+
+        ShadowBuffer<uint4> shadow;
+        shadow.init(pBuffer);
+        EXPECT_EQ(shadow.getCount(), kElementCount);
+
+        // The initial contents are uploaded in full.
+        for (uint32_t i = 0; i < kElementCount; i++) shadow.set(i, uint4(i));
+        EXPECT(shadow.isDirty());
+        EXPECT_EQ(shadow.upload(), kElementCount * sizeof(uint4));
+        EXPECT(!shadow.isDirty());
+        EXPECT_EQ(shadow.upload(), 0u);
+        verifyBuffer(ctx, pBuffer, shadow);
+
+        // Rewriting unchanged elements doesn't upload.
+        for (uint32_t i = 0; i < kElementCount; i++) shadow.set(i, uint4(i));
+        EXPECT(!shadow.isDirty());
+
+        // Modified elements are uploaded as a single range spanning all of them.
+        shadow.set(10, uint4(1, 2, 3, 4));
+        shadow.set(500, uint4(5, 6, 7, 8));
+        shadow.set(100, uint4(9));
+        EXPECT_EQ(shadow.upload(), 491 * sizeof(uint4));
+        verifyBuffer(ctx, pBuffer, shadow);
+
+        shadow.set(kElementCount - 1, uint4(0));
+        EXPECT_EQ(shadow.upload(), sizeof(uint4));
+        verifyBuffer(ctx, pBuffer, shadow);
+    }
+}
@@ -0,0 +1,153 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/TlasInstanceList.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create a list with one instance per matrix, followed by an instance with identity transform.
+        */
+        TlasInstanceList createInstanceList(const std::vector<glm::mat4>& matrices)
+        {
+            std::vector<D3D12_RAYTRACING_INSTANCE_DESC> descs;
+            std::vector<uint32_t> matrixIDs;
+            for (uint32_t i = 0; i <= matrices.size(); i++)
+            {
+                const bool isIdentity = i == matrices.size();
+                D3D12_RAYTRACING_INSTANCE_DESC desc = {};
+                desc.InstanceID = i;
+                glm::mat4 transform4x4 = transpose(isIdentity ? glm::identity<glm::mat4>() : matrices[i]);
+                std::memcpy(desc.Transform, &transform4x4, sizeof(desc.Transform));
+                descs.push_back(desc);
+                matrixIDs.push_back(isIdentity ? TlasInstanceList::kIdentityMatrix : i);
+            }
+
+            TlasInstanceList list;
+            list.init(std::move(descs), std::move(matrixIDs));
+            return list;
+        }
+
+        float3 getTranslation(const D3D12_RAYTRACING_INSTANCE_DESC& desc)
+        {
+            return float3(desc.Transform[0][3], desc.Transform[1][3], desc.Transform[2][3]);
+        }
+    }
+
+    CPU_TEST(TlasInstanceList_Patch)
+    {
+        const uint32_t count = 100;
+        std::vector<glm::mat4> matrices(count);
+        for (uint32_t i = 0; i < count; i++) matrices[i] = glm::translate(glm::mat4(1.f), float3(i, 0, 0));
+
+        auto list = createInstanceList(matrices);
+        EXPECT(list.needsBuild());
+        EXPECT_EQ(list.getDirtyRange().first, 0);
+        EXPECT_EQ(list.getDirtyRange().second, count + 1);
+        EXPECT(list.beginBuild(true) == TlasInstanceList::BuildType::Rebuild);
+        list.clearDirtyRange();
+        EXPECT(!list.needsBuild());
+
+        // Moving two instances patches only their descs.
+        std::vector<bool> changed(count, false);
+        auto isMatrixChanged = [&](uint32_t matrixID) { return (bool)changed[matrixID]; };
+        matrices[10] = glm::translate(glm::mat4(1.f), float3(10, 1, 0));
+        matrices[20] = glm::translate(glm::mat4(1.f), float3(20, 2, 0));
+        changed[10] = changed[20] = true;
+
+        EXPECT_EQ(list.updateTransforms(matrices, isMatrixChanged), 2u);
+        EXPECT(list.needsBuild());
+        EXPECT_EQ(list.getDirtyRange().first, 10);
+        EXPECT_EQ(list.getDirtyRange().second, 21);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            EXPECT(getTranslation(list.getDescs()[i]) == float3(matrices[i][3])) << "i = " << i;
+            EXPECT_EQ(list.getDescs()[i].InstanceID, i);
+        }
+        EXPECT(getTranslation(list.getDescs()[count]) == float3(0.f));
+
+        // Flagged matrices that didn't change don't patch anything.
+        list.beginBuild(true);
+        list.clearDirtyRange();
+        EXPECT_EQ(list.updateTransforms(matrices, isMatrixChanged), 0u);
+        EXPECT(!list.needsBuild());
+        EXPECT(list.getDirtyRange().first == list.getDirtyRange().second);
+
+        // A build can be requested without changing descs, e.g. when the BLASes are updated.
+        list.invalidate();
+        EXPECT(list.needsBuild());
+        EXPECT(list.getDirtyRange().first == list.getDirtyRange().second);
+    }
+
+    CPU_TEST(TlasInstanceList_Rebuild)
+    {
+        const uint32_t count = 100;
+        std::vector<glm::mat4> matrices(count);
+        for (uint32_t i = 0; i < count; i++) matrices[i] = glm::translate(glm::mat4(1.f), float3(i, 0, 0));
+
+        auto list = createInstanceList(matrices);
+        list.setRebuildHeuristic(0.05f, 1000);
+
+        // Without update support, the TLAS is always rebuilt.
+        EXPECT(list.beginBuild(false) == TlasInstanceList::BuildType::Rebuild);
+        EXPECT(list.beginBuild(false) == TlasInstanceList::BuildType::Rebuild);
+
+        // Small movements are refit. The instances span 99 units, so moving one instance by 0.1 units is negligible.
+        std::vector<bool> changed(count, false);
+        auto isMatrixChanged = [&](uint32_t matrixID) { return (bool)changed[matrixID]; };
+        changed[0] = true;
+        matrices[0] = glm::translate(glm::mat4(1.f), float3(0.f, 0.1f, 0.f));
+        list.updateTransforms(matrices, isMatrixChanged);
+        EXPECT(list.beginBuild(true) == TlasInstanceList::BuildType::Refit);
+        EXPECT_EQ(list.getRefitCount(), 1u);
+        EXPECT_LT(list.getRelativeDisplacement(), 0.05f);
+
+        // Moving all instances far from their position at the last rebuild triggers a rebuild.
+        std::fill(changed.begin(), changed.end(), true);
+        for (uint32_t i = 0; i < count; i++) matrices[i] = glm::translate(glm::mat4(1.f), float3(i, 10, 0));
+        list.updateTransforms(matrices, isMatrixChanged);
+        EXPECT_GT(list.getRelativeDisplacement(), 0.05f);
+        EXPECT(list.beginBuild(true) == TlasInstanceList::BuildType::Rebuild);
+        EXPECT_EQ(list.getRefitCount(), 0u);
+        EXPECT_EQ(list.getRelativeDisplacement(), 0.f);
+
+        // The displacement is measured from the positions at the last rebuild, not accumulated per update.
+        for (uint32_t frame = 0; frame < 100; frame++)
+        {
+            const float offset = (frame % 2) ? 0.1f : 0.f;
+            for (uint32_t i = 0; i < count; i++) matrices[i] = glm::translate(glm::mat4(1.f), float3(i, 10 + offset, 0));
+            list.updateTransforms(matrices, isMatrixChanged);
+            EXPECT(list.beginBuild(true) == TlasInstanceList::BuildType::Refit) << "frame = " << frame;
+        }
+
+        // The number of consecutive refits is limited.
+        list.setRebuildHeuristic(0.05f, 100);
+        EXPECT(list.beginBuild(true) == TlasInstanceList::BuildType::Rebuild);
+    }
+}
@@ -0,0 +1,296 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Animation/TransformHierarchy.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// The large transform hierarchy benchmarks are disabled by default as they take a long time to run.
+//#define RUN_LARGE_TRANSFORM_HIERARCHY_BENCHMARKS
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kInvalidNode = TransformHierarchy::kInvalidNode;
+
+        glm::mat4 randomTransform(std::mt19937& rng)
+        {
+            std::uniform_real_distribution<float> u(-1.f, 1.f);
+            glm::mat4 m = glm::translate(glm::mat4(1.f), float3(u(rng), u(rng), u(rng)));
+            m = glm::rotate(m, u(rng) * glm::pi<float>(), glm::normalize(float3(u(rng), u(rng), u(rng)) + float3(0.f, 0.f, 2.f)));
+            return glm::scale(m, float3(1.f) + 0.1f * float3(u(rng), u(rng), u(rng)));
+        }
+
+        float maxDifference(const glm::mat4& a, const glm::mat4& b)
+        {
+            float d = 0.f;
+            for (int c = 0; c < 4; c++) for (int r = 0; r < 4; r++) d = std::max(d, std::abs(a[c][r] - b[c][r]));
+            return d;
+        }
+
+        /** Reference implementation recomputing all matrices, as the animation controller did before incremental updates.
+        */
+        struct ReferenceHierarchy
+        {
+            std::vector<uint32_t> parents;
+            std::vector<glm::mat4> localMatrices;
+            std::vector<glm::mat4> localToBindSpace;
+            std::vector<glm::mat4> globalMatrices;
+            std::vector<glm::mat4> invTransposeGlobalMatrices;
+            std::vector<glm::mat4> skinningMatrices;
+            std::vector<glm::mat4> invTransposeSkinningMatrices;
+
+            void update()
+            {
+                globalMatrices = localMatrices;
+                invTransposeGlobalMatrices.resize(globalMatrices.size());
+                skinningMatrices.resize(globalMatrices.size());
+                invTransposeSkinningMatrices.resize(globalMatrices.size());
+                for (size_t i = 0; i < globalMatrices.size(); i++)
+                {
+                    if (parents[i] != kInvalidNode) globalMatrices[i] = globalMatrices[parents[i]] * globalMatrices[i];
+                    invTransposeGlobalMatrices[i] = glm::transpose(glm::inverse(globalMatrices[i]));
+                    skinningMatrices[i] = globalMatrices[i] * localToBindSpace[i];
+                    invTransposeSkinningMatrices[i] = glm::transpose(glm::inverse(skinningMatrices[i]));
+                }
+            }
+        };
+
+        /** Synthetic scene graphs.
+        */
+        enum class HierarchyType
+        {
+            Random,     ///< Random forest.
+            Deep,       ///< Single chain of nodes.
+            Wide,       ///< Single root with all other nodes as children.
+        };
+
+        std::vector<uint32_t> createParents(HierarchyType type, uint32_t nodeCount, std::mt19937& rng)
+        {
+            std::vector<uint32_t> parents(nodeCount, kInvalidNode);
+            for (uint32_t i = 1; i < nodeCount; i++)
+            {
+                switch (type)
+                {
+                case HierarchyType::Random: parents[i] = rng() % 10 == 0 ? kInvalidNode : rng() % i; break;
+                case HierarchyType::Deep: parents[i] = i - 1; break;
+                case HierarchyType::Wide: parents[i] = 0; break;
+                }
+            }
+            return parents;
+        }
+
+        void benchmarkUpdate(HierarchyType type, const std::string& typeName, uint32_t nodeCount, uint32_t animatedCount)
+        {
+            std::mt19937 rng;
+            ReferenceHierarchy ref;
+            ref.parents = createParents(type, nodeCount, rng);
+            ref.localToBindSpace.resize(nodeCount, glm::mat4(1.f));
+            for (uint32_t i = 0; i < nodeCount; i++) ref.localMatrices.push_back(randomTransform(rng));
+
+            // Animate nodes in the second half of the node list, which is the lower half of the deep hierarchy.
+            std::vector<bool> animated(nodeCount, false);
+            std::vector<uint32_t> animatedNodes;
+            for (uint32_t i = 0; i < animatedCount; i++)
+            {
+                uint32_t nodeID = nodeCount / 2 + rng() % (nodeCount - nodeCount / 2);
+                animated[nodeID] = true;
+                animatedNodes.push_back(nodeID);
+            }
+
+            TransformHierarchy hierarchy(ref.parents, ref.localMatrices, animated, ref.localToBindSpace);
+            hierarchy.update();
+
+            const uint32_t frameCount = 10;
+            glm::mat4 transform = randomTransform(rng);
+
+            CpuTimer timer;
+            timer.update();
+            for (uint32_t frame = 0; frame < frameCount; frame++)
+            {
+                for (uint32_t nodeID : animatedNodes) ref.localMatrices[nodeID] = transform;
+                ref.update();
+            }
+            timer.update();
+            double referenceTime = timer.delta() * 1000.0 / frameCount;
+
+            size_t uploadedCount = 0;
+            size_t rangeCount = 0;
+            timer.update();
+            for (uint32_t frame = 0; frame < frameCount; frame++)
+            {
+                hierarchy.clearChanges();
+                for (uint32_t nodeID : animatedNodes) hierarchy.setLocalMatrix(nodeID, transform);
+                hierarchy.update();
+                auto ranges = hierarchy.getChangedRanges(16);
+                rangeCount = ranges.size();
+                uploadedCount = 0;
+                for (const auto& range : ranges) uploadedCount += range.count;
+            }
+            timer.update();
+            double incrementalTime = timer.delta() * 1000.0 / frameCount;
+
+            logInfo("TransformHierarchy " + typeName + ": " + std::to_string(nodeCount) + " nodes, " + std::to_string(animatedCount) + " animated. " +
+                "Full update: " + std::to_string(referenceTime) + " ms, incremental: " + std::to_string(incrementalTime) + " ms per frame. " +
+                "Uploading " + std::to_string(uploadedCount) + " matrices in " + std::to_string(rangeCount) + " ranges.");
+        }
+    }
+
+    CPU_TEST(TransformHierarchy_Incremental)
+    {
+        const uint32_t nodeCount = 2000;
+        std::mt19937 rng;
+
+        ReferenceHierarchy ref;
+        ref.parents = createParents(HierarchyType::Random, nodeCount, rng);
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            ref.localMatrices.push_back(randomTransform(rng));
+            ref.localToBindSpace.push_back(randomTransform(rng));
+        }
+
+        std::vector<bool> animated(nodeCount, false);
+        std::vector<uint32_t> animatedNodes;
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            if (rng() % 20 == 0)
+            {
+                animated[i] = true;
+                animatedNodes.push_back(i);
+            }
+        }
+
+        TransformHierarchy hierarchy(ref.parents, ref.localMatrices, animated, ref.localToBindSpace);
+        const auto initialLocalMatrices = ref.localMatrices;
+
+        for (uint32_t frame = 0; frame < 20; frame++)
+        {
+            hierarchy.clearChanges();
+
+            // Restore the initial matrices in one frame, as done when animations are disabled.
+            bool reset = frame == 10;
+            if (reset)
+            {
+                hierarchy.resetLocalMatrices();
+                ref.localMatrices = initialLocalMatrices;
+            }
+
+            // Change a random subset of the animated nodes.
+            std::vector<bool> expectedChanged(nodeCount, false);
+            for (uint32_t nodeID : animatedNodes)
+            {
+                if (reset || frame == 0) expectedChanged[nodeID] = true;
+                if (rng() % 4 == 0)
+                {
+                    auto m = randomTransform(rng);
+                    hierarchy.setLocalMatrix(nodeID, m);
+                    ref.localMatrices[nodeID] = m;
+                    expectedChanged[nodeID] = true;
+                }
+            }
+            for (uint32_t i = 0; i < nodeCount; i++)
+            {
+                if (ref.parents[i] != kInvalidNode && expectedChanged[ref.parents[i]]) expectedChanged[i] = true;
+            }
+
+            hierarchy.update();
+            ref.update();
+
+            float maxDiff = 0.f;
+            bool changedMatches = true;
+            for (uint32_t i = 0; i < nodeCount; i++)
+            {
+                maxDiff = std::max(maxDiff, maxDifference(hierarchy.getGlobalMatrices()[i], ref.globalMatrices[i]));
+                maxDiff = std::max(maxDiff, maxDifference(hierarchy.getInvTransposeGlobalMatrices()[i], ref.invTransposeGlobalMatrices[i]));
+                maxDiff = std::max(maxDiff, maxDifference(hierarchy.getSkinningMatrices()[i], ref.skinningMatrices[i]));
+                maxDiff = std::max(maxDiff, maxDifference(hierarchy.getInvTransposeSkinningMatrices()[i], ref.invTransposeSkinningMatrices[i]));
+                changedMatches &= hierarchy.isChanged(i) == expectedChanged[i];
+            }
+            EXPECT_LE(maxDiff, 1e-3f) << "frame " << frame;
+            EXPECT(changedMatches) << "frame " << frame;
+
+            // Without merging, the changed ranges cover exactly the changed nodes, or all nodes after a full update.
+            auto ranges = hierarchy.getChangedRanges();
+            if (reset || frame == 0)
+            {
+                EXPECT(ranges.size() == 1 && ranges[0].offset == 0 && ranges[0].count == nodeCount) << "frame " << frame;
+            }
+            else
+            {
+                std::vector<bool> inRange(nodeCount, false);
+                for (const auto& range : ranges) for (uint32_t i = 0; i < range.count; i++) inRange[range.offset + i] = true;
+                EXPECT(inRange == expectedChanged) << "frame " << frame;
+            }
+        }
+    }
+
+    CPU_TEST(TransformHierarchy_ChangedRanges)
+    {
+        // Nodes 1, 2, 3 and 6 are animated.
+        std::vector<uint32_t> parents = { kInvalidNode, 0, 1, 0, 0, 0, 0, 0 };
+        std::vector<bool> animated = { false, true, false, true, false, false, true, false };
+        TransformHierarchy hierarchy(parents, std::vector<glm::mat4>(parents.size(), glm::mat4(1.f)), animated);
+        hierarchy.update();
+
+        hierarchy.clearChanges();
+        hierarchy.setLocalMatrix(1, glm::mat4(2.f));
+        hierarchy.setLocalMatrix(6, glm::mat4(2.f));
+        hierarchy.update();
+
+        // Node 2 changes with its parent.
+        auto ranges = hierarchy.getChangedRanges();
+        EXPECT_EQ(ranges.size(), 2u);
+        if (ranges.size() == 2)
+        {
+            EXPECT(ranges[0].offset == 1 && ranges[0].count == 2);
+            EXPECT(ranges[1].offset == 6 && ranges[1].count == 1);
+        }
+
+        ranges = hierarchy.getChangedRanges(3);
+        EXPECT_EQ(ranges.size(), 1u);
+        if (ranges.size() == 1) EXPECT(ranges[0].offset == 1 && ranges[0].count == 6);
+
+        // No changes.
+        hierarchy.clearChanges();
+        hierarchy.update();
+        EXPECT(hierarchy.getChangedRanges().empty());
+    }
+
+    CPU_TEST(TransformHierarchy_Benchmark)
+    {
+        benchmarkUpdate(HierarchyType::Deep, "deep", 100000, 1);
+        benchmarkUpdate(HierarchyType::Wide, "wide", 100000, 10);
+        benchmarkUpdate(HierarchyType::Random, "random", 100000, 10);
+#ifdef RUN_LARGE_TRANSFORM_HIERARCHY_BENCHMARKS
+        benchmarkUpdate(HierarchyType::Deep, "deep", 1000000, 1);
+        benchmarkUpdate(HierarchyType::Wide, "wide", 1000000, 100);
+        benchmarkUpdate(HierarchyType::Random, "random", 1000000, 100);
+#endif
+    }
+}
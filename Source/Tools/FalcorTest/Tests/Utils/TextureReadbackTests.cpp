@@ -0,0 +1,72 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/TextureReadback.h"
+
+namespace Falcor
+{
+    GPU_TEST(TextureReadback_Ordering)
+    {
+        // Fake frames are written to the same texture and read back with fewer staging buffers than frames,
+        // so staging buffers are recycled. Each callback must see the contents of its own frame, in order.
+        const uint32_t width = 67, height = 33;
+        const uint32_t frameCount = 16;
+        Texture::SharedPtr pTexture = Texture::create2D(width, height, ResourceFormat::R32Uint, 1, 1, nullptr, Resource::BindFlags::ShaderResource);
+        auto pReadback = TextureReadback::create(3);
+        EXPECT_EQ(pReadback->getStagingBufferCount(), 3u);
+
+        std::vector<uint32_t> frames;
+        std::vector<uint32_t> mismatches;
+        std::vector<uint32_t> data(width * height);
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            for (uint32_t i = 0; i < data.size(); i++) data[i] = frame * 100000 + i;
+            ctx.getRenderContext()->updateTextureData(pTexture.get(), data.data());
+
+            pReadback->readTexture(ctx.getRenderContext(), pTexture.get(), 0, [&frames, &mismatches, frame, width, height] (const std::vector<uint8_t>& bytes)
+            {
+                frames.push_back(frame);
+                const uint32_t* pValues = reinterpret_cast<const uint32_t*>(bytes.data());
+                uint32_t count = bytes.size() == width * height * sizeof(uint32_t) ? width * height : 0;
+                uint32_t errors = count == 0 ? 1 : 0;
+                for (uint32_t i = 0; i < count; i++) if (pValues[i] != frame * 100000 + i) errors++;
+                mismatches.push_back(errors);
+            });
+            EXPECT_LE(pReadback->getPendingCount(), 3u);
+        }
+        pReadback->flush();
+
+        EXPECT_EQ(pReadback->getPendingCount(), 0u);
+        EXPECT_EQ(frames.size(), frameCount);
+        for (uint32_t i = 0; i < frames.size(); i++)
+        {
+            EXPECT_EQ(frames[i], i) << "i = " << i;
+            EXPECT_EQ(mismatches[i], 0u) << "i = " << i;
+        }
+    }
+}
@@ -0,0 +1,173 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <atomic>
+#include <execution>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Compute-bound work item for the benchmarks.
+        float work(uint32_t i)
+        {
+            float x = float(i);
+            for (uint32_t j = 0; j < 64; j++) x = std::sqrt(x * 1.0001f + 1.f);
+            return x;
+        }
+    }
+
+    CPU_TEST(Threading_DispatchTask)
+    {
+        std::atomic<uint32_t> counter = 0;
+        std::vector<Threading::Task> tasks;
+        for (uint32_t i = 0; i < 1000; i++) tasks.push_back(Threading::dispatchTask([&counter] () { counter++; }));
+        Threading::wait(tasks);
+        EXPECT_EQ(counter, 1000u);
+        for (const auto& task : tasks) EXPECT(!task.isRunning());
+
+        // Empty handles are never running.
+        Threading::Task task;
+        EXPECT(!task.isRunning());
+        task.finish();
+    }
+
+    CPU_TEST(Threading_Continuations)
+    {
+        // Each continuation only increments the value if its predecessors have run.
+        uint32_t value = 0;
+        auto task = Threading::dispatchTask([&value] () { value = 1; });
+        for (uint32_t i = 1; i <= 10; i++) task = task.then([&value, i] () { if (value == i) value++; });
+        task.finish();
+        EXPECT_EQ(value, 11u);
+
+        // Continuation of a finished task.
+        task = task.then([&value] () { value = 0; });
+        task.finish();
+        EXPECT_EQ(value, 0u);
+    }
+
+    CPU_TEST(Threading_ParallelFor)
+    {
+        const uint32_t count = 100000;
+        std::vector<uint32_t> visits(count, 0);
+        Threading::parallelFor(0, count, [&visits] (uint32_t i) { visits[i]++; });
+        EXPECT(std::all_of(visits.begin(), visits.end(), [] (uint32_t v) { return v == 1; }));
+
+        // Explicit grain sizes and ranges not starting at zero.
+        for (uint32_t grainSize : { 1u, 7u, 1000u, 200000u })
+        {
+            std::atomic<uint64_t> sum = 0;
+            Threading::parallelFor(100, 1100, [&sum] (uint32_t i) { sum += i; }, grainSize);
+            EXPECT_EQ(sum, 599500ull) << "grainSize " << grainSize;
+        }
+
+        // Empty range.
+        Threading::parallelFor(5, 5, [] (uint32_t) { throw std::runtime_error("Should not be called"); });
+    }
+
+    CPU_TEST(Threading_Nested)
+    {
+        // Nested loops and tasks waited on from within tasks must not deadlock.
+        std::atomic<uint32_t> counter = 0;
+        Threading::parallelFor(0, 64, [&counter] (uint32_t)
+        {
+            Threading::parallelFor(0, 100, [&counter] (uint32_t) { counter++; });
+            auto task = Threading::dispatchTask([&counter] () { counter++; });
+            task.finish();
+        });
+        EXPECT_EQ(counter, 64u * 101u);
+    }
+
+    CPU_TEST(Threading_Exceptions)
+    {
+        bool caught = false;
+        try
+        {
+            Threading::parallelFor(0, 1000, [] (uint32_t i) { if (i == 500) throw std::runtime_error("parallelFor"); });
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        EXPECT(caught);
+
+        caught = false;
+        auto task = Threading::dispatchTask([] () { throw std::runtime_error("task"); });
+        try
+        {
+            task.finish();
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        EXPECT(caught);
+    }
+
+    CPU_TEST(Threading_Benchmark)
+    {
+        CpuTimer timer;
+
+        // Task overhead.
+        const uint32_t taskCount = 100000;
+        timer.update();
+        for (uint32_t i = 0; i < taskCount; i++) Threading::dispatchTask([] () {});
+        Threading::finish();
+        timer.update();
+        logInfo("Threading: " + std::to_string(taskCount) + " empty tasks took " + std::to_string(timer.delta() * 1000.0) + " ms (" + std::to_string(timer.delta() * 1e9 / taskCount) + " ns per task)");
+
+        timer.update();
+        for (uint32_t i = 0; i < 10000; i++) Threading::parallelFor(0, Threading::getThreadCount() + 1, [] (uint32_t) {}, 1);
+        timer.update();
+        logInfo("Threading: 10000 minimal parallelFor calls took " + std::to_string(timer.delta() * 1000.0) + " ms");
+
+        // Scaling of a compute-bound loop.
+        const uint32_t count = 1 << 20;
+        std::vector<float> results(count);
+        auto range = NumericRange<uint32_t>(0, count);
+
+        timer.update();
+        for (uint32_t i = 0; i < count; i++) results[i] = work(i);
+        timer.update();
+        double serialTime = timer.delta() * 1000.0;
+
+        timer.update();
+        Threading::parallelFor(0, count, [&results] (uint32_t i) { results[i] = work(i); });
+        timer.update();
+        double parallelForTime = timer.delta() * 1000.0;
+
+        timer.update();
+        std::for_each(std::execution::par, range.begin(), range.end(), [&results] (uint32_t i) { results[i] = work(i); });
+        timer.update();
+        double stdParTime = timer.delta() * 1000.0;
+
+        logInfo("Threading: " + std::to_string(count) + " work items on " + std::to_string(Threading::getThreadCount()) + " workers. Serial: " + std::to_string(serialTime) +
+            " ms, parallelFor: " + std::to_string(parallelForTime) + " ms (" + std::to_string(serialTime / parallelForTime) + "x), std::execution::par: " + std::to_string(stdParTime) + " ms");
+    }
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/WorkQueue.h"
+#include <atomic>
+#include <chrono>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Gate that blocks the consumer until the test opens it.
+        */
+        struct Gate
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool open = false;
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] () { return open; });
+            }
+
+            void release()
+            {
+                { std::lock_guard<std::mutex> lock(mutex); open = true; }
+                cv.notify_all();
+            }
+        };
+    }
+
+    CPU_TEST(WorkQueue_Ordering)
+    {
+        // Fake producer pushing faster than the consumer runs. Tasks must execute in submission order.
+        const uint32_t count = 1000;
+        std::vector<uint32_t> order;
+        auto pQueue = WorkQueue::create(4);
+        EXPECT_EQ(pQueue->getCapacity(), 4u);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            pQueue->push([&order, i] () { order.push_back(i); });
+            EXPECT_LE(pQueue->getPendingCount(), 4u);
+        }
+        pQueue->flush();
+
+        EXPECT_EQ(pQueue->getPendingCount(), 0u);
+        EXPECT_EQ(order.size(), count);
+        for (uint32_t i = 0; i < order.size(); i++) EXPECT_EQ(order[i], i) << "i = " << i;
+    }
+
+    CPU_TEST(WorkQueue_BackPressure)
+    {
+        const uint32_t capacity = 3;
+        auto pQueue = WorkQueue::create(capacity);
+        Gate gate;
+        std::atomic<uint32_t> executed = 0;
+
+        // Fill the queue while the consumer is blocked. None of these pushes should stall.
+        pQueue->push([&] () { gate.wait(); executed++; });
+        for (uint32_t i = 1; i < capacity; i++) pQueue->push([&] () { executed++; });
+        EXPECT_EQ(pQueue->getPendingCount(), capacity);
+        EXPECT_EQ(pQueue->getStallCount(), 0u);
+
+        // The next push must block until the consumer makes room.
+        std::atomic<bool> pushed = false;
+        std::thread producer([&] () { pQueue->push([&] () { executed++; }); pushed = true; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT(!pushed);
+        EXPECT_EQ(executed, 0u);
+        EXPECT_EQ(pQueue->getPendingCount(), capacity);
+
+        gate.release();
+        producer.join();
+        EXPECT(pushed);
+        pQueue->flush();
+
+        EXPECT_EQ(executed, capacity + 1);
+        EXPECT_EQ(pQueue->getStallCount(), 1u);
+
+        // wait() returns once the pending count has dropped to the given limit.
+        Gate gate2;
+        pQueue->push([&] () { gate2.wait(); });
+        pQueue->push([] () {});
+        gate2.release();
+        pQueue->wait(1);
+        EXPECT_LE(pQueue->getPendingCount(), 1u);
+        pQueue->flush();
+    }
+
+    CPU_TEST(WorkQueue_Exceptions)
+    {
+        auto pQueue = WorkQueue::create(2);
+        bool ran = false;
+        pQueue->push([] () { throw std::exception("WorkQueue test exception"); });
+        pQueue->push([&ran] () { ran = true; });
+
+        // The exception is rethrown by flush() and doesn't stop the following tasks.
+        bool caught = false;
+        try { pQueue->flush(); }
+        catch (const std::exception&) { caught = true; }
+        EXPECT(caught);
+        EXPECT(ran);
+
+        caught = false;
+        try { pQueue->flush(); }
+        catch (const std::exception&) { caught = true; }
+        EXPECT(!caught);
+    }
+}
@@ -35,6 +35,16 @@
 #include <stdexcept>
 #include <map>
 #include <functional>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <filesystem>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
 
 template<typename T>
 T sqr(T x) { return x * x; }
@@ -159,70 +169,151 @@ private:
     {}
 };
 
+// Error metrics operating on one RGBA pixel at a time. The per-channel errors are averaged over the compared channels.
+
 struct MSE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    static constexpr double kScale = 1.0;
+    __m128 operator()(__m128 a, __m128 b) const
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += sqr(a[i] - b[i]); }
-        return error / count;
+        __m128 d = _mm_sub_ps(a, b);
+        return _mm_mul_ps(d, d);
     }
 };
 
 struct RMSE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    static constexpr double kScale = 1.0;
+    __m128 operator()(__m128 a, __m128 b) const
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += sqr(a[i] - b[i]) / (sqr(a[i]) + 1e-3); }
-        return error / count;
+        __m128 d = _mm_sub_ps(a, b);
+        return _mm_div_ps(_mm_mul_ps(d, d), _mm_add_ps(_mm_mul_ps(a, a), _mm_set1_ps(1e-3f)));
     }
 };
 
 struct MAE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    static constexpr double kScale = 1.0;
+    __m128 operator()(__m128 a, __m128 b) const
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += std::fabs(sqr(a[i] - b[i])); }
-        return error / count;
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 d = _mm_sub_ps(a, b);
+        return _mm_and_ps(_mm_mul_ps(d, d), absMask);
     }
 };
 
 struct MAPE
 {
-    double operator()(const float* a, const float* b, size_t count) const
+    static constexpr double kScale = 100.0;
+    __m128 operator()(__m128 a, __m128 b) const
     {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += std::fabs((a[i] - b[i]) / (a[i] + 1e-3)); }
-        return 100.0 * error / count;
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        return _mm_and_ps(_mm_div_ps(_mm_sub_ps(a, b), _mm_add_ps(a, _mm_set1_ps(1e-3f))), absMask);
     }
 };
 
+inline float horizontalSum(__m128 v)
+{
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+// Number of image rows processed as one work item.
+static const uint32_t kTileHeight = 16;
+
+struct CompareResult
+{
+    double error = 0.0;     ///< Error of the images. A lower bound if the comparison was stopped early.
+    bool complete = true;   ///< False if the comparison was stopped early because the error threshold was exceeded.
+};
+
+/** Compare two images using the given metric.
+    The image is split into tiles of rows that are compared in parallel. Errors are summed per tile and the tile sums
+    are reduced in a fixed order, so the result does not depend on the number of threads.
+    \param[in] imageA First image.
+    \param[in] imageB Second image.
+    \param[in] alpha Include the alpha channel.
+    \param[out] errorMap Optional per-pixel error map.
+    \param[in] exitThreshold If non-negative, tiles are skipped as soon as the error is known to exceed this threshold. Ignored if an error map is requested.
+    \return Returns the comparison result.
+*/
 template<typename Metric>
-double compare(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)
+CompareResult compare(const Image& imageA, const Image& imageB, bool alpha, float* errorMap, double exitThreshold)
 {
-    Metric metric;
-    double sum = 0.0;
-    const float* a = imageA.getData();
-    const float* b = imageB.getData();
-    size_t count = imageA.getWidth() * imageA.getHeight();
-    for (size_t i = 0; i < count; ++i)
+    const uint32_t width = imageA.getWidth();
+    const uint32_t height = imageA.getHeight();
+    const size_t count = size_t(width) * height;
+    const __m128 channelMask = _mm_castsi128_ps(_mm_set_epi32(alpha ? -1 : 0, -1, -1, -1));
+    const float invChannelCount = alpha ? 1.f / 4.f : 1.f / 3.f;
+
+    // All metrics are non-negative, so the partial sum of the finished tiles is a lower bound of the final error.
+    const bool earlyExit = exitThreshold >= 0.0 && !errorMap;
+    const double exitSum = exitThreshold * count / Metric::kScale;
+    std::atomic<double> finishedSum = 0.0;
+    std::atomic<bool> exceeded = false;
+
+    const uint32_t tileCount = (height + kTileHeight - 1) / kTileHeight;
+    std::vector<double> tileSums(tileCount, 0.0);
+    std::vector<uint32_t> tiles(tileCount);
+    std::iota(tiles.begin(), tiles.end(), 0);
+
+    std::for_each(std::execution::par, tiles.begin(), tiles.end(), [&](uint32_t tile)
     {
-        double error = metric(a, b, alpha ? 4 : 3);
-        if (errorMap) *errorMap++ = float(error);
-        sum += error;
-        a += 4;
-        b += 4;
-    }
-    return sum / count;
+        if (earlyExit && exceeded.load(std::memory_order_relaxed)) return;
+
+        Metric metric;
+        double tileSum = 0.0;
+        const uint32_t endRow = std::min(height, (tile + 1) * kTileHeight);
+        for (uint32_t y = tile * kTileHeight; y < endRow; y++)
+        {
+            const size_t rowOffset = size_t(y) * width;
+            const float* a = imageA.getData() + rowOffset * 4;
+            const float* b = imageB.getData() + rowOffset * 4;
+            float blockSum = 0.f;
+            double rowSum = 0.0;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                __m128 e = _mm_and_ps(metric(_mm_loadu_ps(a + x * 4), _mm_loadu_ps(b + x * 4)), channelMask);
+                float error = horizontalSum(e) * invChannelCount;
+                if (errorMap) errorMap[rowOffset + x] = error;
+
+                // Sum blocks of pixels in single precision and accumulate the blocks in double precision.
+                blockSum += error;
+                if ((x & 63) == 63)
+                {
+                    rowSum += blockSum;
+                    blockSum = 0.f;
+                }
+            }
+            tileSum += rowSum + blockSum;
+        }
+        tileSums[tile] = tileSum;
+
+        if (earlyExit)
+        {
+            double sum = finishedSum.load(std::memory_order_relaxed);
+            while (!finishedSum.compare_exchange_weak(sum, sum + tileSum, std::memory_order_relaxed)) {}
+            if (sum + tileSum > exitSum) exceeded.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    double sum = 0.0;
+    for (double tileSum : tileSums) sum += tileSum;
+
+    CompareResult result;
+    result.error = Metric::kScale * sum / count;
+    result.complete = !exceeded.load();
+    return result;
 }
 
 struct ErrorMetric
 {
     std::string name;
     std::string desc;
-    std::function<double(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)> compare;
+    std::function<CompareResult(const Image& imageA, const Image& imageB, bool alpha, float* errorMap, double exitThreshold)> compare;
 };
 
 static const std::vector<ErrorMetric> errorMetrics =
@@ -250,21 +341,50 @@ static Image::SharedPtr generateHeatMap(uint32_t width, uint32_t height, const f
         *dst++ = 1.f;
     };
 
-    const auto [minValue, maxValue] = std::minmax_element(errorMap, errorMap + width * height);
+    const size_t count = size_t(width) * height;
+    const auto [minValue, maxValue] = std::minmax_element(std::execution::par, errorMap, errorMap + count);
     const float range = std::max(1e-5f, *maxValue - *minValue);
     auto image = Image::create(width, height);
-    float* dst = image->getData();
-    for (size_t i = 0; i < width * height; ++i)
+
+    std::vector<uint32_t> rows(height);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](uint32_t y)
     {
-        float t = clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
-        writeColor(t, dst);
-        dst += 4;
-    }
+        float* dst = image->getData() + size_t(y) * width * 4;
+        for (size_t i = size_t(y) * width; i < size_t(y + 1) * width; ++i)
+        {
+            float t = clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
+            writeColor(t, dst);
+            dst += 4;
+        }
+    });
 
     return image;
 }
 
-static bool compareImages(const std::string& filenameA, const std::string& filenameB, ErrorMetric metric, float threshold, bool alpha, const std::string& heatMapFilename)
+// Serializes console output of concurrent comparisons.
+static std::mutex sOutputMutex;
+
+static void printError(const std::string& msg)
+{
+    std::lock_guard<std::mutex> lock(sOutputMutex);
+    std::cerr << msg << std::endl;
+}
+
+enum class CompareStatus
+{
+    Passed,
+    Failed,         ///< Error exceeds the threshold or is not finite.
+    Invalid,        ///< Images could not be loaded or have different resolutions.
+};
+
+struct ImageResult
+{
+    CompareStatus status = CompareStatus::Invalid;
+    CompareResult result;
+};
+
+static ImageResult compareImages(const std::string& filenameA, const std::string& filenameB, ErrorMetric metric, float threshold, bool alpha, bool earlyExit, const std::string& heatMapFilename)
 {
     auto loadImage = [] (const std::string& filename)
     {
@@ -274,7 +394,7 @@ static bool compareImages(const std::string& filenameA, const std::string& filen
         }
         catch (const std::runtime_error& e)
         {
-            std::cerr << "Cannot load image from '" << filename << "' (Error: " << e.what() << ")." << std::endl;
+            printError("Cannot load image from '" + filename + "' (Error: " + e.what() + ").");
             return Image::SharedPtr();
         }
     };
@@ -287,29 +407,31 @@ static bool compareImages(const std::string& filenameA, const std::string& filen
         }
         catch (const std::runtime_error& e)
         {
-            std::cerr << "Cannot save image to '" << filename << "' (Error: " << e.what() << ")." << std::endl;
+            printError("Cannot save image to '" + filename + "' (Error: " + e.what() + ").");
         }
     };
 
+    ImageResult result;
+
     // Load images.
     auto imageA = loadImage(filenameA);
-    if (!imageA) return false;
+    if (!imageA) return result;
     auto imageB = loadImage(filenameB);
-    if (!imageB) return false;
+    if (!imageB) return result;
 
     // Check resolution.
     if (imageA->getWidth() != imageB->getWidth() || imageA->getHeight() != imageB->getHeight())
     {
-        std::cerr << "Cannot compare images with different resolutions." << std::endl;
-        return false;
+        printError("Cannot compare images with different resolutions ('" + filenameA + "' and '" + filenameB + "').");
+        return result;
     }
 
     uint32_t width = imageA->getWidth();
     uint32_t height = imageB->getHeight();
 
     // Compare images.
-    std::unique_ptr<float[]> errorMap = heatMapFilename.empty() ? nullptr : std::make_unique<float[]>(width * height);
-    double error = metric.compare(*imageA, *imageB, alpha, errorMap.get());
+    std::unique_ptr<float[]> errorMap = heatMapFilename.empty() ? nullptr : std::make_unique<float[]>(size_t(width) * height);
+    result.result = metric.compare(*imageA, *imageB, alpha, errorMap.get(), earlyExit ? threshold : -1.0);
 
     // Generate heat map.
     if (errorMap)
@@ -318,12 +440,94 @@ static bool compareImages(const std::string& filenameA, const std::string& filen
         saveImage(*heatMap, heatMapFilename);
     }
 
-    std::cout << error << std::endl;
-
     // Treat nans and infs as errors.
-    if (std::isnan(error) || std::isinf(error)) return false;
+    double error = result.result.error;
+    bool passed = !std::isnan(error) && !std::isinf(error) && error <= threshold && result.result.complete;
+    result.status = passed ? CompareStatus::Passed : CompareStatus::Failed;
+    return result;
+}
+
+/** Collect all image files in a directory tree.
+    \param[in] dir Root directory.
+    \param[in] excludeSuffix Files ending with this suffix are skipped.
+    \return Returns the sorted relative paths of all images.
+*/
+static std::vector<std::string> collectImages(const std::filesystem::path& dir, const std::string& excludeSuffix)
+{
+    static const std::vector<std::string> kExtensions = { ".png", ".jpg", ".tga", ".bmp", ".pfm", ".exr" };
 
-    return error <= threshold;
+    std::vector<std::string> images;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir))
+    {
+        if (!entry.is_regular_file()) continue;
+        std::string path = entry.path().lexically_relative(dir).generic_string();
+        if (!excludeSuffix.empty() && path.size() >= excludeSuffix.size() && path.compare(path.size() - excludeSuffix.size(), excludeSuffix.size(), excludeSuffix) == 0) continue;
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [] (char c) { return (char)std::tolower(c); });
+        if (std::find(kExtensions.begin(), kExtensions.end(), ext) == kExtensions.end()) continue;
+        images.push_back(path);
+    }
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+/** Compare all images in two directory trees.
+    Images are matched by their relative path. Each image is reported on a separate line as "<status>\t<error>\t<path>",
+    where status is one of PASSED, FAILED, INVALID, MISSING1 (only in the second directory) or MISSING2 (only in the first directory).
+    \return Returns true if all images exist in both directories and pass the comparison.
+*/
+static bool compareDirectories(const std::filesystem::path& dirA, const std::filesystem::path& dirB, ErrorMetric metric, float threshold, bool alpha, bool earlyExit, const std::string& heatMapSuffix, uint32_t jobCount)
+{
+    auto imagesA = collectImages(dirA, heatMapSuffix);
+    auto imagesB = collectImages(dirB, heatMapSuffix);
+
+    std::vector<std::string> images;
+    std::set_union(imagesA.begin(), imagesA.end(), imagesB.begin(), imagesB.end(), std::back_inserter(images));
+
+    std::vector<std::string> statuses(images.size());
+    std::vector<ImageResult> results(images.size());
+
+    // Compare the images on a fixed number of threads to bound the memory used by loaded images.
+    // Each comparison is itself parallelized over image tiles.
+    std::atomic<size_t> nextImage = 0;
+    auto worker = [&] ()
+    {
+        for (size_t i = nextImage++; i < images.size(); i = nextImage++)
+        {
+            const auto& image = images[i];
+            bool inA = std::binary_search(imagesA.begin(), imagesA.end(), image);
+            bool inB = std::binary_search(imagesB.begin(), imagesB.end(), image);
+            if (!inA) { statuses[i] = "MISSING1"; continue; }
+            if (!inB) { statuses[i] = "MISSING2"; continue; }
+
+            std::string heatMapFilename = heatMapSuffix.empty() ? "" : (dirB / image).string() + heatMapSuffix;
+            results[i] = compareImages((dirA / image).string(), (dirB / image).string(), metric, threshold, alpha, earlyExit, heatMapFilename);
+            switch (results[i].status)
+            {
+            case CompareStatus::Passed: statuses[i] = "PASSED"; break;
+            case CompareStatus::Failed: statuses[i] = "FAILED"; break;
+            case CompareStatus::Invalid: statuses[i] = "INVALID"; break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < std::max(1u, jobCount); i++) threads.emplace_back(worker);
+    for (auto& thread : threads) thread.join();
+
+    // Report in sorted order.
+    bool success = true;
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        bool valid = results[i].status != CompareStatus::Invalid;
+        std::cout << statuses[i] << "\t";
+        if (valid) std::cout << results[i].result.error;
+        else std::cout << "-";
+        std::cout << "\t" << images[i] << std::endl;
+        success &= statuses[i] == "PASSED";
+    }
+
+    return success;
 }
 
 static void printMetrics(std::ostream &stream = std::cout)
@@ -337,16 +541,19 @@ static void printMetrics(std::ostream &stream = std::cout)
 
 int main(int argc, char** argv)
 {
-    args::ArgumentParser parser("Utility to compare images.");
+    args::ArgumentParser parser("Utility to compare images.", "If both arguments are directories, all images in the two directory trees are compared.");
     parser.helpParams.programName = "ImageCompare";
     args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
     args::Flag listMetricsFlag(parser, "", "List available error metrics.", {'l'});
     args::ValueFlag<std::string> metricFlag(parser, "metric", "The error metric.", {'m'});
     args::ValueFlag<float> thresholdFlag(parser, "threshold", "The error threshold.", {'t'});
     args::Flag alphaFlag(parser, "", "Include alpha channel.", {'a'});
+    args::Flag earlyExitFlag(parser, "", "Stop comparing as soon as the error threshold is exceeded. The reported error is then a lower bound. Ignored when generating heat maps.", {'x'});
     args::ValueFlag<std::string> heatMapFlag(parser, "filename", "Generate error heat map.", {'e'});
-    args::Positional<std::string> image1(parser, "image1", "The first image.", args::Options::Required);
-    args::Positional<std::string> image2(parser, "image2", "The second image.", args::Options::Required);
+    args::ValueFlag<std::string> heatMapSuffixFlag(parser, "suffix", "Directory mode: Generate error heat maps next to the images of the second directory, named by appending the suffix.", {'s'});
+    args::ValueFlag<uint32_t> jobsFlag(parser, "jobs", "Directory mode: Number of images compared concurrently (default 4).", {'j'});
+    args::Positional<std::string> image1(parser, "image1", "The first image or directory.", args::Options::Required);
+    args::Positional<std::string> image2(parser, "image2", "The second image or directory.", args::Options::Required);
     args::CompletionFlag completionFlag(parser, {"complete"});
 
     try
@@ -396,12 +603,48 @@ int main(int argc, char** argv)
         metric = *it;
     }
 
-    return compareImages(
+    float threshold = thresholdFlag ? args::get(thresholdFlag) : 0.f;
+    bool alpha = alphaFlag ? args::get(alphaFlag) : false;
+    bool earlyExit = earlyExitFlag ? args::get(earlyExitFlag) : false;
+
+    std::filesystem::path path1 = args::get(image1);
+    std::filesystem::path path2 = args::get(image2);
+    if (std::filesystem::is_directory(path1) || std::filesystem::is_directory(path2))
+    {
+        if (!std::filesystem::is_directory(path1) || !std::filesystem::is_directory(path2))
+        {
+            std::cerr << "Cannot compare an image with a directory." << std::endl;
+            return 1;
+        }
+        if (heatMapFlag)
+        {
+            std::cerr << "Use -s to generate heat maps when comparing directories." << std::endl;
+            return 1;
+        }
+
+        return compareDirectories(
+            path1,
+            path2,
+            metric,
+            threshold,
+            alpha,
+            earlyExit,
+            heatMapSuffixFlag ? args::get(heatMapSuffixFlag) : "",
+            jobsFlag ? args::get(jobsFlag) : 4
+        ) ? 0 : 1;
+    }
+
+    auto result = compareImages(
         args::get(image1),
         args::get(image2),
         metric,
-        thresholdFlag ? args::get(thresholdFlag) : 0.f,
-        alphaFlag ? args::get(alphaFlag) : false,
+        threshold,
+        alpha,
+        earlyExit,
         heatMapFlag ? args::get(heatMapFlag) : ""
-    ) ? 0 : 1;
+    );
+
+    if (result.status == CompareStatus::Invalid) return 1;
+    std::cout << result.result.error << std::endl;
+    return result.status == CompareStatus::Passed ? 0 : 1;
 }
@@ -175,18 +175,20 @@ class Test:
 
         return Test.Result.PASSED, []
 
-    def compare_image(self, ref_file, result_file, error_file, tolerance, image_compare_exe):
+    def compare_image_dirs(self, ref_dir, result_dir, tolerance, image_compare_exe):
         '''
-        Compare two images using ImageCompare.
-        Returns a tuple containing the a boolean to indicate success and the measured error.
+        Compare all images in two directories using a single ImageCompare run.
+        Error images are written next to the result images.
+        Returns a tuple containing a dictionary mapping image names to (status, error) and a list of messages.
         '''
-        args = [str(image_compare_exe), '-m', 'mse', '-t', str(tolerance), str(ref_file), str(result_file)]
-        if error_file:
-            args += ['-e', str(error_file)]
-        process = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
-        output = process.communicate()[0]
-        error = float(output.strip())
-        return process.returncode == 0, error
+        args = [str(image_compare_exe), '-m', 'mse', '-t', str(tolerance), '-s', config.ERROR_IMAGE_SUFFIX, str(ref_dir), str(result_dir)]
+        process = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        output, errors = process.communicate()
+        results = {}
+        for line in output.decode().splitlines():
+            status, error, image = line.split('\t', 2)
+            results[Path(image)] = (status, float(error) if error != '-' else float('nan'))
+        return results, errors.decode().splitlines()
 
     def compare_images(self, ref_dir, result_dir, image_compare_exe):
         '''
@@ -221,16 +223,16 @@ class Test:
         image_reports = []
 
         # Compare every result image with the corresponding reference image and report missing references.
+        compare_results, compare_messages = self.compare_image_dirs(ref_dir, result_dir, self.tolerance, image_compare_exe)
+        messages += compare_messages
         for image in result_images:
             if not image in ref_images:
                 result = Test.Result.FAILED
                 messages.append(f'Test has generated image "{image}" with no corresponding reference image.')
                 continue
 
-            ref_file = ref_dir / image
-            result_file = result_dir / image
-            error_file = result_dir / (str(image) + config.ERROR_IMAGE_SUFFIX)
-            compare_success, compare_error = self.compare_image(ref_file, result_file, error_file, self.tolerance, image_compare_exe)
+            status, compare_error = compare_results.get(image, ('INVALID', float('nan')))
+            compare_success = status == 'PASSED'
             if not compare_success:
                 result = Test.Result.FAILED
                 messages.append(f'Test image "{image}" failed with error {compare_error}.')